@@ -0,0 +1,55 @@
+#pragma once
+
+// The parts of the DLPack ABI (https://github.com/dmlc/dlpack, v0.8) used for
+// the unversioned "dltensor" capsule exchange. The layouts must match the
+// upstream dlpack.h exactly; they live in their own namespace so a translation
+// unit may also include the real header.
+
+#include <cstdint>
+
+namespace dlpack {
+
+enum DLDeviceType : int32_t {
+    kDLCPU = 1,
+};
+
+enum DLDataTypeCode : uint8_t {
+    kDLInt = 0,
+    kDLUInt = 1,
+    kDLFloat = 2,
+};
+
+struct DLDevice {
+    int32_t device_type;
+    int32_t device_id;
+};
+
+struct DLDataType {
+    uint8_t code;
+    uint8_t bits;
+    uint16_t lanes;
+};
+
+struct DLTensor {
+    void *data;
+    DLDevice device;
+    int32_t ndim;
+    DLDataType dtype;
+    int64_t *shape;
+    // In elements; null means compact row-major.
+    int64_t *strides;
+    uint64_t byte_offset;
+};
+
+struct DLManagedTensor {
+    DLTensor dl_tensor;
+    void *manager_ctx;
+    void (*deleter)(DLManagedTensor *self);
+};
+
+// Capsule names: a consumer renames the capsule once it owns the tensor, so
+// the capsule's destructor knows not to delete it again.
+inline constexpr const char *kCapsuleName = "dltensor";
+inline constexpr const char *kUsedCapsuleName = "used_dltensor";
+
+} // namespace dlpack
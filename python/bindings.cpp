@@ -2,9 +2,19 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "DLPack.hpp"
 #include "api/Api.hpp"
+#include "tensor/DataLoader.hpp"
+#include "tensor/Linear.hpp"
+#include "tensor/Ops.hpp"
+#include "tensor/Optim.hpp"
 
 namespace py = pybind11;
 
@@ -16,15 +26,48 @@ static Tensor::DType parse_dtype(const std::string &s) {
     throw std::invalid_argument("unsupported dtype: " + s);
 }
 
-template <typename T>
-static py::array_t<T> dtensor_to_numpy(const Tensor::DTensor &dt) {
-    if (!Tensor::api::is_contiguous(dt)) {
-        throw std::runtime_error("only contiguous tensors are supported for export");
+static const char *dtype_name(Tensor::DType dt) {
+    switch (dt) {
+    case Tensor::DType::f32:
+        return "f32";
+    case Tensor::DType::f64:
+        return "f64";
+    case Tensor::DType::i32:
+        return "i32";
+    case Tensor::DType::i64:
+        return "i64";
     }
+    throw std::runtime_error("unknown dtype");
+}
+
+static py::dtype numpy_dtype(Tensor::DType dt) {
+    switch (dt) {
+    case Tensor::DType::f32:
+        return py::dtype::of<float>();
+    case Tensor::DType::f64:
+        return py::dtype::of<double>();
+    case Tensor::DType::i32:
+        return py::dtype::of<int32_t>();
+    case Tensor::DType::i64:
+        return py::dtype::of<int64_t>();
+    }
+    throw std::runtime_error("unknown dtype");
+}
+
+static py::tuple to_tuple(const Tensor::Dims &dims) {
+    py::tuple result(dims.size());
+    for (size_t i = 0; i < dims.size(); ++i) {
+        result[i] = py::int_(dims[i]);
+    }
+    return result;
+}
 
+// A NumPy view of `dt`'s elements, strides and offset included. The array
+// keeps the storage alive through its base capsule.
+static py::array dtensor_to_numpy(const Tensor::DTensor &dt) {
+    const auto itemsize = static_cast<ssize_t>(Tensor::dtype_size(dt.dtype()));
     std::vector<ssize_t> shape(dt.shape().begin(), dt.shape().end());
     std::vector<ssize_t> strides(shape.size());
-    const ssize_t itemsize = static_cast<ssize_t>(sizeof(T));
     for (size_t i = 0; i < shape.size(); ++i) {
         strides[i] = dt.stride()[i] * itemsize;
     }
@@ -34,49 +77,488 @@ static py::array_t<T> dtensor_to_numpy(const Tensor::DTensor &dt) {
         new std::shared_ptr<Tensor::Storage>(storage_sp),
         "tensor_storage_sp",
         [](void *p) { delete static_cast<std::shared_ptr<Tensor::Storage> *>(p); });
-    return py::array_t<T>(shape, strides,
-                          static_cast<T *>(const_cast<void *>(dt.data())), base);
+    return py::array(numpy_dtype(dt.dtype()), shape, strides, dt.data(), base);
+}
+
+// A Storage over memory that a Python-side owner keeps alive. `release` gives
+// the memory back; it runs under the GIL from whichever thread drops the last
+// tensor, and is skipped once the interpreter is gone.
+template <typename Release>
+static std::shared_ptr<Tensor::Storage> foreign_storage(void *data, size_t bytes, size_t alignment,
+                                                        Release release) {
+    std::shared_ptr<void> block(data, [release](void *) {
+        if (Py_IsInitialized()) {
+            py::gil_scoped_acquire gil;
+            release();
+        }
+    });
+    return std::make_shared<Tensor::Storage>(std::move(block), bytes, alignment);
+}
+
+struct ForeignLayout {
+    Tensor::Dims shape;
+    Tensor::Dims stride;
+    // Bytes from the start of the buffer through the last element.
+    size_t bytes{0};
+};
+
+// Checks a foreign buffer's layout against what a DTensor can describe.
+// `stride` is in elements; dims of size 0 or 1 are never stepped over, so
+// they take the default stride whatever the producer reported.
+static ForeignLayout foreign_layout(Tensor::Dims shape, const Tensor::Dims &stride, int64_t offset,
+                                    size_t itemsize) {
+    ForeignLayout layout{std::move(shape), {}, 0};
+    layout.stride = Tensor::default_strides(layout.shape);
+    int64_t last = offset;
+    for (size_t i = 0; i < layout.shape.size(); ++i) {
+        if (layout.shape[i] < 0) {
+            throw std::invalid_argument("buffer dimensions must be non-negative");
+        }
+        if (layout.shape[i] <= 1) {
+            continue;
+        }
+        if (stride[i] < 0) {
+            throw std::invalid_argument(
+                "buffers with negative strides cannot be shared; pass a copy instead");
+        }
+        layout.stride[i] = stride[i];
+        last += (layout.shape[i] - 1) * stride[i];
+    }
+    const bool empty = Tensor::numel_from_shape(layout.shape) == 0;
+    layout.bytes = empty ? static_cast<size_t>(offset) * itemsize
+                         : static_cast<size_t>(last + 1) * itemsize;
+    return layout;
+}
+
+// Wraps a NumPy array's buffer without copying. The tensor keeps the array
+// alive and sees writes made through it.
+static Tensor::DTensor from_numpy(const py::array &array) {
+    Tensor::DType dtype;
+    if (py::isinstance<py::array_t<float>>(array)) {
+        dtype = Tensor::DType::f32;
+    } else if (py::isinstance<py::array_t<double>>(array)) {
+        dtype = Tensor::DType::f64;
+    } else if (py::isinstance<py::array_t<int32_t>>(array)) {
+        dtype = Tensor::DType::i32;
+    } else if (py::isinstance<py::array_t<int64_t>>(array)) {
+        dtype = Tensor::DType::i64;
+    } else {
+        throw std::invalid_argument(
+            "from_numpy supports native-endian float32, float64, int32 and int64 arrays");
+    }
+    if (!array.writeable()) {
+        throw std::invalid_argument("from_numpy requires a writeable array");
+    }
+    const auto itemsize = static_cast<ssize_t>(Tensor::dtype_size(dtype));
+    void *data = const_cast<void *>(array.data());
+    if (reinterpret_cast<uintptr_t>(data) % static_cast<uintptr_t>(itemsize) != 0) {
+        throw std::invalid_argument("from_numpy requires an aligned array");
+    }
+
+    Tensor::Dims shape;
+    Tensor::Dims stride;
+    for (ssize_t i = 0; i < array.ndim(); ++i) {
+        shape.push_back(array.shape(i));
+        if (array.shape(i) > 1 && array.strides(i) % itemsize != 0) {
+            throw std::invalid_argument("from_numpy requires strides that are whole elements");
+        }
+        stride.push_back(array.strides(i) / itemsize);
+    }
+    ForeignLayout layout =
+        foreign_layout(std::move(shape), stride, 0, static_cast<size_t>(itemsize));
+    auto *owner = new py::object(array);
+    auto storage = foreign_storage(data, layout.bytes, static_cast<size_t>(itemsize),
+                                   [owner] { delete owner; });
+    return Tensor::DTensor(std::move(storage), std::move(layout.shape), std::move(layout.stride),
+                           0, dtype);
+}
+
+static Tensor::DType dlpack_dtype(const dlpack::DLDataType &type) {
+    if (type.lanes == 1) {
+        if (type.code == dlpack::kDLFloat && type.bits == 32) return Tensor::DType::f32;
+        if (type.code == dlpack::kDLFloat && type.bits == 64) return Tensor::DType::f64;
+        if (type.code == dlpack::kDLInt && type.bits == 32) return Tensor::DType::i32;
+        if (type.code == dlpack::kDLInt && type.bits == 64) return Tensor::DType::i64;
+    }
+    throw std::invalid_argument("from_dlpack supports float32, float64, int32 and int64 tensors");
+}
+
+static dlpack::DLDataType dlpack_type_of(Tensor::DType dt) {
+    const auto bits = static_cast<uint8_t>(8 * Tensor::dtype_size(dt));
+    const bool floating = Tensor::is_floating_dtype(dt);
+    return {floating ? dlpack::kDLFloat : dlpack::kDLInt, bits, 1};
+}
+
+// Takes over a "dltensor" capsule, from an object's __dlpack__ or passed
+// directly, and wraps its memory without copying. The producer's deleter
+// runs when the last tensor over it goes away.
+static Tensor::DTensor from_dlpack(const py::object &source) {
+    py::object capsule =
+        py::hasattr(source, "__dlpack__") ? source.attr("__dlpack__")() : source;
+    if (!PyCapsule_IsValid(capsule.ptr(), dlpack::kCapsuleName)) {
+        throw std::invalid_argument(
+            "from_dlpack expects an object with __dlpack__ or an unused DLPack capsule");
+    }
+    auto *managed = static_cast<dlpack::DLManagedTensor *>(
+        PyCapsule_GetPointer(capsule.ptr(), dlpack::kCapsuleName));
+    if (managed == nullptr || PyCapsule_SetName(capsule.ptr(), dlpack::kUsedCapsuleName) != 0) {
+        throw py::error_already_set();
+    }
+    // From here on the tensor is ours to delete, whether or not it is usable.
+    std::unique_ptr<dlpack::DLManagedTensor, void (*)(dlpack::DLManagedTensor *)> owned(
+        managed, [](dlpack::DLManagedTensor *self) {
+            if (self->deleter != nullptr) {
+                self->deleter(self);
+            }
+        });
+
+    const dlpack::DLTensor &dl = managed->dl_tensor;
+    if (dl.device.device_type != dlpack::kDLCPU) {
+        throw std::invalid_argument("from_dlpack only accepts CPU tensors");
+    }
+    const Tensor::DType dtype = dlpack_dtype(dl.dtype);
+    const size_t itemsize = Tensor::dtype_size(dtype);
+    if (dl.byte_offset % itemsize != 0 ||
+        reinterpret_cast<uintptr_t>(dl.data) % itemsize != 0) {
+        throw std::invalid_argument("from_dlpack requires an aligned tensor");
+    }
+    const auto offset = static_cast<int64_t>(dl.byte_offset / itemsize);
+    Tensor::Dims shape(dl.shape, dl.shape + dl.ndim);
+    const Tensor::Dims stride = dl.strides != nullptr
+                                    ? Tensor::Dims(dl.strides, dl.strides + dl.ndim)
+                                    : Tensor::default_strides(shape);
+    ForeignLayout layout = foreign_layout(std::move(shape), stride, offset, itemsize);
+
+    auto storage = foreign_storage(dl.data, layout.bytes, itemsize,
+                                   [managed = owned.release()] {
+                                       if (managed->deleter != nullptr) {
+                                           managed->deleter(managed);
+                                       }
+                                   });
+    return Tensor::DTensor(std::move(storage), std::move(layout.shape), std::move(layout.stride),
+                           offset, dtype);
+}
+
+// What an exported DLManagedTensor points into: a handle on the tensor, which
+// keeps its storage alive, and the shape and strides in DLPack's form.
+struct DLPackExport {
+    Tensor::DTensor tensor;
+    Tensor::Dims shape;
+    Tensor::Dims stride;
+    dlpack::DLManagedTensor managed{};
+};
+
+static void delete_unconsumed_dltensor(PyObject *capsule) {
+    if (PyCapsule_IsValid(capsule, dlpack::kCapsuleName)) {
+        auto *managed = static_cast<dlpack::DLManagedTensor *>(
+            PyCapsule_GetPointer(capsule, dlpack::kCapsuleName));
+        managed->deleter(managed);
+    }
+}
+
+// Exports `dt` as an unversioned "dltensor" capsule sharing its memory, which
+// the protocol allows whatever max_version the consumer asks for. Only the CPU
+// device exists, so there is no stream to synchronize with.
+static py::capsule to_dlpack(const Tensor::DTensor &dt, const py::object &stream,
+                             const py::kwargs &options) {
+    if (!stream.is_none()) {
+        throw std::invalid_argument("__dlpack__ takes no stream for CPU tensors");
+    }
+    if (options.contains("dl_device") && !options["dl_device"].is_none() &&
+        !options["dl_device"].equal(py::make_tuple(static_cast<int>(dlpack::kDLCPU), 0))) {
+        throw std::invalid_argument("__dlpack__ can only export to the CPU");
+    }
+    const bool copy = options.contains("copy") && !options["copy"].is_none() &&
+                      py::bool_(options["copy"]);
+    auto context = std::make_unique<DLPackExport>();
+    context->tensor = copy ? Tensor::ops::clone(dt) : dt;
+    context->shape = context->tensor.shape();
+    context->stride = context->tensor.stride();
+
+    dlpack::DLTensor &dl = context->managed.dl_tensor;
+    dl.data = context->tensor.data();
+    dl.device = {dlpack::kDLCPU, 0};
+    dl.ndim = context->tensor.rank();
+    dl.dtype = dlpack_type_of(dt.dtype());
+    dl.shape = context->shape.data();
+    dl.strides = context->stride.data();
+    dl.byte_offset = 0;
+    context->managed.manager_ctx = context.get();
+    context->managed.deleter = [](dlpack::DLManagedTensor *self) {
+        delete static_cast<DLPackExport *>(self->manager_ctx);
+    };
+
+    PyObject *capsule =
+        PyCapsule_New(&context->managed, dlpack::kCapsuleName, delete_unconsumed_dltensor);
+    if (capsule == nullptr) {
+        throw py::error_already_set();
+    }
+    context.release();
+    return py::reinterpret_steal<py::capsule>(capsule);
+}
+
+// Runs `compute` with the GIL released so other Python threads keep running
+// while a kernel does. `compute` must not touch Python objects.
+template <typename F> static auto without_gil(F &&compute) {
+    py::gil_scoped_release nogil;
+    return compute();
+}
+
+// The result of an op that has an out= form: a fresh tensor from `fresh`, or
+// `out` itself after `into` has written the result into it.
+template <typename Fresh, typename Into>
+static py::object fresh_or_into(const py::object &out, Fresh fresh, Into into) {
+    if (out.is_none()) {
+        return py::cast(without_gil(fresh));
+    }
+    auto &dst = out.cast<Tensor::DTensor &>();
+    without_gil([&] { into(dst); });
+    return out;
+}
+
+static py::object matmul(const Tensor::DTensor &lhs, const Tensor::DTensor &rhs,
+                         const py::object &out) {
+    return fresh_or_into(
+        out, [&] { return Tensor::ops::matmul(lhs, rhs); },
+        [&](Tensor::DTensor &dst) { Tensor::ops::matmul_out(lhs, rhs, dst); });
+}
+
+static py::object add(const Tensor::DTensor &lhs, const Tensor::DTensor &rhs,
+                      const py::object &out) {
+    return fresh_or_into(
+        out, [&] { return Tensor::ops::add(lhs, rhs); },
+        [&](Tensor::DTensor &dst) { Tensor::ops::add_out(lhs, rhs, dst); });
+}
+
+static py::object relu(const Tensor::DTensor &input, const py::object &out) {
+    return fresh_or_into(
+        out, [&] { return Tensor::ops::relu(input); },
+        [&](Tensor::DTensor &dst) { Tensor::ops::relu_out(input, dst); });
+}
+
+static Tensor::Shuffle parse_shuffle(const std::string &s) {
+    if (s == "none") return Tensor::Shuffle::none;
+    if (s == "rows") return Tensor::Shuffle::rows;
+    if (s == "within_shards") return Tensor::Shuffle::within_shards;
+    throw std::invalid_argument("unsupported shuffle: " + s);
+}
+
+static Tensor::ops::Activation parse_activation(const std::string &s) {
+    if (s == "identity" || s == "none") return Tensor::ops::Activation::identity();
+    if (s == "relu") return Tensor::ops::Activation::relu();
+    throw std::invalid_argument("unsupported activation: " + s);
+}
+
+static Tensor::DTensor linear_forward(const Tensor::nn::Linear &linear,
+                                      const Tensor::DTensor &input,
+                                      const std::string &activation) {
+    const Tensor::ops::Activation fn = parse_activation(activation);
+    return without_gil([&] { return linear.forward(input, fn); });
+}
+
+// step, zero_grad and the learning rate, shared by the optimizer classes.
+// Steps release the GIL.
+template <typename Optimizer, typename Class> static void bind_optimizer(Class &cls) {
+    cls.def("step", &Optimizer::step, py::arg("parameters"),
+            py::call_guard<py::gil_scoped_release>())
+        .def("zero_grad", &Optimizer::zero_grad, py::arg("parameters"),
+             py::call_guard<py::gil_scoped_release>())
+        .def_property("lr", &Optimizer::learning_rate, &Optimizer::set_learning_rate)
+        .def_property_readonly("last_grad_norm", &Optimizer::last_grad_norm,
+                               "Global gradient norm seen by the last step, before "
+                               "clipping; only measured when max_grad_norm is set.");
 }
 
 PYBIND11_MODULE(tensor_py, m) {
     m.doc() = "Tensor pybind11 module (experimental)";
 
+    py::class_<Tensor::DTensor>(m, "Tensor")
+        .def_property_readonly("shape",
+                               [](const Tensor::DTensor &t) { return to_tuple(t.shape()); })
+        .def_property_readonly("strides",
+                               [](const Tensor::DTensor &t) { return to_tuple(t.stride()); },
+                               "Strides in elements.")
+        .def_property_readonly("offset", &Tensor::DTensor::offset)
+        .def_property_readonly("dtype",
+                               [](const Tensor::DTensor &t) { return dtype_name(t.dtype()); })
+        .def("numpy", &dtensor_to_numpy, "A NumPy view sharing this tensor's memory.")
+        .def("__dlpack__", &to_dlpack, py::arg("stream") = py::none())
+        .def("__dlpack_device__", [](const Tensor::DTensor &) {
+            return py::make_tuple(static_cast<int>(dlpack::kDLCPU), 0);
+        })
+        .def_property("requires_grad", &Tensor::DTensor::requires_grad,
+                      &Tensor::DTensor::set_requires_grad)
+        .def_property_readonly("grad",
+                               [](const Tensor::DTensor &t) -> std::optional<Tensor::DTensor> {
+                                   if (auto grad = t.grad()) {
+                                       return *grad;
+                                   }
+                                   return std::nullopt;
+                               })
+        .def("zero_grad", &Tensor::DTensor::zero_grad)
+        .def("item", [](const Tensor::DTensor &t) { return dtensor_to_numpy(t).attr("item")(); })
+        .def("matmul", &matmul, py::arg("other"), py::kw_only(), py::arg("out") = py::none())
+        .def("add", &add, py::arg("other"), py::kw_only(), py::arg("out") = py::none())
+        .def("relu", &relu, py::kw_only(), py::arg("out") = py::none())
+        .def("__matmul__",
+             [](const Tensor::DTensor &lhs, const Tensor::DTensor &rhs) {
+                 return matmul(lhs, rhs, py::none());
+             },
+             py::is_operator())
+        .def("__add__",
+             [](const Tensor::DTensor &lhs, const Tensor::DTensor &rhs) {
+                 return add(lhs, rhs, py::none());
+             },
+             py::is_operator())
+        .def("mse_loss", &Tensor::ops::mse_loss, py::arg("target"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("sum", py::overload_cast<const Tensor::DTensor &>(&Tensor::ops::sum),
+             py::call_guard<py::gil_scoped_release>())
+        .def("backward", &Tensor::ops::backward, py::call_guard<py::gil_scoped_release>());
+
+    // Ops release the GIL while their kernels run. The out= forms write into a
+    // preallocated tensor of the result's shape and dtype and return it; like
+    // the C++ *_out variants they do not record autograd history.
+    m.def("matmul", &matmul, py::arg("lhs"), py::arg("rhs"), py::kw_only(),
+          py::arg("out") = py::none());
+    m.def("add", &add, py::arg("lhs"), py::arg("rhs"), py::kw_only(),
+          py::arg("out") = py::none());
+    m.def("relu", &relu, py::arg("input"), py::kw_only(), py::arg("out") = py::none());
+    m.def("mse_loss", &Tensor::ops::mse_loss, py::arg("prediction"), py::arg("target"),
+          py::call_guard<py::gil_scoped_release>());
+
+    py::class_<Tensor::nn::Linear>(m, "Linear")
+        .def(py::init([](int64_t in_features, int64_t out_features, const std::string &dtype) {
+                 return Tensor::nn::Linear(in_features, out_features, parse_dtype(dtype));
+             }),
+             py::arg("in_features"), py::arg("out_features"), py::arg("dtype") = "f32")
+        .def("forward", &linear_forward, py::arg("input"), py::arg("activation") = "identity")
+        .def("__call__", &linear_forward, py::arg("input"), py::arg("activation") = "identity")
+        .def_property_readonly("weight",
+                               [](const Tensor::nn::Linear &linear) { return linear.weight(); })
+        .def_property_readonly("bias",
+                               [](const Tensor::nn::Linear &linear) { return linear.bias(); })
+        .def("parameters", [](const Tensor::nn::Linear &linear) {
+            return std::vector<Tensor::DTensor>{linear.weight(), linear.bias()};
+        });
+
+    // Tensors are handles, so the parameter list may hold the ones returned by
+    // Linear.parameters(): updates land in the module's storage.
+    // Optimizer state is kept by position, so pass the same parameters in the
+    // same order on every step. max_grad_norm > 0 turns on global-norm
+    // gradient clipping.
+    py::class_<Tensor::nn::SGD> sgd(m, "SGD");
+    sgd.def(py::init([](float lr, float momentum, float dampening, bool nesterov,
+                        float weight_decay, float max_grad_norm) {
+                return Tensor::nn::SGD(lr, {momentum, dampening, nesterov, weight_decay,
+                                            max_grad_norm});
+            }),
+            py::arg("lr"), py::kw_only(), py::arg("momentum") = 0.0f,
+            py::arg("dampening") = 0.0f, py::arg("nesterov") = false,
+            py::arg("weight_decay") = 0.0f, py::arg("max_grad_norm") = 0.0f);
+    bind_optimizer<Tensor::nn::SGD>(sgd);
+
+    py::class_<Tensor::nn::Adam> adam(m, "Adam");
+    adam.def(py::init([](float lr, std::pair<float, float> betas, float eps, float weight_decay,
+                         float max_grad_norm) {
+                 return Tensor::nn::Adam(lr, {betas.first, betas.second, eps, weight_decay,
+                                              false, max_grad_norm});
+             }),
+             py::arg("lr") = 1e-3f, py::kw_only(),
+             py::arg("betas") = std::make_pair(0.9f, 0.999f), py::arg("eps") = 1e-8f,
+             py::arg("weight_decay") = 0.0f, py::arg("max_grad_norm") = 0.0f);
+    bind_optimizer<Tensor::nn::Adam>(adam);
+
+    py::class_<Tensor::nn::AdamW, Tensor::nn::Adam>(m, "AdamW")
+        .def(py::init([](float lr, std::pair<float, float> betas, float eps, float weight_decay,
+                         float max_grad_norm) {
+                 Tensor::nn::AdamOptions options;
+                 options.beta1 = betas.first;
+                 options.beta2 = betas.second;
+                 options.eps = eps;
+                 options.max_grad_norm = max_grad_norm;
+                 return Tensor::nn::AdamW(lr, weight_decay, options);
+             }),
+             py::arg("lr") = 1e-3f, py::kw_only(),
+             py::arg("betas") = std::make_pair(0.9f, 0.999f), py::arg("eps") = 1e-8f,
+             py::arg("weight_decay") = 0.01f, py::arg("max_grad_norm") = 0.0f);
+
+    // Iterating a DataLoader starts its next epoch, so `for batch in loader`
+    // walks epochs 0, 1, ... in turn; start_epoch picks one explicitly.
+    py::class_<Tensor::DataLoader>(m, "DataLoader")
+        .def(py::init([](std::vector<std::string> shards, int64_t features, int64_t batch_size,
+                         const std::string &shuffle, uint64_t seed, bool drop_last,
+                         const std::string &dtype, int num_workers, int prefetch) {
+                 Tensor::DataLoaderOptions options;
+                 options.batch_size = batch_size;
+                 options.shuffle = parse_shuffle(shuffle);
+                 options.seed = seed;
+                 options.drop_last = drop_last;
+                 options.dtype = parse_dtype(dtype);
+                 options.num_workers = num_workers;
+                 options.prefetch = prefetch;
+                 return std::make_unique<Tensor::DataLoader>(std::move(shards), features, options);
+             }),
+             py::arg("shards"), py::arg("features"), py::kw_only(), py::arg("batch_size") = 32,
+             py::arg("shuffle") = "rows", py::arg("seed") = 0, py::arg("drop_last") = false,
+             py::arg("dtype") = "f32", py::arg("num_workers") = 1, py::arg("prefetch") = 2)
+        .def_property_readonly("features", &Tensor::DataLoader::features)
+        .def_property_readonly("rows", &Tensor::DataLoader::rows)
+        .def_property_readonly("shard_count", &Tensor::DataLoader::shard_count)
+        .def("shard_rows", &Tensor::DataLoader::shard_rows, py::arg("shard"))
+        .def_property_readonly("batches_per_epoch", &Tensor::DataLoader::batches_per_epoch)
+        .def_property_readonly("epoch", &Tensor::DataLoader::epoch)
+        .def("__len__", &Tensor::DataLoader::batches_per_epoch)
+        .def("start_epoch", &Tensor::DataLoader::start_epoch, py::arg("epoch"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("next",
+             [](Tensor::DataLoader &loader) -> std::optional<Tensor::DTensor> {
+                 auto batch = without_gil([&] { return loader.next(); });
+                 if (!batch.defined()) {
+                     return std::nullopt;
+                 }
+                 return batch;
+             },
+             "The next batch of the current epoch, or None once it is done.")
+        .def("__iter__",
+             [](Tensor::DataLoader &loader) -> Tensor::DataLoader & {
+                 without_gil([&] { loader.start_epoch(loader.epoch() + 1); });
+                 return loader;
+             },
+             py::return_value_policy::reference_internal)
+        .def("__next__", [](Tensor::DataLoader &loader) {
+            auto batch = without_gil([&] { return loader.next(); });
+            if (!batch.defined()) {
+                throw py::stop_iteration();
+            }
+            return batch;
+        });
+
+    m.def("from_numpy", &from_numpy, py::arg("array").noconvert(),
+          "Wraps a NumPy array's memory, strides included, without copying.");
+    m.def("from_dlpack", &from_dlpack, py::arg("source"),
+          "Wraps a DLPack-exporting object's memory (a PyTorch tensor, a NumPy "
+          "array, ...) without copying.");
+
     m.def(
         "zeros",
         [](const std::vector<int64_t> &shape, const std::string &dtype) -> py::array {
-            Tensor::DType dt = parse_dtype(dtype);
-            Tensor::DTensor t = Tensor::api::zeros(shape, dt);
-            switch (dt) {
-            case Tensor::DType::f32:
-                return py::array(dtensor_to_numpy<float>(t));
-            case Tensor::DType::f64:
-                return py::array(dtensor_to_numpy<double>(t));
-            case Tensor::DType::i32:
-                return py::array(dtensor_to_numpy<int32_t>(t));
-            case Tensor::DType::i64:
-                return py::array(dtensor_to_numpy<int64_t>(t));
-            }
-            throw std::runtime_error("dtype not supported in zeros");
+            return dtensor_to_numpy(Tensor::api::zeros(shape, parse_dtype(dtype)));
         },
         py::arg("shape"), py::arg("dtype") = "f32");
 
     m.def(
         "ones",
         [](const std::vector<int64_t> &shape, const std::string &dtype) -> py::array {
-            Tensor::DType dt = parse_dtype(dtype);
-            switch (dt) {
+            switch (parse_dtype(dtype)) {
             case Tensor::DType::f32:
-                return py::array(
-                    dtensor_to_numpy<float>(Tensor::api::ones<float>(shape).as_dtensor()));
+                return dtensor_to_numpy(Tensor::api::ones<float>(shape).as_dtensor());
             case Tensor::DType::f64:
-                return py::array(
-                    dtensor_to_numpy<double>(Tensor::api::ones<double>(shape).as_dtensor()));
+                return dtensor_to_numpy(Tensor::api::ones<double>(shape).as_dtensor());
             case Tensor::DType::i32:
-                return py::array(dtensor_to_numpy<int32_t>(
-                    Tensor::api::ones<int32_t>(shape).as_dtensor()));
+                return dtensor_to_numpy(Tensor::api::ones<int32_t>(shape).as_dtensor());
             case Tensor::DType::i64:
-                return py::array(dtensor_to_numpy<int64_t>(
-                    Tensor::api::ones<int64_t>(shape).as_dtensor()));
+                return dtensor_to_numpy(Tensor::api::ones<int64_t>(shape).as_dtensor());
             }
             throw std::runtime_error("dtype not supported in ones");
         },
@@ -1,5 +1,35 @@
 """Python convenience wrapper around the native ``tensor_py`` extension."""
 
-from tensor_py import ones, zeros
+from tensor_py import (
+    Adam,
+    AdamW,
+    DataLoader,
+    SGD,
+    Linear,
+    Tensor,
+    add,
+    from_dlpack,
+    from_numpy,
+    matmul,
+    mse_loss,
+    ones,
+    relu,
+    zeros,
+)
 
-__all__ = ["ones", "zeros"]
+__all__ = [
+    "Adam",
+    "AdamW",
+    "DataLoader",
+    "SGD",
+    "Linear",
+    "Tensor",
+    "add",
+    "from_dlpack",
+    "from_numpy",
+    "matmul",
+    "mse_loss",
+    "ones",
+    "relu",
+    "zeros",
+]
@@ -0,0 +1,51 @@
+import numpy as np
+import pytest
+
+import tensor as T
+
+
+def _write_shards(tmp_path, rows_per_shard, features):
+    paths, first = [], 0
+    for index, rows in enumerate(rows_per_shard):
+        data = np.arange(first * features, (first + rows) * features, dtype=np.float32)
+        path = tmp_path / f"shard_{index}.bin"
+        data.tofile(path)
+        paths.append(str(path))
+        first += rows
+    return paths
+
+
+def test_iterating_walks_epochs_over_every_row(tmp_path):
+    shards = _write_shards(tmp_path, [10, 7], features=4)
+    loader = T.DataLoader(shards, 4, batch_size=5, seed=3)
+    assert (loader.rows, loader.shard_count, len(loader)) == (17, 2, 4)
+    assert loader.epoch == -1
+
+    epochs = []
+    for _ in range(2):
+        rows = np.concatenate([batch.numpy() for batch in loader])
+        assert rows.shape == (17, 4)
+        ids = (rows[:, 0] // 4).astype(np.int64)
+        assert sorted(ids) == list(range(17))
+        assert np.array_equal(rows, ids[:, None] * 4 + np.arange(4))
+        epochs.append(ids)
+    assert loader.epoch == 1
+    assert not np.array_equal(epochs[0], epochs[1])
+
+
+def test_next_returns_none_at_the_end_of_an_epoch(tmp_path):
+    shards = _write_shards(tmp_path, [6], features=2)
+    loader = T.DataLoader(shards, 2, batch_size=4, shuffle="none", drop_last=True, num_workers=0)
+    loader.start_epoch(0)
+    batch = loader.next()
+    assert batch.shape == (4, 2)
+    assert np.array_equal(batch.numpy().ravel(), np.arange(8, dtype=np.float32))
+    assert loader.next() is None
+
+
+def test_rejects_bad_shards(tmp_path):
+    shards = _write_shards(tmp_path, [3], features=2)
+    with pytest.raises(ValueError):
+        T.DataLoader(shards, 4)
+    with pytest.raises(ValueError):
+        T.DataLoader(shards, 2, shuffle="sometimes")
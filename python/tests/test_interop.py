@@ -0,0 +1,58 @@
+import numpy as np
+import pytest
+
+try:
+    import torch
+except Exception:  # pragma: no cover
+    torch = None
+
+import tensor as T
+
+
+def test_from_numpy_shares_memory_and_strides():
+    base = np.arange(24, dtype=np.float32).reshape(4, 6)
+    view = base[1:, ::2]
+    t = T.from_numpy(view)
+    assert t.shape == (3, 3)
+    assert t.strides == (6, 2)
+    assert t.dtype == "f32"
+    out = t.numpy()
+    assert np.array_equal(out, view)
+    base[1, 0] = -1.0
+    assert out[0, 0] == -1.0
+
+
+def test_from_numpy_keeps_the_array_alive():
+    t = T.from_numpy(np.full((1000,), 7, dtype=np.int64))
+    assert np.all(t.numpy() == 7)
+
+
+def test_from_numpy_rejects_unsupported_arrays():
+    with pytest.raises(ValueError):
+        T.from_numpy(np.zeros(4, dtype=np.float16))
+    with pytest.raises(ValueError):
+        T.from_numpy(np.arange(4.0)[::-1])
+    frozen = np.zeros(3, dtype=np.float64)
+    frozen.flags.writeable = False
+    with pytest.raises(ValueError):
+        T.from_numpy(frozen)
+
+
+def test_dlpack_round_trip_with_numpy():
+    base = np.arange(12, dtype=np.float64).reshape(3, 4).T
+    t = T.from_dlpack(base)
+    assert t.shape == (4, 3)
+    back = np.from_dlpack(t)
+    assert np.array_equal(back, base)
+    base[0, 0] = 42.0
+    assert back[0, 0] == 42.0
+
+
+@pytest.mark.skipif(torch is None, reason="torch not available")
+def test_dlpack_with_torch():
+    source = torch.arange(10, dtype=torch.int32)[2:]
+    t = T.from_dlpack(source)
+    assert np.array_equal(t.numpy(), source.numpy())
+    back = torch.from_dlpack(t)
+    source[0] = -5
+    assert back[0].item() == -5
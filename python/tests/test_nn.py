@@ -0,0 +1,116 @@
+import threading
+
+import numpy as np
+import pytest
+
+import tensor as T
+
+
+def _tensor(values, requires_grad=False):
+    t = T.from_numpy(np.ascontiguousarray(values, dtype=np.float32))
+    t.requires_grad = requires_grad
+    return t
+
+
+def test_ops_match_numpy():
+    a = np.arange(6, dtype=np.float32).reshape(2, 3) - 2.0
+    b = np.arange(12, dtype=np.float32).reshape(3, 4) / 4.0
+    ta, tb = _tensor(a), _tensor(b)
+    assert np.allclose((ta @ tb).numpy(), a @ b)
+    assert np.allclose(T.relu(ta).numpy(), np.maximum(a, 0))
+    assert np.allclose((ta + ta).numpy(), a + a)
+    loss = T.mse_loss(ta, T.relu(ta))
+    assert loss.item() == pytest.approx(np.mean((a - np.maximum(a, 0)) ** 2))
+
+
+def test_out_arguments_reuse_the_buffer():
+    a = _tensor(np.eye(3))
+    b = _tensor(np.arange(9).reshape(3, 3) - 4)
+    out = T.from_numpy(np.empty((3, 3), dtype=np.float32))
+    address = out.numpy().__array_interface__["data"][0]
+    assert a.matmul(b, out=out) is out
+    assert np.array_equal(out.numpy(), b.numpy())
+    assert T.relu(b, out=out) is out
+    assert np.array_equal(out.numpy(), np.maximum(b.numpy(), 0))
+    assert T.add(a, b, out=out) is out
+    assert out.numpy().__array_interface__["data"][0] == address
+    with pytest.raises(ValueError):
+        T.matmul(a, b, out=T.from_numpy(np.empty((2, 3), dtype=np.float32)))
+
+
+def test_backward_and_sgd_fit_a_linear_model():
+    rng = np.random.default_rng(0)
+    x = rng.standard_normal((32, 4)).astype(np.float32)
+    y = (x @ np.array([[1.0], [-2.0], [0.5], [3.0]], dtype=np.float32)).astype(np.float32)
+    inputs, targets = _tensor(x), _tensor(y)
+    model = T.Linear(4, 1)
+    optimizer = T.SGD(lr=0.1)
+    losses = []
+    for _ in range(50):
+        optimizer.zero_grad(model.parameters())
+        loss = model(inputs).mse_loss(targets)
+        loss.backward()
+        optimizer.step(model.parameters())
+        losses.append(loss.item())
+    assert losses[-1] < 1e-2 * losses[0]
+    assert model.weight.grad is not None
+    assert inputs.grad is None
+
+
+def test_threads_run_kernels_concurrently():
+    a = np.random.default_rng(1).standard_normal((128, 128)).astype(np.float32)
+    expected = a @ a
+    ta = _tensor(a)
+    errors = []
+
+    def work():
+        out = T.from_numpy(np.empty_like(a))
+        for _ in range(20):
+            T.matmul(ta, ta, out=out)
+            if not np.allclose(out.numpy(), expected, atol=1e-3):
+                errors.append("mismatch")
+
+    threads = [threading.Thread(target=work) for _ in range(4)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    assert not errors
+
+
+@pytest.mark.parametrize(
+    "make_optimizer",
+    [
+        lambda: T.SGD(lr=0.05, momentum=0.9, nesterov=True),
+        lambda: T.Adam(lr=0.05),
+        lambda: T.AdamW(lr=0.05, weight_decay=0.0, max_grad_norm=10.0),
+    ],
+)
+def test_optimizers_fit_a_linear_model(make_optimizer):
+    rng = np.random.default_rng(2)
+    x = rng.standard_normal((32, 3)).astype(np.float32)
+    y = (x @ np.array([[2.0], [-1.0], [0.5]], dtype=np.float32)).astype(np.float32)
+    inputs, targets = _tensor(x), _tensor(y)
+    model = T.Linear(3, 1)
+    optimizer = make_optimizer()
+    first = last = None
+    for _ in range(200):
+        optimizer.zero_grad(model.parameters())
+        loss = model(inputs).mse_loss(targets)
+        loss.backward()
+        optimizer.step(model.parameters())
+        last = loss.item()
+        first = first if first is not None else last
+    assert last < 1e-2 * first
+
+
+def test_clipping_reports_the_gradient_norm():
+    weight = _tensor(np.zeros(2), requires_grad=True)
+    target = _tensor(np.array([3.0, 4.0]))
+    optimizer = T.SGD(lr=1.0, max_grad_norm=1.0)
+    loss = weight.mse_loss(target)
+    loss.backward()
+    optimizer.step([weight])
+    # d/dw mean((w - t)^2) = w - t, which at w = 0 has norm 5.
+    assert optimizer.last_grad_norm == pytest.approx(5.0)
+    assert np.allclose(weight.numpy(), [0.6, 0.8])
@@ -1,30 +1,35 @@
 #pragma once
 
+#include "tensor/Arena.hpp"
+#include "tensor/Ops.hpp"
 #include "tensor/Tensor.hpp"
 
 #include <cstdint>
 #include <cstring>
+#include <initializer_list>
 #include <vector>
 
 namespace Tensor::api {
 
+// Scope that serves one training step's allocations from a bump arena; see
+// tensor/Arena.hpp.
+using StepArena = ::Tensor::StepArena;
+
 template <typename T> Tensor<T> make_scalar(const T &value) {
   auto storage = make_host_storage(sizeof(T), 64);
-  std::vector<int64_t> shape{1};
-  DTensor tensor(std::move(storage), shape, default_strides(shape), 0, dtype_of<T>(),
-                 true, false);
+  DTensor tensor(std::move(storage), Dims{1}, Dims{1}, 0, dtype_of<T>(), true, false);
   *static_cast<T *>(tensor.data()) = value;
   return Tensor<T>(std::move(tensor));
 }
 
-inline DTensor empty(const std::vector<int64_t> &shape, DType dtype,
+inline DTensor empty(const Dims &shape, DType dtype,
                      bool requires_grad = false) {
   const auto bytes = static_cast<std::size_t>(numel_from_shape(shape)) * dtype_size(dtype);
   return DTensor(make_host_storage(bytes, 64), shape, default_strides(shape), 0,
                  dtype, true, requires_grad);
 }
 
-inline DTensor zeros(const std::vector<int64_t> &shape, DType dtype,
+inline DTensor zeros(const Dims &shape, DType dtype,
                      bool requires_grad = false) {
   DTensor tensor = empty(shape, dtype, requires_grad);
   std::memset(tensor.data(), 0, static_cast<std::size_t>(tensor.numel()) * dtype_size(dtype));
@@ -32,17 +37,17 @@ inline DTensor zeros(const std::vector<int64_t> &shape, DType dtype,
 }
 
 template <typename T>
-inline Tensor<T> empty(const std::vector<int64_t> &shape, bool requires_grad = false) {
+inline Tensor<T> empty(const Dims &shape, bool requires_grad = false) {
   return Tensor<T>(empty(shape, dtype_of<T>(), requires_grad));
 }
 
 template <typename T>
-inline Tensor<T> zeros(const std::vector<int64_t> &shape, bool requires_grad = false) {
+inline Tensor<T> zeros(const Dims &shape, bool requires_grad = false) {
   return Tensor<T>(zeros(shape, dtype_of<T>(), requires_grad));
 }
 
 template <typename T>
-inline Tensor<T> ones(const std::vector<int64_t> &shape, bool requires_grad = false) {
+inline Tensor<T> ones(const Dims &shape, bool requires_grad = false) {
   Tensor<T> tensor = empty<T>(shape, requires_grad);
   T *ptr = tensor.data();
   for (int64_t index = 0; index < tensor.numel(); ++index) {
@@ -52,40 +57,25 @@ inline Tensor<T> ones(const std::vector<int64_t> &shape, bool requires_grad = fa
 }
 
 inline bool is_contiguous(const DTensor &tensor) {
-  return is_default_contiguous(tensor.shape(), tensor.stride());
+  return tensor.is_contiguous();
 }
 
-inline DTensor reshape(const DTensor &tensor, const std::vector<int64_t> &new_shape) {
-  if (!is_contiguous(tensor)) {
-    throw std::invalid_argument("reshape only supports contiguous tensors");
-  }
-  if (tensor.numel() != numel_from_shape(new_shape)) {
-    throw std::invalid_argument("reshape requires the same element count");
-  }
-  return DTensor(tensor.storage(), new_shape, default_strides(new_shape), tensor.offset(),
-                 tensor.dtype(), true, tensor.requires_grad(),
-                 tensor.autograd_state());
+inline DTensor reshape(const DTensor &tensor, const Dims &new_shape) {
+  return ops::reshape(tensor, new_shape);
 }
 
-inline DTensor permute(const DTensor &tensor, const std::vector<int> &perm) {
-  if (static_cast<int>(perm.size()) != tensor.rank()) {
-    throw std::invalid_argument("permute rank mismatch");
-  }
+inline DTensor permute(const DTensor &tensor, const Dims &perm) {
+  return ops::permute(tensor, perm);
+}
 
-  std::vector<int64_t> new_shape(perm.size());
-  std::vector<int64_t> new_stride(perm.size());
-  for (std::size_t index = 0; index < perm.size(); ++index) {
-    const int axis = perm[index];
-    if (axis < 0 || axis >= tensor.rank()) {
-      throw std::invalid_argument("permute axis out of range");
-    }
-    new_shape[index] = tensor.shape()[static_cast<std::size_t>(axis)];
-    new_stride[index] = tensor.stride()[static_cast<std::size_t>(axis)];
-  }
+// The original std::vector<int> signature; the initializer_list overload keeps
+// braced lists such as permute(t, {1, 0}) unambiguous between the two.
+inline DTensor permute(const DTensor &tensor, const std::vector<int> &perm) {
+  return ops::permute(tensor, Dims(perm.begin(), perm.end()));
+}
 
-  return DTensor(tensor.storage(), std::move(new_shape), std::move(new_stride),
-                 tensor.offset(), tensor.dtype(), false, tensor.requires_grad(),
-                 tensor.autograd_state());
+inline DTensor permute(const DTensor &tensor, std::initializer_list<int64_t> perm) {
+  return ops::permute(tensor, Dims(perm));
 }
 
 } // namespace Tensor::api
@@ -0,0 +1,356 @@
+#include "tensor/Allocator.hpp"
+
+#include <atomic>
+#include <bit>
+#include <cstdlib>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+namespace Tensor {
+
+namespace {
+
+constexpr std::size_t kMinBlock = 64;
+constexpr std::size_t kBlockAlignment = 64;
+constexpr std::size_t kThreadCacheMaxBlock = std::size_t{256} << 10;
+constexpr int kThreadCacheDepth = 8;
+constexpr std::size_t kDefaultCacheLimitMb = 512;
+
+// Class 0 holds blocks up to 64 bytes; above that every (2^k, 2^(k+1)] range is
+// split into four classes of 2^(k-2)-byte steps.
+constexpr int size_class(std::size_t bytes) {
+  if (bytes <= kMinBlock) {
+    return 0;
+  }
+  const int k = static_cast<int>(std::bit_width(bytes - 1)) - 1;
+  const std::size_t step = std::size_t{1} << (k - 2);
+  const auto multiple = static_cast<int>((bytes + step - 1) / step);
+  return 1 + (k - 6) * 4 + (multiple - 5);
+}
+
+constexpr std::size_t class_bytes(int cls) {
+  if (cls == 0) {
+    return kMinBlock;
+  }
+  const int k = (cls - 1) / 4 + 6;
+  const auto multiple = static_cast<std::size_t>((cls - 1) % 4 + 5);
+  return multiple << (k - 2);
+}
+
+constexpr int kNumClasses = 1 + (63 - 6) * 4;
+constexpr int kThreadClasses = size_class(kThreadCacheMaxBlock) + 1;
+
+static_assert(class_bytes(size_class(65)) == 80);
+static_assert(class_bytes(size_class(kThreadCacheMaxBlock)) == kThreadCacheMaxBlock);
+
+void *system_allocate(std::size_t alignment, std::size_t size) {
+#if defined(_WIN32)
+  return _aligned_malloc(size, alignment);
+#else
+  void *ptr = nullptr;
+  if (alignment < sizeof(void *)) {
+    alignment = sizeof(void *);
+  }
+  if (posix_memalign(&ptr, alignment, size) == 0) {
+    return ptr;
+  }
+  return nullptr;
+#endif
+}
+
+void system_free(void *ptr) noexcept {
+#if defined(_WIN32)
+  _aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+
+std::atomic<uint64_t> g_hits{0};
+std::atomic<uint64_t> g_misses{0};
+std::atomic<std::size_t> g_in_use{0};
+std::atomic<std::size_t> g_peak{0};
+std::atomic<std::size_t> g_cached{0};
+std::atomic<bool> g_enabled{true};
+
+void note_allocated(std::size_t bytes) noexcept {
+  const std::size_t now = g_in_use.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  std::size_t peak = g_peak.load(std::memory_order_relaxed);
+  while (now > peak &&
+         !g_peak.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {
+  }
+}
+
+std::size_t default_cache_limit() {
+  std::size_t megabytes = kDefaultCacheLimitMb;
+  if (const char *env = std::getenv("TENSOR_HOST_CACHE_LIMIT_MB")) {
+    try {
+      megabytes = static_cast<std::size_t>(std::stoull(env));
+    } catch (const std::exception &) {
+    }
+  }
+  return megabytes << 20;
+}
+
+class GlobalCache {
+public:
+  explicit GlobalCache(std::size_t limit) : limit_(limit) {
+    g_enabled.store(limit > 0, std::memory_order_relaxed);
+  }
+
+  void *take(int cls) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &bin = bins_[cls];
+    if (bin.empty()) {
+      return nullptr;
+    }
+    void *ptr = bin.back();
+    bin.pop_back();
+    cached_ -= class_bytes(cls);
+    g_cached.fetch_sub(class_bytes(cls), std::memory_order_relaxed);
+    return ptr;
+  }
+
+  void put(int cls, void *ptr) {
+    const std::size_t bytes = class_bytes(cls);
+    std::vector<void *> evicted;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (bytes > limit_) {
+        evicted.push_back(ptr);
+      } else {
+        evict_locked(limit_ - bytes, evicted);
+        bins_[cls].push_back(ptr);
+        cached_ += bytes;
+        g_cached.fetch_add(bytes, std::memory_order_relaxed);
+      }
+    }
+    for (void *block : evicted) {
+      system_free(block);
+    }
+  }
+
+  void trim(std::size_t target) {
+    std::vector<void *> evicted;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      evict_locked(target, evicted);
+    }
+    for (void *block : evicted) {
+      system_free(block);
+    }
+  }
+
+  std::size_t limit() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return limit_;
+  }
+
+  void set_limit(std::size_t limit) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      limit_ = limit;
+      g_enabled.store(limit > 0, std::memory_order_relaxed);
+    }
+    trim(limit);
+  }
+
+private:
+  // Frees the largest idle blocks until at most `target` bytes stay cached.
+  void evict_locked(std::size_t target, std::vector<void *> &evicted) {
+    for (int cls = kNumClasses - 1; cls >= 0 && cached_ > target; --cls) {
+      auto &bin = bins_[cls];
+      while (!bin.empty() && cached_ > target) {
+        evicted.push_back(bin.back());
+        bin.pop_back();
+        cached_ -= class_bytes(cls);
+        g_cached.fetch_sub(class_bytes(cls), std::memory_order_relaxed);
+      }
+    }
+  }
+
+  std::mutex mutex_;
+  std::vector<void *> bins_[kNumClasses];
+  std::size_t cached_{0};
+  std::size_t limit_;
+};
+
+// Intentionally leaked: Storage deleters may run during static destruction.
+GlobalCache &global_cache() {
+  static GlobalCache *cache = new GlobalCache(default_cache_limit());
+  return *cache;
+}
+
+enum class CacheState : uint8_t { unused, live, destroyed };
+thread_local CacheState t_cache_state = CacheState::unused;
+
+class ThreadCache {
+public:
+  ThreadCache() { t_cache_state = CacheState::live; }
+  ~ThreadCache() {
+    flush();
+    t_cache_state = CacheState::destroyed;
+  }
+  ThreadCache(const ThreadCache &) = delete;
+  ThreadCache &operator=(const ThreadCache &) = delete;
+
+  void *take(int cls) noexcept {
+    int &count = counts_[cls];
+    if (count == 0) {
+      return nullptr;
+    }
+    g_cached.fetch_sub(class_bytes(cls), std::memory_order_relaxed);
+    return slots_[cls][--count];
+  }
+
+  bool put(int cls, void *ptr) noexcept {
+    int &count = counts_[cls];
+    if (count == kThreadCacheDepth) {
+      return false;
+    }
+    slots_[cls][count++] = ptr;
+    g_cached.fetch_add(class_bytes(cls), std::memory_order_relaxed);
+    return true;
+  }
+
+  void flush() {
+    for (int cls = 0; cls < kThreadClasses; ++cls) {
+      while (void *ptr = take(cls)) {
+        global_cache().put(cls, ptr);
+      }
+    }
+  }
+
+private:
+  void *slots_[kThreadClasses][kThreadCacheDepth]{};
+  int counts_[kThreadClasses]{};
+};
+
+// Null once the calling thread's cache has been torn down at thread exit.
+ThreadCache *thread_cache() {
+  if (t_cache_state == CacheState::destroyed) {
+    return nullptr;
+  }
+  thread_local ThreadCache cache;
+  return &cache;
+}
+
+struct BlockDeleter {
+  int cls; // -1 for blocks that bypass the caches
+  std::size_t bytes;
+
+  void operator()(void *ptr) const noexcept {
+    g_in_use.fetch_sub(bytes, std::memory_order_relaxed);
+    if (cls < 0 || !g_enabled.load(std::memory_order_relaxed)) {
+      system_free(ptr);
+      return;
+    }
+    if (bytes <= kThreadCacheMaxBlock) {
+      ThreadCache *cache = thread_cache();
+      if (cache != nullptr && cache->put(cls, ptr)) {
+        return;
+      }
+    }
+    try {
+      global_cache().put(cls, ptr);
+    } catch (...) {
+      system_free(ptr);
+    }
+  }
+};
+
+void *take_cached(int cls, std::size_t bytes) {
+  if (!g_enabled.load(std::memory_order_relaxed)) {
+    return nullptr;
+  }
+  if (bytes <= kThreadCacheMaxBlock) {
+    if (ThreadCache *cache = thread_cache()) {
+      if (void *ptr = cache->take(cls)) {
+        return ptr;
+      }
+    }
+  }
+  return global_cache().take(cls);
+}
+
+} // namespace
+
+std::shared_ptr<void> allocate_host_block(std::size_t bytes, std::size_t alignment) {
+  if (bytes == 0) {
+    bytes = 1;
+  }
+  if (alignment > kBlockAlignment) {
+    void *ptr = system_allocate(alignment, bytes);
+    if (ptr == nullptr) {
+      throw std::bad_alloc{};
+    }
+    g_misses.fetch_add(1, std::memory_order_relaxed);
+    note_allocated(bytes);
+    return std::shared_ptr<void>(ptr, BlockDeleter{-1, bytes});
+  }
+
+  const int cls = size_class(bytes);
+  const std::size_t block_bytes = class_bytes(cls);
+  void *ptr = take_cached(cls, block_bytes);
+  if (ptr != nullptr) {
+    g_hits.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    ptr = system_allocate(kBlockAlignment, block_bytes);
+    if (ptr == nullptr) {
+      // Idle blocks of other sizes may be what the system is missing.
+      empty_host_cache();
+      ptr = system_allocate(kBlockAlignment, block_bytes);
+      if (ptr == nullptr) {
+        throw std::bad_alloc{};
+      }
+    }
+    g_misses.fetch_add(1, std::memory_order_relaxed);
+  }
+  note_allocated(block_bytes);
+  return std::shared_ptr<void>(ptr, BlockDeleter{cls, block_bytes});
+}
+
+HostAllocatorStats host_allocator_stats() noexcept {
+  HostAllocatorStats stats;
+  stats.hits = g_hits.load(std::memory_order_relaxed);
+  stats.misses = g_misses.load(std::memory_order_relaxed);
+  stats.bytes_in_use = g_in_use.load(std::memory_order_relaxed);
+  stats.peak_bytes_in_use = g_peak.load(std::memory_order_relaxed);
+  stats.bytes_cached = g_cached.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void reset_host_allocator_stats() noexcept {
+  g_hits.store(0, std::memory_order_relaxed);
+  g_misses.store(0, std::memory_order_relaxed);
+  g_peak.store(g_in_use.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+std::size_t host_cache_limit() noexcept {
+  return global_cache().limit();
+}
+
+void set_host_cache_limit(std::size_t bytes) {
+  global_cache().set_limit(bytes);
+  if (bytes == 0) {
+    if (ThreadCache *cache = thread_cache()) {
+      cache->flush();
+    }
+  }
+}
+
+void empty_host_cache() {
+  if (ThreadCache *cache = thread_cache()) {
+    cache->flush();
+  }
+  global_cache().trim(0);
+}
+
+} // namespace Tensor
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Tensor {
+
+struct HostAllocatorStats {
+  uint64_t hits{0};   // requests served from a cache
+  uint64_t misses{0}; // requests that went to the system allocator
+  std::size_t bytes_in_use{0};
+  std::size_t peak_bytes_in_use{0};
+  std::size_t bytes_cached{0}; // idle blocks held by the global and thread caches
+};
+
+// Returns a block of at least `bytes` bytes aligned to `alignment`. When the
+// last shared_ptr reference drops, the block goes back to the caching host
+// allocator instead of the system.
+//
+// Requests are rounded up to size classes (four per power of two, so at most
+// 25% slack). Each thread keeps a small lock-free cache of blocks up to
+// 256 KiB; everything else is pooled in a global cache bounded by
+// host_cache_limit(). When a release would exceed the limit, the largest idle
+// blocks are returned to the system first. Alignments above 64 bytes bypass
+// the caches.
+std::shared_ptr<void> allocate_host_block(std::size_t bytes, std::size_t alignment = 64);
+
+HostAllocatorStats host_allocator_stats() noexcept;
+// Clears the hit/miss counters and restarts peak tracking from the current usage.
+void reset_host_allocator_stats() noexcept;
+
+// Byte limit of the global cache. Defaults to TENSOR_HOST_CACHE_LIMIT_MB
+// (512 MiB when unset); zero disables caching.
+std::size_t host_cache_limit() noexcept;
+void set_host_cache_limit(std::size_t bytes);
+
+// Releases every idle block in the global cache and the calling thread's cache.
+void empty_host_cache();
+
+} // namespace Tensor
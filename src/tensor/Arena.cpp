@@ -0,0 +1,183 @@
+#include "tensor/Arena.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace Tensor {
+
+namespace {
+
+constexpr std::size_t kChunkBytes = std::size_t{1} << 20;
+constexpr std::size_t kMaxStepBlock = kChunkBytes / 4;
+constexpr std::size_t kChunkAlignment = 64;
+constexpr std::size_t kObjectHeader = alignof(std::max_align_t);
+
+struct ArenaChunk {
+  // One reference per live allocation plus one while the owning arena keeps
+  // the chunk on its list.
+  std::atomic<int64_t> refs{1};
+  std::size_t capacity{0};
+  std::size_t used{0};
+  std::byte *data{nullptr};
+};
+
+ArenaChunk *new_chunk(std::size_t capacity) {
+  auto *chunk = new ArenaChunk;
+  chunk->capacity = capacity;
+  chunk->data = static_cast<std::byte *>(
+      ::operator new(capacity, std::align_val_t{kChunkAlignment}));
+  return chunk;
+}
+
+void release_chunk(ArenaChunk *chunk) noexcept {
+  if (chunk->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    ::operator delete(chunk->data, std::align_val_t{kChunkAlignment});
+    delete chunk;
+  }
+}
+
+class ThreadArena {
+public:
+  ~ThreadArena() {
+    for (ArenaChunk *chunk : chunks_) {
+      release_chunk(chunk);
+    }
+  }
+
+  int depth{0};
+
+  // Bumps `bytes` out of the current chunk, moving on to the next one (or a
+  // fresh one) when it does not fit.
+  void *allocate(std::size_t bytes, std::size_t alignment, ArenaChunk *&owner) {
+    while (current_ < chunks_.size()) {
+      ArenaChunk *chunk = chunks_[current_];
+      const std::size_t offset = (chunk->used + alignment - 1) & ~(alignment - 1);
+      if (offset + bytes <= chunk->capacity) {
+        chunk->used = offset + bytes;
+        chunk->refs.fetch_add(1, std::memory_order_relaxed);
+        owner = chunk;
+        return chunk->data + offset;
+      }
+      ++current_;
+    }
+    chunks_.push_back(new_chunk(std::max(kChunkBytes, bytes)));
+    current_ = chunks_.size() - 1;
+    ArenaChunk *chunk = chunks_.back();
+    chunk->used = bytes;
+    chunk->refs.fetch_add(1, std::memory_order_relaxed);
+    owner = chunk;
+    return chunk->data;
+  }
+
+  // Rewinds idle chunks the step touched, detaches chunks that still back live
+  // allocations, and frees chunks the step never reached.
+  void rewind() noexcept {
+    std::vector<ArenaChunk *> kept;
+    kept.reserve(chunks_.size());
+    for (std::size_t index = 0; index < chunks_.size(); ++index) {
+      ArenaChunk *chunk = chunks_[index];
+      const bool touched = index <= current_ && chunk->used > 0;
+      if (chunk->refs.load(std::memory_order_acquire) == 1 && (touched || kept.empty())) {
+        chunk->used = 0;
+        kept.push_back(chunk);
+      } else {
+        release_chunk(chunk);
+      }
+    }
+    chunks_.swap(kept);
+    current_ = 0;
+  }
+
+  std::size_t reserved_bytes() const noexcept {
+    std::size_t total = 0;
+    for (const ArenaChunk *chunk : chunks_) {
+      total += chunk->capacity;
+    }
+    return total;
+  }
+
+private:
+  std::vector<ArenaChunk *> chunks_;
+  std::size_t current_{0};
+};
+
+ThreadArena &thread_arena() {
+  thread_local ThreadArena arena;
+  return arena;
+}
+
+struct StepBlockDeleter {
+  ArenaChunk *chunk;
+  void operator()(void *) const noexcept { release_chunk(chunk); }
+};
+
+} // namespace
+
+StepArena::StepArena() noexcept {
+  ++thread_arena().depth;
+}
+
+StepArena::~StepArena() {
+  ThreadArena &arena = thread_arena();
+  if (--arena.depth == 0) {
+    arena.rewind();
+  }
+}
+
+ArenaSuspendGuard::ArenaSuspendGuard() noexcept : saved_depth_(thread_arena().depth) {
+  thread_arena().depth = 0;
+}
+
+ArenaSuspendGuard::~ArenaSuspendGuard() {
+  thread_arena().depth = saved_depth_;
+}
+
+bool step_arena_active() noexcept {
+  return thread_arena().depth > 0;
+}
+
+std::size_t step_arena_reserved_bytes() noexcept {
+  return thread_arena().reserved_bytes();
+}
+
+std::shared_ptr<void> allocate_step_block(std::size_t bytes, std::size_t alignment) {
+  ThreadArena &arena = thread_arena();
+  if (arena.depth == 0 || bytes > kMaxStepBlock || alignment > kChunkAlignment) {
+    return {};
+  }
+  ArenaChunk *chunk = nullptr;
+  void *ptr = arena.allocate(bytes, alignment, chunk);
+  return std::shared_ptr<void>(ptr, StepBlockDeleter{chunk}, ArenaAllocator<char>{});
+}
+
+namespace detail {
+
+// Object blocks carry a header naming their chunk; heap fallbacks store null.
+void *arena_allocate_object(std::size_t bytes) {
+  ThreadArena &arena = thread_arena();
+  std::byte *base = nullptr;
+  ArenaChunk *chunk = nullptr;
+  if (arena.depth > 0 && bytes <= kMaxStepBlock) {
+    base = static_cast<std::byte *>(arena.allocate(bytes + kObjectHeader, kObjectHeader, chunk));
+  } else {
+    base = static_cast<std::byte *>(::operator new(bytes + kObjectHeader));
+  }
+  *reinterpret_cast<ArenaChunk **>(base) = chunk;
+  return base + kObjectHeader;
+}
+
+void arena_deallocate_object(void *ptr) noexcept {
+  std::byte *base = static_cast<std::byte *>(ptr) - kObjectHeader;
+  ArenaChunk *chunk = *reinterpret_cast<ArenaChunk **>(base);
+  if (chunk == nullptr) {
+    ::operator delete(base);
+  } else {
+    release_chunk(chunk);
+  }
+}
+
+} // namespace detail
+
+} // namespace Tensor
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace Tensor {
+
+// Opt-in bump allocation scope for one training step. While a StepArena is
+// alive on a thread, tensor storage up to 256 KiB, tensor metadata and
+// autograd nodes created on that thread are carved out of thread-local chunks
+// instead of the heap:
+//
+//   for (...) {
+//     StepArena arena;
+//     auto loss = ops::mse_loss(model.forward(x), y);
+//     ops::backward(loss);
+//     optimizer.step(params);
+//   }
+//
+// When the outermost guard ends, chunks with no live allocations are rewound
+// for the next step in one shot. Anything that escapes the step keeps its chunk
+// alive (each allocation holds a reference on it), so results stay valid; that
+// chunk is simply not reused. Leaf gradients are allocated outside the arena.
+// Guards nest; only the outermost one rewinds.
+class StepArena {
+public:
+  StepArena() noexcept;
+  ~StepArena();
+  StepArena(const StepArena &) = delete;
+  StepArena &operator=(const StepArena &) = delete;
+};
+
+// Routes allocations on the calling thread back to the heap for its lifetime,
+// for state that must outlive the current step.
+class ArenaSuspendGuard {
+public:
+  ArenaSuspendGuard() noexcept;
+  ~ArenaSuspendGuard();
+  ArenaSuspendGuard(const ArenaSuspendGuard &) = delete;
+  ArenaSuspendGuard &operator=(const ArenaSuspendGuard &) = delete;
+
+private:
+  int saved_depth_;
+};
+
+// True while a StepArena is collecting allocations on the calling thread.
+bool step_arena_active() noexcept;
+
+// Bytes currently reserved by the calling thread's arena chunks.
+std::size_t step_arena_reserved_bytes() noexcept;
+
+// Returns a block from the calling thread's arena, or an empty pointer when no
+// arena is active or the request is too large or over-aligned for it.
+std::shared_ptr<void> allocate_step_block(std::size_t bytes, std::size_t alignment);
+
+namespace detail {
+
+void *arena_allocate_object(std::size_t bytes);
+void arena_deallocate_object(void *ptr) noexcept;
+
+} // namespace detail
+
+// Stateless allocator for objects placed by allocate_shared. Every block
+// records where it came from, so it can be released on any thread, after the
+// arena scope has ended, or when it had to fall back to the heap.
+template <typename T> class ArenaAllocator {
+public:
+  using value_type = T;
+
+  ArenaAllocator() noexcept = default;
+  template <typename U> ArenaAllocator(const ArenaAllocator<U> &) noexcept {}
+
+  T *allocate(std::size_t count) {
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "arena objects are at most max_align_t aligned");
+    return static_cast<T *>(detail::arena_allocate_object(count * sizeof(T)));
+  }
+  void deallocate(T *ptr, std::size_t) noexcept { detail::arena_deallocate_object(ptr); }
+
+  template <typename U> bool operator==(const ArenaAllocator<U> &) const noexcept {
+    return true;
+  }
+};
+
+// std::make_shared that places the object and its control block in the
+// calling thread's arena when one is active.
+template <typename T, typename... Args> std::shared_ptr<T> make_arena_shared(Args &&...args) {
+  if (!step_arena_active()) {
+    return std::make_shared<T>(std::forward<Args>(args)...);
+  }
+  return std::allocate_shared<T>(ArenaAllocator<T>{}, std::forward<Args>(args)...);
+}
+
+} // namespace Tensor
@@ -0,0 +1,273 @@
+#include "tensor/Autograd.hpp"
+
+#include "tensor/Arena.hpp"
+#include "tensor/Ops.hpp"
+#include "tensor/Parallel.hpp"
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Tensor {
+
+namespace {
+
+struct NodeTask {
+  int dependencies{0};
+  DTensor grad{};
+  // The first contribution may be shared with another consumer, so it is only
+  // added into once the engine has made its own copy.
+  bool owns_grad{false};
+};
+
+using TaskMap = std::unordered_map<AutogradNode *, NodeTask>;
+
+std::atomic<bool> g_parallel_backward{true};
+thread_local bool t_grad_mode = true;
+thread_local bool t_inference_mode = false;
+
+// Leaves can be shared by graphs that run backward on different threads, so
+// their grad slots are guarded by a small set of striped locks.
+std::mutex &leaf_mutex(const TensorAutogradState *state) {
+  static std::array<std::mutex, 64> mutexes;
+  return mutexes[std::hash<const void *>{}(state) % mutexes.size()];
+}
+
+AutogradNode *next_node(const AutogradEdge &edge) {
+  return edge_requires_grad(edge) ? edge->grad_fn.get() : nullptr;
+}
+
+void accumulate_into(NodeTask &task, DTensor grad) {
+  if (!task.grad.defined()) {
+    task.grad = std::move(grad);
+  } else if (!task.owns_grad) {
+    task.grad = ops::add(task.grad, grad);
+    task.owns_grad = true;
+  } else {
+    ops::add_(task.grad, grad);
+  }
+}
+
+void accumulate_leaf(TensorAutogradState &leaf, const DTensor &grad) {
+  std::lock_guard<std::mutex> lock(leaf_mutex(&leaf));
+  if (leaf.grad) {
+    ops::add_(*leaf.grad, grad);
+    return;
+  }
+  // Leaf gradients outlive the step, so they never come from its arena.
+  ArenaSuspendGuard heap_only;
+  leaf.grad = std::make_shared<DTensor>(ops::clone(grad));
+}
+
+// Counts, for every node reachable from `root`, how many edges of the graph
+// lead into it.
+TaskMap count_dependencies(AutogradNode *root) {
+  TaskMap tasks;
+  tasks.try_emplace(root);
+  std::vector<AutogradNode *> pending{root};
+  while (!pending.empty()) {
+    AutogradNode *node = pending.back();
+    pending.pop_back();
+    for (std::size_t index = 0; index < node->num_inputs(); ++index) {
+      AutogradNode *child = next_node(node->input(index));
+      if (child == nullptr) {
+        continue;
+      }
+      auto [it, inserted] = tasks.try_emplace(child);
+      ++it->second.dependencies;
+      if (inserted) {
+        pending.push_back(child);
+      }
+    }
+  }
+  return tasks;
+}
+
+// Hands the gradients a node produced to its inputs: summed into the buffers of
+// the nodes behind them, or accumulated into leaves.
+void route_gradients(AutogradNode *node, std::vector<DTensor> &grads, TaskMap &tasks,
+                     std::vector<AutogradNode *> &ready) {
+  // Every edge is released even when it carries no gradient, so consumers
+  // further down still become ready.
+  for (std::size_t index = 0; index < grads.size(); ++index) {
+    const AutogradEdge &edge = node->input(index);
+    if (!edge_requires_grad(edge)) {
+      continue;
+    }
+    if (AutogradNode *child = next_node(edge)) {
+      NodeTask &task = tasks.at(child);
+      if (grads[index].defined()) {
+        accumulate_into(task, std::move(grads[index]));
+      }
+      if (--task.dependencies == 0) {
+        ready.push_back(child);
+      }
+    } else if (grads[index].defined()) {
+      accumulate_leaf(*edge, grads[index]);
+    }
+  }
+}
+
+// Keeps a segment's inputs and function; backward rebuilds the segment's graph
+// on fresh handles to the inputs and runs it to recover their gradients.
+struct CheckpointBackward final : AutogradNode {
+  CheckpointBackward(CheckpointFunction fn_in, const std::vector<DTensor> &inputs_in)
+      : fn(std::move(fn_in)), inputs(inputs_in) {
+    edges.reserve(inputs.size());
+    versions.reserve(inputs.size());
+    for (const DTensor &input : inputs) {
+      edges.push_back(input.autograd_state());
+      versions.push_back(input.version());
+    }
+  }
+
+  std::size_t num_inputs() const noexcept override { return edges.size(); }
+  const AutogradEdge &input(std::size_t index) const noexcept override { return edges[index]; }
+
+  void backward(const DTensor &upstream, std::vector<DTensor> &grads) override {
+    GradModeGuard recording(true);
+    std::vector<DTensor> replay;
+    replay.reserve(inputs.size());
+    for (std::size_t index = 0; index < inputs.size(); ++index) {
+      const DTensor &input = inputs[index];
+      if (input.version() != versions[index]) {
+        throw std::runtime_error(
+            "checkpoint backward: a segment input was modified by an in-place op");
+      }
+      replay.emplace_back(input.storage(), input.shape(), input.stride(), input.offset(),
+                          input.dtype(), input.is_contiguous(), edge_requires_grad(edges[index]));
+    }
+
+    const DTensor output = fn(replay);
+    if (output.shape() != upstream.shape()) {
+      throw std::runtime_error("checkpoint backward: the segment's output shape changed");
+    }
+    run_backward(output, upstream);
+    for (std::size_t index = 0; index < replay.size(); ++index) {
+      if (auto grad = replay[index].grad()) {
+        grads[index] = std::move(*grad);
+      }
+    }
+  }
+
+  CheckpointFunction fn;
+  std::vector<DTensor> inputs;
+  std::vector<AutogradEdge> edges;
+  std::vector<uint64_t> versions;
+};
+
+} // namespace
+
+bool grad_mode_enabled() noexcept {
+  return t_grad_mode;
+}
+
+GradModeGuard::GradModeGuard(bool enabled) noexcept : previous_(t_grad_mode) {
+  t_grad_mode = enabled;
+}
+
+GradModeGuard::~GradModeGuard() {
+  t_grad_mode = previous_;
+}
+
+bool inference_mode_enabled() noexcept {
+  return t_inference_mode;
+}
+
+InferenceMode::InferenceMode() noexcept : no_grad_(false), previous_(t_inference_mode) {
+  t_inference_mode = true;
+}
+
+InferenceMode::~InferenceMode() {
+  t_inference_mode = previous_;
+}
+
+void set_parallel_backward(bool enabled) noexcept {
+  g_parallel_backward.store(enabled, std::memory_order_relaxed);
+}
+
+bool parallel_backward_enabled() noexcept {
+  return g_parallel_backward.load(std::memory_order_relaxed);
+}
+
+void run_backward(const DTensor &root, const DTensor &grad) {
+  if (!root.requires_grad()) {
+    return;
+  }
+  require_current_history(root);
+  const auto root_fn = root.grad_fn();
+  if (!root_fn) {
+    accumulate_leaf(*root.autograd_state(), grad);
+    return;
+  }
+
+  TaskMap tasks = count_dependencies(root_fn.get());
+  tasks.at(root_fn.get()).grad = grad;
+  std::vector<AutogradNode *> ready{root_fn.get()};
+  std::vector<AutogradNode *> wave;
+  std::vector<DTensor> upstreams;
+  std::vector<std::vector<DTensor>> wave_grads;
+  const bool parallel = parallel_backward_enabled();
+  while (!ready.empty()) {
+    // A wave is every node that is ready right now, or just the most recent
+    // one when running serially.
+    const std::size_t count = parallel ? ready.size() : 1;
+    wave.assign(ready.end() - static_cast<std::ptrdiff_t>(count), ready.end());
+    ready.resize(ready.size() - count);
+
+    upstreams.resize(count);
+    wave_grads.resize(count);
+    for (std::size_t slot = 0; slot < count; ++slot) {
+      // Moving the buffer out frees it as soon as the node has run.
+      upstreams[slot] = std::move(tasks.at(wave[slot]).grad);
+      wave_grads[slot].assign(wave[slot]->num_inputs(), DTensor{});
+    }
+
+    // Nodes of one wave are independent. Each runs on a pool thread (its own
+    // kernels then stay on that thread); a single ready node runs on the
+    // caller and keeps intra-op parallelism.
+    parallel_for(0, static_cast<int64_t>(count), 1, [&](int64_t begin, int64_t end) {
+      for (int64_t slot = begin; slot < end; ++slot) {
+        const auto index = static_cast<std::size_t>(slot);
+        if (upstreams[index].defined()) {
+          wave[index]->backward(upstreams[index], wave_grads[index]);
+        }
+        upstreams[index] = DTensor{};
+      }
+    });
+
+    // Routing stays on the caller and in wave order, so buffer sums do not
+    // depend on thread timing.
+    for (std::size_t slot = 0; slot < count; ++slot) {
+      route_gradients(wave[slot], wave_grads[slot], tasks, ready);
+    }
+  }
+}
+
+DTensor checkpoint(const CheckpointFunction &fn, const std::vector<DTensor> &inputs) {
+  if (!grad_mode_enabled()) {
+    return fn(inputs);
+  }
+  for (const DTensor &input : inputs) {
+    require_current_history(input);
+  }
+  DTensor output;
+  {
+    NoGradGuard no_grad;
+    output = fn(inputs);
+  }
+  // Parameters the segment captures are invisible here, so the output is
+  // recorded even when none of `inputs` requires grad.
+  DTensor result(output.storage(), output.shape(), output.stride(), output.offset(),
+                 output.dtype(), output.is_contiguous(), true);
+  result.set_grad_fn(make_arena_shared<CheckpointBackward>(fn, inputs));
+  return result;
+}
+
+} // namespace Tensor
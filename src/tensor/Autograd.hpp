@@ -0,0 +1,81 @@
+#pragma once
+
+#include "tensor/Tensor.hpp"
+
+#include <functional>
+#include <vector>
+
+namespace Tensor {
+
+// Backpropagates `grad` from `root` through its autograd graph. Nodes are
+// counted against their consumers first and then executed from a ready queue
+// in topological order, so every node fires once with the sum of all incoming
+// gradients, and deep graphs never recurse. Leaves that require grad
+// accumulate into their grad() as contributions arrive, under a lock, so
+// graphs sharing parameters may run backward on different threads.
+//
+// With parallel backward enabled, all nodes that are ready at the same time
+// run as one wave on the intra-op pool; gradients are then routed on the
+// calling thread in wave order, so results do not depend on thread timing.
+void run_backward(const DTensor &root, const DTensor &grad);
+
+// Defaults to enabled. Disabling it runs one node at a time on the caller.
+void set_parallel_backward(bool enabled) noexcept;
+bool parallel_backward_enabled() noexcept;
+
+// Whether ops on the calling thread record autograd history. Enabled by
+// default; with it disabled, ops produce plain tensors that do not require
+// grad and in-place ops may write to leaves.
+bool grad_mode_enabled() noexcept;
+
+// Sets the calling thread's grad mode for the guard's lifetime.
+class GradModeGuard {
+public:
+  explicit GradModeGuard(bool enabled) noexcept;
+  ~GradModeGuard();
+  GradModeGuard(const GradModeGuard &) = delete;
+  GradModeGuard &operator=(const GradModeGuard &) = delete;
+
+private:
+  bool previous_;
+};
+
+class NoGradGuard : public GradModeGuard {
+public:
+  NoGradGuard() noexcept : GradModeGuard(false) {}
+};
+
+// Disables grad mode and, beyond NoGradGuard, the autograd bookkeeping of the
+// tensors created in its scope: their storages are marked as inference (see
+// DTensor::is_inference) and they are built without an autograd state. Use it
+// for forward passes whose results never take part in training; in-place ops
+// that would record history on such a tensor outside the scope throw.
+class InferenceMode {
+public:
+  InferenceMode() noexcept;
+  ~InferenceMode();
+  InferenceMode(const InferenceMode &) = delete;
+  InferenceMode &operator=(const InferenceMode &) = delete;
+
+private:
+  GradModeGuard no_grad_;
+  bool previous_;
+};
+
+using CheckpointFunction = std::function<DTensor(const std::vector<DTensor> &)>;
+
+// Runs `fn(inputs)` without recording history and returns its output attached
+// to a single node that keeps only `inputs` (and `fn`). During backward the
+// node re-runs `fn` with grad enabled to rebuild the segment's intermediates,
+// backpropagates through them, and hands the input gradients on. Tensors the
+// segment reads besides `inputs`, such as the parameters of captured layers,
+// receive their gradients from that nested pass.
+//
+//   hidden = checkpoint([&](const auto &in) { return block.forward(in[0]); }, {hidden});
+//
+// `fn` must be deterministic for the gradients to match an uncheckpointed run,
+// and `inputs` must not be modified in place before backward. With grad mode
+// disabled this is just fn(inputs).
+DTensor checkpoint(const CheckpointFunction &fn, const std::vector<DTensor> &inputs);
+
+} // namespace Tensor
@@ -0,0 +1,185 @@
+#include "tensor/Batching.hpp"
+
+#include "api/Api.hpp"
+#include "tensor/Autograd.hpp"
+
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Tensor::nn {
+
+using Clock = std::chrono::steady_clock;
+
+struct LinearBatcher::Request : MpscNode {
+  DTensor row;
+  std::promise<DTensor> result;
+  Clock::time_point submitted;
+};
+
+namespace {
+
+// The worker polls for more rows for kSpinWindow after each row joins a batch
+// and for the last kWakeEarly before its deadline, and sleeps otherwise. Timed
+// waits can overshoot by tens of microseconds (Linux timer slack is 50 us by
+// default), so the final stretch is polled to close batches on time, while a
+// long max_delay no longer keeps a core busy.
+constexpr auto kSpinWindow = std::chrono::microseconds{20};
+constexpr auto kWakeEarly = std::chrono::microseconds{60};
+
+// Row `index` of a contiguous {rows, width} tensor, shaped like `shape`.
+DTensor row_view(const DTensor &matrix, int64_t index, const Dims &shape) {
+  return DTensor(matrix.storage(), shape, default_strides(shape),
+                 matrix.offset() + index * matrix.shape()[1], matrix.dtype(), true);
+}
+
+} // namespace
+
+LinearBatcher::LinearBatcher(const Linear &linear, BatchingOptions options,
+                             ops::Activation activation)
+    : linear_(linear), options_(options), activation_(activation) {
+  if (options_.max_batch_size < 1) {
+    throw std::invalid_argument("LinearBatcher requires a positive max_batch_size");
+  }
+  if (options_.max_delay.count() < 0) {
+    throw std::invalid_argument("LinearBatcher requires a non-negative max_delay");
+  }
+  worker_ = std::thread([this] { run(); });
+}
+
+LinearBatcher::~LinearBatcher() {
+  stopping_.store(true, std::memory_order_release);
+  wake_worker();
+  worker_.join();
+}
+
+std::future<DTensor> LinearBatcher::submit(DTensor row) {
+  const int64_t in_features = linear_.weight().shape()[0];
+  if (row.dtype() != linear_.weight().dtype()) {
+    throw std::invalid_argument("LinearBatcher row dtype must match the layer");
+  }
+  const bool single_row = row.rank() == 1 || (row.rank() == 2 && row.shape()[0] == 1);
+  if (!single_row || row.shape().back() != in_features) {
+    throw std::invalid_argument("LinearBatcher expects one row of in_features values");
+  }
+  if (stopping_.load(std::memory_order_acquire)) {
+    throw std::runtime_error("LinearBatcher is shutting down");
+  }
+
+  auto request = std::make_unique<Request>();
+  request->row = std::move(row);
+  request->submitted = Clock::now();
+  std::future<DTensor> result = request->result.get_future();
+  queue_.push(request.release());
+  wake_worker();
+  return result;
+}
+
+BatchingStats LinearBatcher::stats() const noexcept {
+  return {batches_.load(std::memory_order_relaxed), rows_.load(std::memory_order_relaxed)};
+}
+
+// wake_ and sleeping_ are sequentially consistent: either the producer sees
+// the worker going to sleep and notifies it under the mutex, or the worker
+// sees the new wake_ value before it waits.
+void LinearBatcher::wake_worker() {
+  wake_.fetch_add(1);
+  if (sleeping_.load()) {
+    { std::lock_guard lock(wake_mutex_); }
+    wake_cv_.notify_one();
+  }
+}
+
+// Returns once wake_ has moved past `seen`, on shutdown, or at `deadline`
+// (Clock::time_point::max() for none).
+void LinearBatcher::sleep_until_woken(uint32_t seen, Clock::time_point deadline) {
+  std::unique_lock lock(wake_mutex_);
+  sleeping_.store(true);
+  const auto woken = [&] {
+    return wake_.load() != seen || stopping_.load(std::memory_order_acquire);
+  };
+  if (deadline == Clock::time_point::max()) {
+    wake_cv_.wait(lock, woken);
+  } else {
+    wake_cv_.wait_until(lock, deadline, woken);
+  }
+  sleeping_.store(false);
+}
+
+void LinearBatcher::run() {
+  InferenceMode inference;
+  const auto max_batch = static_cast<std::size_t>(options_.max_batch_size);
+  std::vector<Request *> batch;
+  batch.reserve(max_batch);
+  const auto pop = [this]() { return static_cast<Request *>(queue_.pop()); };
+
+  for (;;) {
+    // Read before popping: a push that pop() misses bumps it afterwards, so
+    // the wait below returns at once instead of sleeping through the row.
+    const uint32_t seen = wake_.load();
+    if (Request *first = pop()) {
+      batch.push_back(first);
+    } else if (stopping_.load(std::memory_order_acquire)) {
+      return;
+    } else {
+      sleep_until_woken(seen, Clock::time_point::max());
+      continue;
+    }
+
+    const Clock::time_point deadline = batch.front()->submitted + options_.max_delay;
+    const Clock::time_point wake_at = deadline - kWakeEarly;
+    Clock::time_point spin_end = Clock::now() + kSpinWindow;
+    while (batch.size() < max_batch) {
+      const uint32_t filling = wake_.load();
+      if (Request *next = pop()) {
+        batch.push_back(next);
+        spin_end = Clock::now() + kSpinWindow;
+        continue;
+      }
+      const Clock::time_point now = Clock::now();
+      if (now >= deadline || stopping_.load(std::memory_order_acquire)) {
+        break;
+      }
+      if (now < spin_end || now >= wake_at) {
+        std::this_thread::yield();
+      } else {
+        sleep_until_woken(filling, wake_at);
+      }
+    }
+
+    run_batch(batch.data(), static_cast<int64_t>(batch.size()));
+    for (Request *request : batch) {
+      delete request;
+    }
+    batch.clear();
+  }
+}
+
+void LinearBatcher::run_batch(Request **requests, int64_t count) {
+  batches_.fetch_add(1, std::memory_order_relaxed);
+  rows_.fetch_add(static_cast<uint64_t>(count), std::memory_order_relaxed);
+  const int64_t in_features = linear_.weight().shape()[0];
+  int64_t served = 0;
+  try {
+    DTensor input = api::empty({count, in_features}, linear_.weight().dtype());
+    for (int64_t index = 0; index < count; ++index) {
+      const DTensor &row = requests[index]->row;
+      DTensor slot = row_view(input, index, row.shape());
+      ops::copy(row, slot);
+    }
+    const DTensor output = linear_.forward(input, activation_);
+    for (; served < count; ++served) {
+      Dims shape = requests[served]->row.shape();
+      shape.back() = output.shape()[1];
+      requests[served]->result.set_value(row_view(output, served, shape));
+    }
+  } catch (...) {
+    for (; served < count; ++served) {
+      requests[served]->result.set_exception(std::current_exception());
+    }
+  }
+}
+
+} // namespace Tensor::nn
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Linear.hpp"
+#include "MpscQueue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace Tensor::nn {
+
+struct BatchingOptions {
+  // Rows coalesced into one forward at most.
+  int64_t max_batch_size{64};
+  // How long the oldest queued row may wait for others to join its batch.
+  std::chrono::microseconds max_delay{200};
+};
+
+struct BatchingStats {
+  uint64_t batches{0};
+  uint64_t rows{0};
+};
+
+// Serves single-row Linear forwards from many threads as batched GEMMs.
+// submit() queues a row without taking a lock (it only touches a mutex to
+// wake a sleeping worker) and returns a future; a worker thread stacks the
+// queued rows into one {B, in_features} input, runs the forward once under
+// InferenceMode and hands each caller its row of the output. A batch runs
+// once it holds max_batch_size rows or its oldest row has waited max_delay,
+// whichever comes first.
+//
+// The batcher holds its own handles on the layer's parameters, so updates made
+// through the original Linear are seen by later batches. Results are views
+// into the batch output and carry no autograd history.
+class LinearBatcher {
+public:
+  explicit LinearBatcher(const Linear &linear, BatchingOptions options = {},
+                         ops::Activation activation = ops::Activation::identity());
+  // Serves every row already submitted, then stops the worker.
+  ~LinearBatcher();
+  LinearBatcher(const LinearBatcher &) = delete;
+  LinearBatcher &operator=(const LinearBatcher &) = delete;
+
+  // `row` has shape {in_features} or {1, in_features} and the layer's dtype;
+  // the result has the matching {out_features} or {1, out_features} shape.
+  // The row must not be modified until the future is ready.
+  std::future<DTensor> submit(DTensor row);
+
+  BatchingStats stats() const noexcept;
+
+private:
+  struct Request;
+
+  void run();
+  void run_batch(Request **requests, int64_t count);
+  void wake_worker();
+  void sleep_until_woken(uint32_t seen, std::chrono::steady_clock::time_point deadline);
+
+  Linear linear_;
+  BatchingOptions options_;
+  ops::Activation activation_;
+  MpscQueue queue_;
+  // Bumped after every push and on shutdown. The worker sleeps on wake_cv_
+  // until it moves, and producers only notify while sleeping_ is set.
+  std::atomic<uint32_t> wake_{0};
+  std::atomic<bool> sleeping_{false};
+  std::mutex wake_mutex_;
+  std::condition_variable wake_cv_;
+  std::atomic<bool> stopping_{false};
+  std::atomic<uint64_t> batches_{0};
+  std::atomic<uint64_t> rows_{0};
+  std::thread worker_;
+};
+
+} // namespace Tensor::nn
@@ -0,0 +1,296 @@
+#include "tensor/DataLoader.hpp"
+
+#include "tensor/Allocator.hpp"
+#include "tensor/MappedFile.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+namespace Tensor {
+
+struct DataLoader::State {
+  // Fixed at construction.
+  std::vector<MappedFile> shards;
+  std::vector<int64_t> shard_begin; // first global row of each shard, then the total
+  int64_t features{0};
+  std::size_t row_bytes{0};
+  DataLoaderOptions options;
+  int64_t batches{0};
+  std::vector<std::shared_ptr<void>> buffers;
+
+  std::mutex mutex;
+  // Workers wait for a batch to claim and a free buffer to fill.
+  std::condition_variable work;
+  // next() waits for its batch to land or for a buffer to come back.
+  std::condition_variable landed;
+  std::vector<unsigned char *> free;
+  // Global row ids in serving order; null means in order.
+  std::shared_ptr<const std::vector<int64_t>> order;
+  // Bumped by start_epoch so batches of an earlier epoch are dropped.
+  uint64_t generation{0};
+  int64_t epoch{-1};
+  int64_t next_claim{0};
+  int64_t next_yield{0};
+  std::map<int64_t, DTensor> ready;
+  bool stopping{false};
+
+  int64_t rows() const noexcept { return shard_begin.back(); }
+
+  int64_t batch_rows(int64_t index) const noexcept {
+    return std::min(options.batch_size, rows() - index * options.batch_size);
+  }
+
+  // Copies batch `index`'s rows into `buffer`.
+  void gather(const std::vector<int64_t> *serving, int64_t index, unsigned char *buffer) const {
+    const int64_t first = index * options.batch_size;
+    const int64_t count = batch_rows(index);
+    for (int64_t slot = 0; slot < count; ++slot) {
+      const int64_t row = serving != nullptr ? (*serving)[first + slot] : first + slot;
+      const auto shard = static_cast<std::size_t>(
+          std::upper_bound(shard_begin.begin(), shard_begin.end(), row) - shard_begin.begin() - 1);
+      const auto local = static_cast<std::size_t>(row - shard_begin[shard]);
+      std::memcpy(buffer + static_cast<std::size_t>(slot) * row_bytes,
+                  shards[shard].bytes + local * row_bytes, row_bytes);
+    }
+  }
+
+  DTensor wrap(std::shared_ptr<Storage> storage, int64_t index) const {
+    return DTensor(std::move(storage), {batch_rows(index), features}, {features, 1}, 0,
+                   options.dtype, true);
+  }
+
+  void give_back(unsigned char *buffer) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      free.push_back(buffer);
+    }
+    work.notify_one();
+    landed.notify_one();
+  }
+};
+
+namespace {
+
+// Batch `index` assembled into a pooled `buffer`, which returns to the pool
+// when the last tensor over it goes away.
+template <typename State>
+DTensor pooled_batch(const std::shared_ptr<State> &state,
+                     const std::vector<int64_t> *serving, int64_t index, unsigned char *buffer) {
+  state->gather(serving, index, buffer);
+  std::shared_ptr<void> block(buffer, [state](void *p) {
+    state->give_back(static_cast<unsigned char *>(p));
+  });
+  const std::size_t bytes = static_cast<std::size_t>(state->options.batch_size) * state->row_bytes;
+  return state->wrap(std::make_shared<Storage>(std::move(block), bytes, 64), index);
+}
+
+template <typename State>
+void run_worker(const std::shared_ptr<State> &state) {
+  for (;;) {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->work.wait(lock, [&] {
+      return state->stopping || (state->next_claim < state->batches && !state->free.empty());
+    });
+    if (state->stopping) {
+      return;
+    }
+    const int64_t index = state->next_claim++;
+    unsigned char *buffer = state->free.back();
+    state->free.pop_back();
+    const auto serving = state->order;
+    const uint64_t generation = state->generation;
+    lock.unlock();
+
+    DTensor batch = pooled_batch(state, serving.get(), index, buffer);
+    lock.lock();
+    if (generation == state->generation) {
+      state->ready.emplace(index, std::move(batch));
+      lock.unlock();
+      state->landed.notify_one();
+    } else {
+      // A stale batch; dropping it returns the buffer, which takes the lock.
+      lock.unlock();
+      batch = DTensor();
+    }
+  }
+}
+
+std::vector<int64_t> shuffled_order(const std::vector<int64_t> &shard_begin, Shuffle shuffle,
+                                    uint64_t seed, int64_t epoch) {
+  std::seed_seq sequence{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32),
+                         static_cast<uint32_t>(epoch), static_cast<uint32_t>(epoch >> 32)};
+  std::mt19937_64 generator(sequence);
+  std::vector<int64_t> order(static_cast<std::size_t>(shard_begin.back()));
+  if (shuffle == Shuffle::rows) {
+    std::iota(order.begin(), order.end(), int64_t{0});
+    std::shuffle(order.begin(), order.end(), generator);
+    return order;
+  }
+  std::vector<std::size_t> shards(shard_begin.size() - 1);
+  std::iota(shards.begin(), shards.end(), std::size_t{0});
+  std::shuffle(shards.begin(), shards.end(), generator);
+  auto out = order.begin();
+  for (const std::size_t shard : shards) {
+    const auto begin = out;
+    out = std::generate_n(out, shard_begin[shard + 1] - shard_begin[shard],
+                          [row = shard_begin[shard]]() mutable { return row++; });
+    std::shuffle(begin, out, generator);
+  }
+  return order;
+}
+
+} // namespace
+
+DataLoader::DataLoader(std::vector<std::string> shards, int64_t features,
+                       DataLoaderOptions options)
+    : features_(features), state_(std::make_shared<State>()) {
+  if (features <= 0) {
+    throw std::invalid_argument("DataLoader requires a positive feature count");
+  }
+  if (options.batch_size <= 0 || options.prefetch < 1 || options.num_workers < 0) {
+    throw std::invalid_argument(
+        "DataLoader requires batch_size > 0, prefetch >= 1 and num_workers >= 0");
+  }
+  if (shards.empty()) {
+    throw std::invalid_argument("DataLoader requires at least one shard");
+  }
+
+  State &state = *state_;
+  state.features = features;
+  state.row_bytes = static_cast<std::size_t>(features) * dtype_size(options.dtype);
+  state.options = options;
+  state.shard_begin.push_back(0);
+  for (const auto &path : shards) {
+    MappedFile shard = map_file(path);
+    if (shard.size % state.row_bytes != 0) {
+      throw std::invalid_argument("DataLoader shard " + path +
+                                  " does not hold a whole number of rows");
+    }
+    state.shard_begin.push_back(state.shard_begin.back() +
+                                static_cast<int64_t>(shard.size / state.row_bytes));
+    state.shards.push_back(std::move(shard));
+  }
+  state.batches = options.drop_last
+                      ? state.rows() / options.batch_size
+                      : (state.rows() + options.batch_size - 1) / options.batch_size;
+
+  const std::size_t batch_bytes = static_cast<std::size_t>(options.batch_size) * state.row_bytes;
+  for (int slot = 0; slot <= options.prefetch; ++slot) {
+    state.buffers.push_back(allocate_host_block(batch_bytes, 64));
+    state.free.push_back(static_cast<unsigned char *>(state.buffers.back().get()));
+  }
+  for (int worker = 0; worker < options.num_workers; ++worker) {
+    workers_.emplace_back([state = state_] { run_worker(state); });
+  }
+}
+
+DataLoader::~DataLoader() {
+  // Queued batches hold the state through their buffers; drop them outside
+  // the lock so the state can go once the last outside batch does.
+  std::map<int64_t, DTensor> stale;
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->stopping = true;
+    ++state_->generation;
+    stale.swap(state_->ready);
+  }
+  state_->work.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+int64_t DataLoader::rows() const noexcept {
+  return state_->rows();
+}
+
+int64_t DataLoader::shard_count() const noexcept {
+  return static_cast<int64_t>(state_->shards.size());
+}
+
+int64_t DataLoader::shard_rows(int64_t shard) const {
+  if (shard < 0 || shard >= shard_count()) {
+    throw std::out_of_range("DataLoader shard index out of range");
+  }
+  const auto index = static_cast<std::size_t>(shard);
+  return state_->shard_begin[index + 1] - state_->shard_begin[index];
+}
+
+int64_t DataLoader::batches_per_epoch() const noexcept {
+  return state_->batches;
+}
+
+int64_t DataLoader::epoch() const noexcept {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->epoch;
+}
+
+void DataLoader::start_epoch(int64_t epoch) {
+  if (epoch < 0) {
+    throw std::invalid_argument("DataLoader epochs are non-negative");
+  }
+  State &state = *state_;
+  std::shared_ptr<const std::vector<int64_t>> order;
+  if (state.options.shuffle != Shuffle::none) {
+    order = std::make_shared<const std::vector<int64_t>>(
+        shuffled_order(state.shard_begin, state.options.shuffle, state.options.seed, epoch));
+  }
+  std::map<int64_t, DTensor> stale;
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    stale.swap(state.ready);
+    state.order = std::move(order);
+    ++state.generation;
+    state.epoch = epoch;
+    state.next_claim = 0;
+    state.next_yield = 0;
+  }
+  state.work.notify_all();
+}
+
+DTensor DataLoader::next() {
+  State &state = *state_;
+  std::unique_lock<std::mutex> lock(state.mutex);
+  if (state.epoch < 0) {
+    throw std::runtime_error("DataLoader::next called before start_epoch");
+  }
+  if (state.next_yield >= state.batches) {
+    return {};
+  }
+  const int64_t index = state.next_yield;
+  // Wait for a worker to deliver, unless nobody will: no workers, or every
+  // buffer is still held by the caller.
+  state.landed.wait(lock, [&] {
+    return state.ready.count(index) != 0 ||
+           (state.next_claim == index && (state.free.empty() || workers_.empty()));
+  });
+  ++state.next_yield;
+  if (const auto found = state.ready.find(index); found != state.ready.end()) {
+    DTensor batch = std::move(found->second);
+    state.ready.erase(found);
+    return batch;
+  }
+
+  ++state.next_claim;
+  const auto serving = state.order;
+  if (!state.free.empty()) {
+    unsigned char *buffer = state.free.back();
+    state.free.pop_back();
+    lock.unlock();
+    return pooled_batch(state_, serving.get(), index, buffer);
+  }
+  lock.unlock();
+  auto storage = make_host_storage(static_cast<std::size_t>(state.options.batch_size) *
+                                   state.row_bytes);
+  state.gather(serving.get(), index, static_cast<unsigned char *>(storage->data()));
+  return state.wrap(std::move(storage), index);
+}
+
+} // namespace Tensor
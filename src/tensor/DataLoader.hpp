@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Tensor.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Tensor {
+
+enum class Shuffle : uint8_t {
+  none,          // shards in order, rows in order
+  rows,          // one permutation of every row in the dataset
+  within_shards, // shards in a shuffled order, rows shuffled inside each shard
+};
+
+struct DataLoaderOptions {
+  int64_t batch_size{32};
+  Shuffle shuffle{Shuffle::rows};
+  // Epoch e shuffles with a generator seeded from (seed, e), so reruns and
+  // restarts see the same order.
+  uint64_t seed{0};
+  // Skip the last batch of an epoch when it would be short.
+  bool drop_last{false};
+  DType dtype{DType::f32};
+  // Background threads assembling batches. With zero, next() assembles each
+  // batch on the calling thread.
+  int num_workers{1};
+  // Batches assembled ahead of the one being consumed.
+  int prefetch{2};
+};
+
+// Streams {batch_size, features} batches out of raw shard files, each holding
+// rows of `features` values back to back with no header. Shards are mapped,
+// so rows are paged in on demand, and worker threads gather each batch's rows
+// into one of prefetch + 1 reusable buffers while the caller trains on the
+// previous one:
+//
+//   DataLoader loader(shards, 512, {.batch_size = 256});
+//   for (int64_t epoch = 0; epoch < epochs; ++epoch) {
+//     loader.start_epoch(epoch);
+//     for (DTensor batch = loader.next(); batch.defined(); batch = loader.next()) {
+//       ...
+//     }
+//   }
+//
+// A buffer goes back to the ring once every tensor over the batch is gone, so
+// callers that hold on to more than `prefetch` batches make next() assemble
+// into fresh memory instead. start_epoch and next must be called from one
+// thread at a time.
+class DataLoader {
+public:
+  DataLoader(std::vector<std::string> shards, int64_t features, DataLoaderOptions options = {});
+  ~DataLoader();
+  DataLoader(const DataLoader &) = delete;
+  DataLoader &operator=(const DataLoader &) = delete;
+
+  int64_t features() const noexcept { return features_; }
+  int64_t rows() const noexcept;
+  int64_t shard_count() const noexcept;
+  int64_t shard_rows(int64_t shard) const;
+  int64_t batches_per_epoch() const noexcept;
+  // The epoch being served, or -1 before the first start_epoch.
+  int64_t epoch() const noexcept;
+
+  // Starts serving `epoch` from its first batch, dropping any batches still
+  // queued from the previous one.
+  void start_epoch(int64_t epoch);
+  // The next batch of the current epoch, or an undefined tensor once the
+  // epoch is done. Batches do not require grad.
+  DTensor next();
+
+private:
+  struct State;
+
+  int64_t features_;
+  std::shared_ptr<State> state_;
+  std::vector<std::thread> workers_;
+};
+
+} // namespace Tensor
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace Tensor {
+
+// The sizes or strides of a tensor. Up to kInlineDims values are stored in
+// the object itself, so tensors and views of common ranks carry their layout
+// without a heap allocation; higher ranks spill to a heap buffer.
+class Dims {
+public:
+  static constexpr std::size_t kInlineDims = 6;
+
+  using value_type = int64_t;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = int64_t &;
+  using const_reference = const int64_t &;
+  using pointer = int64_t *;
+  using const_pointer = const int64_t *;
+  using iterator = int64_t *;
+  using const_iterator = const int64_t *;
+
+  Dims() noexcept = default;
+  explicit Dims(std::size_t count, int64_t value = 0) { assign(count, value); }
+  Dims(std::initializer_list<int64_t> values) { assign_range(values.begin(), values.end()); }
+  Dims(const std::vector<int64_t> &values) { assign_range(values.begin(), values.end()); }
+  template <std::input_iterator It> Dims(It first, It last) { assign_range(first, last); }
+
+  Dims(const Dims &other) { assign_range(other.begin(), other.end()); }
+  Dims(Dims &&other) noexcept { take(other); }
+  Dims &operator=(const Dims &other) {
+    if (this != &other) {
+      assign_range(other.begin(), other.end());
+    }
+    return *this;
+  }
+  Dims &operator=(Dims &&other) noexcept {
+    if (this != &other) {
+      heap_.reset();
+      take(other);
+    }
+    return *this;
+  }
+  ~Dims() = default;
+
+  // For code written against the std::vector layouts tensors used to return.
+  operator std::vector<int64_t>() const { return std::vector<int64_t>(begin(), end()); }
+
+  std::size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
+  std::size_t capacity() const noexcept { return heap_ ? capacity_ : kInlineDims; }
+
+  int64_t *data() noexcept { return heap_ ? heap_.get() : inline_; }
+  const int64_t *data() const noexcept { return heap_ ? heap_.get() : inline_; }
+  int64_t &operator[](std::size_t index) noexcept { return data()[index]; }
+  const int64_t &operator[](std::size_t index) const noexcept { return data()[index]; }
+  int64_t &front() noexcept { return data()[0]; }
+  const int64_t &front() const noexcept { return data()[0]; }
+  int64_t &back() noexcept { return data()[size_ - 1]; }
+  const int64_t &back() const noexcept { return data()[size_ - 1]; }
+
+  iterator begin() noexcept { return data(); }
+  iterator end() noexcept { return data() + size_; }
+  const_iterator begin() const noexcept { return data(); }
+  const_iterator end() const noexcept { return data() + size_; }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+  std::reverse_iterator<iterator> rbegin() noexcept { return std::reverse_iterator(end()); }
+  std::reverse_iterator<iterator> rend() noexcept { return std::reverse_iterator(begin()); }
+  std::reverse_iterator<const_iterator> rbegin() const noexcept {
+    return std::reverse_iterator(end());
+  }
+  std::reverse_iterator<const_iterator> rend() const noexcept {
+    return std::reverse_iterator(begin());
+  }
+
+  void reserve(std::size_t count) {
+    if (count > capacity()) {
+      grow(count);
+    }
+  }
+  void clear() noexcept { size_ = 0; }
+  void assign(std::size_t count, int64_t value) {
+    reserve(count);
+    std::fill_n(data(), count, value);
+    size_ = count;
+  }
+  void resize(std::size_t count, int64_t value = 0) {
+    reserve(count);
+    if (count > size_) {
+      std::fill(data() + size_, data() + count, value);
+    }
+    size_ = count;
+  }
+  void push_back(int64_t value) {
+    if (size_ == capacity()) {
+      grow(2 * size_);
+    }
+    data()[size_++] = value;
+  }
+  void pop_back() noexcept { --size_; }
+  iterator insert(const_iterator position, int64_t value) {
+    const auto index = static_cast<std::size_t>(position - begin());
+    push_back(value);
+    std::rotate(begin() + index, end() - 1, end());
+    return begin() + index;
+  }
+  iterator erase(const_iterator position) {
+    const auto index = static_cast<std::size_t>(position - begin());
+    std::copy(begin() + index + 1, end(), begin() + index);
+    --size_;
+    return begin() + index;
+  }
+
+  friend bool operator==(const Dims &lhs, const Dims &rhs) noexcept {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+  }
+
+private:
+  template <typename It> void assign_range(It first, It last) {
+    if constexpr (std::forward_iterator<It>) {
+      size_ = 0;
+      reserve(static_cast<std::size_t>(std::distance(first, last)));
+      size_ = static_cast<std::size_t>(std::copy(first, last, data()) - data());
+    } else {
+      clear();
+      for (; first != last; ++first) {
+        push_back(*first);
+      }
+    }
+  }
+
+  void grow(std::size_t count) {
+    count = std::max(count, 2 * kInlineDims);
+    auto buffer = std::make_unique_for_overwrite<int64_t[]>(count);
+    std::copy_n(data(), size_, buffer.get());
+    heap_ = std::move(buffer);
+    capacity_ = count;
+  }
+
+  void take(Dims &other) noexcept {
+    size_ = other.size_;
+    capacity_ = other.capacity_;
+    if (other.heap_) {
+      heap_ = std::move(other.heap_);
+    } else {
+      std::copy_n(other.inline_, size_, inline_);
+    }
+    other.size_ = 0;
+  }
+
+  std::size_t size_{0};
+  std::size_t capacity_{0};
+  std::unique_ptr<int64_t[]> heap_{};
+  int64_t inline_[kInlineDims];
+};
+
+} // namespace Tensor
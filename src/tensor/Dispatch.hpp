@@ -0,0 +1,36 @@
+#pragma once
+
+#include "tensor/Tensor.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+
+namespace Tensor {
+
+template <typename T> struct TypeTag {
+  using type = T;
+};
+
+// Calls fn(TypeTag<T>{}) with the scalar type stored for `dtype`. Every case
+// instantiates fn separately, so a kernel written against T is compiled (and
+// vectorized) once per dtype and the switch runs once per op, not per element:
+//
+//   dispatch_dtype(tensor.dtype(), [&](auto tag) {
+//     using T = typename decltype(tag)::type;
+//     ...
+//   });
+template <typename F> decltype(auto) dispatch_dtype(DType dtype, F &&fn) {
+  switch (dtype) {
+  case DType::f32:
+    return fn(TypeTag<float>{});
+  case DType::f64:
+    return fn(TypeTag<double>{});
+  case DType::i32:
+    return fn(TypeTag<std::int32_t>{});
+  case DType::i64:
+    return fn(TypeTag<std::int64_t>{});
+  }
+  throw std::invalid_argument("unsupported dtype");
+}
+
+} // namespace Tensor
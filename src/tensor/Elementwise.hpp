@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "tensor/Parallel.hpp"
+#include "tensor/TensorIterator.hpp"
+#include "tensor/Vec.hpp"
+
+namespace Tensor::kernels {
+
+// Applies dst[i] = op(src0[i], src1[i], ...) over [0, n) on the calling thread.
+// `op` is called with simd::Vec<T> arguments for both full registers and the
+// masked tail, so a generic lambda such as [](auto a, auto b) { return a + b; }
+// serves every width. Sources may alias dst; nothing past index n is read or
+// written.
+template <typename T, typename Op, typename... Src>
+void map_contiguous_serial(int64_t n, T *dst, const Op &op, const Src *...src) {
+  static_assert((std::is_same_v<T, Src> && ...), "map_contiguous operands share one dtype");
+  using V = simd::Vec<T>;
+  constexpr int64_t width = V::size;
+
+  int64_t index = 0;
+  for (; index + 2 * width <= n; index += 2 * width) {
+    const V first = op(V::load(src + index)...);
+    const V second = op(V::load(src + index + width)...);
+    first.store(dst + index);
+    second.store(dst + index + width);
+  }
+  for (; index + width <= n; index += width) {
+    op(V::load(src + index)...).store(dst + index);
+  }
+  if (index < n) {
+    const int64_t remaining = n - index;
+    op(V::load_partial(src + index, remaining)...).store_partial(dst + index, remaining);
+  }
+}
+
+// Parallel map_contiguous_serial: chunks of kDefaultGrainSize elements run on
+// the intra-op pool.
+template <typename T, typename Op, typename... Src>
+void map_contiguous(int64_t n, T *dst, const Op &op, const Src *...src) {
+  parallel_for(0, n, kDefaultGrainSize, [&](int64_t begin, int64_t end) {
+    map_contiguous_serial(end - begin, dst + begin, op, (src + begin)...);
+  });
+}
+
+template <typename T> void fill_contiguous(int64_t n, T *dst, T value) {
+  const simd::Vec<T> broadcast(value);
+  parallel_for(0, n, kDefaultGrainSize, [&](int64_t begin, int64_t end) {
+    constexpr int64_t width = simd::Vec<T>::size;
+    int64_t index = begin;
+    for (; index + width <= end; index += width) {
+      broadcast.store(dst + index);
+    }
+    if (index < end) {
+      broadcast.store_partial(dst + index, end - index);
+    }
+  });
+}
+
+namespace detail {
+
+template <typename T, typename Op> constexpr std::size_t map_arity() {
+  using V = simd::Vec<T>;
+  if constexpr (std::is_invocable_v<const Op &, V>) {
+    return 1;
+  } else if constexpr (std::is_invocable_v<const Op &, V, V>) {
+    return 2;
+  } else if constexpr (std::is_invocable_v<const Op &, V, V, V>) {
+    return 3;
+  } else {
+    static_assert(!sizeof(Op), "map functors take one to three operands");
+  }
+}
+
+template <typename T>
+simd::Vec<T> load_run(const char *base, int64_t stride, int64_t index, int64_t count) {
+  using V = simd::Vec<T>;
+  const T *ptr = reinterpret_cast<const T *>(base);
+  if (stride == 0) {
+    return V(*ptr);
+  }
+  return count == V::size ? V::load(ptr + index) : V::load_partial(ptr + index, count);
+}
+
+// One inner run of a strided map. Dense runs take the flat kernel, runs whose
+// inputs are dense or broadcast stay vectorized, anything else is scalar.
+template <typename T, typename Op, std::size_t... I>
+void map_run(const Op &op, char *const *data, const int64_t *strides, int64_t n,
+             std::index_sequence<I...>) {
+  using V = simd::Vec<T>;
+  constexpr auto elem = static_cast<int64_t>(sizeof(T));
+  T *dst = reinterpret_cast<T *>(data[0]);
+  if (strides[0] == elem && ((strides[I + 1] == elem) && ...)) {
+    map_contiguous_serial(n, dst, op, reinterpret_cast<const T *>(data[I + 1])...);
+    return;
+  }
+  if (strides[0] == elem && ((strides[I + 1] == elem || strides[I + 1] == 0) && ...)) {
+    for (int64_t index = 0; index < n; index += V::size) {
+      const int64_t count = std::min(V::size, n - index);
+      const V out = op(load_run<T>(data[I + 1], strides[I + 1], index, count)...);
+      if (count == V::size) {
+        out.store(dst + index);
+      } else {
+        out.store_partial(dst + index, count);
+      }
+    }
+    return;
+  }
+  for (int64_t index = 0; index < n; ++index) {
+    *reinterpret_cast<T *>(data[0] + index * strides[0]) =
+        op(*reinterpret_cast<const T *>(data[I + 1] + index * strides[I + 1])...);
+  }
+}
+
+} // namespace detail
+
+// Elementwise map over a TensorIterator whose operand 0 is the output. `op` is
+// called with Vec<T> on dense and broadcast runs and with T on strided ones.
+template <typename T, typename Op> void map(const TensorIterator &iter, const Op &op) {
+  constexpr std::size_t arity = detail::map_arity<T, Op>();
+  if (iter.is_contiguous()) {
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+      map_contiguous(iter.numel(), reinterpret_cast<T *>(iter.data(0)), op,
+                     reinterpret_cast<const T *>(iter.data(static_cast<int>(I) + 1))...);
+    }(std::make_index_sequence<arity>{});
+    return;
+  }
+  iter.for_each([&](char *const *data, const int64_t *strides, int64_t n) {
+    detail::map_run<T>(op, data, strides, n, std::make_index_sequence<arity>{});
+  });
+}
+
+template <typename T> void fill(const TensorIterator &iter, T value) {
+  if (iter.is_contiguous()) {
+    fill_contiguous(iter.numel(), reinterpret_cast<T *>(iter.data(0)), value);
+    return;
+  }
+  iter.for_each([value](char *const *data, const int64_t *strides, int64_t n) {
+    for (int64_t index = 0; index < n; ++index) {
+      *reinterpret_cast<T *>(data[0] + index * strides[0]) = value;
+    }
+  });
+}
+
+} // namespace Tensor::kernels
@@ -0,0 +1,728 @@
+#include "tensor/Gemm.hpp"
+
+#include "tensor/Elementwise.hpp"
+#include "tensor/Parallel.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TENSOR_GEMM_X86 1
+#include <immintrin.h>
+#else
+#define TENSOR_GEMM_X86 0
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace Tensor::kernels {
+
+namespace {
+
+// Packed panels and the microkernels follow the usual five-loop layout:
+// B is packed into KC x NR micro-panels that stay in L1, A into MR x KC
+// micro-panels of an MC x KC block that stays in L2, and the KC x NC slab of B
+// is sized against L3.
+using MicroKernelFn = void (*)(int64_t kc, const float *a, const float *b, float *c,
+                               int64_t ldc, float alpha, float beta);
+
+struct MicroKernel {
+  int64_t mr;
+  int64_t nr;
+  MicroKernelFn fn;
+  const char *name;
+};
+
+struct Blocking {
+  int64_t kc;
+  int64_t mc;
+  int64_t nc;
+};
+
+constexpr int64_t kMaxMr = 12;
+constexpr int64_t kMaxNr = 32;
+constexpr std::size_t kPanelAlignment = 64;
+
+template <int64_t MR, int64_t NR>
+void ukernel_scalar(int64_t kc, const float *a, const float *b, float *c, int64_t ldc,
+                    float alpha, float beta) {
+  float acc[MR][NR] = {};
+  for (int64_t p = 0; p < kc; ++p) {
+    for (int64_t i = 0; i < MR; ++i) {
+      const float av = a[i];
+      for (int64_t j = 0; j < NR; ++j) {
+        acc[i][j] += av * b[j];
+      }
+    }
+    a += MR;
+    b += NR;
+  }
+
+  for (int64_t i = 0; i < MR; ++i) {
+    float *row = c + i * ldc;
+    for (int64_t j = 0; j < NR; ++j) {
+      row[j] = beta == 0.0f ? alpha * acc[i][j] : alpha * acc[i][j] + beta * row[j];
+    }
+  }
+}
+
+void axpy_rows_scalar(int64_t n, int64_t k, const float *x, const float *b, int64_t ldb,
+                      float *c) {
+  for (int64_t p = 0; p < k; ++p) {
+    const float xv = x[p];
+    const float *row = b + p * ldb;
+    for (int64_t j = 0; j < n; ++j) {
+      c[j] += xv * row[j];
+    }
+  }
+}
+
+float dot_scalar(int64_t k, const float *a, const float *b) {
+  float acc = 0.0f;
+  for (int64_t p = 0; p < k; ++p) {
+    acc += a[p] * b[p];
+  }
+  return acc;
+}
+
+#if TENSOR_GEMM_X86
+
+__attribute__((target("avx2,fma"))) void
+ukernel_avx2_6x16(int64_t kc, const float *a, const float *b, float *c, int64_t ldc,
+                  float alpha, float beta) {
+  __m256 acc[6][2];
+#pragma GCC unroll 6
+  for (int i = 0; i < 6; ++i) {
+    acc[i][0] = _mm256_setzero_ps();
+    acc[i][1] = _mm256_setzero_ps();
+  }
+
+  for (int64_t p = 0; p < kc; ++p) {
+    const __m256 b0 = _mm256_load_ps(b);
+    const __m256 b1 = _mm256_load_ps(b + 8);
+#pragma GCC unroll 6
+    for (int i = 0; i < 6; ++i) {
+      const __m256 av = _mm256_broadcast_ss(a + i);
+      acc[i][0] = _mm256_fmadd_ps(av, b0, acc[i][0]);
+      acc[i][1] = _mm256_fmadd_ps(av, b1, acc[i][1]);
+    }
+    a += 6;
+    b += 16;
+  }
+
+  const __m256 va = _mm256_set1_ps(alpha);
+  if (beta == 0.0f) {
+#pragma GCC unroll 6
+    for (int i = 0; i < 6; ++i) {
+      _mm256_storeu_ps(c + i * ldc, _mm256_mul_ps(va, acc[i][0]));
+      _mm256_storeu_ps(c + i * ldc + 8, _mm256_mul_ps(va, acc[i][1]));
+    }
+  } else {
+    const __m256 vb = _mm256_set1_ps(beta);
+#pragma GCC unroll 6
+    for (int i = 0; i < 6; ++i) {
+      float *row = c + i * ldc;
+      _mm256_storeu_ps(row, _mm256_fmadd_ps(va, acc[i][0],
+                                            _mm256_mul_ps(vb, _mm256_loadu_ps(row))));
+      _mm256_storeu_ps(row + 8, _mm256_fmadd_ps(va, acc[i][1],
+                                                _mm256_mul_ps(vb, _mm256_loadu_ps(row + 8))));
+    }
+  }
+}
+
+__attribute__((target("avx512f"))) void
+ukernel_avx512_12x32(int64_t kc, const float *a, const float *b, float *c, int64_t ldc,
+                     float alpha, float beta) {
+  __m512 acc[12][2];
+#pragma GCC unroll 12
+  for (int i = 0; i < 12; ++i) {
+    acc[i][0] = _mm512_setzero_ps();
+    acc[i][1] = _mm512_setzero_ps();
+  }
+
+  for (int64_t p = 0; p < kc; ++p) {
+    const __m512 b0 = _mm512_load_ps(b);
+    const __m512 b1 = _mm512_load_ps(b + 16);
+#pragma GCC unroll 12
+    for (int i = 0; i < 12; ++i) {
+      const __m512 av = _mm512_set1_ps(a[i]);
+      acc[i][0] = _mm512_fmadd_ps(av, b0, acc[i][0]);
+      acc[i][1] = _mm512_fmadd_ps(av, b1, acc[i][1]);
+    }
+    a += 12;
+    b += 32;
+  }
+
+  const __m512 va = _mm512_set1_ps(alpha);
+  if (beta == 0.0f) {
+#pragma GCC unroll 12
+    for (int i = 0; i < 12; ++i) {
+      _mm512_storeu_ps(c + i * ldc, _mm512_mul_ps(va, acc[i][0]));
+      _mm512_storeu_ps(c + i * ldc + 16, _mm512_mul_ps(va, acc[i][1]));
+    }
+  } else {
+    const __m512 vb = _mm512_set1_ps(beta);
+#pragma GCC unroll 12
+    for (int i = 0; i < 12; ++i) {
+      float *row = c + i * ldc;
+      _mm512_storeu_ps(row, _mm512_fmadd_ps(va, acc[i][0],
+                                            _mm512_mul_ps(vb, _mm512_loadu_ps(row))));
+      _mm512_storeu_ps(row + 16,
+                       _mm512_fmadd_ps(va, acc[i][1], _mm512_mul_ps(vb, _mm512_loadu_ps(row + 16))));
+    }
+  }
+}
+
+// c[0:n] += sum_p x[p] * b[p, 0:n], four rows of B per pass over c.
+__attribute__((target("avx2,fma"))) void axpy_rows_avx2(int64_t n, int64_t k,
+                                                        const float *x, const float *b,
+                                                        int64_t ldb, float *c) {
+  int64_t p = 0;
+  for (; p + 4 <= k; p += 4) {
+    const float *r0 = b + p * ldb;
+    const float *r1 = r0 + ldb;
+    const float *r2 = r1 + ldb;
+    const float *r3 = r2 + ldb;
+    const __m256 x0 = _mm256_set1_ps(x[p]);
+    const __m256 x1 = _mm256_set1_ps(x[p + 1]);
+    const __m256 x2 = _mm256_set1_ps(x[p + 2]);
+    const __m256 x3 = _mm256_set1_ps(x[p + 3]);
+    int64_t j = 0;
+    for (; j + 8 <= n; j += 8) {
+      __m256 acc = _mm256_loadu_ps(c + j);
+      acc = _mm256_fmadd_ps(x0, _mm256_loadu_ps(r0 + j), acc);
+      acc = _mm256_fmadd_ps(x1, _mm256_loadu_ps(r1 + j), acc);
+      acc = _mm256_fmadd_ps(x2, _mm256_loadu_ps(r2 + j), acc);
+      acc = _mm256_fmadd_ps(x3, _mm256_loadu_ps(r3 + j), acc);
+      _mm256_storeu_ps(c + j, acc);
+    }
+    for (; j < n; ++j) {
+      c[j] += x[p] * r0[j] + x[p + 1] * r1[j] + x[p + 2] * r2[j] + x[p + 3] * r3[j];
+    }
+  }
+  for (; p < k; ++p) {
+    const float *row = b + p * ldb;
+    const __m256 xv = _mm256_set1_ps(x[p]);
+    int64_t j = 0;
+    for (; j + 8 <= n; j += 8) {
+      _mm256_storeu_ps(c + j, _mm256_fmadd_ps(xv, _mm256_loadu_ps(row + j),
+                                              _mm256_loadu_ps(c + j)));
+    }
+    for (; j < n; ++j) {
+      c[j] += x[p] * row[j];
+    }
+  }
+}
+
+__attribute__((target("avx2,fma"))) float dot_avx2(int64_t k, const float *a,
+                                                   const float *b) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  int64_t p = 0;
+  for (; p + 16 <= k; p += 16) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + p), _mm256_loadu_ps(b + p), acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + p + 8), _mm256_loadu_ps(b + p + 8), acc1);
+  }
+  for (; p + 8 <= k; p += 8) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + p), _mm256_loadu_ps(b + p), acc0);
+  }
+  const __m256 sum8 = _mm256_add_ps(acc0, acc1);
+  __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1));
+  sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+  sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 0x55));
+  float acc = _mm_cvtss_f32(sum4);
+  for (; p < k; ++p) {
+    acc += a[p] * b[p];
+  }
+  return acc;
+}
+
+#endif
+
+struct VectorKernels {
+  void (*axpy_rows)(int64_t, int64_t, const float *, const float *, int64_t, float *);
+  float (*dot)(int64_t, const float *, const float *);
+};
+
+const MicroKernel &micro_kernel() {
+  static const MicroKernel kernel = [] {
+#if TENSOR_GEMM_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+      return MicroKernel{12, 32, &ukernel_avx512_12x32, "avx512"};
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+      return MicroKernel{6, 16, &ukernel_avx2_6x16, "avx2"};
+    }
+#endif
+    return MicroKernel{4, 8, &ukernel_scalar<4, 8>, "scalar"};
+  }();
+  return kernel;
+}
+
+const VectorKernels &vector_kernels() {
+  static const VectorKernels kernels = [] {
+#if TENSOR_GEMM_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+      return VectorKernels{&axpy_rows_avx2, &dot_avx2};
+    }
+#endif
+    return VectorKernels{&axpy_rows_scalar, &dot_scalar};
+  }();
+  return kernels;
+}
+
+int64_t cache_bytes(int level, int64_t fallback) {
+#if defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE) &&                \
+    defined(_SC_LEVEL3_CACHE_SIZE)
+  const int name = level == 1   ? _SC_LEVEL1_DCACHE_SIZE
+                   : level == 2 ? _SC_LEVEL2_CACHE_SIZE
+                                : _SC_LEVEL3_CACHE_SIZE;
+  const long value = sysconf(name);
+  if (value > 0) {
+    return static_cast<int64_t>(value);
+  }
+#else
+  (void)level;
+#endif
+  return fallback;
+}
+
+int64_t round_down(int64_t value, int64_t multiple) {
+  return std::max(multiple, value / multiple * multiple);
+}
+
+const Blocking &blocking() {
+  static const Blocking params = [] {
+    const MicroKernel &uk = micro_kernel();
+    const int64_t l1 = cache_bytes(1, 32 * 1024);
+    const int64_t l2 = cache_bytes(2, 256 * 1024);
+    const int64_t l3 = cache_bytes(3, 8 * 1024 * 1024);
+    const auto elem = static_cast<int64_t>(sizeof(float));
+
+    // One A and one B micro-panel share three quarters of L1.
+    const int64_t kc =
+        std::clamp(round_down(l1 * 3 / 4 / ((uk.mr + uk.nr) * elem), 16), int64_t{64},
+                   int64_t{1024});
+    // The packed A block takes half of L2, the packed B slab half of L3.
+    const int64_t mc =
+        std::clamp(round_down(l2 / 2 / (kc * elem), uk.mr), uk.mr, round_down(1024, uk.mr));
+    const int64_t nc =
+        std::clamp(round_down(l3 / 2 / (kc * elem), uk.nr), uk.nr, round_down(8192, uk.nr));
+    return Blocking{kc, mc, nc};
+  }();
+  return params;
+}
+
+struct AlignedDelete {
+  void operator()(float *ptr) const noexcept {
+    ::operator delete(ptr, std::align_val_t{kPanelAlignment});
+  }
+};
+
+class PackBuffer {
+public:
+  float *reserve(std::size_t count) {
+    if (count > capacity_) {
+      data_.reset(static_cast<float *>(
+          ::operator new(count * sizeof(float), std::align_val_t{kPanelAlignment})));
+      capacity_ = count;
+    }
+    return data_.get();
+  }
+
+private:
+  std::unique_ptr<float, AlignedDelete> data_{};
+  std::size_t capacity_{0};
+};
+
+// Packs an mc x kc block of A (element (i, p) at a[i * rs + p * cs]) into
+// MR-row micro-panels, zero-padding the last one.
+void pack_a(int64_t mc, int64_t kc, const float *a, int64_t rs, int64_t cs, int64_t mr,
+            float *dst) {
+  for (int64_t i0 = 0; i0 < mc; i0 += mr) {
+    const int64_t rows = std::min(mr, mc - i0);
+    const float *panel = a + i0 * rs;
+    if (rs == 1 && rows == mr) {
+      for (int64_t p = 0; p < kc; ++p) {
+        std::copy_n(panel + p * cs, mr, dst + p * mr);
+      }
+    } else {
+      for (int64_t i = 0; i < rows; ++i) {
+        const float *src = panel + i * rs;
+        for (int64_t p = 0; p < kc; ++p) {
+          dst[p * mr + i] = src[p * cs];
+        }
+      }
+      for (int64_t p = 0; p < kc; ++p) {
+        std::fill(dst + p * mr + rows, dst + (p + 1) * mr, 0.0f);
+      }
+    }
+    dst += kc * mr;
+  }
+}
+
+// Packs a kc x nc block of B (element (p, j) at b[p * rs + j * cs]) into
+// NR-column micro-panels, zero-padding the last one.
+void pack_b(int64_t kc, int64_t nc, const float *b, int64_t rs, int64_t cs, int64_t nr,
+            float *dst) {
+  for (int64_t j0 = 0; j0 < nc; j0 += nr) {
+    const int64_t cols = std::min(nr, nc - j0);
+    const float *panel = b + j0 * cs;
+    if (cs == 1 && cols == nr) {
+      for (int64_t p = 0; p < kc; ++p) {
+        std::copy_n(panel + p * rs, nr, dst + p * nr);
+      }
+    } else {
+      for (int64_t j = 0; j < cols; ++j) {
+        const float *src = panel + j * cs;
+        for (int64_t p = 0; p < kc; ++p) {
+          dst[p * nr + j] = src[p * rs];
+        }
+      }
+      for (int64_t p = 0; p < kc; ++p) {
+        std::fill(dst + p * nr + cols, dst + (p + 1) * nr, 0.0f);
+      }
+    }
+    dst += kc * nr;
+  }
+}
+
+// Applies an epilogue to a rows x cols tile of C whose bias starts at `bias`.
+template <typename T>
+void apply_epilogue(int64_t rows, int64_t cols, T *c, int64_t ldc, const T *bias,
+                    const Epilogue<T> &epilogue) {
+  const auto finish = [&](const auto &act) {
+    for (int64_t i = 0; i < rows; ++i) {
+      T *row = c + i * ldc;
+      if (bias != nullptr) {
+        map_contiguous_serial(
+            cols, row, [&act](auto x, auto b) { return act(x + b); }, row, bias);
+      } else {
+        map_contiguous_serial(cols, row, act, row);
+      }
+    }
+  };
+  switch (epilogue.activation) {
+  case Activation::identity:
+    finish([](auto x) { return x; });
+    break;
+  case Activation::relu:
+    finish([](auto x) { return simd::maximum(x, decltype(x)(0)); });
+    break;
+  case Activation::clamp: {
+    const T lo = epilogue.min_value;
+    const T hi = epilogue.max_value;
+    finish([lo, hi](auto x) {
+      using V = decltype(x);
+      return simd::clamp(x, V(lo), V(hi));
+    });
+    break;
+  }
+  }
+}
+
+const float *bias_at(const Epilogue<float> *epilogue, int64_t column) {
+  return epilogue->bias != nullptr ? epilogue->bias + column : nullptr;
+}
+
+// Runs the microkernel over tiles [tile_begin, tile_end) of an mc x nc block.
+// Tiles are numbered column-panel major so consecutive tiles reuse one packed
+// B micro-panel.
+// `epilogue` is set only for the block that finishes C, starting at column
+// `col0` of the full output.
+void macro_kernel(const MicroKernel &uk, int64_t mc, int64_t nc, int64_t kc,
+                  const float *packed_a, const float *packed_b, float *c, int64_t ldc,
+                  float alpha, float beta, int64_t tile_begin, int64_t tile_end,
+                  const Epilogue<float> *epilogue, int64_t col0) {
+  alignas(kPanelAlignment) float edge[kMaxMr * kMaxNr];
+  const int64_t tiles_m = (mc + uk.mr - 1) / uk.mr;
+
+  for (int64_t tile = tile_begin; tile < tile_end; ++tile) {
+    const int64_t jr = (tile / tiles_m) * uk.nr;
+    const int64_t ir = (tile % tiles_m) * uk.mr;
+    const int64_t cols = std::min(uk.nr, nc - jr);
+    const int64_t rows = std::min(uk.mr, mc - ir);
+    const float *a_panel = packed_a + ir * kc;
+    const float *b_panel = packed_b + jr * kc;
+    float *c_tile = c + ir * ldc + jr;
+
+    if (rows == uk.mr && cols == uk.nr) {
+      uk.fn(kc, a_panel, b_panel, c_tile, ldc, alpha, beta);
+      if (epilogue != nullptr) {
+        apply_epilogue(rows, cols, c_tile, ldc, bias_at(epilogue, col0 + jr), *epilogue);
+      }
+      continue;
+    }
+
+    uk.fn(kc, a_panel, b_panel, edge, uk.nr, 1.0f, 0.0f);
+    for (int64_t i = 0; i < rows; ++i) {
+      float *row = c_tile + i * ldc;
+      const float *src = edge + i * uk.nr;
+      for (int64_t j = 0; j < cols; ++j) {
+        row[j] = beta == 0.0f ? alpha * src[j] : alpha * src[j] + beta * row[j];
+      }
+    }
+    if (epilogue != nullptr) {
+      apply_epilogue(rows, cols, c_tile, ldc, bias_at(epilogue, col0 + jr), *epilogue);
+    }
+  }
+}
+
+void scale_c(int64_t m, int64_t n, float beta, float *c, int64_t ldc) {
+  for (int64_t i = 0; i < m; ++i) {
+    float *row = c + i * ldc;
+    if (beta == 0.0f) {
+      std::fill_n(row, n, 0.0f);
+    } else if (beta != 1.0f) {
+      for (int64_t j = 0; j < n; ++j) {
+        row[j] *= beta;
+      }
+    }
+  }
+}
+
+// y[0:len] = alpha * M x + beta * y for a len x k matrix M (element (r, p) at
+// mat[r * rs + p * cs]). Streams M once instead of packing it; returns false
+// when neither dimension of M is contiguous.
+bool gemv(int64_t len, int64_t k, float alpha, const float *mat, int64_t rs, int64_t cs,
+          const float *x, int64_t incx, float beta, float *y, int64_t incy) {
+  if (cs != 1 && rs != 1) {
+    return false;
+  }
+
+  thread_local PackBuffer x_buffer;
+  thread_local PackBuffer y_buffer;
+  const VectorKernels &vk = vector_kernels();
+
+  if (cs == 1) {
+    const float *xv = x;
+    if (incx != 1) {
+      float *gathered = x_buffer.reserve(static_cast<std::size_t>(k));
+      for (int64_t p = 0; p < k; ++p) {
+        gathered[p] = x[p * incx];
+      }
+      xv = gathered;
+    }
+    parallel_for(0, len, std::max<int64_t>(1, kDefaultGrainSize / k),
+                 [&](int64_t begin, int64_t end) {
+                   for (int64_t r = begin; r < end; ++r) {
+                     const float value = alpha * vk.dot(k, mat + r * rs, xv);
+                     float &out = y[r * incy];
+                     out = beta == 0.0f ? value : value + beta * out;
+                   }
+                 });
+    return true;
+  }
+
+  float *scaled = x_buffer.reserve(static_cast<std::size_t>(k));
+  for (int64_t p = 0; p < k; ++p) {
+    scaled[p] = alpha * x[p * incx];
+  }
+  float *acc = incy == 1 ? y : y_buffer.reserve(static_cast<std::size_t>(len));
+  // Split by output columns so each thread streams its own slice of M.
+  parallel_for(0, len, std::max<int64_t>(64, kDefaultGrainSize / k),
+               [&](int64_t begin, int64_t end) {
+                 if (incy == 1) {
+                   scale_c(1, end - begin, beta, acc + begin, end - begin);
+                 } else {
+                   std::fill(acc + begin, acc + end, 0.0f);
+                 }
+                 vk.axpy_rows(end - begin, k, scaled, mat + begin, cs, acc + begin);
+                 if (incy != 1) {
+                   for (int64_t r = begin; r < end; ++r) {
+                     float &out = y[r * incy];
+                     out = beta == 0.0f ? acc[r] : acc[r] + beta * out;
+                   }
+                 }
+               });
+  return true;
+}
+
+// Row kernel for dtypes without a packed microkernel. C rows are updated with
+// vectorized axpys over a KC x NC block of B that stays in L2; B is copied to a
+// dense buffer first when its rows are strided.
+template <typename T>
+void gemm_rows(int64_t m, int64_t n, int64_t k, T alpha, const T *a, int64_t a_rs,
+               int64_t a_cs, const T *b, int64_t b_rs, int64_t b_cs, T beta, T *c,
+               int64_t ldc, const Epilogue<T> &epilogue) {
+  constexpr int64_t kBlockK = 128;
+  constexpr int64_t kBlockN = 512;
+  if (m <= 0 || n <= 0) {
+    return;
+  }
+
+  std::vector<T> dense_b;
+  if (b_cs != 1 && k > 0) {
+    dense_b.resize(static_cast<std::size_t>(k * n));
+    for (int64_t p = 0; p < k; ++p) {
+      for (int64_t j = 0; j < n; ++j) {
+        dense_b[static_cast<std::size_t>(p * n + j)] = b[p * b_rs + j * b_cs];
+      }
+    }
+    b = dense_b.data();
+    b_rs = n;
+  }
+
+  const int64_t row_grain =
+      std::max<int64_t>(1, (int64_t{1} << 20) / std::max<int64_t>(1, 2 * n * k));
+  parallel_for(0, m, row_grain, [&](int64_t row_begin, int64_t row_end) {
+    for (int64_t jc = 0; jc < n; jc += kBlockN) {
+      const int64_t nc = std::min(kBlockN, n - jc);
+      for (int64_t i = row_begin; i < row_end; ++i) {
+        T *row = c + i * ldc + jc;
+        if (beta == T{0}) {
+          std::fill(row, row + nc, T{0});
+        } else if (beta != T{1}) {
+          map_contiguous_serial(
+              nc, row, [beta](auto x) { return x * decltype(x)(beta); }, row);
+        }
+      }
+      for (int64_t pc = 0; pc < k; pc += kBlockK) {
+        const int64_t kc = std::min(kBlockK, k - pc);
+        for (int64_t i = row_begin; i < row_end; ++i) {
+          T *row = c + i * ldc + jc;
+          for (int64_t p = pc; p < pc + kc; ++p) {
+            const T scale = alpha * a[i * a_rs + p * a_cs];
+            map_contiguous_serial(
+                nc, row,
+                [scale](auto acc, auto bv) { return acc + decltype(acc)(scale) * bv; }, row,
+                b + p * b_rs + jc);
+          }
+        }
+      }
+      if (epilogue.active()) {
+        apply_epilogue(row_end - row_begin, nc, c + row_begin * ldc + jc, ldc,
+                       epilogue.bias != nullptr ? epilogue.bias + jc : nullptr, epilogue);
+      }
+    }
+  });
+}
+
+} // namespace
+
+void sgemm_strided(int64_t m, int64_t n, int64_t k, float alpha, const float *a,
+                   int64_t a_rs, int64_t a_cs, const float *b, int64_t b_rs, int64_t b_cs,
+                   float beta, float *c, int64_t ldc, const Epilogue<float> &epilogue) {
+  if (m <= 0 || n <= 0) {
+    return;
+  }
+  // The vector paths finish a single row or column, which is still in cache
+  // when the epilogue runs over it.
+  const auto finish_all = [&] {
+    if (epilogue.active()) {
+      apply_epilogue(m, n, c, ldc, epilogue.bias, epilogue);
+    }
+  };
+  if (k <= 0 || alpha == 0.0f) {
+    scale_c(m, n, beta, c, ldc);
+    finish_all();
+    return;
+  }
+  if (m == 1 && gemv(n, k, alpha, b, b_cs, b_rs, a, a_cs, beta, c, 1)) {
+    finish_all();
+    return;
+  }
+  if (n == 1 && gemv(m, k, alpha, a, a_rs, a_cs, b, b_rs, beta, c, ldc)) {
+    finish_all();
+    return;
+  }
+
+  const MicroKernel &uk = micro_kernel();
+  const Blocking &bl = blocking();
+  const int64_t kc_max = std::min(bl.kc, k);
+  const int64_t mc_max = std::min(bl.mc, (m + uk.mr - 1) / uk.mr * uk.mr);
+  const int64_t nc_max = std::min(bl.nc, (n + uk.nr - 1) / uk.nr * uk.nr);
+
+  thread_local PackBuffer a_buffer;
+  thread_local PackBuffer b_buffer;
+  float *packed_a = a_buffer.reserve(static_cast<std::size_t>(mc_max * kc_max));
+  float *packed_b = b_buffer.reserve(static_cast<std::size_t>(kc_max * nc_max));
+
+  // Packing and the macro-kernel are split across the intra-op pool; the
+  // packed panels are shared, so only the loops inside a block run in parallel.
+  for (int64_t jc = 0; jc < n; jc += bl.nc) {
+    const int64_t nc = std::min(bl.nc, n - jc);
+    const int64_t tiles_n = (nc + uk.nr - 1) / uk.nr;
+    for (int64_t pc = 0; pc < k; pc += bl.kc) {
+      const int64_t kc = std::min(bl.kc, k - pc);
+      const float beta_block = pc == 0 ? beta : 1.0f;
+      const Epilogue<float> *block_epilogue =
+          pc + kc == k && epilogue.active() ? &epilogue : nullptr;
+      const float *b_block = b + pc * b_rs + jc * b_cs;
+      parallel_for(0, tiles_n, std::max<int64_t>(1, kDefaultGrainSize / (kc * uk.nr)),
+                   [&](int64_t begin, int64_t end) {
+                     const int64_t j0 = begin * uk.nr;
+                     pack_b(kc, std::min(nc, end * uk.nr) - j0, b_block + j0 * b_cs, b_rs,
+                            b_cs, uk.nr, packed_b + j0 * kc);
+                   });
+
+      for (int64_t ic = 0; ic < m; ic += bl.mc) {
+        const int64_t mc = std::min(bl.mc, m - ic);
+        const int64_t tiles_m = (mc + uk.mr - 1) / uk.mr;
+        const float *a_block = a + ic * a_rs + pc * a_cs;
+        parallel_for(0, tiles_m, std::max<int64_t>(1, kDefaultGrainSize / (kc * uk.mr)),
+                     [&](int64_t begin, int64_t end) {
+                       const int64_t i0 = begin * uk.mr;
+                       pack_a(std::min(mc, end * uk.mr) - i0, kc, a_block + i0 * a_rs, a_rs,
+                              a_cs, uk.mr, packed_a + i0 * kc);
+                     });
+
+        // Roughly a million flops per chunk keeps dispatch overhead negligible.
+        const int64_t tile_grain = std::max<int64_t>(1, (int64_t{1} << 20) / (2 * uk.mr * uk.nr * kc));
+        parallel_for(0, tiles_m * tiles_n, tile_grain,
+                     [&](int64_t begin, int64_t end) {
+                       macro_kernel(uk, mc, nc, kc, packed_a, packed_b, c + ic * ldc + jc,
+                                    ldc, alpha, beta_block, begin, end, block_epilogue, jc);
+                     });
+      }
+    }
+  }
+}
+
+void sgemm(Transpose trans_a, Transpose trans_b, int64_t m, int64_t n, int64_t k,
+           float alpha, const float *a, int64_t lda, const float *b, int64_t ldb,
+           float beta, float *c, int64_t ldc) {
+  const bool ta = trans_a == Transpose::trans;
+  const bool tb = trans_b == Transpose::trans;
+  sgemm_strided(m, n, k, alpha, a, ta ? 1 : lda, ta ? lda : 1, b, tb ? 1 : ldb,
+                tb ? ldb : 1, beta, c, ldc);
+}
+
+template <typename T>
+void gemm_strided(int64_t m, int64_t n, int64_t k, T alpha, const T *a, int64_t a_rs,
+                  int64_t a_cs, const T *b, int64_t b_rs, int64_t b_cs, T beta, T *c,
+                  int64_t ldc, const Epilogue<T> &epilogue) {
+  gemm_rows(m, n, k, alpha, a, a_rs, a_cs, b, b_rs, b_cs, beta, c, ldc, epilogue);
+}
+
+template <>
+void gemm_strided<float>(int64_t m, int64_t n, int64_t k, float alpha, const float *a,
+                         int64_t a_rs, int64_t a_cs, const float *b, int64_t b_rs,
+                         int64_t b_cs, float beta, float *c, int64_t ldc,
+                         const Epilogue<float> &epilogue) {
+  sgemm_strided(m, n, k, alpha, a, a_rs, a_cs, b, b_rs, b_cs, beta, c, ldc, epilogue);
+}
+
+template void gemm_strided<double>(int64_t, int64_t, int64_t, double, const double *,
+                                   int64_t, int64_t, const double *, int64_t, int64_t,
+                                   double, double *, int64_t, const Epilogue<double> &);
+template void gemm_strided<int32_t>(int64_t, int64_t, int64_t, int32_t, const int32_t *,
+                                    int64_t, int64_t, const int32_t *, int64_t, int64_t,
+                                    int32_t, int32_t *, int64_t, const Epilogue<int32_t> &);
+template void gemm_strided<int64_t>(int64_t, int64_t, int64_t, int64_t, const int64_t *,
+                                    int64_t, int64_t, const int64_t *, int64_t, int64_t,
+                                    int64_t, int64_t *, int64_t, const Epilogue<int64_t> &);
+
+const char *sgemm_kernel_name() noexcept {
+  return micro_kernel().name;
+}
+
+} // namespace Tensor::kernels
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Tensor::kernels {
+
+enum class Transpose : uint8_t { none, trans };
+
+enum class Activation : uint8_t { identity, relu, clamp };
+
+// Work folded into a GEMM's final store: every finished tile of C becomes
+// act(C + bias[j]) while it is still in L1, instead of in separate passes over
+// the whole output. `bias` holds n contiguous values or is null.
+template <typename T> struct Epilogue {
+  const T *bias{nullptr};
+  Activation activation{Activation::identity};
+  T min_value{};
+  T max_value{};
+
+  bool active() const noexcept { return bias != nullptr || activation != Activation::identity; }
+};
+
+// Single-precision GEMM on row-major operands:
+//   C[m x n] = alpha * op(A)[m x k] * op(B)[k x n] + beta * C
+// `lda`, `ldb` and `ldc` are row strides of the stored (untransposed) matrices.
+// When `beta` is zero the previous contents of C are never read, so C may be
+// uninitialized.
+void sgemm(Transpose trans_a, Transpose trans_b, int64_t m, int64_t n, int64_t k,
+           float alpha, const float *a, int64_t lda, const float *b, int64_t ldb,
+           float beta, float *c, int64_t ldc);
+
+// Same product with arbitrary element strides: op(A)(i, p) is read from
+// a[i * a_rs + p * a_cs] and op(B)(p, j) from b[p * b_rs + j * b_cs]. Every
+// transpose combination and any 2-D view maps onto this form without copies.
+void sgemm_strided(int64_t m, int64_t n, int64_t k, float alpha, const float *a,
+                   int64_t a_rs, int64_t a_cs, const float *b, int64_t b_rs, int64_t b_cs,
+                   float beta, float *c, int64_t ldc, const Epilogue<float> &epilogue = {});
+
+// sgemm_strided generalized over the tensor dtypes (float, double, int32_t and
+// int64_t). f32 runs the packed engine above; the other dtypes use a
+// cache-blocked row kernel whose inner loop is vectorized through simd::Vec.
+template <typename T>
+void gemm_strided(int64_t m, int64_t n, int64_t k, T alpha, const T *a, int64_t a_rs,
+                  int64_t a_cs, const T *b, int64_t b_rs, int64_t b_cs, T beta, T *c,
+                  int64_t ldc, const Epilogue<T> &epilogue = {});
+
+template <>
+void gemm_strided<float>(int64_t m, int64_t n, int64_t k, float alpha, const float *a,
+                         int64_t a_rs, int64_t a_cs, const float *b, int64_t b_rs,
+                         int64_t b_cs, float beta, float *c, int64_t ldc,
+                         const Epilogue<float> &epilogue);
+
+// Name of the microkernel selected for this CPU ("avx512", "avx2" or "scalar").
+const char *sgemm_kernel_name() noexcept;
+
+} // namespace Tensor::kernels
@@ -0,0 +1,530 @@
+#include "tensor/Lazy.hpp"
+
+#include "api/Api.hpp"
+#include "tensor/Arena.hpp"
+#include "tensor/Autograd.hpp"
+#include "tensor/Dispatch.hpp"
+#include "tensor/Elementwise.hpp"
+#include "tensor/Ops.hpp"
+#include "tensor/Parallel.hpp"
+#include "tensor/Reduce.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Tensor {
+
+namespace {
+
+thread_local bool t_lazy_mode = false;
+
+// Elements per fused block; one block of every intermediate stays in L1. A
+// block is also a leaf of the eager pairwise sum.
+constexpr int64_t kBlock = kernels::kReduceBlock;
+
+using lazy::PointwiseOp;
+using lazy::Reduction;
+
+constexpr auto kAdd = [](auto a, auto b) { return a + b; };
+constexpr auto kSub = [](auto a, auto b) { return a - b; };
+constexpr auto kMul = [](auto a, auto b) { return a * b; };
+constexpr auto kRelu = [](auto x) { return simd::maximum(x, decltype(x)(0)); };
+
+// One node of a recorded expression: an op over its operands, or a leaf that
+// reads a materialized tensor.
+struct LazyNode {
+  PointwiseOp op{PointwiseOp::add};
+  std::shared_ptr<const LazyNode> lhs{};
+  std::shared_ptr<const LazyNode> rhs{};
+  double min_value{0.0};
+  double max_value{0.0};
+  DTensor leaf{};
+  uint64_t version{0};
+
+  bool is_leaf() const noexcept { return leaf.defined(); }
+};
+
+// An expression flattened for evaluation. Operands precede their users, the
+// last instruction is the root, and each distinct input tensor appears once.
+struct Instr {
+  PointwiseOp op{PointwiseOp::add};
+  int lhs{-1};
+  int rhs{-1};
+  int leaf{-1};
+  double min_value{0.0};
+  double max_value{0.0};
+};
+
+struct Program {
+  std::vector<Instr> instrs;
+  std::vector<DTensor> leaves;
+  std::vector<uint64_t> versions;
+
+  void check_versions() const {
+    for (std::size_t index = 0; index < leaves.size(); ++index) {
+      if (leaves[index].version() != versions[index]) {
+        throw std::runtime_error(
+            "lazy evaluation: an input was modified by an in-place op before it was read");
+      }
+    }
+  }
+};
+
+Program compile(const std::shared_ptr<const LazyNode> &root) {
+  Program program;
+  std::unordered_map<const LazyNode *, int> slots;
+  std::vector<std::pair<const LazyNode *, bool>> stack{{root.get(), false}};
+  while (!stack.empty()) {
+    const auto [node, expanded] = stack.back();
+    stack.pop_back();
+    if (slots.count(node) != 0) {
+      continue;
+    }
+    if (node->is_leaf()) {
+      const auto same_input = std::find_if(
+          program.instrs.begin(), program.instrs.end(), [&](const Instr &instr) {
+            if (instr.leaf < 0) {
+              return false;
+            }
+            // Aliases with different autograd states stay separate inputs, so
+            // each keeps its own edge.
+            const DTensor &leaf = program.leaves[static_cast<std::size_t>(instr.leaf)];
+            return leaf.storage() == node->leaf.storage() && leaf.offset() == node->leaf.offset() &&
+                   leaf.autograd_state() == node->leaf.autograd_state();
+          });
+      if (same_input != program.instrs.end()) {
+        slots.emplace(node, static_cast<int>(same_input - program.instrs.begin()));
+        continue;
+      }
+      Instr instr;
+      instr.leaf = static_cast<int>(program.leaves.size());
+      program.leaves.push_back(node->leaf);
+      program.versions.push_back(node->version);
+      slots.emplace(node, static_cast<int>(program.instrs.size()));
+      program.instrs.push_back(instr);
+      continue;
+    }
+    if (!expanded) {
+      stack.emplace_back(node, true);
+      for (const auto &operand : {node->rhs, node->lhs}) {
+        if (operand && slots.count(operand.get()) == 0) {
+          stack.emplace_back(operand.get(), false);
+        }
+      }
+      continue;
+    }
+    Instr instr;
+    instr.op = node->op;
+    instr.lhs = slots.at(node->lhs.get());
+    instr.rhs = node->rhs ? slots.at(node->rhs.get()) : -1;
+    instr.min_value = node->min_value;
+    instr.max_value = node->max_value;
+    slots.emplace(node, static_cast<int>(program.instrs.size()));
+    program.instrs.push_back(instr);
+  }
+  return program;
+}
+
+template <typename T>
+void evaluate_instr(const Instr &instr, int64_t len, T *dst, const T *lhs, const T *rhs) {
+  switch (instr.op) {
+  case PointwiseOp::add:
+    kernels::map_contiguous_serial(len, dst, kAdd, lhs, rhs);
+    break;
+  case PointwiseOp::sub:
+    kernels::map_contiguous_serial(len, dst, kSub, lhs, rhs);
+    break;
+  case PointwiseOp::mul:
+    kernels::map_contiguous_serial(len, dst, kMul, lhs, rhs);
+    break;
+  case PointwiseOp::relu:
+    kernels::map_contiguous_serial(len, dst, kRelu, lhs);
+    break;
+  case PointwiseOp::clamp: {
+    const auto lo = static_cast<T>(instr.min_value);
+    const auto hi = static_cast<T>(instr.max_value);
+    kernels::map_contiguous_serial(
+        len, dst,
+        [lo, hi](auto x) {
+          using V = decltype(x);
+          return simd::clamp(x, V(lo), V(hi));
+        },
+        lhs);
+    break;
+  }
+  }
+}
+
+// Per-thread block buffers: `values[i]` points at instruction i's values for
+// the current block, either in an input tensor or in scratch.
+template <typename T> struct BlockFrame {
+  explicit BlockFrame(std::size_t instrs) : values(instrs), scratch(instrs * kBlock) {}
+
+  T *slot(std::size_t index) { return scratch.data() + index * kBlock; }
+
+  std::vector<const T *> values;
+  std::vector<T> scratch;
+};
+
+// Evaluates every instruction over elements [begin, begin + len). The root is
+// written to `root_out` when given.
+template <typename T>
+void evaluate_block(const Program &program, const std::vector<const T *> &inputs,
+                    int64_t begin, int64_t len, BlockFrame<T> &frame, T *root_out) {
+  const std::size_t root = program.instrs.size() - 1;
+  for (std::size_t index = 0; index < program.instrs.size(); ++index) {
+    const Instr &instr = program.instrs[index];
+    if (instr.leaf >= 0) {
+      frame.values[index] = inputs[static_cast<std::size_t>(instr.leaf)] + begin;
+      continue;
+    }
+    T *dst = index == root && root_out != nullptr ? root_out : frame.slot(index);
+    evaluate_instr(instr, len, dst, frame.values[static_cast<std::size_t>(instr.lhs)],
+                   instr.rhs >= 0 ? frame.values[static_cast<std::size_t>(instr.rhs)]
+                                  : nullptr);
+    frame.values[index] = dst;
+  }
+}
+
+template <typename T> std::vector<const T *> input_pointers(const Program &program) {
+  std::vector<const T *> inputs;
+  inputs.reserve(program.leaves.size());
+  for (const DTensor &leaf : program.leaves) {
+    inputs.push_back(static_cast<const T *>(leaf.data()));
+  }
+  return inputs;
+}
+
+// Producer of a pending result: the expression over `shape`, optionally
+// reduced to one element.
+struct LazyExpr final : StorageProducer {
+  LazyExpr(std::shared_ptr<const LazyNode> root_in, std::optional<Reduction> reduction_in,
+           Dims shape_in, DType dtype_in, bool grad_mode_in, bool requires_grad_in)
+      : root(std::move(root_in)), reduction(reduction_in), shape(std::move(shape_in)),
+        dtype(dtype_in), grad_mode(grad_mode_in), requires_grad(requires_grad_in) {}
+
+  void produce(void *data, std::size_t) override {
+    const Program program = compile(root);
+    program.check_versions();
+    const int64_t count = numel_from_shape(shape);
+    dispatch_dtype(dtype, [&](auto tag) {
+      using T = typename decltype(tag)::type;
+      const auto inputs = input_pointers<T>(program);
+      if (!reduction) {
+        T *out = static_cast<T *>(data);
+        const int64_t blocks = (count + kBlock - 1) / kBlock;
+        parallel_for(0, blocks, kDefaultGrainSize / kBlock, [&](int64_t first, int64_t last) {
+          BlockFrame<T> frame(program.instrs.size());
+          for (int64_t block = first; block < last; ++block) {
+            const int64_t begin = block * kBlock;
+            const int64_t len = std::min(kBlock, count - begin);
+            evaluate_block(program, inputs, begin, len, frame, out + begin);
+          }
+        });
+        return;
+      }
+
+      // Blocks are folded and combined exactly as ops::sum folds a row, so a
+      // fused reduction matches the eager one bit for bit.
+      const int64_t blocks = (count + kBlock - 1) / kBlock;
+      std::vector<T> partials(static_cast<std::size_t>(blocks));
+      parallel_for(0, blocks, kDefaultGrainSize / kBlock, [&](int64_t first, int64_t last) {
+        BlockFrame<T> frame(program.instrs.size());
+        for (int64_t block = first; block < last; ++block) {
+          const int64_t begin = block * kBlock;
+          const int64_t len = std::min(kBlock, count - begin);
+          evaluate_block(program, inputs, begin, len, frame, static_cast<T *>(nullptr));
+          partials[static_cast<std::size_t>(block)] = kernels::sum_block(frame.values.back(), len);
+        }
+      });
+      T total = kernels::pairwise_sum(partials.data(), blocks);
+      if (*reduction == Reduction::mean) {
+        total = count == 0 ? T{0} : static_cast<T>(total / count);
+      }
+      *static_cast<T *>(data) = total;
+    });
+  }
+
+  std::shared_ptr<const LazyNode> root;
+  std::optional<Reduction> reduction;
+  Dims shape;
+  DType dtype;
+  // The grad mode the expression was recorded in, and whether its result
+  // requires grad.
+  bool grad_mode;
+  bool requires_grad;
+};
+
+// The whole fused region as one autograd node. Backward re-evaluates the
+// expression block by block and sweeps it in reverse, so the gradients of all
+// inputs come out of a single pass without materializing intermediates.
+struct FusedBackward final : AutogradNode {
+  FusedBackward(const std::shared_ptr<const LazyNode> &root,
+                std::optional<Reduction> reduction_in, Dims shape_in)
+      : program(compile(root)), reduction(reduction_in), shape(std::move(shape_in)) {
+    for (const DTensor &leaf : program.leaves) {
+      edges.push_back(leaf.autograd_state());
+    }
+  }
+
+  std::size_t num_inputs() const noexcept override { return edges.size(); }
+  const AutogradEdge &input(std::size_t index) const noexcept override { return edges[index]; }
+
+  void backward(const DTensor &upstream, std::vector<DTensor> &grads) override {
+    program.check_versions();
+    const DType dtype = program.leaves.front().dtype();
+    dispatch_dtype(dtype, [&](auto tag) {
+      run<typename decltype(tag)::type>(upstream, grads, dtype);
+    });
+  }
+
+  template <typename T>
+  void run(const DTensor &upstream, std::vector<DTensor> &grads, DType dtype) {
+    const std::size_t size = program.instrs.size();
+    const std::size_t root = size - 1;
+    const int64_t count = numel_from_shape(shape);
+
+    // An instruction needs an adjoint when some input below it requires grad.
+    std::vector<char> needs(size, 0);
+    std::vector<T *> grad_data(size, nullptr);
+    for (std::size_t index = 0; index < size; ++index) {
+      const Instr &instr = program.instrs[index];
+      if (instr.leaf >= 0) {
+        const auto leaf = static_cast<std::size_t>(instr.leaf);
+        if (edge_requires_grad(edges[leaf])) {
+          grads[leaf] = api::empty(shape, dtype);
+          grad_data[index] = static_cast<T *>(grads[leaf].data());
+          needs[index] = 1;
+        }
+        continue;
+      }
+      needs[index] = needs[static_cast<std::size_t>(instr.lhs)] ||
+                     (instr.rhs >= 0 && needs[static_cast<std::size_t>(instr.rhs)]);
+    }
+
+    DTensor dense_upstream;
+    T scalar{0};
+    if (reduction) {
+      scalar = static_cast<const T *>(upstream.data())[0];
+      if (*reduction == Reduction::mean) {
+        scalar = static_cast<T>(scalar / static_cast<double>(std::max<int64_t>(count, 1)));
+      }
+    } else {
+      dense_upstream = upstream.is_contiguous() ? upstream : ops::clone(upstream);
+    }
+    const T *up = reduction ? nullptr : static_cast<const T *>(dense_upstream.data());
+    const auto inputs = input_pointers<T>(program);
+    const int64_t blocks = (count + kBlock - 1) / kBlock;
+
+    parallel_for(0, blocks, kDefaultGrainSize / kBlock, [&](int64_t first, int64_t last) {
+      BlockFrame<T> frame(size);
+      std::vector<T> adjoint_scratch(size * kBlock);
+      std::vector<T *> adjoints(size, nullptr);
+      for (int64_t block = first; block < last; ++block) {
+        const int64_t begin = block * kBlock;
+        const int64_t len = std::min(kBlock, count - begin);
+        evaluate_block(program, inputs, begin, len, frame, static_cast<T *>(nullptr));
+
+        for (std::size_t index = 0; index < size; ++index) {
+          if (!needs[index]) {
+            continue;
+          }
+          adjoints[index] = grad_data[index] != nullptr
+                                ? grad_data[index] + begin
+                                : adjoint_scratch.data() + index * kBlock;
+          std::fill_n(adjoints[index], len, T{0});
+        }
+        const T *root_adjoint = up != nullptr ? up + begin : adjoints[root];
+        if (up == nullptr) {
+          std::fill_n(adjoints[root], len, scalar);
+        }
+
+        for (std::size_t index = size; index-- > 0;) {
+          const Instr &instr = program.instrs[index];
+          if (instr.leaf >= 0 || !needs[index]) {
+            continue;
+          }
+          const T *adjoint = index == root ? root_adjoint : adjoints[index];
+          propagate(instr, len, adjoint, frame, adjoints, needs, index);
+        }
+      }
+    });
+  }
+
+  // Adds instruction `index`'s contribution to its operands' adjoints.
+  template <typename T>
+  static void propagate(const Instr &instr, int64_t len, const T *adjoint,
+                        const BlockFrame<T> &frame, const std::vector<T *> &adjoints,
+                        const std::vector<char> &needs, std::size_t index) {
+    const auto lhs = static_cast<std::size_t>(instr.lhs);
+    const auto rhs = static_cast<std::size_t>(instr.rhs);
+    const T *value = frame.values[index];
+    switch (instr.op) {
+    case PointwiseOp::add:
+    case PointwiseOp::sub:
+      if (needs[lhs]) {
+        kernels::map_contiguous_serial(len, adjoints[lhs], kAdd, adjoints[lhs], adjoint);
+      }
+      if (needs[rhs]) {
+        if (instr.op == PointwiseOp::add) {
+          kernels::map_contiguous_serial(len, adjoints[rhs], kAdd, adjoints[rhs], adjoint);
+        } else {
+          kernels::map_contiguous_serial(len, adjoints[rhs], kSub, adjoints[rhs], adjoint);
+        }
+      }
+      break;
+    case PointwiseOp::mul: {
+      const auto fma = [](auto acc, auto up, auto other) { return acc + up * other; };
+      if (needs[lhs]) {
+        kernels::map_contiguous_serial(len, adjoints[lhs], fma, adjoints[lhs], adjoint,
+                                       frame.values[rhs]);
+      }
+      if (needs[rhs]) {
+        kernels::map_contiguous_serial(len, adjoints[rhs], fma, adjoints[rhs], adjoint,
+                                       frame.values[lhs]);
+      }
+      break;
+    }
+    case PointwiseOp::relu:
+      kernels::map_contiguous_serial(
+          len, adjoints[lhs],
+          [](auto acc, auto up, auto out) {
+            using V = decltype(out);
+            return acc + simd::select(out > V(0), up, V(0));
+          },
+          adjoints[lhs], adjoint, value);
+      break;
+    case PointwiseOp::clamp: {
+      const auto lo = static_cast<T>(instr.min_value);
+      const auto hi = static_cast<T>(instr.max_value);
+      kernels::map_contiguous_serial(
+          len, adjoints[lhs],
+          [lo, hi](auto acc, auto up, auto out) {
+            using V = decltype(out);
+            return acc + simd::select((out > V(lo)) & (out < V(hi)), up, V(0));
+          },
+          adjoints[lhs], adjoint, value);
+      break;
+    }
+    }
+  }
+
+  Program program;
+  std::optional<Reduction> reduction;
+  Dims shape;
+  std::vector<AutogradEdge> edges;
+};
+
+// The pending elementwise expression behind `tensor`, if a new expression may
+// inline it. One recorded under another grad mode, or whose result's
+// requires_grad has changed since, is not: its inputs would receive gradients
+// that `tensor`'s own history does not route to them.
+std::shared_ptr<LazyExpr> inlinable_expr(const DTensor &tensor) {
+  if (!tensor.defined()) {
+    return nullptr;
+  }
+  auto expr = std::dynamic_pointer_cast<LazyExpr>(tensor.storage()->producer());
+  if (!expr || expr->reduction || tensor.offset() != 0 || tensor.shape() != expr->shape ||
+      expr->grad_mode != grad_mode_enabled() || expr->requires_grad != tensor.requires_grad()) {
+    return nullptr;
+  }
+  return expr;
+}
+
+// The node `tensor` contributes to a new expression: an inlinable pending
+// result is inlined, anything else is read as an input.
+std::shared_ptr<const LazyNode> node_of(const DTensor &tensor) {
+  if (const auto expr = inlinable_expr(tensor)) {
+    return expr->root;
+  }
+  auto leaf = std::make_shared<LazyNode>();
+  leaf->leaf = tensor;
+  leaf->version = tensor.version();
+  return leaf;
+}
+
+bool fusable(const DTensor &tensor) {
+  return tensor.defined() && tensor.is_contiguous() && tensor.numel() > 0;
+}
+
+DTensor make_pending(std::shared_ptr<const LazyNode> root, std::optional<Reduction> reduction,
+                     const Dims &shape, DType dtype, bool requires_grad) {
+  const Dims result_shape =
+      reduction ? Dims{1} : shape;
+  const auto bytes = static_cast<std::size_t>(numel_from_shape(result_shape)) * dtype_size(dtype);
+  auto expr = make_arena_shared<LazyExpr>(root, reduction, shape, dtype, grad_mode_enabled(),
+                                          requires_grad);
+  auto storage = make_arena_shared<Storage>(std::shared_ptr<StorageProducer>(std::move(expr)),
+                                            bytes, std::size_t{64});
+  DTensor result(std::move(storage), result_shape, default_strides(result_shape), 0, dtype,
+                 true, requires_grad);
+  if (requires_grad) {
+    result.set_grad_fn(make_arena_shared<FusedBackward>(root, reduction, shape));
+  }
+  return result;
+}
+
+} // namespace
+
+LazyGuard::LazyGuard() noexcept : previous_(t_lazy_mode) {
+  t_lazy_mode = true;
+}
+
+LazyGuard::~LazyGuard() {
+  t_lazy_mode = previous_;
+}
+
+bool lazy_mode_enabled() noexcept {
+  return t_lazy_mode;
+}
+
+bool is_pending(const DTensor &tensor) noexcept {
+  return tensor.defined() && tensor.storage()->pending();
+}
+
+namespace lazy {
+
+std::optional<DTensor> binary(PointwiseOp op, const DTensor &lhs, const DTensor &rhs,
+                              bool requires_grad) {
+  if (!t_lazy_mode || !fusable(lhs) || !fusable(rhs) || lhs.dtype() != rhs.dtype() ||
+      lhs.shape() != rhs.shape()) {
+    return std::nullopt;
+  }
+  auto node = std::make_shared<LazyNode>();
+  node->op = op;
+  node->lhs = node_of(lhs);
+  node->rhs = node_of(rhs);
+  return make_pending(std::move(node), std::nullopt, lhs.shape(), lhs.dtype(), requires_grad);
+}
+
+std::optional<DTensor> unary(PointwiseOp op, const DTensor &input, bool requires_grad,
+                             double min_value, double max_value) {
+  if (!t_lazy_mode || !fusable(input)) {
+    return std::nullopt;
+  }
+  auto node = std::make_shared<LazyNode>();
+  node->op = op;
+  node->lhs = node_of(input);
+  node->min_value = min_value;
+  node->max_value = max_value;
+  return make_pending(std::move(node), std::nullopt, input.shape(), input.dtype(),
+                      requires_grad);
+}
+
+std::optional<DTensor> reduce(Reduction reduction, const DTensor &input, bool requires_grad) {
+  if (!t_lazy_mode || !fusable(input)) {
+    return std::nullopt;
+  }
+  const auto expr = inlinable_expr(input);
+  if (!expr) {
+    return std::nullopt;
+  }
+  return make_pending(expr->root, reduction, input.shape(), input.dtype(), requires_grad);
+}
+
+} // namespace lazy
+
+} // namespace Tensor
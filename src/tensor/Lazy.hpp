@@ -0,0 +1,64 @@
+#pragma once
+
+#include "tensor/Tensor.hpp"
+
+#include <cstdint>
+#include <optional>
+
+namespace Tensor {
+
+// Opt-in deferred evaluation of pointwise chains. While a LazyGuard is alive on
+// a thread, add, sub, mul, relu and clamp on contiguous operands of one shape
+// and dtype return pending tensors that record an expression instead of
+// computing it, and sum/mean of a pending tensor folds the reduction in:
+//
+//   LazyGuard lazy;
+//   auto diff = ops::sub(prediction, target);
+//   auto loss = ops::mean(ops::mul(diff, diff)); // nothing computed yet
+//   ops::backward(loss);
+//
+// A pending tensor is computed the first time its data is accessed, in one
+// fused loop over its whole expression: intermediates live in L1-sized blocks
+// and are never written to memory. Operands that are themselves pending are
+// inlined, so a chain is fused however it was built. Each pending result that
+// requires grad gets a single autograd node for its expression, whose
+// backward is again one fused pass producing the gradients of every input.
+//
+// Inputs are read when the result is computed; modifying one in place before
+// then makes that read throw. Ops that do not qualify run eagerly as usual,
+// reading (and so computing) any pending operands.
+class LazyGuard {
+public:
+  LazyGuard() noexcept;
+  ~LazyGuard();
+  LazyGuard(const LazyGuard &) = delete;
+  LazyGuard &operator=(const LazyGuard &) = delete;
+
+private:
+  bool previous_;
+};
+
+bool lazy_mode_enabled() noexcept;
+
+// True while `tensor` is a pending lazy result that has not been computed.
+bool is_pending(const DTensor &tensor) noexcept;
+
+namespace lazy {
+
+enum class PointwiseOp : uint8_t { add, sub, mul, relu, clamp };
+enum class Reduction : uint8_t { sum, mean };
+
+// Hooks for the pointwise ops: the deferred result, or nullopt when lazy mode
+// is off or the operands cannot be fused. `requires_grad` says whether the
+// result records autograd history.
+std::optional<DTensor> binary(PointwiseOp op, const DTensor &lhs, const DTensor &rhs,
+                              bool requires_grad);
+std::optional<DTensor> unary(PointwiseOp op, const DTensor &input, bool requires_grad,
+                             double min_value = 0.0, double max_value = 0.0);
+// Only defers reductions of pending tensors; a materialized input is read once
+// by the eager kernel anyway.
+std::optional<DTensor> reduce(Reduction reduction, const DTensor &input, bool requires_grad);
+
+} // namespace lazy
+
+} // namespace Tensor
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Ops.hpp"
+#include "Optim.hpp"
 
 #include <vector>
 
@@ -8,9 +9,11 @@ namespace Tensor::nn {
 
 class Linear {
 public:
-  Linear(int64_t in_features, int64_t out_features);
+  Linear(int64_t in_features, int64_t out_features, DType dtype = DType::f32);
 
-  DTensor forward(const DTensor &input) const;
+  // activation(input @ weight + bias), fused into one GEMM pass.
+  DTensor forward(const DTensor &input,
+                  ops::Activation activation = ops::Activation::identity()) const;
 
   DTensor &weight() noexcept { return weight_; }
   const DTensor &weight() const noexcept { return weight_; }
@@ -24,15 +27,4 @@ private:
   DTensor bias_;
 };
 
-class SGD {
-public:
-  explicit SGD(float learning_rate) : learning_rate_(learning_rate) {}
-
-  void zero_grad(const std::vector<DTensor *> &parameters) const;
-  void step(const std::vector<DTensor *> &parameters) const;
-
-private:
-  float learning_rate_;
-};
-
 } // namespace Tensor::nn
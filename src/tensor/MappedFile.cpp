@@ -0,0 +1,59 @@
+#include "tensor/MappedFile.hpp"
+
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include "tensor/Allocator.hpp"
+
+#include <algorithm>
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Tensor {
+
+#if defined(_WIN32)
+MappedFile map_file(const std::string &path) {
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in) {
+    throw std::runtime_error("cannot open " + path);
+  }
+  const auto size = static_cast<std::size_t>(in.tellg());
+  in.seekg(0);
+  std::shared_ptr<void> block = allocate_host_block(std::max<std::size_t>(size, 1), 64);
+  if (!in.read(static_cast<char *>(block.get()), static_cast<std::streamsize>(size))) {
+    throw std::runtime_error("cannot read " + path);
+  }
+  return {block, static_cast<const unsigned char *>(block.get()), size};
+}
+#else
+MappedFile map_file(const std::string &path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::runtime_error("cannot open " + path);
+  }
+  struct stat info {};
+  if (::fstat(fd, &info) != 0) {
+    ::close(fd);
+    throw std::runtime_error("cannot stat " + path);
+  }
+  const auto size = static_cast<std::size_t>(info.st_size);
+  if (size == 0) {
+    ::close(fd);
+    return {};
+  }
+  void *address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (address == MAP_FAILED) {
+    throw std::runtime_error("cannot map " + path);
+  }
+  std::shared_ptr<void> block(address, [size](void *p) { ::munmap(p, size); });
+  return {block, static_cast<const unsigned char *>(address), size};
+}
+#endif
+
+} // namespace Tensor
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace Tensor {
+
+// A whole file mapped into memory. Storage built over it holds `block`, or an
+// aliasing shared_ptr to it, to keep the mapping alive.
+struct MappedFile {
+  std::shared_ptr<void> block;
+  const unsigned char *bytes{nullptr};
+  std::size_t size{0};
+};
+
+// Maps `path` privately and writably: pages are read on first touch, and
+// writes copy the touched pages instead of reaching the file, which must not
+// be truncated while the mapping is alive. Empty files give an empty mapping.
+// Where mmap is unavailable the file is read into a host block instead.
+// Throws std::runtime_error if the file cannot be opened or mapped.
+MappedFile map_file(const std::string &path);
+
+} // namespace Tensor
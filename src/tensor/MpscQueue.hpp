@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+
+namespace Tensor {
+
+struct MpscNode {
+  std::atomic<MpscNode *> next{nullptr};
+};
+
+// Vyukov's intrusive multi-producer, single-consumer queue. push is one atomic
+// exchange and never waits on other producers. pop must only be called from
+// the consumer thread; it can return null while a producer is halfway through
+// a push, so consumers pair the queue with a wake-up signal that producers
+// raise after pushing. The queue does not own its nodes.
+class MpscQueue {
+public:
+  MpscQueue() noexcept : head_(&stub_), tail_(&stub_) {}
+  MpscQueue(const MpscQueue &) = delete;
+  MpscQueue &operator=(const MpscQueue &) = delete;
+
+  void push(MpscNode *node) noexcept {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    MpscNode *previous = head_.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+  }
+
+  MpscNode *pop() noexcept {
+    MpscNode *tail = tail_;
+    MpscNode *next = tail->next.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (next == nullptr) {
+        return nullptr;
+      }
+      tail_ = next;
+      tail = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+      tail_ = next;
+      return tail;
+    }
+    if (tail != head_.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    // `tail` is the last node; park the stub behind it so it can be handed out.
+    push(&stub_);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      tail_ = next;
+      return tail;
+    }
+    return nullptr;
+  }
+
+private:
+  alignas(64) std::atomic<MpscNode *> head_;
+  alignas(64) MpscNode *tail_;
+  MpscNode stub_;
+};
+
+} // namespace Tensor
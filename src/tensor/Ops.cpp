@@ -1,10 +1,20 @@
 #include "tensor/Ops.hpp"
 
 #include "api/Api.hpp"
+#include "tensor/Arena.hpp"
+#include "tensor/Autograd.hpp"
+#include "tensor/Dispatch.hpp"
+#include "tensor/Elementwise.hpp"
+#include "tensor/Gemm.hpp"
+#include "tensor/Lazy.hpp"
+#include "tensor/Parallel.hpp"
+#include "tensor/Reduce.hpp"
+#include "tensor/TensorIterator.hpp"
 
 #include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <optional>
 #include <stdexcept>
 #include <utility>
 
@@ -12,17 +22,9 @@ namespace Tensor::ops {
 
 namespace {
 
-void require_contiguous(const DTensor &tensor, const char *op_name) {
-  if (!tensor.is_contiguous()) {
-    throw std::invalid_argument(std::string(op_name) +
-                                " only supports contiguous tensors");
-  }
-}
-
-void require_f32(const DTensor &tensor, const char *op_name) {
-  if (tensor.dtype() != DType::f32) {
-    throw std::invalid_argument(std::string(op_name) +
-                                " currently supports only f32 tensors");
+void require_same_dtype(const DTensor &lhs, const DTensor &rhs, const char *op_name) {
+  if (lhs.dtype() != rhs.dtype()) {
+    throw std::invalid_argument(std::string(op_name) + " requires matching dtypes");
   }
 }
 
@@ -32,303 +34,1073 @@ void require_same_shape(const DTensor &lhs, const DTensor &rhs, const char *op_n
   }
 }
 
-float *f32_data(DTensor &tensor) {
-  return static_cast<float *>(tensor.data());
+template <typename T> T *typed_data(DTensor &tensor) {
+  return static_cast<T *>(tensor.data());
 }
 
-const float *f32_data(const DTensor &tensor) {
-  return static_cast<const float *>(tensor.data());
+template <typename T> const T *typed_data(const DTensor &tensor) {
+  return static_cast<const T *>(tensor.data());
 }
 
-DTensor make_f32_tensor(const std::vector<int64_t> &shape, bool requires_grad = false) {
-  return api::zeros(shape, DType::f32, requires_grad);
+// Pointwise functors shared by the forward ops and their backward nodes. Each
+// one is instantiated for simd::Vec<T> of every dtype by the map kernels.
+constexpr auto kAdd = [](auto a, auto b) { return a + b; };
+constexpr auto kSub = [](auto a, auto b) { return a - b; };
+constexpr auto kMul = [](auto a, auto b) { return a * b; };
+constexpr auto kRelu = [](auto x) { return simd::maximum(x, decltype(x)(0)); };
+constexpr auto kNeg = [](auto x) { return -x; };
+
+// Runs a pointwise functor over strided, broadcast inputs into `result`, which
+// has their broadcast shape and may alias them elementwise. Dense same-shape
+// operands skip the iterator setup and go straight to the flat kernel.
+template <typename T, typename Op>
+void map_into(DTensor &result, const DTensor &input, const Op &op) {
+  if (result.is_contiguous() && input.is_contiguous() && input.shape() == result.shape()) {
+    kernels::map_contiguous(result.numel(), typed_data<T>(result), op, typed_data<T>(input));
+    return;
+  }
+  TensorIterator iter(result, {input});
+  kernels::map<T>(iter, op);
 }
 
-void add_inplace_f32(DTensor &dst, const DTensor &src) {
-  require_f32(dst, "add_inplace");
-  require_f32(src, "add_inplace");
-  require_contiguous(dst, "add_inplace");
-  require_contiguous(src, "add_inplace");
-  require_same_shape(dst, src, "add_inplace");
+template <typename T, typename Op>
+void map_into(DTensor &result, const DTensor &lhs, const DTensor &rhs, const Op &op) {
+  if (result.is_contiguous() && lhs.is_contiguous() && rhs.is_contiguous() &&
+      lhs.shape() == result.shape() && rhs.shape() == result.shape()) {
+    kernels::map_contiguous(result.numel(), typed_data<T>(result), op, typed_data<T>(lhs),
+                            typed_data<T>(rhs));
+    return;
+  }
+  TensorIterator iter(result, {lhs, rhs});
+  kernels::map<T>(iter, op);
+}
+
+// map_into a fresh contiguous tensor of the broadcast shape.
+template <typename T, typename Op>
+DTensor map_typed(const DTensor &input, const Op &op, bool requires_grad = false) {
+  DTensor result = api::empty(input.shape(), input.dtype(), requires_grad);
+  map_into<T>(result, input, op);
+  return result;
+}
+
+template <typename T, typename Op>
+DTensor map_typed(const DTensor &lhs, const DTensor &rhs, const Op &op,
+                  bool requires_grad = false) {
+  DTensor result = api::empty(lhs.shape() == rhs.shape()
+                                  ? lhs.shape()
+                                  : broadcast_shapes(lhs.shape(), rhs.shape()),
+                              lhs.dtype(), requires_grad);
+  map_into<T>(result, lhs, rhs, op);
+  return result;
+}
+
+// map_typed for functors that are generic over the dtype.
+template <typename Op>
+DTensor map_pointwise(const DTensor &input, const Op &op, bool requires_grad = false) {
+  return dispatch_dtype(input.dtype(), [&](auto tag) {
+    return map_typed<typename decltype(tag)::type>(input, op, requires_grad);
+  });
+}
+
+template <typename Op>
+DTensor map_pointwise(const DTensor &lhs, const DTensor &rhs, const Op &op,
+                      bool requires_grad = false) {
+  return dispatch_dtype(lhs.dtype(), [&](auto tag) {
+    return map_typed<typename decltype(tag)::type>(lhs, rhs, op, requires_grad);
+  });
+}
 
-  float *dst_ptr = f32_data(dst);
-  const float *src_ptr = f32_data(src);
-  for (int64_t index = 0; index < dst.numel(); ++index) {
-    dst_ptr[index] += src_ptr[index];
+template <typename Op>
+void map_pointwise_into(DTensor &result, const DTensor &lhs, const DTensor &rhs,
+                        const Op &op) {
+  dispatch_dtype(result.dtype(), [&](auto tag) {
+    map_into<typename decltype(tag)::type>(result, lhs, rhs, op);
+  });
+}
+
+// Which dims of `shape` a reduction over `dims` folds; an empty list folds
+// every dim.
+std::vector<bool> reduced_dims(const Dims &shape, const std::vector<int64_t> &dims,
+                               const char *op_name) {
+  const auto rank = static_cast<int64_t>(shape.size());
+  std::vector<bool> reduced(shape.size(), dims.empty());
+  for (const int64_t dim : dims) {
+    const int64_t axis = dim < 0 ? dim + rank : dim;
+    if (axis < 0 || axis >= rank) {
+      throw std::invalid_argument(std::string(op_name) + " dim out of range");
+    }
+    if (reduced[static_cast<std::size_t>(axis)]) {
+      throw std::invalid_argument(std::string(op_name) + " got a repeated dim");
+    }
+    reduced[static_cast<std::size_t>(axis)] = true;
   }
+  return reduced;
 }
 
-void scale_inplace_f32(DTensor &tensor, float scale) {
-  require_f32(tensor, "scale_inplace");
-  require_contiguous(tensor, "scale_inplace");
+// `shape` with the reduced dims set to 1, or dropped without keepdim. Reducing
+// every dim without keepdim gives {1}, like the scalar reductions.
+Dims reduced_shape(const Dims &shape, const std::vector<bool> &reduced, bool keepdim) {
+  Dims result;
+  for (std::size_t dim = 0; dim < shape.size(); ++dim) {
+    if (!reduced[dim]) {
+      result.push_back(shape[dim]);
+    } else if (keepdim) {
+      result.push_back(1);
+    }
+  }
+  if (result.empty()) {
+    result.push_back(1);
+  }
+  return result;
+}
 
-  float *ptr = f32_data(tensor);
-  for (int64_t index = 0; index < tensor.numel(); ++index) {
-    ptr[index] *= scale;
+int64_t reduced_count(const Dims &shape, const std::vector<bool> &reduced) {
+  int64_t count = 1;
+  for (std::size_t dim = 0; dim < shape.size(); ++dim) {
+    count *= reduced[dim] ? shape[dim] : 1;
   }
+  return count;
 }
 
-void accumulate_gradient(DTensor tensor, const DTensor &grad);
+// `tensor` as a contiguous tensor over the same elements, with its dims taken
+// outermost first by stride: dim i of the result is dim order[i] of `tensor`.
+// Permute and reshape views are relabeled in place; layouts with gaps or
+// repeated elements are copied in their own dim order.
+DTensor dense_layout(const DTensor &tensor, Dims &order) {
+  const std::size_t rank = tensor.shape().size();
+  order.assign(rank, 0);
+  for (std::size_t dim = 0; dim < rank; ++dim) {
+    order[dim] = static_cast<int64_t>(dim);
+  }
+  if (tensor.is_contiguous()) {
+    return tensor;
+  }
+  const Dims &stride = tensor.stride();
+  std::stable_sort(order.begin(), order.end(), [&stride](int64_t lhs, int64_t rhs) {
+    return stride[static_cast<std::size_t>(lhs)] > stride[static_cast<std::size_t>(rhs)];
+  });
+  Dims shape(rank);
+  int64_t running = 1;
+  bool dense = true;
+  for (std::size_t index = rank; index-- > 0;) {
+    const auto dim = static_cast<std::size_t>(order[index]);
+    shape[index] = tensor.shape()[dim];
+    if (shape[index] != 1) {
+      dense = dense && stride[dim] == running;
+      running *= shape[index];
+    }
+  }
+  if (!dense) {
+    for (std::size_t dim = 0; dim < rank; ++dim) {
+      order[dim] = static_cast<int64_t>(dim);
+    }
+    return clone(tensor);
+  }
+  return DTensor(tensor.storage(), shape, default_strides(shape), tensor.offset(),
+                 tensor.dtype(), true);
+}
 
-struct AddBackward final : AutogradNode {
-  AddBackward(DTensor lhs_in, DTensor rhs_in)
-      : lhs(std::move(lhs_in)), rhs(std::move(rhs_in)) {}
+// Puts the dims of `result`, contiguous and laid out in `order` as returned by
+// dense_layout, back in the order of the tensor it was computed from. Only a
+// result whose dims of size > 1 change places is copied.
+DTensor in_dim_order(const DTensor &result, const Dims &order) {
+  if (std::is_sorted(order.begin(), order.end())) {
+    return result;
+  }
+  Dims shape(order.size());
+  Dims stride(order.size());
+  for (std::size_t index = 0; index < order.size(); ++index) {
+    const auto dim = static_cast<std::size_t>(order[index]);
+    shape[dim] = result.shape()[index];
+    stride[dim] = result.stride()[index];
+  }
+  const Dims dense = default_strides(shape);
+  for (std::size_t dim = 0; dim < shape.size(); ++dim) {
+    if (shape[dim] == 1) {
+      stride[dim] = dense[dim];
+    }
+  }
+  const DTensor relabeled(result.storage(), shape, stride, result.offset(), result.dtype());
+  return relabeled.is_contiguous() ? relabeled : clone(relabeled);
+}
 
-  void backward(const DTensor &upstream) override {
-    if (lhs.requires_grad()) {
-      accumulate_gradient(lhs, upstream);
+// Folds the reduced dims of `tensor` into a fresh contiguous tensor that keeps
+// them with size 1. The dims are visited in memory order (dense_layout), so
+// permute and reshape views are read in place. Each run of adjacent reduced
+// dims is one [outer, size, inner] kernel pass, innermost run first, so every
+// pass reads its input contiguously.
+DTensor reduce_kept(kernels::ReduceOp op, const DTensor &tensor, const std::vector<bool> &reduced) {
+  Dims order;
+  DTensor current = dense_layout(tensor, order);
+  std::vector<bool> folds(reduced.size());
+  for (std::size_t index = 0; index < folds.size(); ++index) {
+    folds[index] = reduced[static_cast<std::size_t>(order[index])];
+  }
+  Dims shape = current.shape();
+  const auto product = [&shape](std::size_t begin, std::size_t end) {
+    int64_t count = 1;
+    for (std::size_t dim = begin; dim < end; ++dim) {
+      count *= shape[dim];
     }
-    if (rhs.requires_grad()) {
-      accumulate_gradient(rhs, upstream);
+    return count;
+  };
+  bool folded = false;
+  for (std::size_t end = shape.size(); end > 0;) {
+    if (!folds[end - 1]) {
+      --end;
+      continue;
+    }
+    std::size_t begin = end - 1;
+    while (begin > 0 && folds[begin - 1]) {
+      --begin;
+    }
+    const int64_t outer = product(0, begin);
+    const int64_t size = product(begin, end);
+    const int64_t inner = product(end, shape.size());
+    std::fill(shape.begin() + static_cast<std::ptrdiff_t>(begin),
+              shape.begin() + static_cast<std::ptrdiff_t>(end), int64_t{1});
+    DTensor next = api::empty(shape, tensor.dtype());
+    kernels::reduce_contiguous(op, tensor.dtype(), current.data(), next.data(), outer, size,
+                               inner);
+    current = std::move(next);
+    folded = true;
+    end = begin;
+  }
+  return in_dim_order(folded ? current : clone(current), order);
+}
+
+// `tensor`'s contiguous values under another shape of the same size.
+DTensor view_as_shape(const DTensor &tensor, const Dims &shape,
+                      bool requires_grad = false) {
+  const DTensor dense = tensor.is_contiguous() ? tensor : clone(tensor);
+  return DTensor(dense.storage(), shape, default_strides(shape), dense.offset(), dense.dtype(),
+                 true, requires_grad);
+}
+
+// Sums a gradient over the dims that were broadcast to reach its shape.
+DTensor reduce_to_shape(const DTensor &grad, const Dims &shape) {
+  if (grad.shape() == shape) {
+    return grad;
+  }
+  const std::size_t leading = grad.shape().size() - shape.size();
+  std::vector<bool> reduced(grad.shape().size());
+  for (std::size_t dim = 0; dim < reduced.size(); ++dim) {
+    reduced[dim] = dim < leading || (shape[dim - leading] == 1 && grad.shape()[dim] != 1);
+  }
+  return view_as_shape(reduce_kept(kernels::ReduceOp::sum, grad, reduced), shape);
+}
+
+// Fresh contiguous tensor with every element set to `value`.
+DTensor full_of(const Dims &shape, DType dtype, double value) {
+  DTensor result = api::empty(shape, dtype);
+  dispatch_dtype(dtype, [&](auto tag) {
+    using T = typename decltype(tag)::type;
+    kernels::fill_contiguous(result.numel(), typed_data<T>(result), static_cast<T>(value));
+  });
+  return result;
+}
+
+template <typename T> T first_value(const DTensor &tensor) {
+  return typed_data<T>(tensor)[0];
+}
+
+// A tensor a node reads during backward, with the storage version it had when
+// it was saved. Reading it after an in-place write throws instead of producing
+// wrong gradients.
+struct SavedTensor {
+  SavedTensor() = default;
+  explicit SavedTensor(DTensor value)
+      : tensor(std::move(value)), version(tensor.version()) {}
+
+  const DTensor &unpack(const char *op_name) const {
+    if (tensor.version() != version) {
+      throw std::runtime_error(std::string(op_name) +
+                               " backward: a saved tensor was modified by an in-place op");
     }
+    return tensor;
   }
 
-  DTensor lhs;
-  DTensor rhs;
+  DTensor tensor;
+  uint64_t version{0};
 };
 
-struct SubBackward final : AutogradNode {
-  SubBackward(DTensor lhs_in, DTensor rhs_in)
+// The parts of an input a node needs when it does not read its values: where
+// to send the gradient and the shape to reduce a broadcast gradient back to.
+struct NodeInput {
+  NodeInput() = default;
+  explicit NodeInput(const DTensor &tensor)
+      : edge(tensor.autograd_state()), shape(tensor.shape()) {}
+  NodeInput(AutogradEdge edge_in, Dims shape_in)
+      : edge(std::move(edge_in)), shape(std::move(shape_in)) {}
+
+  bool requires_grad() const noexcept { return edge_requires_grad(edge); }
+
+  AutogradEdge edge;
+  Dims shape;
+};
+
+// The same values reached through the same autograd history. An alias made
+// without grad reads the same elements but must not take the other's gradient.
+bool same_tensor(const DTensor &lhs, const DTensor &rhs) {
+  return lhs.storage() == rhs.storage() && lhs.offset() == rhs.offset() &&
+         lhs.shape() == rhs.shape() && lhs.stride() == rhs.stride() &&
+         lhs.autograd_state() == rhs.autograd_state();
+}
+
+constexpr int64_t kMaskWordBits = 64;
+
+// One bit per element, for nodes that only need to know where the gradient
+// passes through: 1/32 of the f32 tensor it replaces.
+struct PackedMask {
+  std::shared_ptr<Storage> words;
+  Dims shape;
+};
+
+// Packs pred(x) for every element of `values`, walking a dense copy when the
+// tensor is strided.
+template <typename Pred> PackedMask pack_mask(const DTensor &values, const Pred &pred) {
+  const DTensor dense = values.is_contiguous() ? values : clone(values);
+  const int64_t count = dense.numel();
+  const int64_t words = (count + kMaskWordBits - 1) / kMaskWordBits;
+  PackedMask mask{make_host_storage(static_cast<std::size_t>(words) * sizeof(uint64_t)),
+                  dense.shape()};
+  auto *bits = static_cast<uint64_t *>(mask.words->data());
+  dispatch_dtype(dense.dtype(), [&](auto tag) {
+    using T = typename decltype(tag)::type;
+    const T *src = typed_data<T>(dense);
+    parallel_for(0, words, kDefaultGrainSize / kMaskWordBits, [&](int64_t begin, int64_t end) {
+      for (int64_t word = begin; word < end; ++word) {
+        const int64_t first = word * kMaskWordBits;
+        const int64_t last = std::min(count, first + kMaskWordBits);
+        uint64_t packed = 0;
+        for (int64_t index = first; index < last; ++index) {
+          packed |= static_cast<uint64_t>(pred(src[index]) ? 1 : 0) << (index - first);
+        }
+        bits[word] = packed;
+      }
+    });
+  });
+  return mask;
+}
+
+// `upstream` where the mask is set and zero elsewhere.
+DTensor apply_mask(const DTensor &upstream, const PackedMask &mask) {
+  const DTensor dense = upstream.is_contiguous() ? upstream : clone(upstream);
+  DTensor result = api::empty(mask.shape, dense.dtype());
+  const int64_t count = result.numel();
+  const int64_t words = (count + kMaskWordBits - 1) / kMaskWordBits;
+  const auto *bits = static_cast<const uint64_t *>(mask.words->data());
+  dispatch_dtype(dense.dtype(), [&](auto tag) {
+    using T = typename decltype(tag)::type;
+    const T *src = typed_data<T>(dense);
+    T *dst = typed_data<T>(result);
+    parallel_for(0, words, kDefaultGrainSize / kMaskWordBits, [&](int64_t begin, int64_t end) {
+      for (int64_t word = begin; word < end; ++word) {
+        const int64_t first = word * kMaskWordBits;
+        const int64_t last = std::min(count, first + kMaskWordBits);
+        const uint64_t packed = bits[word];
+        for (int64_t index = first; index < last; ++index) {
+          dst[index] = ((packed >> (index - first)) & 1U) != 0 ? src[index] : T{0};
+        }
+      }
+    });
+  });
+  return result;
+}
+
+constexpr auto kReluMask = [](auto x) { return x > decltype(x){0}; };
+
+auto clamp_mask(double min_value, double max_value) {
+  return [min_value, max_value](auto x) {
+    using T = decltype(x);
+    return x > static_cast<T>(min_value) && x < static_cast<T>(max_value);
+  };
+}
+
+// Nodes fill grads[i] with the gradient for input(i); the autograd engine sums
+// contributions per node and routes them on. They keep edges rather than input
+// tensors, so an input's storage lives on only when backward reads it.
+struct BinaryNode : AutogradNode {
+  std::size_t num_inputs() const noexcept override { return 2; }
+};
+
+struct UnaryNode : AutogradNode {
+  std::size_t num_inputs() const noexcept override { return 1; }
+};
+
+struct AddBackward final : BinaryNode {
+  AddBackward(NodeInput lhs_in, NodeInput rhs_in)
       : lhs(std::move(lhs_in)), rhs(std::move(rhs_in)) {}
 
-  void backward(const DTensor &upstream) override {
+  const AutogradEdge &input(std::size_t index) const noexcept override {
+    return index == 0 ? lhs.edge : rhs.edge;
+  }
+
+  void backward(const DTensor &upstream, std::vector<DTensor> &grads) override {
     if (lhs.requires_grad()) {
-      accumulate_gradient(lhs, upstream);
+      grads[0] = reduce_to_shape(upstream, lhs.shape);
     }
     if (rhs.requires_grad()) {
-      DTensor grad_rhs = clone(upstream);
-      scale_inplace_f32(grad_rhs, -1.0f);
-      accumulate_gradient(rhs, grad_rhs);
+      grads[1] = reduce_to_shape(upstream, rhs.shape);
     }
   }
 
-  DTensor lhs;
-  DTensor rhs;
+  NodeInput lhs;
+  NodeInput rhs;
 };
 
-struct MulBackward final : AutogradNode {
-  MulBackward(DTensor lhs_in, DTensor rhs_in)
+struct SubBackward final : BinaryNode {
+  SubBackward(NodeInput lhs_in, NodeInput rhs_in)
       : lhs(std::move(lhs_in)), rhs(std::move(rhs_in)) {}
 
-  void backward(const DTensor &upstream) override {
+  const AutogradEdge &input(std::size_t index) const noexcept override {
+    return index == 0 ? lhs.edge : rhs.edge;
+  }
+
+  void backward(const DTensor &upstream, std::vector<DTensor> &grads) override {
     if (lhs.requires_grad()) {
-      DTensor grad_lhs = make_f32_tensor(lhs.shape());
-      float *dst = f32_data(grad_lhs);
-      const float *up = f32_data(upstream);
-      const float *rhs_ptr = f32_data(rhs);
-      for (int64_t index = 0; index < lhs.numel(); ++index) {
-        dst[index] = up[index] * rhs_ptr[index];
-      }
-      accumulate_gradient(lhs, grad_lhs);
+      grads[0] = reduce_to_shape(upstream, lhs.shape);
     }
-
     if (rhs.requires_grad()) {
-      DTensor grad_rhs = make_f32_tensor(rhs.shape());
-      float *dst = f32_data(grad_rhs);
-      const float *up = f32_data(upstream);
-      const float *lhs_ptr = f32_data(lhs);
-      for (int64_t index = 0; index < rhs.numel(); ++index) {
-        dst[index] = up[index] * lhs_ptr[index];
-      }
-      accumulate_gradient(rhs, grad_rhs);
+      grads[1] = map_pointwise(reduce_to_shape(upstream, rhs.shape), kNeg);
     }
   }
 
-  DTensor lhs;
-  DTensor rhs;
+  NodeInput lhs;
+  NodeInput rhs;
 };
 
-struct SumBackward final : AutogradNode {
-  explicit SumBackward(DTensor input_in) : input(std::move(input_in)) {}
+// Each operand's values are saved only when the other one requires grad. A
+// tensor multiplied by itself is saved once and its two gradient halves are
+// summed here rather than by the engine.
+struct MulBackward final : BinaryNode {
+  MulBackward(NodeInput lhs_in, NodeInput rhs_in, SavedTensor lhs_value_in,
+              SavedTensor rhs_value_in, bool same_operand_in)
+      : lhs(std::move(lhs_in)), rhs(std::move(rhs_in)), lhs_value(std::move(lhs_value_in)),
+        rhs_value(std::move(rhs_value_in)), same_operand(same_operand_in) {}
+
+  const AutogradEdge &input(std::size_t index) const noexcept override {
+    return index == 0 ? lhs.edge : rhs.edge;
+  }
 
-  void backward(const DTensor &upstream) override {
-    if (!input.requires_grad()) {
+  void backward(const DTensor &upstream, std::vector<DTensor> &grads) override {
+    if (same_operand) {
+      grads[0] = map_pointwise(upstream, lhs_value.unpack("mul"), [](auto up, auto x) {
+        const auto half = up * x;
+        return half + half;
+      });
       return;
     }
-
-    DTensor grad_input = make_f32_tensor(input.shape());
-    const float scalar = f32_data(upstream)[0];
-    float *dst = f32_data(grad_input);
-    for (int64_t index = 0; index < input.numel(); ++index) {
-      dst[index] = scalar;
+    if (lhs.requires_grad()) {
+      grads[0] = reduce_to_shape(map_pointwise(upstream, rhs_value.unpack("mul"), kMul),
+                                 lhs.shape);
+    }
+    if (rhs.requires_grad()) {
+      grads[1] = reduce_to_shape(map_pointwise(upstream, lhs_value.unpack("mul"), kMul),
+                                 rhs.shape);
     }
-    accumulate_gradient(input, grad_input);
   }
 
-  DTensor input;
+  NodeInput lhs;
+  NodeInput rhs;
+  SavedTensor lhs_value;
+  SavedTensor rhs_value;
+  bool same_operand;
 };
 
-struct MeanBackward final : AutogradNode {
-  explicit MeanBackward(DTensor input_in) : input(std::move(input_in)) {}
-
-  void backward(const DTensor &upstream) override {
-    if (!input.requires_grad()) {
+// The upstream gradient of a reduction, viewed with the reduced dims kept,
+// broadcast back over `shape` and divided by `divisor` (the reduced count for
+// mean, 1 for sum).
+DTensor expand_gradient(const DTensor &upstream, const Dims &kept_shape,
+                        const Dims &shape, int64_t divisor) {
+  const DTensor kept = view_as_shape(upstream, kept_shape);
+  DTensor result = api::empty(shape, upstream.dtype());
+  dispatch_dtype(upstream.dtype(), [&](auto tag) {
+    using T = typename decltype(tag)::type;
+    if (divisor == 1) {
+      map_into<T>(result, kept, [](auto x) { return x; });
       return;
     }
+    const auto scale = static_cast<T>(divisor);
+    map_into<T>(result, kept, [scale](auto x) { return x / decltype(x)(scale); });
+  });
+  return result;
+}
 
-    DTensor grad_input = make_f32_tensor(input.shape());
-    const float scalar = f32_data(upstream)[0] /
-                         static_cast<float>(std::max<int64_t>(input.numel(), 1));
-    float *dst = f32_data(grad_input);
-    for (int64_t index = 0; index < input.numel(); ++index) {
-      dst[index] = scalar;
-    }
-    accumulate_gradient(input, grad_input);
+// sum and mean: every reduced element receives the upstream value of its
+// output, scaled by 1/count for mean.
+struct ReduceBackward final : UnaryNode {
+  ReduceBackward(NodeInput input_in, Dims kept_shape_in, int64_t divisor_in)
+      : input_info(std::move(input_in)), kept_shape(std::move(kept_shape_in)),
+        divisor(divisor_in) {}
+
+  const AutogradEdge &input(std::size_t) const noexcept override { return input_info.edge; }
+
+  void backward(const DTensor &upstream, std::vector<DTensor> &grads) override {
+    grads[0] = expand_gradient(upstream, kept_shape, input_info.shape, divisor);
   }
 
-  DTensor input;
+  NodeInput input_info;
+  Dims kept_shape;
+  int64_t divisor;
 };
 
-struct ReluBackward final : AutogradNode {
-  explicit ReluBackward(DTensor input_in) : input(std::move(input_in)) {}
+// max and min: the gradient reaches the elements equal to their output, split
+// evenly between ties. Saves a bit mask of those elements and the tie counts,
+// which are output-sized.
+struct ExtremumBackward final : UnaryNode {
+  ExtremumBackward(AutogradEdge edge_in, PackedMask mask_in, DTensor ties_in)
+      : edge(std::move(edge_in)), mask(std::move(mask_in)), ties(std::move(ties_in)) {}
+
+  const AutogradEdge &input(std::size_t) const noexcept override { return edge; }
+
+  void backward(const DTensor &upstream, std::vector<DTensor> &grads) override {
+    const DTensor share =
+        map_pointwise(view_as_shape(upstream, ties.shape()), ties, [](auto up, auto count) {
+          // Masked tail lanes load a count of zero, which would trap an
+          // integer division.
+          using V = decltype(count);
+          return up / simd::select(count > V(0), count, V(1));
+        });
+    grads[0] = apply_mask(expand_gradient(share, ties.shape(), mask.shape, 1), mask);
+  }
 
-  void backward(const DTensor &upstream) override {
-    if (!input.requires_grad()) {
-      return;
+  AutogradEdge edge;
+  PackedMask mask;
+  DTensor ties;
+};
+
+// relu and clamp pass the gradient through exactly where their output is
+// strictly inside the clamped range, so both save that as a bit mask built
+// from the output and keep neither the input nor the output alive.
+struct MaskBackward final : UnaryNode {
+  MaskBackward(AutogradEdge edge_in, PackedMask mask_in)
+      : edge(std::move(edge_in)), mask(std::move(mask_in)) {}
+
+  const AutogradEdge &input(std::size_t) const noexcept override { return edge; }
+
+  void backward(const DTensor &upstream, std::vector<DTensor> &grads) override {
+    grads[0] = apply_mask(upstream, mask);
+  }
+
+  AutogradEdge edge;
+  PackedMask mask;
+};
+
+// grad_lhs = up[m, n] * rhs[k, n]^T and grad_rhs = lhs[m, k]^T * up; the
+// transposes are expressed through strides so neither operand is copied.
+DTensor matmul_grad_lhs(const DTensor &upstream, const DTensor &rhs, int64_t m, int64_t k,
+                        int64_t n) {
+  DTensor grad = api::empty({m, k}, upstream.dtype());
+  dispatch_dtype(upstream.dtype(), [&](auto tag) {
+    using T = typename decltype(tag)::type;
+    kernels::gemm_strided<T>(m, k, n, T{1}, typed_data<T>(upstream), upstream.stride()[0],
+                             upstream.stride()[1], typed_data<T>(rhs), rhs.stride()[1],
+                             rhs.stride()[0], T{0}, typed_data<T>(grad), k);
+  });
+  return grad;
+}
+
+DTensor matmul_grad_rhs(const DTensor &lhs, const DTensor &upstream, int64_t m, int64_t k,
+                        int64_t n) {
+  DTensor grad = api::empty({k, n}, upstream.dtype());
+  dispatch_dtype(upstream.dtype(), [&](auto tag) {
+    using T = typename decltype(tag)::type;
+    kernels::gemm_strided<T>(k, n, m, T{1}, typed_data<T>(lhs), lhs.stride()[1],
+                             lhs.stride()[0], typed_data<T>(upstream), upstream.stride()[0],
+                             upstream.stride()[1], T{0}, typed_data<T>(grad), n);
+  });
+  return grad;
+}
+
+// The product's values of one side are only needed for the other side's
+// gradient, so each operand is saved only when the other requires grad.
+struct MatmulBackward final : BinaryNode {
+  MatmulBackward(const DTensor &lhs_in, const DTensor &rhs_in)
+      : lhs_edge(lhs_in.autograd_state()), rhs_edge(rhs_in.autograd_state()),
+        m(lhs_in.shape()[0]), k(lhs_in.shape()[1]), n(rhs_in.shape()[1]) {
+    if (rhs_in.requires_grad()) {
+      saved_lhs = SavedTensor(lhs_in);
+    }
+    if (lhs_in.requires_grad()) {
+      saved_rhs = SavedTensor(rhs_in);
     }
+  }
+
+  const AutogradEdge &input(std::size_t index) const noexcept override {
+    return index == 0 ? lhs_edge : rhs_edge;
+  }
 
-    DTensor grad_input = make_f32_tensor(input.shape());
-    float *dst = f32_data(grad_input);
-    const float *up = f32_data(upstream);
-    const float *in = f32_data(input);
-    for (int64_t index = 0; index < input.numel(); ++index) {
-      dst[index] = in[index] > 0.0f ? up[index] : 0.0f;
+  void backward(const DTensor &upstream, std::vector<DTensor> &grads) override {
+    if (edge_requires_grad(lhs_edge)) {
+      grads[0] = matmul_grad_lhs(upstream, saved_rhs.unpack("matmul"), m, k, n);
+    }
+    if (edge_requires_grad(rhs_edge)) {
+      grads[1] = matmul_grad_rhs(saved_lhs.unpack("matmul"), upstream, m, k, n);
     }
-    accumulate_gradient(input, grad_input);
   }
 
-  DTensor input;
+  AutogradEdge lhs_edge;
+  AutogradEdge rhs_edge;
+  SavedTensor saved_lhs;
+  SavedTensor saved_rhs;
+  int64_t m;
+  int64_t k;
+  int64_t n;
 };
 
-struct ClampBackward final : AutogradNode {
-  ClampBackward(DTensor input_in, float min_in, float max_in)
-      : input(std::move(input_in)), min_value(min_in), max_value(max_in) {}
-
-  void backward(const DTensor &upstream) override {
-    if (!input.requires_grad()) {
-      return;
+// One node for linear's matmul, bias and activation. Like the unfused ops it
+// saves the input and weight only for each other's gradient, plus the
+// activation's mask.
+struct LinearBackward final : AutogradNode {
+  LinearBackward(const DTensor &input_in, const DTensor &weight_in, const DTensor &bias_in,
+                 std::optional<PackedMask> mask_in)
+      : edges{input_in.autograd_state(), weight_in.autograd_state(),
+              bias_in.defined() ? bias_in.autograd_state() : AutogradEdge{}},
+        mask(std::move(mask_in)), m(input_in.shape()[0]), k(input_in.shape()[1]),
+        n(weight_in.shape()[1]) {
+    if (weight_in.requires_grad()) {
+      saved_input = SavedTensor(input_in);
+    }
+    if (input_in.requires_grad()) {
+      saved_weight = SavedTensor(weight_in);
+    }
+    if (bias_in.defined()) {
+      bias_shape = bias_in.shape();
     }
+  }
+
+  std::size_t num_inputs() const noexcept override { return 3; }
+  const AutogradEdge &input(std::size_t index) const noexcept override { return edges[index]; }
 
-    DTensor grad_input = make_f32_tensor(input.shape());
-    float *dst = f32_data(grad_input);
-    const float *up = f32_data(upstream);
-    const float *in = f32_data(input);
-    for (int64_t index = 0; index < input.numel(); ++index) {
-      const bool active = in[index] > min_value && in[index] < max_value;
-      dst[index] = active ? up[index] : 0.0f;
+  void backward(const DTensor &upstream, std::vector<DTensor> &grads) override {
+    const DTensor grad = mask ? apply_mask(upstream, *mask) : upstream;
+    if (edge_requires_grad(edges[0])) {
+      grads[0] = matmul_grad_lhs(grad, saved_weight.unpack("linear"), m, k, n);
+    }
+    if (edge_requires_grad(edges[1])) {
+      grads[1] = matmul_grad_rhs(saved_input.unpack("linear"), grad, m, k, n);
+    }
+    if (edge_requires_grad(edges[2])) {
+      grads[2] = reduce_to_shape(grad, bias_shape);
     }
-    accumulate_gradient(input, grad_input);
   }
 
-  DTensor input;
-  float min_value;
-  float max_value;
+  AutogradEdge edges[3];
+  SavedTensor saved_input;
+  SavedTensor saved_weight;
+  Dims bias_shape;
+  std::optional<PackedMask> mask;
+  int64_t m;
+  int64_t k;
+  int64_t n;
 };
 
-struct MatmulBackward final : AutogradNode {
-  MatmulBackward(DTensor lhs_in, DTensor rhs_in)
-      : lhs(std::move(lhs_in)), rhs(std::move(rhs_in)) {}
+// reshape and permute views of a tensor that requires grad get their own
+// autograd state and one of these nodes, which lays the view's gradient out
+// in the base's shape, rather than sharing the base's state.
+struct ViewBackward : UnaryNode {
+  explicit ViewBackward(NodeInput input_in) : input_info(std::move(input_in)) {}
 
-  void backward(const DTensor &upstream) override {
-    const int64_t m = lhs.shape()[0];
-    const int64_t k = lhs.shape()[1];
-    const int64_t n = rhs.shape()[1];
+  const AutogradEdge &input(std::size_t) const noexcept override { return input_info.edge; }
 
-    const float *lhs_ptr = f32_data(lhs);
-    const float *rhs_ptr = f32_data(rhs);
-    const float *up_ptr = f32_data(upstream);
+  NodeInput input_info;
+};
 
-    if (lhs.requires_grad()) {
-      DTensor grad_lhs = make_f32_tensor(lhs.shape());
-      float *dst = f32_data(grad_lhs);
-      for (int64_t row = 0; row < m; ++row) {
-        for (int64_t inner = 0; inner < k; ++inner) {
-          float acc = 0.0f;
-          for (int64_t col = 0; col < n; ++col) {
-            acc += up_ptr[row * n + col] * rhs_ptr[inner * n + col];
-          }
-          dst[row * k + inner] = acc;
-        }
-      }
-      accumulate_gradient(lhs, grad_lhs);
-    }
+struct ReshapeBackward final : ViewBackward {
+  using ViewBackward::ViewBackward;
 
-    if (rhs.requires_grad()) {
-      DTensor grad_rhs = make_f32_tensor(rhs.shape());
-      float *dst = f32_data(grad_rhs);
-      for (int64_t inner = 0; inner < k; ++inner) {
-        for (int64_t col = 0; col < n; ++col) {
-          float acc = 0.0f;
-          for (int64_t row = 0; row < m; ++row) {
-            acc += lhs_ptr[row * k + inner] * up_ptr[row * n + col];
-          }
-          dst[inner * n + col] = acc;
-        }
-      }
-      accumulate_gradient(rhs, grad_rhs);
-    }
+  void backward(const DTensor &upstream, std::vector<DTensor> &grads) override {
+    grads[0] = view_as_shape(upstream, input_info.shape);
+  }
+};
+
+struct PermuteBackward final : ViewBackward {
+  PermuteBackward(NodeInput input_in, Dims inverse_in)
+      : ViewBackward(std::move(input_in)), inverse(std::move(inverse_in)) {}
+
+  void backward(const DTensor &upstream, std::vector<DTensor> &grads) override {
+    grads[0] = clone(permute(upstream, inverse));
   }
 
-  DTensor lhs;
-  DTensor rhs;
+  Dims inverse;
 };
 
-struct BiasAddBackward final : AutogradNode {
-  BiasAddBackward(DTensor value_in, DTensor bias_in)
+struct BiasAddBackward final : BinaryNode {
+  BiasAddBackward(NodeInput value_in, NodeInput bias_in)
       : value(std::move(value_in)), bias(std::move(bias_in)) {}
 
-  void backward(const DTensor &upstream) override {
+  const AutogradEdge &input(std::size_t index) const noexcept override {
+    return index == 0 ? value.edge : bias.edge;
+  }
+
+  void backward(const DTensor &upstream, std::vector<DTensor> &grads) override {
     if (value.requires_grad()) {
-      accumulate_gradient(value, upstream);
+      grads[0] = upstream;
     }
-
-    if (!bias.requires_grad()) {
-      return;
+    // reduce_to_shape folds the rows in fixed runs and combines the runs
+    // pairwise, so the result does not depend on the thread count.
+    if (bias.requires_grad()) {
+      grads[1] = reduce_to_shape(upstream, bias.shape);
     }
+  }
+
+  NodeInput value;
+  NodeInput bias;
+};
 
-    const int64_t rows = upstream.shape()[0];
-    const int64_t cols = upstream.shape()[1];
-    DTensor grad_bias = make_f32_tensor(bias.shape());
-    float *dst = f32_data(grad_bias);
-    const float *up = f32_data(upstream);
-    for (int64_t col = 0; col < cols; ++col) {
-      float acc = 0.0f;
-      for (int64_t row = 0; row < rows; ++row) {
-        acc += up[row * cols + col];
+enum class LossKind : uint8_t { mse, l1, huber };
+
+// Per-element loss of d = prediction - target and its derivative in d, for
+// simd::Vec<T>. Huber is quadratic within delta and linear beyond it.
+template <LossKind Kind, typename V> V loss_value(const V &d, const V &delta) {
+  if constexpr (Kind == LossKind::mse) {
+    return d * d;
+  } else if constexpr (Kind == LossKind::l1) {
+    return simd::maximum(d, -d);
+  } else {
+    const V magnitude = simd::maximum(d, -d);
+    const V half(0.5);
+    return simd::select(magnitude <= delta, half * d * d, delta * (magnitude - half * delta));
+  }
+}
+
+template <LossKind Kind, typename V> V loss_slope(const V &d, const V &delta) {
+  if constexpr (Kind == LossKind::mse) {
+    return d + d;
+  } else if constexpr (Kind == LossKind::l1) {
+    const V zero(0);
+    return simd::select(d > zero, V(1), simd::select(d < zero, V(-1), zero));
+  } else {
+    return simd::clamp(d, -delta, delta);
+  }
+}
+
+template <typename F> decltype(auto) dispatch_loss(LossKind kind, F &&fn) {
+  switch (kind) {
+  case LossKind::mse:
+    return fn(std::integral_constant<LossKind, LossKind::mse>{});
+  case LossKind::l1:
+    return fn(std::integral_constant<LossKind, LossKind::l1>{});
+  case LossKind::huber:
+    break;
+  }
+  return fn(std::integral_constant<LossKind, LossKind::huber>{});
+}
+
+// Sum of the per-element loss in one pass over both operands. Each block of
+// terms is staged in L1 and folded like a row of ops::sum, and the blocks are
+// combined pairwise.
+template <LossKind Kind, typename T>
+T loss_sum(const T *prediction, const T *target, int64_t count, T delta) {
+  const int64_t blocks = (count + kernels::kReduceBlock - 1) / kernels::kReduceBlock;
+  std::vector<T> partials(static_cast<std::size_t>(blocks));
+  parallel_for(0, blocks, kDefaultGrainSize / kernels::kReduceBlock,
+               [&](int64_t begin, int64_t end) {
+                 T terms[kernels::kReduceBlock];
+                 for (int64_t block = begin; block < end; ++block) {
+                   const int64_t first = block * kernels::kReduceBlock;
+                   const int64_t len = std::min(kernels::kReduceBlock, count - first);
+                   kernels::map_contiguous_serial(
+                       len, terms,
+                       [delta](auto p, auto t) {
+                         return loss_value<Kind>(p - t, decltype(p)(delta));
+                       },
+                       prediction + first, target + first);
+                   partials[static_cast<std::size_t>(block)] = kernels::sum_block(terms, len);
+                 }
+               });
+  return kernels::pairwise_sum(partials.data(), blocks);
+}
+
+// Backward of a mean loss: scale * slope(d) for the prediction and its negation
+// for the target, both written in the same pass. Either output may be null.
+template <LossKind Kind, typename T>
+void loss_grads(const T *prediction, const T *target, int64_t count, T delta, T scale,
+                T *prediction_grad, T *target_grad) {
+  using V = simd::Vec<T>;
+  parallel_for(0, count, kDefaultGrainSize, [&](int64_t begin, int64_t end) {
+    const auto step = [&](int64_t index, int64_t len) {
+      const bool full = len == V::size;
+      const V p = full ? V::load(prediction + index) : V::load_partial(prediction + index, len);
+      const V t = full ? V::load(target + index) : V::load_partial(target + index, len);
+      const V grad = loss_slope<Kind>(p - t, V(delta)) * V(scale);
+      if (prediction_grad != nullptr) {
+        full ? grad.store(prediction_grad + index)
+             : grad.store_partial(prediction_grad + index, len);
+      }
+      if (target_grad != nullptr) {
+        const V negated = -grad;
+        full ? negated.store(target_grad + index)
+             : negated.store_partial(target_grad + index, len);
       }
-      dst[col] = acc;
+    };
+    int64_t index = begin;
+    for (; index + V::size <= end; index += V::size) {
+      step(index, V::size);
+    }
+    if (index < end) {
+      step(index, end - index);
     }
-    accumulate_gradient(bias, grad_bias);
+  });
+}
+
+struct LossBackward final : BinaryNode {
+  LossBackward(LossKind kind_in, NodeInput prediction_in, NodeInput target_in,
+               SavedTensor prediction_value_in, SavedTensor target_value_in, double delta_in)
+      : kind(kind_in), prediction(std::move(prediction_in)), target(std::move(target_in)),
+        prediction_value(std::move(prediction_value_in)),
+        target_value(std::move(target_value_in)), delta(delta_in) {}
+
+  const AutogradEdge &input(std::size_t index) const noexcept override {
+    return index == 0 ? prediction.edge : target.edge;
   }
 
-  DTensor value;
-  DTensor bias;
+  void backward(const DTensor &upstream, std::vector<DTensor> &grads) override {
+    const DTensor &p = prediction_value.unpack("loss");
+    const DTensor &t = target_value.unpack("loss");
+    const int64_t count = p.numel();
+    if (prediction.requires_grad()) {
+      grads[0] = api::empty(prediction.shape, p.dtype());
+    }
+    if (target.requires_grad()) {
+      grads[1] = api::empty(target.shape, p.dtype());
+    }
+    dispatch_dtype(p.dtype(), [&](auto tag) {
+      using T = typename decltype(tag)::type;
+      const auto divisor = static_cast<double>(std::max<int64_t>(count, 1));
+      const auto scale = static_cast<T>(first_value<T>(upstream) / divisor);
+      dispatch_loss(kind, [&](auto loss) {
+        loss_grads<decltype(loss)::value>(
+            typed_data<T>(p), typed_data<T>(t), count, static_cast<T>(delta), scale,
+            grads[0].defined() ? typed_data<T>(grads[0]) : nullptr,
+            grads[1].defined() ? typed_data<T>(grads[1]) : nullptr);
+      });
+    });
+  }
+
+  LossKind kind;
+  NodeInput prediction;
+  NodeInput target;
+  SavedTensor prediction_value;
+  SavedTensor target_value;
+  double delta;
 };
 
-void accumulate_gradient(DTensor tensor, const DTensor &grad) {
-  if (!tensor.requires_grad()) {
-    return;
+// Whether an op on these inputs records autograd history.
+template <typename... Inputs> bool records_grad(const Inputs &...inputs) {
+  if (!grad_mode_enabled()) {
+    return false;
   }
+  (require_current_history(inputs), ...);
+  return (inputs.requires_grad() || ...);
+}
+
+void require_broadcasts_to(const DTensor &input, const DTensor &target, const char *op_name) {
+  if (broadcast_shapes(target.shape(), input.shape()) != target.shape()) {
+    throw std::invalid_argument(std::string(op_name) + " cannot broadcast into its output");
+  }
+}
+
+// A leaf's gradient is accumulated into its current values, so autograd cannot
+// allow them to change underneath it while it is recording.
+void require_inplace_allowed(const DTensor &self, const char *op_name) {
+  if (grad_mode_enabled() && self.requires_grad() && self.is_leaf()) {
+    throw std::invalid_argument(std::string(op_name) +
+                                " cannot modify a leaf tensor that requires grad");
+  }
+  // The base's history would not see the write.
+  if (grad_mode_enabled() && dynamic_cast<const ViewBackward *>(self.grad_fn().get())) {
+    throw std::invalid_argument(std::string(op_name) +
+                                " cannot modify a view of a tensor that requires grad");
+  }
+}
 
-  if (tensor.is_leaf()) {
-    if (!tensor.grad()) {
-      tensor.set_grad(std::make_shared<DTensor>(clone(grad)));
-    } else {
-      add_inplace_f32(*tensor.grad(), grad);
+// An out= variant overwrites `out` without recording history, so any history
+// `out` already has would describe values it no longer holds.
+void require_plain_output(const DTensor &out, const char *op_name) {
+  require_inplace_allowed(out, op_name);
+  if (grad_mode_enabled() && out.requires_grad()) {
+    throw std::invalid_argument(std::string(op_name) +
+                                " cannot write into a tensor with autograd history");
+  }
+}
+
+void require_no_grad(const DTensor &lhs, const DTensor &rhs, const char *op_name) {
+  if (records_grad(lhs, rhs)) {
+    throw std::invalid_argument(std::string(op_name) + " does not record autograd history");
+  }
+}
+
+// Edge to self's autograd history before the in-place op. record_inplace
+// moves self onto a fresh state, so this one stays with the nodes that already
+// consumed self and keeps routing their gradients to the old history.
+AutogradEdge history_of(const DTensor &self) {
+  if (!self.autograd_state()) {
+    if (self.is_inference()) {
+      throw std::runtime_error(
+          "in-place ops cannot record autograd history on an inference tensor");
     }
+    return {};
   }
+  return self.autograd_state();
+}
+
+// Other handles to self's storage keep the old state, which no longer
+// describes the values they read; the epoch bump makes autograd refuse them.
+void record_inplace(DTensor &self, std::shared_ptr<AutogradNode> node) {
+  self.storage()->bump_history_epoch();
+  auto state = make_arena_shared<TensorAutogradState>();
+  state->requires_grad = true;
+  state->is_leaf = false;
+  state->grad_fn = std::move(node);
+  state->history_epoch = self.storage()->history_epoch();
+  self = DTensor(self.storage(), self.shape(), self.stride(), self.offset(), self.dtype(),
+                 self.is_contiguous(), true, std::move(state));
+}
 
-  if (auto fn = tensor.grad_fn()) {
-    fn->backward(grad);
+static_assert(static_cast<int>(ActivationKind::clamp) ==
+              static_cast<int>(kernels::Activation::clamp));
+
+// `bias`, when defined, holds N contiguous values the epilogue adds before
+// `activation`.
+void matmul_into(const DTensor &lhs, const DTensor &rhs, DTensor &out,
+                 const DTensor &bias = {}, Activation activation = Activation::identity()) {
+  const int64_t m = lhs.shape()[0];
+  const int64_t k = lhs.shape()[1];
+  const int64_t n = rhs.shape()[1];
+  dispatch_dtype(lhs.dtype(), [&](auto tag) {
+    using T = typename decltype(tag)::type;
+    kernels::Epilogue<T> epilogue;
+    epilogue.bias = bias.defined() ? typed_data<T>(bias) : nullptr;
+    epilogue.activation = static_cast<kernels::Activation>(activation.kind);
+    epilogue.min_value = static_cast<T>(activation.min_value);
+    epilogue.max_value = static_cast<T>(activation.max_value);
+    kernels::gemm_strided<T>(m, n, k, T{1}, typed_data<T>(lhs), lhs.stride()[0],
+                             lhs.stride()[1], typed_data<T>(rhs), rhs.stride()[0],
+                             rhs.stride()[1], T{0}, typed_data<T>(out), out.stride()[0],
+                             epilogue);
+  });
+}
+
+void require_matmul_operands(const DTensor &lhs, const DTensor &rhs, const char *op_name) {
+  require_same_dtype(lhs, rhs, op_name);
+  if (lhs.rank() != 2 || rhs.rank() != 2) {
+    throw std::invalid_argument(std::string(op_name) + " requires rank-2 tensors");
+  }
+  if (lhs.shape()[1] != rhs.shape()[0]) {
+    throw std::invalid_argument(std::string(op_name) + " dimension mismatch");
   }
 }
 
+// Forward of the mean losses; non-contiguous operands are read from dense copies.
+DTensor pointwise_loss(LossKind kind, const DTensor &prediction, const DTensor &target,
+                       double delta, const char *op_name) {
+  require_same_dtype(prediction, target, op_name);
+  require_same_shape(prediction, target, op_name);
+  // An integer mean would truncate both the loss and its gradient scale.
+  if (!is_floating_dtype(prediction.dtype())) {
+    throw std::invalid_argument(std::string(op_name) + " requires a floating-point dtype");
+  }
+  const DTensor p = prediction.is_contiguous() ? prediction : clone(prediction);
+  const DTensor t = target.is_contiguous() ? target : clone(target);
+
+  const bool needs_grad = records_grad(prediction, target);
+  DTensor result = api::empty({1}, prediction.dtype(), needs_grad);
+  dispatch_dtype(prediction.dtype(), [&](auto tag) {
+    using T = typename decltype(tag)::type;
+    const int64_t count = p.numel();
+    const T total = dispatch_loss(kind, [&](auto loss) {
+      return loss_sum<decltype(loss)::value>(typed_data<T>(p), typed_data<T>(t), count,
+                                             static_cast<T>(delta));
+    });
+    typed_data<T>(result)[0] = count == 0 ? T{0} : static_cast<T>(total / count);
+  });
+
+  if (needs_grad) {
+    result.set_grad_fn(make_arena_shared<LossBackward>(
+        kind, NodeInput(prediction), NodeInput(target), SavedTensor(p), SavedTensor(t), delta));
+  }
+  return result;
+}
+
+DTensor extremum(kernels::ReduceOp op, const DTensor &tensor, const std::vector<int64_t> &dims,
+                 bool keepdim, const char *op_name) {
+  const auto reduced = reduced_dims(tensor.shape(), dims, op_name);
+  if (reduced_count(tensor.shape(), reduced) == 0) {
+    throw std::invalid_argument(std::string(op_name) + " of an empty dim");
+  }
+  const bool needs_grad = records_grad(tensor);
+  const DTensor kept = reduce_kept(op, tensor, reduced);
+  DTensor result = view_as_shape(kept, reduced_shape(tensor.shape(), reduced, keepdim), needs_grad);
+
+  if (needs_grad) {
+    // A NaN result was produced by the NaNs it reduced, so those are its hits.
+    const DTensor hits = map_pointwise(tensor, kept, [](auto value, auto best) {
+      using V = decltype(value);
+      return simd::select(best >= best,
+                          simd::select((value >= best) & (value <= best), V(1), V(0)),
+                          simd::select(value >= value, V(0), V(1)));
+    });
+    result.set_grad_fn(make_arena_shared<ExtremumBackward>(
+        tensor.autograd_state(), pack_mask(hits, kReluMask),
+        reduce_kept(kernels::ReduceOp::sum, hits, reduced)));
+  }
+  return result;
+}
+
 } // namespace
 
 DTensor clone(const DTensor &tensor) {
   DTensor result = api::empty(tensor.shape(), tensor.dtype(), false);
-  std::memcpy(result.data(), tensor.data(),
-              static_cast<std::size_t>(tensor.numel()) * dtype_size(tensor.dtype()));
+  copy(tensor, result);
+  return result;
+}
+
+DTensor reshape(const DTensor &tensor, const Dims &shape) {
+  if (!tensor.is_contiguous()) {
+    throw std::invalid_argument("reshape only supports contiguous tensors");
+  }
+  if (tensor.numel() != numel_from_shape(shape)) {
+    throw std::invalid_argument("reshape requires the same element count");
+  }
+  const bool needs_grad = records_grad(tensor);
+  DTensor result(tensor.storage(), shape, default_strides(shape), tensor.offset(),
+                 tensor.dtype(), true, needs_grad);
+  if (needs_grad) {
+    result.set_grad_fn(make_arena_shared<ReshapeBackward>(NodeInput(tensor)));
+  }
+  return result;
+}
+
+DTensor permute(const DTensor &tensor, const Dims &perm) {
+  if (static_cast<int32_t>(perm.size()) != tensor.rank()) {
+    throw std::invalid_argument("permute rank mismatch");
+  }
+
+  Dims shape(perm.size(), 0);
+  Dims stride(perm.size(), 0);
+  Dims inverse(perm.size(), -1);
+  for (std::size_t index = 0; index < perm.size(); ++index) {
+    const int64_t axis = perm[index];
+    if (axis < 0 || axis >= tensor.rank()) {
+      throw std::invalid_argument("permute axis out of range");
+    }
+    if (inverse[static_cast<std::size_t>(axis)] >= 0) {
+      throw std::invalid_argument("permute repeats an axis");
+    }
+    shape[index] = tensor.shape()[static_cast<std::size_t>(axis)];
+    stride[index] = tensor.stride()[static_cast<std::size_t>(axis)];
+    inverse[static_cast<std::size_t>(axis)] = static_cast<int64_t>(index);
+  }
+
+  const bool needs_grad = records_grad(tensor);
+  DTensor result(tensor.storage(), std::move(shape), std::move(stride), tensor.offset(),
+                 tensor.dtype(), false, needs_grad);
+  if (needs_grad) {
+    result.set_grad_fn(
+        make_arena_shared<PermuteBackward>(NodeInput(tensor), std::move(inverse)));
+  }
   return result;
 }
 
@@ -337,211 +1109,236 @@ DTensor zeros_like(const DTensor &tensor) {
 }
 
 DTensor ones_like(const DTensor &tensor) {
-  DTensor result = zeros_like(tensor);
-  require_f32(result, "ones_like");
-  fill(result, 1.0f);
-  return result;
+  return full_of(tensor.shape(), tensor.dtype(), 1.0);
 }
 
-void fill(DTensor &tensor, float value) {
-  require_f32(tensor, "fill");
-  require_contiguous(tensor, "fill");
-  float *ptr = f32_data(tensor);
-  for (int64_t index = 0; index < tensor.numel(); ++index) {
-    ptr[index] = value;
-  }
+void fill(DTensor &tensor, double value) {
+  TensorIterator iter(tensor, {});
+  dispatch_dtype(tensor.dtype(), [&](auto tag) {
+    using T = typename decltype(tag)::type;
+    kernels::fill(iter, static_cast<T>(value));
+  });
+  tensor.bump_version();
 }
 
 void copy(const DTensor &src, DTensor &dst) {
   if (src.dtype() != dst.dtype()) {
     throw std::invalid_argument("copy requires matching dtypes");
   }
-  require_contiguous(src, "copy");
-  require_contiguous(dst, "copy");
   require_same_shape(src, dst, "copy");
-  std::memcpy(dst.data(), src.data(),
-              static_cast<std::size_t>(src.numel()) * dtype_size(src.dtype()));
+  dst.bump_version();
+  if (src.is_contiguous() && dst.is_contiguous()) {
+    std::memcpy(dst.data(), src.data(),
+                static_cast<std::size_t>(src.numel()) * dtype_size(src.dtype()));
+    return;
+  }
+  // Copies move bits, so integer lanes of the right width serve every dtype.
+  TensorIterator iter(dst, {src});
+  const auto identity = [](auto x) { return x; };
+  if (dtype_size(src.dtype()) == 4) {
+    kernels::map<int32_t>(iter, identity);
+  } else {
+    kernels::map<int64_t>(iter, identity);
+  }
 }
 
 DTensor add(const DTensor &lhs, const DTensor &rhs) {
-  require_contiguous(lhs, "add");
-  require_contiguous(rhs, "add");
-  require_f32(lhs, "add");
-  require_f32(rhs, "add");
-  require_same_shape(lhs, rhs, "add");
+  require_same_dtype(lhs, rhs, "add");
 
-  const bool needs_grad = lhs.requires_grad() || rhs.requires_grad();
-  DTensor result = make_f32_tensor(lhs.shape(), needs_grad);
-  float *dst = f32_data(result);
-  const float *lhs_ptr = f32_data(lhs);
-  const float *rhs_ptr = f32_data(rhs);
-  for (int64_t index = 0; index < lhs.numel(); ++index) {
-    dst[index] = lhs_ptr[index] + rhs_ptr[index];
+  const bool needs_grad = records_grad(lhs, rhs);
+  if (auto deferred = lazy::binary(lazy::PointwiseOp::add, lhs, rhs, needs_grad)) {
+    return *deferred;
   }
+  DTensor result = map_pointwise(lhs, rhs, kAdd, needs_grad);
 
   if (needs_grad) {
-    result.set_grad_fn(std::make_shared<AddBackward>(lhs, rhs));
+    result.set_grad_fn(make_arena_shared<AddBackward>(NodeInput(lhs), NodeInput(rhs)));
   }
   return result;
 }
 
 DTensor sub(const DTensor &lhs, const DTensor &rhs) {
-  require_contiguous(lhs, "sub");
-  require_contiguous(rhs, "sub");
-  require_f32(lhs, "sub");
-  require_f32(rhs, "sub");
-  require_same_shape(lhs, rhs, "sub");
+  require_same_dtype(lhs, rhs, "sub");
 
-  const bool needs_grad = lhs.requires_grad() || rhs.requires_grad();
-  DTensor result = make_f32_tensor(lhs.shape(), needs_grad);
-  float *dst = f32_data(result);
-  const float *lhs_ptr = f32_data(lhs);
-  const float *rhs_ptr = f32_data(rhs);
-  for (int64_t index = 0; index < lhs.numel(); ++index) {
-    dst[index] = lhs_ptr[index] - rhs_ptr[index];
+  const bool needs_grad = records_grad(lhs, rhs);
+  if (auto deferred = lazy::binary(lazy::PointwiseOp::sub, lhs, rhs, needs_grad)) {
+    return *deferred;
   }
+  DTensor result = map_pointwise(lhs, rhs, kSub, needs_grad);
 
   if (needs_grad) {
-    result.set_grad_fn(std::make_shared<SubBackward>(lhs, rhs));
+    result.set_grad_fn(make_arena_shared<SubBackward>(NodeInput(lhs), NodeInput(rhs)));
   }
   return result;
 }
 
 DTensor mul(const DTensor &lhs, const DTensor &rhs) {
-  require_contiguous(lhs, "mul");
-  require_contiguous(rhs, "mul");
-  require_f32(lhs, "mul");
-  require_f32(rhs, "mul");
-  require_same_shape(lhs, rhs, "mul");
+  require_same_dtype(lhs, rhs, "mul");
 
-  const bool needs_grad = lhs.requires_grad() || rhs.requires_grad();
-  DTensor result = make_f32_tensor(lhs.shape(), needs_grad);
-  float *dst = f32_data(result);
-  const float *lhs_ptr = f32_data(lhs);
-  const float *rhs_ptr = f32_data(rhs);
-  for (int64_t index = 0; index < lhs.numel(); ++index) {
-    dst[index] = lhs_ptr[index] * rhs_ptr[index];
+  const bool needs_grad = records_grad(lhs, rhs);
+  if (auto deferred = lazy::binary(lazy::PointwiseOp::mul, lhs, rhs, needs_grad)) {
+    return *deferred;
   }
+  DTensor result = map_pointwise(lhs, rhs, kMul, needs_grad);
 
   if (needs_grad) {
-    result.set_grad_fn(std::make_shared<MulBackward>(lhs, rhs));
+    const bool same_operand = same_tensor(lhs, rhs);
+    result.set_grad_fn(make_arena_shared<MulBackward>(
+        NodeInput(lhs), NodeInput(rhs),
+        rhs.requires_grad() || same_operand ? SavedTensor(lhs) : SavedTensor{},
+        lhs.requires_grad() && !same_operand ? SavedTensor(rhs) : SavedTensor{}, same_operand));
   }
   return result;
 }
 
 DTensor matmul(const DTensor &lhs, const DTensor &rhs) {
-  require_contiguous(lhs, "matmul");
-  require_contiguous(rhs, "matmul");
-  require_f32(lhs, "matmul");
-  require_f32(rhs, "matmul");
-  if (lhs.rank() != 2 || rhs.rank() != 2) {
-    throw std::invalid_argument("matmul requires rank-2 tensors");
-  }
-  if (lhs.shape()[1] != rhs.shape()[0]) {
-    throw std::invalid_argument("matmul dimension mismatch");
-  }
+  require_matmul_operands(lhs, rhs, "matmul");
 
-  const int64_t m = lhs.shape()[0];
-  const int64_t k = lhs.shape()[1];
-  const int64_t n = rhs.shape()[1];
-  const bool needs_grad = lhs.requires_grad() || rhs.requires_grad();
-  DTensor result = make_f32_tensor({m, n}, needs_grad);
-  float *dst = f32_data(result);
-  const float *lhs_ptr = f32_data(lhs);
-  const float *rhs_ptr = f32_data(rhs);
-
-  for (int64_t row = 0; row < m; ++row) {
-    for (int64_t col = 0; col < n; ++col) {
-      float acc = 0.0f;
-      for (int64_t inner = 0; inner < k; ++inner) {
-        acc += lhs_ptr[row * k + inner] * rhs_ptr[inner * n + col];
-      }
-      dst[row * n + col] = acc;
-    }
-  }
+  const bool needs_grad = records_grad(lhs, rhs);
+  DTensor result = api::empty({lhs.shape()[0], rhs.shape()[1]}, lhs.dtype(), needs_grad);
+  matmul_into(lhs, rhs, result);
 
   if (needs_grad) {
-    result.set_grad_fn(std::make_shared<MatmulBackward>(lhs, rhs));
+    result.set_grad_fn(make_arena_shared<MatmulBackward>(lhs, rhs));
   }
   return result;
 }
 
 DTensor sum(const DTensor &tensor) {
-  require_contiguous(tensor, "sum");
-  require_f32(tensor, "sum");
+  return sum(tensor, {});
+}
 
-  DTensor result = make_f32_tensor({1}, tensor.requires_grad());
-  float total = 0.0f;
-  const float *ptr = f32_data(tensor);
-  for (int64_t index = 0; index < tensor.numel(); ++index) {
-    total += ptr[index];
+DTensor sum(const DTensor &tensor, const std::vector<int64_t> &dims, bool keepdim) {
+  const auto reduced = reduced_dims(tensor.shape(), dims, "sum");
+  const bool needs_grad = records_grad(tensor);
+  if (!keepdim && std::all_of(reduced.begin(), reduced.end(), [](bool dim) { return dim; })) {
+    if (auto deferred = lazy::reduce(lazy::Reduction::sum, tensor, needs_grad)) {
+      return *deferred;
+    }
   }
-  f32_data(result)[0] = total;
+  const DTensor kept = reduce_kept(kernels::ReduceOp::sum, tensor, reduced);
+  DTensor result = view_as_shape(kept, reduced_shape(tensor.shape(), reduced, keepdim), needs_grad);
 
-  if (tensor.requires_grad()) {
-    result.set_grad_fn(std::make_shared<SumBackward>(tensor));
+  if (needs_grad) {
+    result.set_grad_fn(make_arena_shared<ReduceBackward>(NodeInput(tensor), kept.shape(), 1));
   }
   return result;
 }
 
 DTensor mean(const DTensor &tensor) {
-  require_contiguous(tensor, "mean");
-  require_f32(tensor, "mean");
+  return mean(tensor, {});
+}
 
-  DTensor result = make_f32_tensor({1}, tensor.requires_grad());
-  const float total = f32_data(sum(tensor))[0];
-  f32_data(result)[0] = tensor.numel() == 0
-                            ? 0.0f
-                            : total / static_cast<float>(tensor.numel());
+DTensor mean(const DTensor &tensor, const std::vector<int64_t> &dims, bool keepdim) {
+  const auto reduced = reduced_dims(tensor.shape(), dims, "mean");
+  const bool needs_grad = records_grad(tensor);
+  if (!keepdim && std::all_of(reduced.begin(), reduced.end(), [](bool dim) { return dim; })) {
+    if (auto deferred = lazy::reduce(lazy::Reduction::mean, tensor, needs_grad)) {
+      return *deferred;
+    }
+  }
+  const int64_t count = reduced_count(tensor.shape(), reduced);
+  DTensor kept = reduce_kept(kernels::ReduceOp::sum, tensor, reduced);
+  if (count != 0) {
+    dispatch_dtype(tensor.dtype(), [&](auto tag) {
+      using T = typename decltype(tag)::type;
+      const auto divisor = static_cast<T>(count);
+      T *values = typed_data<T>(kept);
+      kernels::map_contiguous(
+          kept.numel(), values, [divisor](auto x) { return x / decltype(x)(divisor); }, values);
+    });
+  }
+  DTensor result = view_as_shape(kept, reduced_shape(tensor.shape(), reduced, keepdim), needs_grad);
 
-  if (tensor.requires_grad()) {
-    result.set_grad_fn(std::make_shared<MeanBackward>(tensor));
+  if (needs_grad) {
+    result.set_grad_fn(make_arena_shared<ReduceBackward>(NodeInput(tensor), kept.shape(),
+                                                         std::max<int64_t>(count, 1)));
   }
   return result;
 }
 
-DTensor relu(const DTensor &tensor) {
-  require_contiguous(tensor, "relu");
-  require_f32(tensor, "relu");
+DTensor max(const DTensor &tensor, const std::vector<int64_t> &dims, bool keepdim) {
+  return extremum(kernels::ReduceOp::max, tensor, dims, keepdim, "max");
+}
+
+DTensor min(const DTensor &tensor, const std::vector<int64_t> &dims, bool keepdim) {
+  return extremum(kernels::ReduceOp::min, tensor, dims, keepdim, "min");
+}
 
-  DTensor result = make_f32_tensor(tensor.shape(), tensor.requires_grad());
-  float *dst = f32_data(result);
-  const float *src = f32_data(tensor);
-  for (int64_t index = 0; index < tensor.numel(); ++index) {
-    dst[index] = std::max(src[index], 0.0f);
+DTensor argmax(const DTensor &tensor, int64_t dim, bool keepdim) {
+  const auto reduced = reduced_dims(tensor.shape(), {dim}, "argmax");
+  if (reduced_count(tensor.shape(), reduced) == 0) {
+    throw std::invalid_argument("argmax of an empty dim");
+  }
+  Dims order;
+  const DTensor dense = dense_layout(tensor, order);
+  const auto axis = static_cast<int64_t>(
+      std::find(reduced.begin(), reduced.end(), true) - reduced.begin());
+  const auto position =
+      static_cast<std::size_t>(std::find(order.begin(), order.end(), axis) - order.begin());
+  int64_t outer = 1;
+  int64_t inner = 1;
+  for (std::size_t index = 0; index < dense.shape().size(); ++index) {
+    if (index < position) {
+      outer *= dense.shape()[index];
+    } else if (index > position) {
+      inner *= dense.shape()[index];
+    }
   }
+  Dims kept_shape = dense.shape();
+  kept_shape[position] = 1;
+  DTensor picks = api::empty(kept_shape, DType::i64);
+  kernels::argmax_contiguous(tensor.dtype(), dense.data(), typed_data<int64_t>(picks), outer,
+                             dense.shape()[position], inner);
+  return view_as_shape(in_dim_order(picks, order), reduced_shape(tensor.shape(), reduced, keepdim));
+}
 
-  if (tensor.requires_grad()) {
-    result.set_grad_fn(std::make_shared<ReluBackward>(tensor));
+DTensor relu(const DTensor &tensor) {
+  const bool needs_grad = records_grad(tensor);
+  if (auto deferred = lazy::unary(lazy::PointwiseOp::relu, tensor, needs_grad)) {
+    return *deferred;
+  }
+  DTensor result = map_pointwise(tensor, kRelu, needs_grad);
+
+  if (needs_grad) {
+    result.set_grad_fn(make_arena_shared<MaskBackward>(tensor.autograd_state(),
+                                                       pack_mask(result, kReluMask)));
   }
   return result;
 }
 
-DTensor clamp(const DTensor &tensor, float min_value, float max_value) {
-  require_contiguous(tensor, "clamp");
-  require_f32(tensor, "clamp");
+DTensor clamp(const DTensor &tensor, double min_value, double max_value) {
   if (min_value > max_value) {
     throw std::invalid_argument("clamp requires min_value <= max_value");
   }
 
-  DTensor result = make_f32_tensor(tensor.shape(), tensor.requires_grad());
-  float *dst = f32_data(result);
-  const float *src = f32_data(tensor);
-  for (int64_t index = 0; index < tensor.numel(); ++index) {
-    dst[index] = std::clamp(src[index], min_value, max_value);
+  const bool needs_grad = records_grad(tensor);
+  if (auto deferred =
+          lazy::unary(lazy::PointwiseOp::clamp, tensor, needs_grad, min_value, max_value)) {
+    return *deferred;
   }
+  DTensor result = dispatch_dtype(tensor.dtype(), [&](auto tag) {
+    using T = typename decltype(tag)::type;
+    const auto lo = static_cast<T>(min_value);
+    const auto hi = static_cast<T>(max_value);
+    return map_typed<T>(
+        tensor,
+        [lo, hi](auto x) {
+          using V = decltype(x);
+          return simd::clamp(x, V(lo), V(hi));
+        },
+        needs_grad);
+  });
 
-  if (tensor.requires_grad()) {
-    result.set_grad_fn(std::make_shared<ClampBackward>(tensor, min_value, max_value));
+  if (needs_grad) {
+    result.set_grad_fn(make_arena_shared<MaskBackward>(
+        tensor.autograd_state(), pack_mask(result, clamp_mask(min_value, max_value))));
   }
   return result;
 }
 
 DTensor bias_add(const DTensor &value, const DTensor &bias) {
-  require_contiguous(value, "bias_add");
-  require_contiguous(bias, "bias_add");
-  require_f32(value, "bias_add");
-  require_f32(bias, "bias_add");
+  require_same_dtype(value, bias, "bias_add");
   if (value.rank() != 2) {
     throw std::invalid_argument("bias_add expects a rank-2 value tensor");
   }
@@ -555,36 +1352,207 @@ DTensor bias_add(const DTensor &value, const DTensor &bias) {
     throw std::invalid_argument("bias_add output width must match bias size");
   }
 
-  const int64_t rows = value.shape()[0];
-  const bool needs_grad = value.requires_grad() || bias.requires_grad();
-  DTensor result = make_f32_tensor(value.shape(), needs_grad);
-  float *dst = f32_data(result);
-  const float *value_ptr = f32_data(value);
-  const float *bias_ptr = f32_data(bias);
+  const bool needs_grad = records_grad(value, bias);
+  DTensor result = map_pointwise(value, bias, kAdd, needs_grad);
+
+  if (needs_grad) {
+    result.set_grad_fn(make_arena_shared<BiasAddBackward>(NodeInput(value), NodeInput(bias)));
+  }
+  return result;
+}
+
+DTensor &add_(DTensor &self, const DTensor &other) {
+  require_same_dtype(self, other, "add_");
+  require_broadcasts_to(other, self, "add_");
+  require_inplace_allowed(self, "add_");
+
+  const bool needs_grad = records_grad(self, other);
+  std::shared_ptr<AutogradNode> node;
+  if (needs_grad) {
+    node = make_arena_shared<AddBackward>(NodeInput(history_of(self), self.shape()),
+                                          NodeInput(other));
+  }
+  map_pointwise_into(self, self, other, kAdd);
+  self.bump_version();
+  if (needs_grad) {
+    record_inplace(self, std::move(node));
+  }
+  return self;
+}
+
+DTensor &mul_(DTensor &self, const DTensor &other) {
+  require_same_dtype(self, other, "mul_");
+  require_broadcasts_to(other, self, "mul_");
+  require_inplace_allowed(self, "mul_");
 
-  for (int64_t row = 0; row < rows; ++row) {
-    for (int64_t col = 0; col < cols; ++col) {
-      dst[row * cols + col] = value_ptr[row * cols + col] + bias_ptr[col];
+  const bool needs_grad = records_grad(self, other);
+  std::shared_ptr<AutogradNode> node;
+  if (needs_grad) {
+    // The gradient of `other` needs self's values from before the write, and
+    // mul_(x, x) reads nothing else.
+    const bool same_operand = same_tensor(self, other);
+    node = make_arena_shared<MulBackward>(
+        NodeInput(history_of(self), self.shape()), NodeInput(other),
+        other.requires_grad() || same_operand ? SavedTensor(clone(self)) : SavedTensor{},
+        self.requires_grad() && !same_operand ? SavedTensor(other) : SavedTensor{},
+        same_operand);
+  }
+  map_pointwise_into(self, self, other, kMul);
+  self.bump_version();
+  if (needs_grad) {
+    record_inplace(self, std::move(node));
+  }
+  return self;
+}
+
+DTensor &relu_(DTensor &self) {
+  require_inplace_allowed(self, "relu_");
+
+  const bool needs_grad = records_grad(self);
+  AutogradEdge previous = needs_grad ? history_of(self) : AutogradEdge{};
+  dispatch_dtype(self.dtype(), [&](auto tag) {
+    map_into<typename decltype(tag)::type>(self, self, kRelu);
+  });
+  self.bump_version();
+  if (needs_grad) {
+    record_inplace(self, make_arena_shared<MaskBackward>(std::move(previous),
+                                                         pack_mask(self, kReluMask)));
+  }
+  return self;
+}
+
+DTensor &clamp_(DTensor &self, double min_value, double max_value) {
+  if (min_value > max_value) {
+    throw std::invalid_argument("clamp_ requires min_value <= max_value");
+  }
+  require_inplace_allowed(self, "clamp_");
+
+  const bool needs_grad = records_grad(self);
+  AutogradEdge previous = needs_grad ? history_of(self) : AutogradEdge{};
+  dispatch_dtype(self.dtype(), [&](auto tag) {
+    using T = typename decltype(tag)::type;
+    const auto lo = static_cast<T>(min_value);
+    const auto hi = static_cast<T>(max_value);
+    map_into<T>(self, self, [lo, hi](auto x) {
+      using V = decltype(x);
+      return simd::clamp(x, V(lo), V(hi));
+    });
+  });
+  self.bump_version();
+  if (needs_grad) {
+    PackedMask mask = pack_mask(self, clamp_mask(min_value, max_value));
+    record_inplace(self, make_arena_shared<MaskBackward>(std::move(previous), std::move(mask)));
+  }
+  return self;
+}
+
+DTensor &add_out(const DTensor &lhs, const DTensor &rhs, DTensor &out) {
+  require_same_dtype(lhs, rhs, "add_out");
+  require_same_dtype(lhs, out, "add_out");
+  require_no_grad(lhs, rhs, "add_out");
+  require_plain_output(out, "add_out");
+  if (broadcast_shapes(lhs.shape(), rhs.shape()) != out.shape()) {
+    throw std::invalid_argument("add_out output shape must match the broadcast shape");
+  }
+
+  map_pointwise_into(out, lhs, rhs, kAdd);
+  out.bump_version();
+  return out;
+}
+
+DTensor &relu_out(const DTensor &input, DTensor &out) {
+  require_same_dtype(input, out, "relu_out");
+  if (records_grad(input)) {
+    throw std::invalid_argument("relu_out does not record autograd history");
+  }
+  require_plain_output(out, "relu_out");
+  if (input.shape() != out.shape()) {
+    throw std::invalid_argument("relu_out output shape must match its input");
+  }
+
+  dispatch_dtype(out.dtype(), [&](auto tag) {
+    map_into<typename decltype(tag)::type>(out, input, kRelu);
+  });
+  out.bump_version();
+  return out;
+}
+
+DTensor &matmul_out(const DTensor &lhs, const DTensor &rhs, DTensor &out) {
+  require_matmul_operands(lhs, rhs, "matmul_out");
+  require_same_dtype(lhs, out, "matmul_out");
+  require_no_grad(lhs, rhs, "matmul_out");
+  require_plain_output(out, "matmul_out");
+  if (out.shape() != Dims{lhs.shape()[0], rhs.shape()[1]}) {
+    throw std::invalid_argument("matmul_out output shape must be {M, N}");
+  }
+  if (out.stride()[1] != 1) {
+    throw std::invalid_argument("matmul_out requires an output with unit column stride");
+  }
+  if (out.storage() == lhs.storage() || out.storage() == rhs.storage()) {
+    throw std::invalid_argument("matmul_out output must not alias its inputs");
+  }
+
+  matmul_into(lhs, rhs, out);
+  out.bump_version();
+  return out;
+}
+
+DTensor linear(const DTensor &input, const DTensor &weight, const DTensor &bias,
+               Activation activation) {
+  require_matmul_operands(input, weight, "linear");
+  const int64_t n = weight.shape()[1];
+  if (bias.defined()) {
+    require_same_dtype(input, bias, "linear");
+    if (!(bias.rank() == 1 || (bias.rank() == 2 && bias.shape()[0] == 1))) {
+      throw std::invalid_argument("linear expects a rank-1 bias or shape {1, N}");
+    }
+    if (bias.shape().back() != n) {
+      throw std::invalid_argument("linear bias size must match the output width");
     }
   }
+  if (activation.kind == ActivationKind::clamp && activation.min_value > activation.max_value) {
+    throw std::invalid_argument("linear clamp requires min_value <= max_value");
+  }
+
+  const bool needs_grad = bias.defined() ? records_grad(input, weight, bias)
+                                         : records_grad(input, weight);
+  DTensor result = api::empty({input.shape()[0], n}, input.dtype(), needs_grad);
+  const DTensor dense_bias =
+      bias.defined() && bias.stride().back() != 1 ? clone(bias) : bias;
+  matmul_into(input, weight, result, dense_bias, activation);
 
   if (needs_grad) {
-    result.set_grad_fn(std::make_shared<BiasAddBackward>(value, bias));
+    std::optional<PackedMask> mask;
+    if (activation.kind == ActivationKind::relu) {
+      mask = pack_mask(result, kReluMask);
+    } else if (activation.kind == ActivationKind::clamp) {
+      mask = pack_mask(result, clamp_mask(activation.min_value, activation.max_value));
+    }
+    result.set_grad_fn(make_arena_shared<LinearBackward>(input, weight, bias, std::move(mask)));
   }
   return result;
 }
 
 DTensor mse_loss(const DTensor &prediction, const DTensor &target) {
-  DTensor diff = sub(prediction, target);
-  return mean(mul(diff, diff));
+  return pointwise_loss(LossKind::mse, prediction, target, 0.0, "mse_loss");
+}
+
+DTensor l1_loss(const DTensor &prediction, const DTensor &target) {
+  return pointwise_loss(LossKind::l1, prediction, target, 0.0, "l1_loss");
+}
+
+DTensor huber_loss(const DTensor &prediction, const DTensor &target, double delta) {
+  if (!(delta > 0.0)) {
+    throw std::invalid_argument("huber_loss requires delta > 0");
+  }
+  return pointwise_loss(LossKind::huber, prediction, target, delta, "huber_loss");
 }
 
 void backward(const DTensor &loss) {
-  require_f32(loss, "backward");
   if (loss.numel() != 1) {
     throw std::invalid_argument("backward expects a scalar loss tensor");
   }
-  accumulate_gradient(loss, ones_like(loss));
+  run_backward(loss, ones_like(loss));
 }
 
 } // namespace Tensor::ops
@@ -6,11 +6,32 @@
 
 namespace Tensor::ops {
 
+enum class ActivationKind : uint8_t { identity, relu, clamp };
+
+// Pointwise activation that linear applies inside its GEMM epilogue.
+struct Activation {
+  ActivationKind kind{ActivationKind::identity};
+  double min_value{0.0};
+  double max_value{0.0};
+
+  static Activation identity() noexcept { return {}; }
+  static Activation relu() noexcept { return {ActivationKind::relu}; }
+  static Activation clamp(double min_value, double max_value) noexcept {
+    return {ActivationKind::clamp, min_value, max_value};
+  }
+};
+
 DTensor clone(const DTensor &tensor);
+// Views of `tensor`'s storage. reshape needs a contiguous tensor; permute
+// reorders the dims through strides. A view of a tensor that requires grad
+// records a node that hands its gradient back in the base's layout, and it
+// cannot be modified in place while grad mode is on.
+DTensor reshape(const DTensor &tensor, const Dims &shape);
+DTensor permute(const DTensor &tensor, const Dims &perm);
 DTensor zeros_like(const DTensor &tensor);
 DTensor ones_like(const DTensor &tensor);
 
-void fill(DTensor &tensor, float value);
+void fill(DTensor &tensor, double value);
 void copy(const DTensor &src, DTensor &dst);
 
 DTensor add(const DTensor &lhs, const DTensor &rhs);
@@ -19,10 +40,47 @@ DTensor mul(const DTensor &lhs, const DTensor &rhs);
 DTensor matmul(const DTensor &lhs, const DTensor &rhs);
 DTensor sum(const DTensor &tensor);
 DTensor mean(const DTensor &tensor);
+// Reductions over `dims`, where negative values count from the back and an
+// empty list means every dim. Reduced dims are dropped, or kept with size 1
+// under keepdim; reducing every dim without keepdim gives shape {1}, as the
+// overloads above do. Sums are accumulated pairwise. max and min send the
+// gradient to the elements equal to their result, split evenly between ties.
+DTensor sum(const DTensor &tensor, const std::vector<int64_t> &dims, bool keepdim = false);
+DTensor mean(const DTensor &tensor, const std::vector<int64_t> &dims, bool keepdim = false);
+DTensor max(const DTensor &tensor, const std::vector<int64_t> &dims, bool keepdim = false);
+DTensor min(const DTensor &tensor, const std::vector<int64_t> &dims, bool keepdim = false);
+// Index of the first maximum along `dim`, as an i64 tensor. Not differentiable.
+DTensor argmax(const DTensor &tensor, int64_t dim, bool keepdim = false);
 DTensor relu(const DTensor &tensor);
-DTensor clamp(const DTensor &tensor, float min_value, float max_value);
+DTensor clamp(const DTensor &tensor, double min_value, double max_value);
 DTensor bias_add(const DTensor &value, const DTensor &bias);
+// activation(input[M, K] @ weight[K, N] + bias) in one GEMM pass, the same
+// values relu(bias_add(matmul(input, weight), bias)) and friends produce. The
+// bias (rank 1 or {1, N}) may be undefined. Records a single autograd node.
+DTensor linear(const DTensor &input, const DTensor &weight, const DTensor &bias,
+               Activation activation = Activation::identity());
+
+// Mean over all elements of a loss of d = prediction - target, computed in one
+// pass; backward writes both gradients in one more. Operands share shape and a
+// floating-point dtype. huber_loss is d^2/2 for |d| <= delta and
+// delta * (|d| - delta/2) beyond it.
 DTensor mse_loss(const DTensor &prediction, const DTensor &target);
+DTensor l1_loss(const DTensor &prediction, const DTensor &target);
+DTensor huber_loss(const DTensor &prediction, const DTensor &target, double delta = 1.0);
+
+// In-place variants overwrite `self` (broadcasting `other` into it) and bump
+// its storage version. Leaves that require grad cannot be modified in place.
+DTensor &add_(DTensor &self, const DTensor &other);
+DTensor &mul_(DTensor &self, const DTensor &other);
+DTensor &relu_(DTensor &self);
+DTensor &clamp_(DTensor &self, double min_value, double max_value);
+
+// out= variants write into a preallocated tensor of the result shape and
+// dtype. They do not record autograd history, so with grad mode on neither
+// the inputs nor `out` may require grad.
+DTensor &add_out(const DTensor &lhs, const DTensor &rhs, DTensor &out);
+DTensor &relu_out(const DTensor &input, DTensor &out);
+DTensor &matmul_out(const DTensor &lhs, const DTensor &rhs, DTensor &out);
 
 void backward(const DTensor &loss);
 
@@ -0,0 +1,397 @@
+#include "tensor/Optim.hpp"
+
+#include "api/Api.hpp"
+#include "tensor/Arena.hpp"
+#include "tensor/Autograd.hpp"
+#include "tensor/Dispatch.hpp"
+#include "tensor/Elementwise.hpp"
+#include "tensor/Ops.hpp"
+#include "tensor/Parallel.hpp"
+#include "tensor/Vec.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+namespace Tensor::nn {
+
+namespace {
+
+// One parameter of a step, with dense views of its values and gradient in
+// the same element order.
+struct Slot {
+  std::size_t index; // position in the parameter list
+  DTensor *parameter;
+  DTensor value; // the parameter, or a dense copy written back after the update
+  DTensor grad;
+};
+
+// `integers` admits integer parameters, which only plain SGD can step.
+std::vector<Slot> collect_slots(const std::vector<DTensor *> &parameters, bool integers) {
+  std::vector<Slot> slots;
+  for (std::size_t index = 0; index < parameters.size(); ++index) {
+    DTensor *parameter = parameters[index];
+    if (parameter == nullptr || !parameter->grad()) {
+      continue;
+    }
+    const DTensor &grad = *parameter->grad();
+    if (!integers && !is_floating_dtype(parameter->dtype())) {
+      throw std::invalid_argument("optimizers update floating-point parameters only");
+    }
+    if (grad.dtype() != parameter->dtype() || grad.shape() != parameter->shape()) {
+      throw std::invalid_argument(
+          "parameter gradients must match their parameter's shape and dtype");
+    }
+    slots.push_back({index, parameter,
+                     parameter->is_contiguous() ? *parameter : ops::clone(*parameter),
+                     grad.is_contiguous() ? grad : ops::clone(grad)});
+  }
+  return slots;
+}
+
+void write_back(const std::vector<Slot> &slots) {
+  for (const Slot &slot : slots) {
+    if (slot.value.storage() != slot.parameter->storage()) {
+      ops::copy(slot.value, *slot.parameter);
+    }
+    slot.parameter->bump_version();
+  }
+}
+
+// Sizes per-parameter state on the first step, whether or not any parameter
+// has a gradient yet, and rejects a different parameter count afterwards.
+template <typename State>
+void fit_state(std::vector<State> &states, std::size_t parameter_count) {
+  if (states.empty()) {
+    states.resize(parameter_count);
+  } else if (states.size() != parameter_count) {
+    throw std::invalid_argument("optimizer steps must pass the same parameters every time");
+  }
+}
+
+// The state buffer kept for `slot`, allocated zeroed (outside any step arena)
+// on first use. Sets `fresh` when it was just created.
+DTensor &state_for(std::vector<DTensor> &states, const Slot &slot, bool &fresh) {
+  DTensor &state = states[slot.index];
+  fresh = !state.defined();
+  if (fresh) {
+    ArenaSuspendGuard heap_only;
+    state = api::zeros(slot.value.shape(), slot.value.dtype());
+  } else if (state.shape() != slot.value.shape() || state.dtype() != slot.value.dtype()) {
+    throw std::invalid_argument("optimizer steps must pass the same parameters every time");
+  }
+  return state;
+}
+
+// Per-parameter inputs of an update beyond its buffers.
+struct SegmentInfo {
+  // The parameter's state buffers were just created.
+  bool fresh{false};
+  // Adam: the bias-corrected step size and 1 / sqrt(1 - beta2^t).
+  double coefficient[2]{};
+};
+
+// One parameter's share of a fused update: its values, gradient and up to two
+// state buffers, all dense in the same element order.
+template <typename T> struct Segment {
+  int64_t numel{0};
+  T *value{nullptr};
+  const T *grad{nullptr};
+  T *state[2]{};
+  SegmentInfo info;
+};
+
+template <typename T> int64_t block_count(const std::vector<Segment<T>> &segments) {
+  int64_t total = 0;
+  for (const auto &segment : segments) {
+    total += segment.numel;
+  }
+  return (total + kDefaultGrainSize - 1) / kDefaultGrainSize;
+}
+
+// Calls fn(block, segment, begin, count) over the elements of every segment
+// taken end to end and cut into blocks of kDefaultGrainSize, all in one
+// parallel_for. A block may span several small segments; a large segment
+// spans several blocks.
+template <typename T, typename Fn>
+void for_each_block(const std::vector<Segment<T>> &segments, const Fn &fn) {
+  std::vector<int64_t> starts(segments.size() + 1, 0);
+  for (std::size_t index = 0; index < segments.size(); ++index) {
+    starts[index + 1] = starts[index] + segments[index].numel;
+  }
+  const int64_t total = starts.back();
+  parallel_for(0, block_count(segments), 1, [&](int64_t first_block, int64_t last_block) {
+    for (int64_t block = first_block; block < last_block; ++block) {
+      int64_t begin = block * kDefaultGrainSize;
+      const int64_t end = std::min(total, begin + kDefaultGrainSize);
+      auto segment = static_cast<std::size_t>(
+          std::upper_bound(starts.begin(), starts.end(), begin) - starts.begin() - 1);
+      for (; begin < end; ++segment) {
+        const int64_t stop = std::min(end, starts[segment + 1]);
+        if (stop > begin) {
+          fn(block, segments[segment], begin - starts[segment], stop - begin);
+        }
+        begin = stop;
+      }
+    }
+  });
+}
+
+template <typename T> simd::Vec<T> load(const T *ptr, int64_t count) {
+  return count == simd::Vec<T>::size ? simd::Vec<T>::load(ptr)
+                                     : simd::Vec<T>::load_partial(ptr, count);
+}
+
+template <typename T> void store(const simd::Vec<T> &value, T *ptr, int64_t count) {
+  if (count == simd::Vec<T>::size) {
+    value.store(ptr);
+  } else {
+    value.store_partial(ptr, count);
+  }
+}
+
+// Calls fn(offset, count) over [0, n) one register at a time.
+template <typename T, typename Fn> void for_each_vector(int64_t n, const Fn &fn) {
+  constexpr int64_t width = simd::Vec<T>::size;
+  int64_t index = 0;
+  for (; index + width <= n; index += width) {
+    fn(index, width);
+  }
+  if (index < n) {
+    fn(index, n - index);
+  }
+}
+
+// Sum of squared gradients. Each block folds into its own partial and the
+// partials are added in block order, so the result does not depend on the
+// thread count.
+template <typename T> double grad_sum_of_squares(const std::vector<Segment<T>> &segments) {
+  using V = simd::Vec<T>;
+  std::vector<double> partials(static_cast<std::size_t>(block_count(segments)), 0.0);
+  for_each_block(segments, [&](int64_t block, const Segment<T> &segment, int64_t begin,
+                               int64_t count) {
+    const T *grad = segment.grad + begin;
+    V acc(T{});
+    for_each_vector<T>(count, [&](int64_t index, int64_t n) {
+      const V g = load(grad + index, n);
+      acc = acc + g * g;
+    });
+    T total{};
+    for (int64_t lane = 0; lane < V::size; ++lane) {
+      total += acc[lane];
+    }
+    partials[static_cast<std::size_t>(block)] += static_cast<double>(total);
+  });
+  return std::accumulate(partials.begin(), partials.end(), 0.0);
+}
+
+// The segments of one step, split by dtype.
+struct Segments {
+  std::vector<Segment<float>> f32;
+  std::vector<Segment<double>> f64;
+
+  void add(Slot &slot, DTensor *first, DTensor *second, SegmentInfo info) {
+    if (slot.value.dtype() == DType::f32) {
+      f32.push_back(make<float>(slot, first, second, info));
+    } else {
+      f64.push_back(make<double>(slot, first, second, info));
+    }
+  }
+
+private:
+  template <typename T>
+  static Segment<T> make(Slot &slot, DTensor *first, DTensor *second, SegmentInfo info) {
+    Segment<T> segment;
+    segment.numel = slot.value.numel();
+    segment.value = static_cast<T *>(slot.value.data());
+    segment.grad = static_cast<const T *>(slot.grad.data());
+    segment.state[0] = first != nullptr ? static_cast<T *>(first->data()) : nullptr;
+    segment.state[1] = second != nullptr ? static_cast<T *>(second->data()) : nullptr;
+    segment.info = info;
+    return segment;
+  }
+};
+
+// The factor gradients are scaled by under global-norm clipping, recording
+// the norm in `norm`.
+double clip_scale(Segments &segments, float max_grad_norm, double &norm) {
+  if (max_grad_norm <= 0.0f) {
+    return 1.0;
+  }
+  norm = std::sqrt(grad_sum_of_squares(segments.f32) + grad_sum_of_squares(segments.f64));
+  const double scale = static_cast<double>(max_grad_norm) / (norm + 1e-6);
+  return std::min(scale, 1.0);
+}
+
+template <typename T>
+void sgd_update(const std::vector<Segment<T>> &segments, const SGDOptions &options,
+                double learning_rate, double grad_scale) {
+  using V = simd::Vec<T>;
+  const auto rate = static_cast<T>(learning_rate);
+  const auto scale = static_cast<T>(grad_scale);
+  const auto decay = static_cast<T>(options.weight_decay);
+  const auto momentum = static_cast<T>(options.momentum);
+  const auto keep = static_cast<T>(1.0 - static_cast<double>(options.dampening));
+  const bool nesterov = options.nesterov;
+  for_each_block(segments, [&](int64_t, const Segment<T> &segment, int64_t begin, int64_t count) {
+    T *value = segment.value + begin;
+    const T *grad = segment.grad + begin;
+    T *buffer = segment.state[0] != nullptr ? segment.state[0] + begin : nullptr;
+    for_each_vector<T>(count, [&](int64_t index, int64_t n) {
+      const V p = load(value + index, n);
+      V g = load(grad + index, n) * V(scale) + V(decay) * p;
+      if (buffer != nullptr) {
+        const V m = segment.info.fresh ? g : V(momentum) * load(buffer + index, n) + V(keep) * g;
+        store(m, buffer + index, n);
+        g = nesterov ? g + V(momentum) * m : m;
+      }
+      store(p - V(rate) * g, value + index, n);
+    });
+  });
+}
+
+// Plain SGD on an integer parameter, with the learning rate cast to its type.
+void integer_sgd_update(Slot &slot, float learning_rate) {
+  dispatch_dtype(slot.value.dtype(), [&](auto tag) {
+    using T = typename decltype(tag)::type;
+    T *value = static_cast<T *>(slot.value.data());
+    const auto rate = static_cast<T>(learning_rate);
+    kernels::map_contiguous(
+        slot.value.numel(), value,
+        [rate](auto param, auto grad) { return param - decltype(param)(rate) * grad; }, value,
+        static_cast<const T *>(slot.grad.data()));
+  });
+}
+
+template <typename T>
+void adam_update(const std::vector<Segment<T>> &segments, const AdamOptions &options,
+                 double learning_rate, double grad_scale) {
+  using V = simd::Vec<T>;
+  const auto scale = static_cast<T>(grad_scale);
+  const auto beta1 = static_cast<T>(options.beta1);
+  const auto beta2 = static_cast<T>(options.beta2);
+  const auto eps = static_cast<T>(options.eps);
+  const bool decoupled = options.decoupled_weight_decay;
+  const auto decay = static_cast<T>(decoupled ? 0.0 : options.weight_decay);
+  const auto shrink = static_cast<T>(
+      decoupled ? 1.0 - learning_rate * static_cast<double>(options.weight_decay) : 1.0);
+  for_each_block(segments, [&](int64_t, const Segment<T> &segment, int64_t begin, int64_t count) {
+    T *value = segment.value + begin;
+    const T *grad = segment.grad + begin;
+    T *exp_avg = segment.state[0] + begin;
+    T *exp_avg_sq = segment.state[1] + begin;
+    const V step_size(static_cast<T>(segment.info.coefficient[0]));
+    const V inverse_root_correction(static_cast<T>(segment.info.coefficient[1]));
+    for_each_vector<T>(count, [&](int64_t index, int64_t n) {
+      const V p = load(value + index, n);
+      const V g = load(grad + index, n) * V(scale) + V(decay) * p;
+      const V m = V(beta1) * load(exp_avg + index, n) + V(T{1} - beta1) * g;
+      const V v = V(beta2) * load(exp_avg_sq + index, n) + V(T{1} - beta2) * g * g;
+      store(m, exp_avg + index, n);
+      store(v, exp_avg_sq + index, n);
+      const V denominator = simd::sqrt(v) * inverse_root_correction + V(eps);
+      store(p * V(shrink) - step_size * m / denominator, value + index, n);
+    });
+  });
+}
+
+} // namespace
+
+SGD::SGD(float learning_rate, SGDOptions options)
+    : learning_rate_(learning_rate), options_(options) {
+  if (options.momentum < 0.0f || options.weight_decay < 0.0f) {
+    throw std::invalid_argument("SGD momentum and weight decay must be non-negative");
+  }
+  if (options.nesterov && (options.momentum == 0.0f || options.dampening != 0.0f)) {
+    throw std::invalid_argument("Nesterov SGD requires momentum and no dampening");
+  }
+}
+
+void SGD::zero_grad(const std::vector<DTensor *> &parameters) const {
+  for (DTensor *parameter : parameters) {
+    if (parameter != nullptr) {
+      parameter->zero_grad();
+    }
+  }
+}
+
+void SGD::step(const std::vector<DTensor *> &parameters) {
+  NoGradGuard no_grad;
+  const bool plain = options_.momentum == 0.0f && options_.weight_decay == 0.0f &&
+                     options_.max_grad_norm <= 0.0f;
+  std::vector<Slot> slots = collect_slots(parameters, plain);
+  if (options_.momentum != 0.0f) {
+    fit_state(momentum_, parameters.size());
+  }
+  Segments segments;
+  for (Slot &slot : slots) {
+    if (!is_floating_dtype(slot.value.dtype())) {
+      integer_sgd_update(slot, learning_rate_);
+      continue;
+    }
+    SegmentInfo info;
+    DTensor *buffer = nullptr;
+    if (options_.momentum != 0.0f) {
+      buffer = &state_for(momentum_, slot, info.fresh);
+    }
+    segments.add(slot, buffer, nullptr, info);
+  }
+
+  const double scale = clip_scale(segments, options_.max_grad_norm, last_grad_norm_);
+  sgd_update(segments.f32, options_, learning_rate_, scale);
+  sgd_update(segments.f64, options_, learning_rate_, scale);
+  write_back(slots);
+}
+
+Adam::Adam(float learning_rate, AdamOptions options)
+    : learning_rate_(learning_rate), options_(options) {
+  if (options.beta1 < 0.0f || options.beta1 >= 1.0f || options.beta2 < 0.0f ||
+      options.beta2 >= 1.0f) {
+    throw std::invalid_argument("Adam betas must lie in [0, 1)");
+  }
+  if (options.eps <= 0.0f || options.weight_decay < 0.0f) {
+    throw std::invalid_argument("Adam requires eps > 0 and non-negative weight decay");
+  }
+}
+
+void Adam::zero_grad(const std::vector<DTensor *> &parameters) const {
+  for (DTensor *parameter : parameters) {
+    if (parameter != nullptr) {
+      parameter->zero_grad();
+    }
+  }
+}
+
+void Adam::step(const std::vector<DTensor *> &parameters) {
+  NoGradGuard no_grad;
+  std::vector<Slot> slots = collect_slots(parameters, false);
+  fit_state(exp_avg_, parameters.size());
+  fit_state(exp_avg_sq_, parameters.size());
+  fit_state(steps_, parameters.size());
+  Segments segments;
+  for (Slot &slot : slots) {
+    SegmentInfo info;
+    DTensor &exp_avg = state_for(exp_avg_, slot, info.fresh);
+    DTensor &exp_avg_sq = state_for(exp_avg_sq_, slot, info.fresh);
+    const auto step = static_cast<double>(++steps_[slot.index]);
+    // p -= lr / (1 - beta1^t) * m / (sqrt(v) / sqrt(1 - beta2^t) + eps)
+    info.coefficient[0] = learning_rate_ / (1.0 - std::pow(options_.beta1, step));
+    info.coefficient[1] = 1.0 / std::sqrt(1.0 - std::pow(options_.beta2, step));
+    segments.add(slot, &exp_avg, &exp_avg_sq, info);
+  }
+
+  const double scale = clip_scale(segments, options_.max_grad_norm, last_grad_norm_);
+  adam_update(segments.f32, options_, learning_rate_, scale);
+  adam_update(segments.f64, options_, learning_rate_, scale);
+  write_back(slots);
+}
+
+AdamW::AdamW(float learning_rate, float weight_decay, AdamOptions options)
+    : Adam(learning_rate, [&] {
+        options.weight_decay = weight_decay;
+        options.decoupled_weight_decay = true;
+        return options;
+      }()) {}
+
+} // namespace Tensor::nn
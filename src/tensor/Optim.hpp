@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Tensor.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Tensor::nn {
+
+// Optimizers update every parameter that has a gradient in one fused pass
+// over its values, gradient and state, with the elements of all parameters
+// of a dtype cut into blocks for a single parallel launch, so many small
+// tensors cost one dispatch and large ones spread over the pool. Parameters
+// must be floating point, except that plain SGD (no momentum, weight decay or
+// clipping) also steps integer ones, with the learning rate cast to their
+// type. Non-contiguous parameters are updated through a dense copy.
+//
+// State is kept by position in the parameter list: pass the same parameters
+// in the same order on every step. Parameters without a gradient are skipped
+// and their state is left alone.
+
+struct SGDOptions {
+  float momentum{0.0f};
+  float dampening{0.0f};
+  bool nesterov{false};
+  // L2 penalty: weight_decay * parameter is added to the gradient.
+  float weight_decay{0.0f};
+  // When positive, gradients are scaled by max_grad_norm / norm whenever
+  // their global L2 norm across all parameters exceeds it. The scale is
+  // applied inside the update; gradients themselves are not rewritten.
+  float max_grad_norm{0.0f};
+};
+
+// Plain, momentum or Nesterov SGD. The first step seeds each momentum
+// buffer with the gradient.
+class SGD {
+public:
+  explicit SGD(float learning_rate, SGDOptions options = {});
+
+  void zero_grad(const std::vector<DTensor *> &parameters) const;
+  void step(const std::vector<DTensor *> &parameters);
+
+  float learning_rate() const noexcept { return learning_rate_; }
+  void set_learning_rate(float learning_rate) noexcept { learning_rate_ = learning_rate; }
+  // Global gradient norm seen by the last step, before clipping. Only
+  // measured when max_grad_norm is set.
+  double last_grad_norm() const noexcept { return last_grad_norm_; }
+
+private:
+  float learning_rate_;
+  SGDOptions options_;
+  std::vector<DTensor> momentum_;
+  double last_grad_norm_{0.0};
+};
+
+struct AdamOptions {
+  float beta1{0.9f};
+  float beta2{0.999f};
+  float eps{1e-8f};
+  float weight_decay{0.0f};
+  // Decay parameters directly by learning_rate * weight_decay (AdamW)
+  // instead of adding an L2 term to the gradient.
+  bool decoupled_weight_decay{false};
+  // Global-norm gradient clipping, as in SGDOptions.
+  float max_grad_norm{0.0f};
+};
+
+// Adam with bias-corrected moments, counted per parameter.
+class Adam {
+public:
+  explicit Adam(float learning_rate, AdamOptions options = {});
+
+  void zero_grad(const std::vector<DTensor *> &parameters) const;
+  void step(const std::vector<DTensor *> &parameters);
+
+  float learning_rate() const noexcept { return learning_rate_; }
+  void set_learning_rate(float learning_rate) noexcept { learning_rate_ = learning_rate; }
+  double last_grad_norm() const noexcept { return last_grad_norm_; }
+
+private:
+  float learning_rate_;
+  AdamOptions options_;
+  std::vector<DTensor> exp_avg_;
+  std::vector<DTensor> exp_avg_sq_;
+  std::vector<int64_t> steps_;
+  double last_grad_norm_{0.0};
+};
+
+// Adam with decoupled weight decay.
+class AdamW : public Adam {
+public:
+  explicit AdamW(float learning_rate, float weight_decay = 0.01f, AdamOptions options = {});
+};
+
+} // namespace Tensor::nn
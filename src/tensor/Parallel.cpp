@@ -0,0 +1,289 @@
+#include "tensor/Parallel.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Tensor {
+
+namespace {
+
+thread_local bool t_in_parallel = false;
+
+class InParallelScope {
+public:
+  InParallelScope() : previous_(t_in_parallel) { t_in_parallel = true; }
+  ~InParallelScope() { t_in_parallel = previous_; }
+  InParallelScope(const InParallelScope &) = delete;
+  InParallelScope &operator=(const InParallelScope &) = delete;
+
+private:
+  bool previous_;
+};
+
+// One contiguous piece of the current job. The owner takes grain-sized chunks
+// from the front; thieves split off the back half.
+struct alignas(64) Slot {
+  std::mutex mutex;
+  int64_t begin{0};
+  int64_t end{0};
+};
+
+class ThreadPool {
+public:
+  explicit ThreadPool(int threads)
+      : slots_(std::make_unique<Slot[]>(static_cast<std::size_t>(threads))),
+        size_(threads) {
+    workers_.reserve(static_cast<std::size_t>(threads - 1));
+    for (int index = 1; index < threads; ++index) {
+      workers_.emplace_back([this, index] { worker_loop(index); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto &worker : workers_) {
+      worker.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  int size() const noexcept { return size_; }
+
+  // Returns false without running anything when another caller owns the pool.
+  bool run(int64_t begin, int64_t end, int64_t grain, detail::RangeFnRef fn) {
+    std::unique_lock<std::mutex> submit(submit_, std::try_to_lock);
+    if (!submit.owns_lock()) {
+      return false;
+    }
+
+    const int64_t count = end - begin;
+    const int64_t chunks = (count + grain - 1) / grain;
+    const int participants = static_cast<int>(std::min<int64_t>(size_, chunks));
+    const int64_t per_slot = count / participants;
+    const int64_t extra = count % participants;
+    int64_t cursor = begin;
+    for (int index = 0; index < participants; ++index) {
+      Slot &slot = slots_[static_cast<std::size_t>(index)];
+      std::lock_guard<std::mutex> lock(slot.mutex);
+      slot.begin = cursor;
+      cursor += per_slot + (index < extra ? 1 : 0);
+      slot.end = cursor;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      fn_ = fn;
+      grain_ = grain;
+      participants_ = participants;
+      active_ = participants - 1;
+      error_ = nullptr;
+      ++generation_;
+    }
+    wake_.notify_all();
+
+    participate(0);
+
+    std::exception_ptr error;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      done_.wait(lock, [this] { return active_ == 0; });
+      error = std::exchange(error_, nullptr);
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    return true;
+  }
+
+private:
+  void worker_loop(int index) {
+    uint64_t seen = 0;
+    for (;;) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+      if (stop_) {
+        return;
+      }
+      seen = generation_;
+      if (index >= participants_) {
+        continue;
+      }
+      lock.unlock();
+
+      participate(index);
+
+      lock.lock();
+      if (--active_ == 0) {
+        done_.notify_one();
+      }
+    }
+  }
+
+  void participate(int index) {
+    InParallelScope scope;
+    int64_t chunk_begin = 0;
+    int64_t chunk_end = 0;
+    while (take(index, chunk_begin, chunk_end) || steal(index, chunk_begin, chunk_end)) {
+      try {
+        fn_.call(fn_.object, chunk_begin, chunk_end);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error_) {
+          error_ = std::current_exception();
+        }
+      }
+    }
+  }
+
+  bool take(int index, int64_t &chunk_begin, int64_t &chunk_end) {
+    Slot &slot = slots_[static_cast<std::size_t>(index)];
+    std::lock_guard<std::mutex> lock(slot.mutex);
+    if (slot.begin >= slot.end) {
+      return false;
+    }
+    chunk_begin = slot.begin;
+    chunk_end = std::min(slot.begin + grain_, slot.end);
+    slot.begin = chunk_end;
+    return true;
+  }
+
+  bool steal(int index, int64_t &chunk_begin, int64_t &chunk_end) {
+    for (int offset = 1; offset < participants_; ++offset) {
+      Slot &victim = slots_[static_cast<std::size_t>((index + offset) % participants_)];
+      int64_t stolen_begin = 0;
+      int64_t stolen_end = 0;
+      {
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        const int64_t remaining = victim.end - victim.begin;
+        if (remaining <= 0) {
+          continue;
+        }
+        if (remaining <= grain_) {
+          chunk_begin = victim.begin;
+          chunk_end = victim.end;
+          victim.begin = victim.end;
+          return true;
+        }
+        stolen_begin = victim.end - remaining / 2;
+        stolen_end = victim.end;
+        victim.end = stolen_begin;
+      }
+
+      Slot &own = slots_[static_cast<std::size_t>(index)];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      chunk_begin = stolen_begin;
+      chunk_end = std::min(stolen_begin + grain_, stolen_end);
+      own.begin = chunk_end;
+      own.end = stolen_end;
+      return true;
+    }
+    return false;
+  }
+
+  std::unique_ptr<Slot[]> slots_;
+  int size_;
+  std::vector<std::thread> workers_;
+
+  std::mutex submit_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  uint64_t generation_{0};
+  bool stop_{false};
+
+  detail::RangeFnRef fn_{};
+  int64_t grain_{1};
+  int participants_{0};
+  int active_{0};
+  std::exception_ptr error_{};
+};
+
+int default_num_threads() {
+  if (const char *env = std::getenv("TENSOR_NUM_THREADS")) {
+    try {
+      const int value = std::stoi(env);
+      if (value > 0) {
+        return value;
+      }
+    } catch (const std::exception &) {
+    }
+  }
+  return static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+std::mutex g_pool_mutex;
+std::shared_ptr<ThreadPool> g_pool;
+int g_num_threads = 0;
+
+std::shared_ptr<ThreadPool> pool() {
+  std::lock_guard<std::mutex> lock(g_pool_mutex);
+  if (!g_pool) {
+    if (g_num_threads == 0) {
+      g_num_threads = default_num_threads();
+    }
+    g_pool = std::make_shared<ThreadPool>(g_num_threads);
+  }
+  return g_pool;
+}
+
+} // namespace
+
+int get_num_threads() {
+  std::lock_guard<std::mutex> lock(g_pool_mutex);
+  if (g_num_threads == 0) {
+    g_num_threads = default_num_threads();
+  }
+  return g_num_threads;
+}
+
+void set_num_threads(int threads) {
+  if (threads < 1) {
+    throw std::invalid_argument("set_num_threads requires a positive thread count");
+  }
+  std::shared_ptr<ThreadPool> previous;
+  {
+    std::lock_guard<std::mutex> lock(g_pool_mutex);
+    if (threads == g_num_threads) {
+      return;
+    }
+    g_num_threads = threads;
+    previous = std::move(g_pool);
+  }
+}
+
+bool in_parallel_region() noexcept {
+  return t_in_parallel;
+}
+
+namespace detail {
+
+bool should_parallelize(int64_t count, int64_t grain) noexcept {
+  return count > grain && !t_in_parallel;
+}
+
+void parallel_run(int64_t begin, int64_t end, int64_t grain, RangeFnRef fn) {
+  const auto shared = pool();
+  if (shared->size() == 1 || !shared->run(begin, end, grain, fn)) {
+    InParallelScope scope;
+    fn.call(fn.object, begin, end);
+  }
+}
+
+} // namespace detail
+
+} // namespace Tensor
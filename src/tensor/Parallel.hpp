@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+namespace Tensor {
+
+// Ranges at or below this many elements stay on the calling thread; a pool
+// dispatch costs a few microseconds, which is more than a pass over 32K floats.
+inline constexpr int64_t kDefaultGrainSize = 32768;
+
+// Intra-op thread count, including the calling thread. Defaults to the
+// TENSOR_NUM_THREADS environment variable, or the hardware concurrency.
+int get_num_threads();
+
+// Resizes the shared pool. Must not race with running parallel_for calls.
+void set_num_threads(int threads);
+
+// True while the current thread is executing a parallel_for body.
+bool in_parallel_region() noexcept;
+
+namespace detail {
+
+struct RangeFnRef {
+  void *object;
+  void (*call)(void *object, int64_t begin, int64_t end);
+};
+
+bool should_parallelize(int64_t count, int64_t grain) noexcept;
+void parallel_run(int64_t begin, int64_t end, int64_t grain, RangeFnRef fn);
+
+} // namespace detail
+
+// Calls fn(chunk_begin, chunk_end) over disjoint chunks covering [begin, end).
+// Chunks hold at least `grain` elements except the tail; idle threads steal the
+// back half of a busy thread's remaining range. Nested calls, calls made while
+// another thread owns the pool, and ranges of at most `grain` elements run
+// inline. The first exception thrown by fn is rethrown on the caller.
+template <typename F>
+void parallel_for(int64_t begin, int64_t end, int64_t grain, const F &fn) {
+  if (begin >= end) {
+    return;
+  }
+  if (grain < 1) {
+    grain = 1;
+  }
+  if (!detail::should_parallelize(end - begin, grain)) {
+    fn(begin, end);
+    return;
+  }
+  using Fn = std::remove_reference_t<const F>;
+  detail::parallel_run(begin, end, grain,
+                       detail::RangeFnRef{const_cast<void *>(static_cast<const void *>(&fn)),
+                                          [](void *object, int64_t b, int64_t e) {
+                                            (*static_cast<Fn *>(object))(b, e);
+                                          }});
+}
+
+} // namespace Tensor
@@ -0,0 +1,293 @@
+#include "tensor/Reduce.hpp"
+
+#include "tensor/Dispatch.hpp"
+#include "tensor/Elementwise.hpp"
+#include "tensor/Parallel.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace Tensor::kernels {
+
+namespace {
+
+// Plane reductions fold runs of kColumnLeaf rows in order and combine the runs
+// pairwise. Each task owns a band of kColumnBand columns, so the partial rows
+// it keeps stay in L1, and at most kColumnChunk rows of one plane; taller
+// planes are split into fixed chunks whose partial rows are combined after.
+constexpr int64_t kColumnLeaf = 32;
+constexpr int64_t kColumnBand = 256;
+constexpr int64_t kColumnChunk = 4096;
+
+template <typename F> void dispatch_reducer(ReduceOp op, F &&fn) {
+  switch (op) {
+  case ReduceOp::sum:
+    fn(detail::SumReducer{});
+    return;
+  case ReduceOp::max:
+    fn(detail::MaxReducer{});
+    return;
+  case ReduceOp::min:
+    fn(detail::MinReducer{});
+    return;
+  }
+}
+
+int64_t leaf_count(int64_t size) {
+  return (size + kReduceBlock - 1) / kReduceBlock;
+}
+
+template <typename Reducer, typename T>
+T reduce_row(const T *src, int64_t size, std::vector<T> &leaves) {
+  const int64_t count = leaf_count(size);
+  leaves.resize(static_cast<std::size_t>(count));
+  for (int64_t leaf = 0; leaf < count; ++leaf) {
+    const int64_t begin = leaf * kReduceBlock;
+    leaves[static_cast<std::size_t>(leaf)] =
+        detail::reduce_block<Reducer>(src + begin, std::min(kReduceBlock, size - begin));
+  }
+  return detail::reduce_tree<Reducer>(leaves.data(), count);
+}
+
+// reduce_row with the leaves of one long row folded in parallel.
+template <typename Reducer, typename T> T reduce_long_row(const T *src, int64_t size) {
+  const int64_t count = leaf_count(size);
+  std::vector<T> leaves(static_cast<std::size_t>(count));
+  parallel_for(0, count, kDefaultGrainSize / kReduceBlock, [&](int64_t begin, int64_t end) {
+    for (int64_t leaf = begin; leaf < end; ++leaf) {
+      const int64_t first = leaf * kReduceBlock;
+      leaves[static_cast<std::size_t>(leaf)] =
+          detail::reduce_block<Reducer>(src + first, std::min(kReduceBlock, size - first));
+    }
+  });
+  return detail::reduce_tree<Reducer>(leaves.data(), count);
+}
+
+template <typename Reducer, typename T>
+void reduce_rows(const T *src, T *dst, int64_t outer, int64_t size) {
+  if (outer == 1 || size >= kDefaultGrainSize) {
+    for (int64_t row = 0; row < outer; ++row) {
+      dst[row] = reduce_long_row<Reducer>(src + row * size, size);
+    }
+    return;
+  }
+  parallel_for(0, outer, std::max<int64_t>(1, kDefaultGrainSize / size),
+               [&](int64_t begin, int64_t end) {
+                 std::vector<T> leaves;
+                 for (int64_t row = begin; row < end; ++row) {
+                   dst[row] = reduce_row<Reducer>(src + row * size, size, leaves);
+                 }
+               });
+}
+
+// Partial rows reduce_plane keeps alive at once for a plane of `rows` rows.
+int64_t plane_depth(int64_t rows) {
+  int64_t depth = 1;
+  for (; rows > kColumnLeaf; rows = (rows + 1) / 2) {
+    ++depth;
+  }
+  return depth;
+}
+
+// Folds `rows` rows of `width` contiguous elements, `stride` elements apart,
+// into `out`. `scratch` holds plane_depth(rows) - 1 rows of `width`.
+template <typename Reducer, typename T>
+void reduce_plane(const T *src, int64_t rows, int64_t stride, int64_t width, T *out,
+                  T *scratch) {
+  const auto combine = [](auto a, auto b) { return Reducer::combine(a, b); };
+  if (rows <= kColumnLeaf) {
+    std::copy_n(src, width, out);
+    for (int64_t row = 1; row < rows; ++row) {
+      map_contiguous_serial(width, out, combine, out, src + row * stride);
+    }
+    return;
+  }
+  const int64_t half = rows / 2;
+  reduce_plane<Reducer>(src, half, stride, width, out, scratch);
+  reduce_plane<Reducer>(src + half * stride, rows - half, stride, width, scratch,
+                        scratch + width);
+  map_contiguous_serial(width, out, combine, out, scratch);
+}
+
+template <typename Reducer, typename T>
+void reduce_columns(const T *src, T *dst, int64_t outer, int64_t size, int64_t inner) {
+  const int64_t bands = (inner + kColumnBand - 1) / kColumnBand;
+  const int64_t chunks = (size + kColumnChunk - 1) / kColumnChunk;
+  std::vector<T> partials(chunks > 1 ? static_cast<std::size_t>(outer * chunks * inner) : 0);
+  const int64_t task_cost = std::min(size, kColumnChunk) * std::min(inner, kColumnBand);
+  parallel_for(0, outer * bands * chunks, std::max<int64_t>(1, kDefaultGrainSize / task_cost),
+               [&](int64_t begin, int64_t end) {
+                 std::vector<T> scratch(
+                     static_cast<std::size_t>(plane_depth(kColumnChunk) * kColumnBand));
+                 for (int64_t task = begin; task < end; ++task) {
+                   const int64_t chunk = task % chunks;
+                   const int64_t band = task / chunks % bands;
+                   const int64_t plane = task / (chunks * bands);
+                   const int64_t column = band * kColumnBand;
+                   const int64_t row = chunk * kColumnChunk;
+                   T *out = chunks == 1 ? dst + plane * inner + column
+                                        : partials.data() + (plane * chunks + chunk) * inner +
+                                              column;
+                   reduce_plane<Reducer>(src + (plane * size + row) * inner + column,
+                                         std::min(kColumnChunk, size - row), inner,
+                                         std::min(kColumnBand, inner - column), out,
+                                         scratch.data());
+                 }
+               });
+  if (chunks == 1) {
+    return;
+  }
+  parallel_for(0, outer * bands, 1, [&](int64_t begin, int64_t end) {
+    std::vector<T> scratch(static_cast<std::size_t>(plane_depth(chunks) * kColumnBand));
+    for (int64_t task = begin; task < end; ++task) {
+      const int64_t plane = task / bands;
+      const int64_t column = task % bands * kColumnBand;
+      reduce_plane<Reducer>(partials.data() + plane * chunks * inner + column, chunks, inner,
+                            std::min(kColumnBand, inner - column),
+                            dst + plane * inner + column, scratch.data());
+    }
+  });
+}
+
+// Planes narrower than a band would run one short vector op per row. Folding
+// them as rows of kColumnBand elements, each holding `groups` consecutive
+// narrow rows, keeps the vector work full width; the interleaved groups and
+// the leftover rows are folded into the output afterwards.
+template <typename Reducer, typename T>
+void reduce_narrow_columns(const T *src, T *dst, int64_t outer, int64_t size, int64_t inner) {
+  const int64_t groups = kColumnBand / inner;
+  const int64_t wide = groups * inner;
+  const int64_t full = size / groups;
+  std::vector<T> partial(static_cast<std::size_t>(wide));
+  std::vector<T> scratch(static_cast<std::size_t>(plane_depth(groups) * inner));
+  const auto combine = [](auto a, auto b) { return Reducer::combine(a, b); };
+  for (int64_t plane = 0; plane < outer; ++plane) {
+    const T *values = src + plane * size * inner;
+    T *out = dst + plane * inner;
+    reduce_columns<Reducer>(values, partial.data(), 1, full, wide);
+    reduce_plane<Reducer>(partial.data(), groups, inner, inner, out, scratch.data());
+    for (int64_t row = full * groups; row < size; ++row) {
+      map_contiguous_serial(inner, out, combine, out, values + row * inner);
+    }
+  }
+}
+
+// Whether `value` replaces `best` as the running argmax: it is larger, or the
+// first NaN.
+template <typename T> bool beats(T value, T best) {
+  return value > best || (value != value && best == best);
+}
+
+template <typename T> int64_t argmax_run(const T *src, int64_t begin, int64_t end) {
+  int64_t best = begin;
+  for (int64_t index = begin + 1; index < end; ++index) {
+    if (beats(src[index], src[best])) {
+      best = index;
+    }
+  }
+  return best;
+}
+
+template <typename T> void argmax_rows(const T *src, int64_t *dst, int64_t outer, int64_t size) {
+  if (outer == 1 || size >= kDefaultGrainSize) {
+    // Fixed chunks keep the pick independent of the thread count; a later
+    // chunk wins only with a strictly larger value.
+    const int64_t chunks = (size + kDefaultGrainSize - 1) / kDefaultGrainSize;
+    std::vector<int64_t> picks(static_cast<std::size_t>(chunks));
+    for (int64_t row = 0; row < outer; ++row) {
+      const T *values = src + row * size;
+      parallel_for(0, chunks, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t chunk = begin; chunk < end; ++chunk) {
+          picks[static_cast<std::size_t>(chunk)] = argmax_run(
+              values, chunk * kDefaultGrainSize, std::min(size, (chunk + 1) * kDefaultGrainSize));
+        }
+      });
+      int64_t best = picks[0];
+      for (const int64_t pick : picks) {
+        if (beats(values[pick], values[best])) {
+          best = pick;
+        }
+      }
+      dst[row] = best;
+    }
+    return;
+  }
+  parallel_for(0, outer, std::max<int64_t>(1, kDefaultGrainSize / size),
+               [&](int64_t begin, int64_t end) {
+                 for (int64_t row = begin; row < end; ++row) {
+                   dst[row] = argmax_run(src + row * size, 0, size);
+                 }
+               });
+}
+
+template <typename T>
+void argmax_columns(const T *src, int64_t *dst, int64_t outer, int64_t size, int64_t inner) {
+  const int64_t bands = (inner + kColumnBand - 1) / kColumnBand;
+  const int64_t task_cost = size * std::min(inner, kColumnBand);
+  parallel_for(0, outer * bands, std::max<int64_t>(1, kDefaultGrainSize / task_cost),
+               [&](int64_t begin, int64_t end) {
+                 T best[kColumnBand];
+                 for (int64_t task = begin; task < end; ++task) {
+                   const int64_t plane = task / bands;
+                   const int64_t column = task % bands * kColumnBand;
+                   const int64_t width = std::min(kColumnBand, inner - column);
+                   const T *values = src + plane * size * inner + column;
+                   int64_t *picks = dst + plane * inner + column;
+                   std::copy_n(values, width, best);
+                   std::fill_n(picks, width, int64_t{0});
+                   for (int64_t row = 1; row < size; ++row) {
+                     const T *current = values + row * inner;
+                     for (int64_t lane = 0; lane < width; ++lane) {
+                       if (beats(current[lane], best[lane])) {
+                         best[lane] = current[lane];
+                         picks[lane] = row;
+                       }
+                     }
+                   }
+                 }
+               });
+}
+
+} // namespace
+
+void reduce_contiguous(ReduceOp op, DType dtype, const void *src, void *dst, int64_t outer,
+                       int64_t size, int64_t inner) {
+  if (outer * inner == 0) {
+    return;
+  }
+  dispatch_dtype(dtype, [&](auto tag) {
+    using T = typename decltype(tag)::type;
+    dispatch_reducer(op, [&](auto reducer) {
+      using Reducer = decltype(reducer);
+      const T *in = static_cast<const T *>(src);
+      T *out = static_cast<T *>(dst);
+      if (size == 0) {
+        std::fill_n(out, outer * inner, Reducer::template identity<T>());
+      } else if (inner == 1) {
+        reduce_rows<Reducer>(in, out, outer, size);
+      } else if (inner <= kColumnBand / 4 && size >= 4 * (kColumnBand / inner)) {
+        reduce_narrow_columns<Reducer>(in, out, outer, size, inner);
+      } else {
+        reduce_columns<Reducer>(in, out, outer, size, inner);
+      }
+    });
+  });
+}
+
+void argmax_contiguous(DType dtype, const void *src, int64_t *dst, int64_t outer, int64_t size,
+                       int64_t inner) {
+  if (outer * inner == 0) {
+    return;
+  }
+  dispatch_dtype(dtype, [&](auto tag) {
+    using T = typename decltype(tag)::type;
+    const T *in = static_cast<const T *>(src);
+    if (inner == 1) {
+      argmax_rows(in, dst, outer, size);
+    } else {
+      argmax_columns(in, dst, outer, size, inner);
+    }
+  });
+}
+
+} // namespace Tensor::kernels
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+#include "tensor/Tensor.hpp"
+#include "tensor/Vec.hpp"
+
+namespace Tensor::kernels {
+
+enum class ReduceOp : uint8_t { sum, max, min };
+
+// Elements per accumulation leaf. A leaf is folded in SIMD lanes and leaf
+// results are combined pairwise, so the rounding error of a sum grows with
+// log(n) instead of n, and the result does not depend on the thread count.
+inline constexpr int64_t kReduceBlock = 256;
+
+// Reduces a contiguous tensor viewed as [outer, size, inner] over its middle
+// dim into a contiguous [outer, inner] output. Rows (inner == 1) are folded
+// along their contiguous run; otherwise whole [size, inner] planes are folded
+// row by row, vectorized across inner. max/min require size > 0 and give NaN
+// wherever the reduced values hold one.
+void reduce_contiguous(ReduceOp op, DType dtype, const void *src, void *dst, int64_t outer,
+                       int64_t size, int64_t inner);
+
+// Index of the first maximum along the middle dim of a contiguous
+// [outer, size, inner] tensor, written to a contiguous [outer, inner] output.
+// A NaN counts as the maximum, as it does for max. Requires size > 0.
+void argmax_contiguous(DType dtype, const void *src, int64_t *dst, int64_t outer, int64_t size,
+                       int64_t inner);
+
+namespace detail {
+
+struct SumReducer {
+  template <typename T> static constexpr T identity() noexcept { return T{0}; }
+  template <typename V> static V combine(const V &a, const V &b) { return a + b; }
+};
+
+// max and min return NaN when either operand is NaN, whatever the order the
+// values are combined in. Unordered lanes take (a - a) + b, which is then NaN;
+// integer lanes are always ordered, and that form cannot overflow for them.
+template <typename V> V unordered_or(const V &ordered, const V &a, const V &b) {
+  return simd::select((a < b) | (a >= b), ordered, (a - a) + b);
+}
+
+struct MaxReducer {
+  template <typename T> static constexpr T identity() noexcept {
+    if constexpr (std::numeric_limits<T>::has_infinity) {
+      return -std::numeric_limits<T>::infinity();
+    } else {
+      return std::numeric_limits<T>::lowest();
+    }
+  }
+  template <typename V> static V combine(const V &a, const V &b) {
+    return unordered_or(simd::maximum(a, b), a, b);
+  }
+};
+
+struct MinReducer {
+  template <typename T> static constexpr T identity() noexcept {
+    if constexpr (std::numeric_limits<T>::has_infinity) {
+      return std::numeric_limits<T>::infinity();
+    } else {
+      return std::numeric_limits<T>::max();
+    }
+  }
+  template <typename V> static V combine(const V &a, const V &b) {
+    return unordered_or(simd::minimum(a, b), a, b);
+  }
+};
+
+// Folds n <= kReduceBlock contiguous elements: two registers of lanes, then
+// the lanes pairwise, then the scalar tail.
+template <typename Reducer, typename T> T reduce_block(const T *src, int64_t n) {
+  using V = simd::Vec<T>;
+  V first(Reducer::template identity<T>());
+  V second(Reducer::template identity<T>());
+  int64_t index = 0;
+  for (; index + 2 * V::size <= n; index += 2 * V::size) {
+    first = Reducer::combine(first, V::load(src + index));
+    second = Reducer::combine(second, V::load(src + index + V::size));
+  }
+  if (index + V::size <= n) {
+    first = Reducer::combine(first, V::load(src + index));
+    index += V::size;
+  }
+  first = Reducer::combine(first, second);
+  T lanes[V::size];
+  first.store(lanes);
+  for (int64_t width = V::size / 2; width > 0; width /= 2) {
+    for (int64_t lane = 0; lane < width; ++lane) {
+      lanes[lane] = Reducer::combine(lanes[lane], lanes[lane + width]);
+    }
+  }
+  T result = lanes[0];
+  for (; index < n; ++index) {
+    result = Reducer::combine(result, src[index]);
+  }
+  return result;
+}
+
+// Combines n >= 1 values as a balanced binary tree.
+template <typename Reducer, typename T> T reduce_tree(const T *values, int64_t n) {
+  if (n == 1) {
+    return values[0];
+  }
+  const int64_t half = n / 2;
+  return Reducer::combine(reduce_tree<Reducer>(values, half),
+                          reduce_tree<Reducer>(values + half, n - half));
+}
+
+} // namespace detail
+
+// The two halves of a sum, for callers that produce their values one block at
+// a time: sum_block folds one block of at most kReduceBlock elements, and
+// pairwise_sum combines the per-block results of consecutive blocks. Together
+// they give exactly what reduce_contiguous computes for a row.
+template <typename T> T sum_block(const T *src, int64_t n) {
+  return detail::reduce_block<detail::SumReducer>(src, n);
+}
+
+template <typename T> T pairwise_sum(const T *values, int64_t n) {
+  return n == 0 ? T{0} : detail::reduce_tree<detail::SumReducer>(values, n);
+}
+
+} // namespace Tensor::kernels
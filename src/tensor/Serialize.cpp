@@ -0,0 +1,676 @@
+#include "tensor/Serialize.hpp"
+
+#include "tensor/MappedFile.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace Tensor {
+
+namespace {
+
+constexpr char kMagic[8] = {'T', 'N', 'S', 'R', 'F', 'I', 'L', 'E'};
+constexpr uint32_t kVersion = 1;
+constexpr uint64_t kPayloadAlignment = 64;
+constexpr std::size_t kMaxRank = 255;
+
+void require_little_endian() {
+  if constexpr (std::endian::native != std::endian::little) {
+    throw std::runtime_error("tensor files are only supported on little-endian hosts");
+  }
+}
+
+uint64_t align_up(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+[[noreturn]] void malformed(const std::string &path, const std::string &what) {
+  throw std::runtime_error("malformed tensor file " + path + ": " + what);
+}
+
+// The storage elements a view covers: its offset and the distance to its last
+// element, plus one.
+struct Span {
+  int64_t first{0};
+  int64_t count{0};
+};
+
+Span span_of(const DTensor &tensor) {
+  if (tensor.numel() == 0) {
+    return {tensor.offset(), 0};
+  }
+  int64_t last = tensor.offset();
+  for (std::size_t dim = 0; dim < tensor.shape().size(); ++dim) {
+    last += (tensor.shape()[dim] - 1) * tensor.stride()[dim];
+  }
+  return {tensor.offset(), last - tensor.offset() + 1};
+}
+
+std::size_t header_bytes(const NamedTensor &entry) {
+  const std::size_t rank = entry.tensor.shape().size();
+  return 4 + entry.name.size() + 4 + 16 * rank + 8 + 16;
+}
+
+// Writes to a temporary file next to `path` and renames it over `path` in
+// commit(), so the old file, and any tensors still mapping it, stay intact
+// until the new one is complete. Without a commit the temporary is removed.
+class Writer {
+public:
+  explicit Writer(const std::string &path)
+      : path_(path), temporary_(path + ".tmp"), out_(temporary_, std::ios::binary) {
+    if (!out_) {
+      throw std::runtime_error("cannot open " + temporary_ + " for writing");
+    }
+  }
+  ~Writer() {
+    if (!committed_) {
+      out_.close();
+      std::error_code ignored;
+      std::filesystem::remove(temporary_, ignored);
+    }
+  }
+  Writer(const Writer &) = delete;
+  Writer &operator=(const Writer &) = delete;
+
+  template <typename T> void put(T value) {
+    bytes(&value, sizeof(T));
+  }
+  void bytes(const void *data, std::size_t count) {
+    out_.write(static_cast<const char *>(data), static_cast<std::streamsize>(count));
+    position_ += count;
+  }
+  void pad_to(uint64_t position) {
+    static constexpr char kZeros[kPayloadAlignment] = {};
+    while (position_ < position) {
+      bytes(kZeros, std::min<uint64_t>(position - position_, sizeof(kZeros)));
+    }
+  }
+  void commit() {
+    out_.close();
+    if (!out_) {
+      throw std::runtime_error("failed to write " + temporary_);
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary_, path_, error);
+    if (error) {
+      throw std::runtime_error("cannot replace " + path_ + ": " + error.message());
+    }
+    committed_ = true;
+  }
+
+private:
+  std::string path_;
+  std::string temporary_;
+  std::ofstream out_;
+  uint64_t position_{0};
+  bool committed_{false};
+};
+
+// Bounds-checked reads from a mapped file.
+class Cursor {
+public:
+  Cursor(const std::string &path, const unsigned char *data, std::size_t size, std::size_t position)
+      : path_(path), data_(data), size_(size), position_(position) {}
+
+  template <typename T> T get() {
+    T value;
+    std::memcpy(&value, take(sizeof(T)), sizeof(T));
+    return value;
+  }
+  const unsigned char *take(std::size_t count) {
+    if (count > size_ - position_) {
+      malformed(path_, "unexpected end of header");
+    }
+    const unsigned char *start = data_ + position_;
+    position_ += count;
+    return start;
+  }
+  std::size_t position() const noexcept { return position_; }
+
+private:
+  const std::string &path_;
+  const unsigned char *data_;
+  std::size_t size_;
+  std::size_t position_;
+};
+
+// A tensor over `bytes` bytes at `position` in the mapping, checked against
+// the layout it is given.
+DTensor mapped_tensor(const std::string &path, const MappedFile &mapping, const std::string &name,
+                      uint64_t position, uint64_t bytes, Dims shape, Dims stride, int64_t offset,
+                      DType dtype) {
+  if (position > mapping.size || bytes > mapping.size - position) {
+    malformed(path, "payload of " + name + " runs past the end of the file");
+  }
+  for (std::size_t dim = 0; dim < shape.size(); ++dim) {
+    if (shape[dim] < 0 || stride[dim] < 0) {
+      malformed(path, "negative dimension or stride in " + name);
+    }
+  }
+  if (offset < 0) {
+    malformed(path, "negative offset in " + name);
+  }
+  const auto itemsize = static_cast<uint64_t>(dtype_size(dtype));
+  const uint64_t capacity = bytes / itemsize;
+  if (std::none_of(shape.begin(), shape.end(), [](int64_t size) { return size == 0; })) {
+    // Grows `last` one dim at a time, checking each step against the room
+    // left so nothing overflows.
+    auto last = static_cast<uint64_t>(offset);
+    if (last >= capacity) {
+      malformed(path, "layout of " + name + " exceeds its payload");
+    }
+    for (std::size_t dim = 0; dim < shape.size(); ++dim) {
+      const auto steps = static_cast<uint64_t>(shape[dim] - 1);
+      const auto step = static_cast<uint64_t>(stride[dim]);
+      if (steps != 0 && step > (capacity - 1 - last) / steps) {
+        malformed(path, "layout of " + name + " exceeds its payload");
+      }
+      last += steps * step;
+    }
+  }
+
+  const unsigned char *data = mapping.bytes + position;
+  std::shared_ptr<Storage> storage;
+  const auto address = reinterpret_cast<uintptr_t>(data);
+  if (address % itemsize == 0) {
+    const uint64_t alignment = address % kPayloadAlignment == 0 ? kPayloadAlignment : itemsize;
+    storage = std::make_shared<Storage>(
+        std::shared_ptr<void>(mapping.block, const_cast<unsigned char *>(data)),
+        static_cast<std::size_t>(bytes), static_cast<std::size_t>(alignment));
+  } else {
+    storage = make_host_storage(static_cast<std::size_t>(bytes));
+    std::memcpy(storage->data(), data, static_cast<std::size_t>(bytes));
+  }
+  return DTensor(std::move(storage), std::move(shape), std::move(stride), offset, dtype);
+}
+
+std::vector<NamedTensor> load_tensor_file(const std::string &path, const MappedFile &mapping) {
+  Cursor cursor(path, mapping.bytes, mapping.size, sizeof(kMagic));
+  if (cursor.get<uint32_t>() != kVersion) {
+    throw std::runtime_error("unsupported tensor file version in " + path);
+  }
+  const auto count = cursor.get<uint32_t>();
+  cursor.get<uint64_t>(); // payload start, implied by the entries
+  std::vector<NamedTensor> tensors;
+  tensors.reserve(std::min<std::size_t>(count, mapping.size / 40));
+  for (uint32_t index = 0; index < count; ++index) {
+    const auto name_bytes = cursor.get<uint32_t>();
+    std::string name(reinterpret_cast<const char *>(cursor.take(name_bytes)), name_bytes);
+    const auto dtype = cursor.get<uint8_t>();
+    if (dtype > static_cast<uint8_t>(DType::i64)) {
+      malformed(path, "unknown dtype for " + name);
+    }
+    const auto rank = cursor.get<uint8_t>();
+    cursor.get<uint16_t>();
+    Dims shape(rank);
+    Dims stride(rank);
+    for (auto &size : shape) {
+      size = cursor.get<int64_t>();
+    }
+    for (auto &step : stride) {
+      step = cursor.get<int64_t>();
+    }
+    const auto offset = cursor.get<int64_t>();
+    const auto position = cursor.get<uint64_t>();
+    const auto bytes = cursor.get<uint64_t>();
+    DTensor tensor = mapped_tensor(path, mapping, name, position, bytes, std::move(shape),
+                                   std::move(stride), offset, static_cast<DType>(dtype));
+    tensors.push_back({std::move(name), std::move(tensor)});
+  }
+  return tensors;
+}
+
+// Just enough JSON for a safetensors header: objects, arrays, strings and
+// integers, with true, false, null and fractions accepted and ignored.
+struct JsonValue {
+  enum class Kind : uint8_t { null, boolean, number, string, array, object };
+  Kind kind{Kind::null};
+  int64_t integer{0};
+  bool is_integer{false};
+  std::string text;
+  std::vector<JsonValue> items;
+  std::vector<std::pair<std::string, JsonValue>> members;
+
+  const JsonValue *find(const std::string &key) const {
+    for (const auto &[name, value] : members) {
+      if (name == key) {
+        return &value;
+      }
+    }
+    return nullptr;
+  }
+};
+
+class JsonParser {
+public:
+  JsonParser(const std::string &path, const char *data, std::size_t size)
+      : path_(path), data_(data), end_(data + size) {}
+
+  JsonValue parse_document() {
+    JsonValue value = parse_value(0);
+    skip_space();
+    if (data_ != end_) {
+      malformed(path_, "trailing bytes after the safetensors header");
+    }
+    return value;
+  }
+
+private:
+  static constexpr int kMaxDepth = 64;
+  static constexpr auto kMaxInteger = static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+
+  JsonValue parse_value(int depth) {
+    if (depth > kMaxDepth) {
+      fail("nesting is too deep");
+    }
+    skip_space();
+    if (data_ == end_) {
+      fail("unexpected end");
+    }
+    JsonValue value;
+    switch (*data_) {
+    case '{':
+      value.kind = JsonValue::Kind::object;
+      ++data_;
+      if (!consume('}')) {
+        do {
+          skip_space();
+          std::string key = parse_string();
+          expect(':');
+          JsonValue member = parse_value(depth + 1);
+          value.members.emplace_back(std::move(key), std::move(member));
+        } while (consume(','));
+        expect('}');
+      }
+      return value;
+    case '[':
+      value.kind = JsonValue::Kind::array;
+      ++data_;
+      if (!consume(']')) {
+        do {
+          value.items.push_back(parse_value(depth + 1));
+        } while (consume(','));
+        expect(']');
+      }
+      return value;
+    case '"':
+      value.kind = JsonValue::Kind::string;
+      value.text = parse_string();
+      return value;
+    case 't':
+      literal("true");
+      value.kind = JsonValue::Kind::boolean;
+      return value;
+    case 'f':
+      literal("false");
+      value.kind = JsonValue::Kind::boolean;
+      return value;
+    case 'n':
+      literal("null");
+      return value;
+    default:
+      return parse_number();
+    }
+  }
+
+  JsonValue parse_number() {
+    JsonValue value;
+    value.kind = JsonValue::Kind::number;
+    const bool negative = data_ != end_ && *data_ == '-';
+    if (negative) {
+      ++data_;
+    }
+    if (data_ == end_ || *data_ < '0' || *data_ > '9') {
+      fail("unexpected character");
+    }
+    uint64_t magnitude = 0;
+    bool fits = true;
+    for (; data_ != end_ && *data_ >= '0' && *data_ <= '9'; ++data_) {
+      const auto digit = static_cast<uint64_t>(*data_ - '0');
+      fits = fits && magnitude <= (kMaxInteger - digit) / 10;
+      magnitude = magnitude * 10 + digit;
+    }
+    value.is_integer = fits;
+    while (data_ != end_ && (*data_ == '.' || *data_ == 'e' || *data_ == 'E' ||
+                             *data_ == '+' || *data_ == '-' || (*data_ >= '0' && *data_ <= '9'))) {
+      value.is_integer = false;
+      ++data_;
+    }
+    if (value.is_integer) {
+      value.integer = negative ? -static_cast<int64_t>(magnitude) : static_cast<int64_t>(magnitude);
+    }
+    return value;
+  }
+
+  std::string parse_string() {
+    if (!consume('"')) {
+      fail("expected a string");
+    }
+    std::string text;
+    while (true) {
+      if (data_ == end_) {
+        fail("unterminated string");
+      }
+      const char c = *data_++;
+      if (c == '"') {
+        return text;
+      }
+      if (c != '\\') {
+        text.push_back(c);
+        continue;
+      }
+      if (data_ == end_) {
+        fail("unterminated string");
+      }
+      switch (const char escape = *data_++) {
+      case '"':
+      case '\\':
+      case '/':
+        text.push_back(escape);
+        break;
+      case 'b':
+        text.push_back('\b');
+        break;
+      case 'f':
+        text.push_back('\f');
+        break;
+      case 'n':
+        text.push_back('\n');
+        break;
+      case 'r':
+        text.push_back('\r');
+        break;
+      case 't':
+        text.push_back('\t');
+        break;
+      case 'u':
+        append_utf8(text, parse_code_point());
+        break;
+      default:
+        fail("bad escape");
+      }
+    }
+  }
+
+  uint32_t parse_hex4() {
+    if (end_ - data_ < 4) {
+      fail("bad \\u escape");
+    }
+    uint32_t value = 0;
+    for (int digit = 0; digit < 4; ++digit) {
+      const char c = *data_++;
+      value <<= 4;
+      if (c >= '0' && c <= '9') {
+        value |= static_cast<uint32_t>(c - '0');
+      } else if (c >= 'a' && c <= 'f') {
+        value |= static_cast<uint32_t>(c - 'a' + 10);
+      } else if (c >= 'A' && c <= 'F') {
+        value |= static_cast<uint32_t>(c - 'A' + 10);
+      } else {
+        fail("bad \\u escape");
+      }
+    }
+    return value;
+  }
+
+  uint32_t parse_code_point() {
+    const uint32_t high = parse_hex4();
+    if (high < 0xD800 || high > 0xDBFF) {
+      return high;
+    }
+    if (end_ - data_ < 6 || data_[0] != '\\' || data_[1] != 'u') {
+      fail("unpaired surrogate");
+    }
+    data_ += 2;
+    const uint32_t low = parse_hex4();
+    if (low < 0xDC00 || low > 0xDFFF) {
+      fail("unpaired surrogate");
+    }
+    return 0x10000 + ((high - 0xD800) << 10) + (low - 0xDC00);
+  }
+
+  static void append_utf8(std::string &text, uint32_t code) {
+    if (code < 0x80) {
+      text.push_back(static_cast<char>(code));
+    } else if (code < 0x800) {
+      text.push_back(static_cast<char>(0xC0 | (code >> 6)));
+      text.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+      text.push_back(static_cast<char>(0xE0 | (code >> 12)));
+      text.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+      text.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else {
+      text.push_back(static_cast<char>(0xF0 | (code >> 18)));
+      text.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+      text.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+      text.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+  }
+
+  void literal(const char *word) {
+    const std::size_t length = std::strlen(word);
+    if (static_cast<std::size_t>(end_ - data_) < length || std::memcmp(data_, word, length) != 0) {
+      fail("unexpected character");
+    }
+    data_ += length;
+  }
+
+  void skip_space() {
+    while (data_ != end_ && (*data_ == ' ' || *data_ == '\t' || *data_ == '\n' || *data_ == '\r')) {
+      ++data_;
+    }
+  }
+
+  bool consume(char c) {
+    skip_space();
+    if (data_ != end_ && *data_ == c) {
+      ++data_;
+      return true;
+    }
+    return false;
+  }
+
+  void expect(char c) {
+    if (!consume(c)) {
+      fail(std::string("expected '") + c + "'");
+    }
+  }
+
+  [[noreturn]] void fail(const std::string &what) {
+    malformed(path_, "safetensors header: " + what);
+  }
+
+  const std::string &path_;
+  const char *data_;
+  const char *end_;
+};
+
+DType safetensors_dtype(const std::string &path, const std::string &name,
+                        const std::string &dtype) {
+  if (dtype == "F32") return DType::f32;
+  if (dtype == "F64") return DType::f64;
+  if (dtype == "I32") return DType::i32;
+  if (dtype == "I64") return DType::i64;
+  throw std::runtime_error("unsupported safetensors dtype " + dtype + " for " + name + " in " +
+                           path);
+}
+
+int64_t json_integer(const std::string &path, const JsonValue *value, const std::string &what) {
+  if (value == nullptr || value->kind != JsonValue::Kind::number || !value->is_integer ||
+      value->integer < 0) {
+    malformed(path, what + " must be a non-negative integer");
+  }
+  return value->integer;
+}
+
+std::vector<NamedTensor> load_safetensors(const std::string &path, const MappedFile &mapping) {
+  Cursor cursor(path, mapping.bytes, mapping.size, 0);
+  const auto header_size = cursor.get<uint64_t>();
+  if (header_size > mapping.size - sizeof(uint64_t)) {
+    malformed(path, "not a tensor file or a safetensors file");
+  }
+  const auto *header = reinterpret_cast<const char *>(cursor.take(header_size));
+  const uint64_t data_start = cursor.position();
+  const JsonValue root =
+      JsonParser(path, header, static_cast<std::size_t>(header_size)).parse_document();
+  if (root.kind != JsonValue::Kind::object) {
+    malformed(path, "safetensors header is not an object");
+  }
+
+  std::vector<NamedTensor> tensors;
+  tensors.reserve(root.members.size());
+  for (const auto &[name, entry] : root.members) {
+    if (name == "__metadata__") {
+      continue;
+    }
+    const JsonValue *dtype = entry.find("dtype");
+    const JsonValue *shape = entry.find("shape");
+    const JsonValue *offsets = entry.find("data_offsets");
+    if (dtype == nullptr || dtype->kind != JsonValue::Kind::string || shape == nullptr ||
+        shape->kind != JsonValue::Kind::array || offsets == nullptr ||
+        offsets->kind != JsonValue::Kind::array || offsets->items.size() != 2 ||
+        shape->items.size() > kMaxRank) {
+      malformed(path, "bad safetensors entry for " + name);
+    }
+    Dims dims;
+    for (const JsonValue &size : shape->items) {
+      dims.push_back(json_integer(path, &size, "shape of " + name));
+    }
+    const auto begin = static_cast<uint64_t>(json_integer(path, &offsets->items[0], name));
+    const auto end = static_cast<uint64_t>(json_integer(path, &offsets->items[1], name));
+    if (end < begin || begin > mapping.size - data_start) {
+      malformed(path, "bad data_offsets for " + name);
+    }
+    const DType type = safetensors_dtype(path, name, dtype->text);
+    Dims stride = default_strides(dims);
+    DTensor tensor = mapped_tensor(path, mapping, name, data_start + begin, end - begin,
+                                   std::move(dims), std::move(stride), 0, type);
+    if (static_cast<uint64_t>(tensor.numel()) * dtype_size(type) != end - begin) {
+      malformed(path, "data_offsets of " + name + " do not match its shape");
+    }
+    tensors.push_back({name, std::move(tensor)});
+  }
+  return tensors;
+}
+
+} // namespace
+
+void save_tensors(const std::string &path, const std::vector<NamedTensor> &tensors) {
+  require_little_endian();
+  uint64_t header = sizeof(kMagic) + 4 + 4 + 8;
+  for (const auto &entry : tensors) {
+    if (!entry.tensor.defined()) {
+      throw std::invalid_argument("save_tensors cannot save undefined tensor " + entry.name);
+    }
+    if (entry.tensor.shape().size() > kMaxRank) {
+      throw std::invalid_argument("save_tensors supports up to 255 dims");
+    }
+    header += header_bytes(entry);
+  }
+
+  std::vector<Span> spans;
+  std::vector<uint64_t> positions;
+  spans.reserve(tensors.size());
+  positions.reserve(tensors.size());
+  uint64_t position = align_up(header, kPayloadAlignment);
+  const uint64_t payload_start = position;
+  for (const auto &entry : tensors) {
+    spans.push_back(span_of(entry.tensor));
+    positions.push_back(position);
+    const uint64_t bytes =
+        static_cast<uint64_t>(spans.back().count) * dtype_size(entry.tensor.dtype());
+    position = align_up(position + bytes, kPayloadAlignment);
+  }
+
+  Writer out(path);
+  out.bytes(kMagic, sizeof(kMagic));
+  out.put(kVersion);
+  out.put(static_cast<uint32_t>(tensors.size()));
+  out.put(payload_start);
+  for (std::size_t index = 0; index < tensors.size(); ++index) {
+    const NamedTensor &entry = tensors[index];
+    const DTensor &tensor = entry.tensor;
+    out.put(static_cast<uint32_t>(entry.name.size()));
+    out.bytes(entry.name.data(), entry.name.size());
+    out.put(static_cast<uint8_t>(tensor.dtype()));
+    out.put(static_cast<uint8_t>(tensor.rank()));
+    out.put(uint16_t{0});
+    for (const int64_t size : tensor.shape()) {
+      out.put(size);
+    }
+    for (const int64_t step : tensor.stride()) {
+      out.put(step);
+    }
+    out.put(int64_t{0});
+    out.put(positions[index]);
+    out.put(static_cast<uint64_t>(spans[index].count) * dtype_size(tensor.dtype()));
+  }
+  for (std::size_t index = 0; index < tensors.size(); ++index) {
+    const DTensor &tensor = tensors[index].tensor;
+    const std::size_t itemsize = dtype_size(tensor.dtype());
+    out.pad_to(positions[index]);
+    const auto *base = static_cast<const unsigned char *>(tensor.storage()->data());
+    out.bytes(base + static_cast<std::size_t>(spans[index].first) * itemsize,
+              static_cast<std::size_t>(spans[index].count) * itemsize);
+  }
+  out.commit();
+}
+
+std::vector<NamedTensor> load_tensors(const std::string &path) {
+  require_little_endian();
+  const MappedFile mapping = map_file(path);
+  if (mapping.size >= sizeof(kMagic) && std::memcmp(mapping.bytes, kMagic, sizeof(kMagic)) == 0) {
+    return load_tensor_file(path, mapping);
+  }
+  if (mapping.size < sizeof(uint64_t)) {
+    malformed(path, "not a tensor file or a safetensors file");
+  }
+  return load_safetensors(path, mapping);
+}
+
+void save_parameters(const std::string &path, const std::vector<DTensor *> &parameters) {
+  std::vector<NamedTensor> tensors;
+  tensors.reserve(parameters.size());
+  for (std::size_t index = 0; index < parameters.size(); ++index) {
+    if (parameters[index] == nullptr) {
+      throw std::invalid_argument("save_parameters got a null parameter");
+    }
+    tensors.push_back({std::to_string(index), *parameters[index]});
+  }
+  save_tensors(path, tensors);
+}
+
+void load_parameters(const std::string &path, const std::vector<DTensor *> &parameters) {
+  const std::vector<NamedTensor> tensors = load_tensors(path);
+  // Check every parameter before rebinding any, so a mismatch leaves them all
+  // untouched.
+  std::vector<const DTensor *> saved;
+  saved.reserve(parameters.size());
+  for (std::size_t index = 0; index < parameters.size(); ++index) {
+    const std::string name = std::to_string(index);
+    const auto found = std::find_if(tensors.begin(), tensors.end(),
+                                    [&](const NamedTensor &entry) { return entry.name == name; });
+    if (parameters[index] == nullptr || found == tensors.end()) {
+      throw std::invalid_argument("load_parameters found no tensor for parameter " + name);
+    }
+    if (found->tensor.dtype() != parameters[index]->dtype() ||
+        found->tensor.shape() != parameters[index]->shape()) {
+      throw std::invalid_argument("load_parameters: parameter " + name +
+                                  " does not match the saved shape or dtype");
+    }
+    saved.push_back(&found->tensor);
+  }
+  for (std::size_t index = 0; index < parameters.size(); ++index) {
+    const bool requires_grad = parameters[index]->requires_grad();
+    *parameters[index] = *saved[index];
+    parameters[index]->set_requires_grad(requires_grad);
+  }
+}
+
+} // namespace Tensor
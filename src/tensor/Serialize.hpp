@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Tensor.hpp"
+
+#include <string>
+#include <vector>
+
+namespace Tensor {
+
+struct NamedTensor {
+  std::string name;
+  DTensor tensor;
+};
+
+// Tensor files hold named tensors back to back:
+//
+//   "TNSRFILE" | u32 version | u32 count | u64 payload start
+//   per tensor: u32 name length | name | u8 dtype | u8 rank | u16 reserved |
+//               i64 shape[rank] | i64 stride[rank] | i64 offset |
+//               u64 payload position | u64 payload bytes
+//   payloads, each starting on a 64-byte boundary
+//
+// All integers are little-endian. A tensor's payload is the span of storage
+// its view covers, so views keep their strides and no element outside the
+// view is written. The file is written next to `path` under a temporary
+// name and then renamed over it, so saving over the file that tensors were
+// loaded from is safe.
+void save_tensors(const std::string &path, const std::vector<NamedTensor> &tensors);
+
+// Maps `path` into memory and returns tensors whose storage points straight
+// into the mapping, so loading costs the same whatever the file size; pages
+// are read on first touch. Each storage keeps the mapping alive. The mapping
+// is private: writes to the tensors never reach the file, and the file must
+// not be truncated while they are alive (save_tensors replaces it instead).
+//
+// Reads tensor files and safetensors files (F32, F64, I32 and I64 tensors);
+// safetensors payloads that are not aligned to their element size are copied.
+// Throws std::runtime_error if the file cannot be read or is malformed.
+std::vector<NamedTensor> load_tensors(const std::string &path);
+
+// Saves `parameters` (for example Linear::parameters()) under the names "0",
+// "1", ... in order.
+void save_parameters(const std::string &path, const std::vector<DTensor *> &parameters);
+
+// Rebinds each of `parameters` to the tensor saved under its index, keeping
+// its requires_grad flag and dropping any gradient. Shapes and dtypes must
+// match what was saved.
+void load_parameters(const std::string &path, const std::vector<DTensor *> &parameters);
+
+} // namespace Tensor
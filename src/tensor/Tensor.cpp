@@ -1,26 +1,28 @@
 #include "Tensor.hpp"
 
-#include <cstdlib>
-#include <new>
+#include <array>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
 #include <utility>
 
-#if defined(_WIN32)
-#include <malloc.h>
-#endif
+#include "tensor/Allocator.hpp"
+#include "tensor/Arena.hpp"
 
 namespace Tensor {
 
 namespace {
 
-void validate_shape_and_stride(const std::vector<int64_t> &shape,
-                               const std::vector<int64_t> &stride,
-                               int64_t offset) {
+// Returns the element count of a valid layout.
+int64_t validate_shape_and_stride(const Dims &shape, const Dims &stride, int64_t offset) {
   if (shape.size() != stride.size()) {
     throw std::invalid_argument("shape and stride rank mismatch");
   }
   if (offset < 0) {
     throw std::invalid_argument("tensor offset must be non-negative");
   }
+  int64_t numel = 1;
   for (std::size_t index = 0; index < shape.size(); ++index) {
     if (shape[index] < 0) {
       throw std::invalid_argument("tensor dimensions must be non-negative");
@@ -28,41 +30,88 @@ void validate_shape_and_stride(const std::vector<int64_t> &shape,
     if (stride[index] < 0) {
       throw std::invalid_argument("tensor strides must be non-negative");
     }
+    numel *= shape[index];
   }
+  return numel;
 }
 
-void *aligned_alloc_host(std::size_t alignment, std::size_t size) {
-#if defined(_WIN32)
-  return _aligned_malloc(size, alignment);
-#else
-  void *ptr = nullptr;
-  if (alignment < sizeof(void *)) {
-    alignment = sizeof(void *);
+// Nodes whose last owner went away while another node was being destroyed.
+// Draining them in a loop keeps the destructor stack one node deep.
+struct DeferredNodes {
+  std::vector<std::shared_ptr<AutogradNode>> nodes;
+  bool draining{false};
+  ~DeferredNodes();
+};
+
+thread_local bool t_deferred_nodes_destroyed = false;
+
+DeferredNodes::~DeferredNodes() {
+  t_deferred_nodes_destroyed = true;
+}
+
+void release_node(std::shared_ptr<AutogradNode> node) noexcept {
+  if (t_deferred_nodes_destroyed) {
+    return;
   }
-  if (posix_memalign(&ptr, alignment, size) == 0) {
-    return ptr;
+  thread_local DeferredNodes deferred;
+  deferred.nodes.push_back(std::move(node));
+  if (deferred.draining) {
+    return;
+  }
+  deferred.draining = true;
+  while (!deferred.nodes.empty()) {
+    std::shared_ptr<AutogradNode> next = std::move(deferred.nodes.back());
+    deferred.nodes.pop_back();
+    next.reset();
+  }
+  deferred.draining = false;
+}
+
+std::shared_ptr<void> allocate_storage_block(std::size_t bytes, std::size_t alignment) {
+  std::shared_ptr<void> block = allocate_step_block(bytes, alignment);
+  if (!block) {
+    block = allocate_host_block(bytes, alignment);
   }
-  return nullptr;
-#endif
+  return block;
+}
+
+// Guards the hand-over from a pending storage's producer to its block.
+std::mutex &storage_mutex(const Storage *storage) {
+  static std::array<std::mutex, 16> mutexes;
+  return mutexes[std::hash<const void *>{}(storage) % mutexes.size()];
+}
+
+// A fresh state starts out current with its storage's in-place history.
+void stamp_history_epoch(TensorAutogradState &state, const std::shared_ptr<Storage> &storage) {
+  state.history_epoch = storage ? storage->history_epoch() : 0;
 }
 
 } // namespace
 
-DTensor::DTensor(std::shared_ptr<Storage> storage, std::vector<int64_t> shape,
-                 std::vector<int64_t> stride, int64_t offset, DType dtype,
-                 bool is_contiguous, bool requires_grad,
+TensorAutogradState::~TensorAutogradState() {
+  if (grad_fn) {
+    release_node(std::move(grad_fn));
+  }
+}
+
+DTensor::DTensor(std::shared_ptr<Storage> storage, Dims shape, Dims stride, int64_t offset,
+                 DType dtype, bool is_contiguous, bool requires_grad,
                  std::shared_ptr<TensorAutogradState> autograd_state)
-    : storage_(std::move(storage)), shape_(std::move(shape)),
-      stride_(std::move(stride)), offset_(offset), dtype_(dtype),
-      is_contiguous_(is_contiguous),
-      autograd_state_(std::move(autograd_state)) {
-  validate_shape_and_stride(shape_, stride_, offset_);
+    : storage_(std::move(storage)), shape_(std::move(shape)), stride_(std::move(stride)),
+      offset_(offset), dtype_(dtype), autograd_state_(std::move(autograd_state)) {
+  numel_ = validate_shape_and_stride(shape_, stride_, offset_);
+  is_contiguous_ = is_contiguous || is_default_contiguous(shape_, stride_);
   if (!storage_) {
     throw std::invalid_argument("tensor storage must be valid");
   }
+  // Tensors outside autograd get their state lazily, from the setters below,
+  // so views and temporaries skip the allocation.
   if (!autograd_state_) {
-    autograd_state_ = std::make_shared<TensorAutogradState>();
-    autograd_state_->requires_grad = requires_grad;
+    if (requires_grad) {
+      autograd_state_ = make_arena_shared<TensorAutogradState>();
+      autograd_state_->requires_grad = true;
+      stamp_history_epoch(*autograd_state_, storage_);
+    }
   } else {
     autograd_state_->requires_grad = autograd_state_->requires_grad || requires_grad;
   }
@@ -75,6 +124,7 @@ bool DTensor::requires_grad() const noexcept {
 void DTensor::set_requires_grad(bool value) noexcept {
   if (!autograd_state_) {
     autograd_state_ = std::make_shared<TensorAutogradState>();
+    stamp_history_epoch(*autograd_state_, storage_);
   }
   autograd_state_->requires_grad = value;
   if (!value) {
@@ -95,6 +145,7 @@ std::shared_ptr<DTensor> DTensor::grad() const noexcept {
 void DTensor::set_grad(std::shared_ptr<DTensor> grad) noexcept {
   if (!autograd_state_) {
     autograd_state_ = std::make_shared<TensorAutogradState>();
+    stamp_history_epoch(*autograd_state_, storage_);
   }
   autograd_state_->grad = std::move(grad);
 }
@@ -112,12 +163,25 @@ std::shared_ptr<AutogradNode> DTensor::grad_fn() const noexcept {
 void DTensor::set_grad_fn(std::shared_ptr<AutogradNode> fn) noexcept {
   if (!autograd_state_) {
     autograd_state_ = std::make_shared<TensorAutogradState>();
+    stamp_history_epoch(*autograd_state_, storage_);
   }
   autograd_state_->grad_fn = std::move(fn);
   autograd_state_->is_leaf = autograd_state_->grad_fn == nullptr;
 }
 
-void *DTensor::data() noexcept {
+bool DTensor::history_is_current() const noexcept {
+  return !autograd_state_ || !storage_ ||
+         autograd_state_->history_epoch == storage_->history_epoch();
+}
+
+void require_current_history(const DTensor &tensor) {
+  if (!tensor.history_is_current()) {
+    throw std::runtime_error("autograd cannot record on a tensor that was modified in place "
+                             "through another handle; use the handle the in-place op updated");
+  }
+}
+
+void *DTensor::data() {
   if (!storage_) {
     return nullptr;
   }
@@ -125,7 +189,7 @@ void *DTensor::data() noexcept {
   return base + (offset_ * static_cast<int64_t>(dtype_size(dtype_)));
 }
 
-const void *DTensor::data() const noexcept {
+const void *DTensor::data() const {
   if (!storage_) {
     return nullptr;
   }
@@ -136,19 +200,32 @@ const void *DTensor::data() const noexcept {
 std::shared_ptr<Storage> make_host_storage(std::size_t bytes,
                                            std::size_t alignment) {
   const std::size_t alloc_bytes = bytes == 0 ? 1 : bytes;
-  void *raw = aligned_alloc_host(alignment, alloc_bytes);
-  if (!raw) {
-    throw std::bad_alloc{};
-  }
+  return make_arena_shared<Storage>(allocate_storage_block(alloc_bytes, alignment), alloc_bytes,
+                                    alignment);
+}
 
-#if defined(_WIN32)
-  auto deleter = [](void *ptr) { _aligned_free(ptr); };
-#else
-  auto deleter = [](void *ptr) { std::free(ptr); };
-#endif
+std::shared_ptr<StorageProducer> Storage::producer() const {
+  if (!pending()) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(storage_mutex(this));
+  return producer_;
+}
 
-  return std::make_shared<Storage>(std::shared_ptr<void>(raw, deleter), alloc_bytes,
-                                   alignment);
+// The producer runs outside the lock, since it may itself read pending
+// storages; if two threads race, the first result to arrive is kept.
+void *Storage::materialize() const {
+  if (std::shared_ptr<StorageProducer> pending_producer = producer()) {
+    std::shared_ptr<void> block = allocate_storage_block(bytes_, alignment_);
+    pending_producer->produce(block.get(), bytes_);
+    std::lock_guard<std::mutex> lock(storage_mutex(this));
+    if (pending_.load(std::memory_order_relaxed)) {
+      data_ = std::move(block);
+      producer_.reset();
+      pending_.store(false, std::memory_order_release);
+    }
+  }
+  return data_.get();
 }
 
 } // namespace Tensor
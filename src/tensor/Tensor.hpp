@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -8,6 +9,8 @@
 #include <type_traits>
 #include <vector>
 
+#include "tensor/Dims.hpp"
+
 namespace Tensor {
 
 enum class DType : uint8_t { f32, f64, i32, i64 };
@@ -16,22 +19,63 @@ class DTensor;
 struct AutogradNode;
 struct TensorAutogradState;
 
+// Whether the calling thread is inside an InferenceMode scope (Autograd.hpp).
+bool inference_mode_enabled() noexcept;
+
+// Computes a storage's contents the first time they are accessed. Lazy ops
+// give one to each deferred result instead of filling it.
+struct StorageProducer {
+  virtual ~StorageProducer() = default;
+  // Fills `bytes` bytes at `data`.
+  virtual void produce(void *data, std::size_t bytes) = 0;
+};
+
 class Storage {
 public:
   Storage() = default;
   Storage(std::shared_ptr<void> ptr, std::size_t bytes, std::size_t alignment)
       : data_(std::move(ptr)), bytes_(bytes), alignment_(alignment) {}
+  // A pending storage: the block is allocated and filled by `producer` on the
+  // first data() call, from whichever thread makes it.
+  Storage(std::shared_ptr<StorageProducer> producer, std::size_t bytes, std::size_t alignment)
+      : bytes_(bytes), alignment_(alignment), producer_(std::move(producer)), pending_(true) {}
 
-  bool valid() const noexcept { return static_cast<bool>(data_); }
-  void *data() noexcept { return data_.get(); }
-  const void *data() const noexcept { return data_.get(); }
+  bool valid() const noexcept { return static_cast<bool>(data_) || pending(); }
+  void *data() { return pending() ? materialize() : data_.get(); }
+  const void *data() const { return pending() ? materialize() : data_.get(); }
   std::size_t size_bytes() const noexcept { return bytes_; }
   std::size_t alignment() const noexcept { return alignment_; }
 
+  // Bumped by every in-place write. Autograd nodes compare it against the
+  // version recorded when they saved a tensor for backward.
+  uint64_t version() const noexcept { return version_; }
+  void bump_version() noexcept { ++version_; }
+
+  // Bumped when an in-place op records new autograd history for a tensor over
+  // this storage. Autograd states remember the epoch they were created in, so
+  // other handles to the storage, copies or views made before the write, can
+  // tell that their values are newer than their history.
+  uint64_t history_epoch() const noexcept { return history_epoch_; }
+  void bump_history_epoch() noexcept { ++history_epoch_; }
+
+  // Allocated inside InferenceMode. Autograd does not record on tensors over it.
+  bool is_inference() const noexcept { return inference_; }
+
+  bool pending() const noexcept { return pending_.load(std::memory_order_acquire); }
+  // The producer of a pending storage, or null once it has been materialized.
+  std::shared_ptr<StorageProducer> producer() const;
+
 private:
-  std::shared_ptr<void> data_{};
+  void *materialize() const;
+
+  mutable std::shared_ptr<void> data_{};
   std::size_t bytes_{0};
   std::size_t alignment_{64};
+  uint64_t version_{0};
+  uint64_t history_epoch_{0};
+  bool inference_{inference_mode_enabled()};
+  mutable std::shared_ptr<StorageProducer> producer_{};
+  mutable std::atomic<bool> pending_{false};
 };
 
 inline constexpr std::size_t dtype_size(DType dt) noexcept {
@@ -52,7 +96,7 @@ inline constexpr bool is_floating_dtype(DType dt) noexcept {
   return dt == DType::f32 || dt == DType::f64;
 }
 
-inline std::int64_t numel_from_shape(const std::vector<int64_t> &shape) {
+inline std::int64_t numel_from_shape(const Dims &shape) {
   std::int64_t total = 1;
   for (const auto dim : shape) {
     if (dim < 0) {
@@ -63,8 +107,8 @@ inline std::int64_t numel_from_shape(const std::vector<int64_t> &shape) {
   return total;
 }
 
-inline std::vector<int64_t> default_strides(const std::vector<int64_t> &shape) {
-  std::vector<int64_t> strides(shape.size(), 1);
+inline Dims default_strides(const Dims &shape) {
+  Dims strides(shape.size(), 1);
   int64_t running = 1;
   for (int index = static_cast<int>(shape.size()) - 1; index >= 0; --index) {
     strides[static_cast<std::size_t>(index)] = running;
@@ -73,38 +117,68 @@ inline std::vector<int64_t> default_strides(const std::vector<int64_t> &shape) {
   return strides;
 }
 
-inline bool is_default_contiguous(const std::vector<int64_t> &shape,
-                                  const std::vector<int64_t> &stride) {
-  return default_strides(shape) == stride;
+inline bool is_default_contiguous(const Dims &shape, const Dims &stride) {
+  if (shape.size() != stride.size()) {
+    return false;
+  }
+  int64_t running = 1;
+  for (std::size_t index = shape.size(); index-- > 0;) {
+    if (stride[index] != running) {
+      return false;
+    }
+    running *= shape[index];
+  }
+  return true;
 }
 
 std::shared_ptr<Storage> make_host_storage(std::size_t bytes,
                                            std::size_t alignment = 64);
 
 struct TensorAutogradState {
+  TensorAutogradState() = default;
+  TensorAutogradState(const TensorAutogradState &) = default;
+  TensorAutogradState &operator=(const TensorAutogradState &) = default;
+  // Releases grad_fn iteratively, so dropping a deep graph does not recurse
+  // once per layer.
+  ~TensorAutogradState();
+
   bool requires_grad{false};
   bool is_leaf{true};
   std::shared_ptr<DTensor> grad{};
   std::shared_ptr<AutogradNode> grad_fn{};
+  // The storage's history_epoch when this state was created.
+  uint64_t history_epoch{0};
 };
 
 class DTensor {
 public:
   DTensor() = default;
-  DTensor(std::shared_ptr<Storage> storage, std::vector<int64_t> shape,
-          std::vector<int64_t> stride, int64_t offset, DType dtype,
-          bool is_contiguous = false, bool requires_grad = false,
+  // Contiguity and numel are derived from the layout once, here; callers that
+  // already know the strides are the default ones may say so with
+  // `is_contiguous` to skip the check.
+  DTensor(std::shared_ptr<Storage> storage, Dims shape, Dims stride, int64_t offset,
+          DType dtype, bool is_contiguous = false, bool requires_grad = false,
           std::shared_ptr<TensorAutogradState> autograd_state = nullptr);
 
-  const std::vector<int64_t> &shape() const noexcept { return shape_; }
-  const std::vector<int64_t> &stride() const noexcept { return stride_; }
+  const Dims &shape() const noexcept { return shape_; }
+  const Dims &stride() const noexcept { return stride_; }
   int64_t offset() const noexcept { return offset_; }
   DType dtype() const noexcept { return dtype_; }
   bool is_contiguous() const noexcept { return is_contiguous_; }
   std::shared_ptr<Storage> storage() const noexcept { return storage_; }
   bool defined() const noexcept { return static_cast<bool>(storage_); }
   int32_t rank() const noexcept { return static_cast<int32_t>(shape_.size()); }
-  int64_t numel() const { return numel_from_shape(shape_); }
+  int64_t numel() const noexcept { return numel_; }
+  uint64_t version() const noexcept { return storage_ ? storage_->version() : 0; }
+  void bump_version() noexcept {
+    if (storage_) {
+      storage_->bump_version();
+    }
+  }
+
+  // Created inside InferenceMode. Unless it was made to require grad,
+  // autograd cannot record in-place ops on it.
+  bool is_inference() const noexcept { return storage_ && storage_->is_inference(); }
 
   bool requires_grad() const noexcept;
   void set_requires_grad(bool value) noexcept;
@@ -117,22 +191,48 @@ public:
   std::shared_ptr<TensorAutogradState> autograd_state() const noexcept {
     return autograd_state_;
   }
+  // False once an in-place op recorded through another handle to the storage
+  // has given the values a newer history than this handle's state holds.
+  bool history_is_current() const noexcept;
 
-  void *data() noexcept;
-  const void *data() const noexcept;
+  // Materializes a pending (lazy) storage first.
+  void *data();
+  const void *data() const;
 
 private:
   std::shared_ptr<Storage> storage_{};
-  std::vector<int64_t> shape_{};
-  std::vector<int64_t> stride_{};
+  Dims shape_{};
+  Dims stride_{};
+  int64_t numel_{1};
   int64_t offset_{0};
   DType dtype_{DType::f32};
   bool is_contiguous_{false};
   std::shared_ptr<TensorAutogradState> autograd_state_{};
 };
 
+// Where a node sends the gradient for one of its inputs: the input's autograd
+// state, without its storage, so recording an op does not keep the input's
+// values alive. Null or !requires_grad edges receive nothing.
+using AutogradEdge = std::shared_ptr<TensorAutogradState>;
+
+inline bool edge_requires_grad(const AutogradEdge &edge) noexcept {
+  return edge && edge->requires_grad;
+}
+
+// Throws unless `tensor`'s autograd history is current, so autograd never
+// records an op on values whose history it no longer has.
+void require_current_history(const DTensor &tensor);
+
+// One recorded op in the autograd graph. Its inputs are the edges it routes
+// gradients to: states with a grad_fn lead to further nodes, leaves that
+// require grad accumulate into TensorAutogradState::grad. Values needed by
+// backward are saved separately, in the smallest form that suffices.
 struct AutogradNode : std::enable_shared_from_this<AutogradNode> {
-  virtual void backward(const DTensor &upstream) = 0;
+  virtual std::size_t num_inputs() const noexcept = 0;
+  virtual const AutogradEdge &input(std::size_t index) const noexcept = 0;
+  // Called once with the summed gradient of the node's output. `grads` holds
+  // num_inputs() undefined tensors; entries left undefined contribute nothing.
+  virtual void backward(const DTensor &upstream, std::vector<DTensor> &grads) = 0;
   virtual ~AutogradNode() = default;
 };
 
@@ -159,15 +259,15 @@ public:
     }
   }
 
-  const std::vector<int64_t> &shape() const noexcept { return dt_.shape(); }
-  const std::vector<int64_t> &stride() const noexcept { return dt_.stride(); }
+  const Dims &shape() const noexcept { return dt_.shape(); }
+  const Dims &stride() const noexcept { return dt_.stride(); }
   int64_t offset() const noexcept { return dt_.offset(); }
   int32_t rank() const noexcept { return dt_.rank(); }
   int64_t numel() const { return dt_.numel(); }
   bool is_contiguous() const noexcept { return dt_.is_contiguous(); }
 
-  T *data() noexcept { return static_cast<T *>(dt_.data()); }
-  const T *data() const noexcept { return static_cast<const T *>(dt_.data()); }
+  T *data() { return static_cast<T *>(dt_.data()); }
+  const T *data() const { return static_cast<const T *>(dt_.data()); }
 
   DTensor &as_dtensor() & noexcept { return dt_; }
   const DTensor &as_dtensor() const & noexcept { return dt_; }
@@ -0,0 +1,167 @@
+#include "tensor/TensorIterator.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace Tensor {
+
+Dims broadcast_shapes(const Dims &lhs, const Dims &rhs) {
+  const std::size_t rank = std::max(lhs.size(), rhs.size());
+  Dims shape(rank, 1);
+  for (std::size_t index = 0; index < rank; ++index) {
+    const int64_t left = index < lhs.size() ? lhs[lhs.size() - 1 - index] : 1;
+    const int64_t right = index < rhs.size() ? rhs[rhs.size() - 1 - index] : 1;
+    if (left != right && left != 1 && right != 1) {
+      throw std::invalid_argument("shapes cannot be broadcast: size " + std::to_string(left) +
+                                  " vs " + std::to_string(right));
+    }
+    shape[rank - 1 - index] = left == 1 ? right : left;
+  }
+  return shape;
+}
+
+TensorIterator::TensorIterator(
+    DTensor &output, std::initializer_list<std::reference_wrapper<const DTensor>> inputs) {
+  std::vector<const DTensor *> operands{&output};
+  Dims full_shape = output.shape();
+  for (const DTensor &input : inputs) {
+    if (input.dtype() != output.dtype()) {
+      throw std::invalid_argument("TensorIterator operands must share a dtype");
+    }
+    operands.push_back(&input);
+    full_shape = broadcast_shapes(full_shape, input.shape());
+  }
+  // Inputs may add leading dims of size 1, but must not expand the output.
+  if (numel_from_shape(full_shape) != output.numel()) {
+    throw std::invalid_argument("TensorIterator inputs must broadcast to the output shape");
+  }
+
+  element_size_ = dtype_size(output.dtype());
+  numel_ = numel_from_shape(full_shape);
+  const int args = static_cast<int>(operands.size());
+  const int rank = static_cast<int>(full_shape.size());
+
+  // Natural order (outermost first); reorder_dimensions flips it.
+  shape_ = full_shape;
+  strides_.assign(static_cast<std::size_t>(rank * args), 0);
+  data_.reserve(operands.size());
+  for (int arg = 0; arg < args; ++arg) {
+    const DTensor &operand = *operands[static_cast<std::size_t>(arg)];
+    data_.push_back(static_cast<char *>(const_cast<void *>(operand.data())));
+    const int leading = rank - operand.rank();
+    for (int dim = 0; dim < operand.rank(); ++dim) {
+      const int64_t size = operand.shape()[static_cast<std::size_t>(dim)];
+      if (size == 1 && full_shape[static_cast<std::size_t>(dim + leading)] != 1) {
+        continue;
+      }
+      strides_[static_cast<std::size_t>((dim + leading) * args + arg)] =
+          operand.stride()[static_cast<std::size_t>(dim)] *
+          static_cast<int64_t>(element_size_);
+    }
+  }
+
+  reorder_dimensions();
+  coalesce_dimensions();
+}
+
+void TensorIterator::reorder_dimensions() {
+  const int dims = ndim();
+  const int args = ntensors();
+  // perm[0] is the innermost dim. Start from the natural row-major order and
+  // insertion-sort by stride, ignoring broadcast (stride 0) entries.
+  std::vector<int> perm(static_cast<std::size_t>(dims));
+  for (int index = 0; index < dims; ++index) {
+    perm[static_cast<std::size_t>(index)] = dims - 1 - index;
+  }
+  const auto natural_stride = [&](int arg, int dim) {
+    return strides_[static_cast<std::size_t>(dim * args + arg)];
+  };
+  const auto should_swap = [&](int inner, int outer) {
+    for (int arg = 0; arg < args; ++arg) {
+      const int64_t inner_stride = natural_stride(arg, inner);
+      const int64_t outer_stride = natural_stride(arg, outer);
+      if (inner_stride == 0 || outer_stride == 0) {
+        continue;
+      }
+      if (inner_stride != outer_stride) {
+        return inner_stride > outer_stride ? 1 : -1;
+      }
+    }
+    return 0;
+  };
+  for (int index = 1; index < dims; ++index) {
+    int outer = index;
+    for (int inner = index - 1; inner >= 0; --inner) {
+      const int comparison = should_swap(perm[static_cast<std::size_t>(inner)],
+                                         perm[static_cast<std::size_t>(outer)]);
+      if (comparison > 0) {
+        std::swap(perm[static_cast<std::size_t>(inner)], perm[static_cast<std::size_t>(outer)]);
+        outer = inner;
+      } else if (comparison < 0) {
+        break;
+      }
+    }
+  }
+
+  Dims shape(static_cast<std::size_t>(dims));
+  Dims strides(strides_.size());
+  for (int dim = 0; dim < dims; ++dim) {
+    const int source = perm[static_cast<std::size_t>(dim)];
+    shape[static_cast<std::size_t>(dim)] = shape_[static_cast<std::size_t>(source)];
+    for (int arg = 0; arg < args; ++arg) {
+      strides[static_cast<std::size_t>(dim * args + arg)] = natural_stride(arg, source);
+    }
+  }
+  shape_ = std::move(shape);
+  strides_ = std::move(strides);
+}
+
+void TensorIterator::coalesce_dimensions() {
+  const int args = ntensors();
+  Dims shape;
+  Dims strides;
+  for (int dim = 0; dim < ndim(); ++dim) {
+    const int64_t size = shape_[static_cast<std::size_t>(dim)];
+    if (size == 1) {
+      continue;
+    }
+    if (!shape.empty()) {
+      const int64_t previous_size = shape.back();
+      const std::size_t previous = strides.size() - static_cast<std::size_t>(args);
+      bool mergeable = true;
+      for (int arg = 0; arg < args && mergeable; ++arg) {
+        mergeable = stride(arg, dim) ==
+                    previous_size * strides[previous + static_cast<std::size_t>(arg)];
+      }
+      if (mergeable) {
+        shape.back() *= size;
+        continue;
+      }
+    }
+    shape.push_back(size);
+    for (int arg = 0; arg < args; ++arg) {
+      strides.push_back(stride(arg, dim));
+    }
+  }
+  if (shape.empty()) {
+    shape.push_back(numel_ == 0 ? 0 : 1);
+    strides.assign(static_cast<std::size_t>(args), 0);
+  }
+  shape_ = std::move(shape);
+  strides_ = std::move(strides);
+}
+
+bool TensorIterator::is_contiguous() const noexcept {
+  if (ndim() != 1) {
+    return false;
+  }
+  for (int arg = 0; arg < ntensors(); ++arg) {
+    if (stride(arg, 0) != static_cast<int64_t>(element_size_) && shape_[0] > 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace Tensor
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "tensor/Parallel.hpp"
+#include "tensor/Tensor.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+namespace Tensor {
+
+// NumPy broadcast of two shapes; throws std::invalid_argument when they clash.
+Dims broadcast_shapes(const Dims &lhs, const Dims &rhs);
+
+// N-d loop plan over one output and any number of inputs of the same dtype.
+// The iteration shape is the broadcast of every operand shape, which must not
+// expand the output; broadcast input dims get stride 0.
+//
+// Dims are reordered so the innermost one has the smallest strides, then
+// adjacent dims that are contiguous for every operand are merged. A dense
+// elementwise op over contiguous tensors therefore becomes a single 1-D loop.
+// Loop bodies are called as loop(data, strides, n): data[arg] points at the
+// first element of operand `arg` (0 is the output) and strides[arg] is its
+// byte stride along the n-element inner run.
+class TensorIterator {
+public:
+  TensorIterator(DTensor &output, std::initializer_list<std::reference_wrapper<const DTensor>> inputs);
+
+  int ndim() const noexcept { return static_cast<int>(shape_.size()); }
+  int ntensors() const noexcept { return static_cast<int>(data_.size()); }
+  // Innermost dim first.
+  const Dims &shape() const noexcept { return shape_; }
+  int64_t numel() const noexcept { return numel_; }
+  std::size_t element_size() const noexcept { return element_size_; }
+
+  char *data(int arg) const noexcept { return data_[static_cast<std::size_t>(arg)]; }
+  int64_t stride(int arg, int dim) const noexcept {
+    return strides_[static_cast<std::size_t>(dim * ntensors() + arg)];
+  }
+
+  // Every operand is one dense run, so the flat kernels apply directly.
+  bool is_contiguous() const noexcept;
+
+  // Runs loop over the linear element range [begin, end) in iteration order.
+  template <typename Loop>
+  void serial_for_each(const Loop &loop, int64_t begin, int64_t end) const;
+
+  // Splits the linear range across the intra-op pool.
+  template <typename Loop>
+  void for_each(const Loop &loop, int64_t grain = kDefaultGrainSize) const;
+
+private:
+  void reorder_dimensions();
+  void coalesce_dimensions();
+
+  Dims shape_;
+  // Byte strides, indexed [dim * ntensors + arg].
+  Dims strides_;
+  std::vector<char *> data_;
+  int64_t numel_{0};
+  std::size_t element_size_{0};
+};
+
+template <typename Loop>
+void TensorIterator::serial_for_each(const Loop &loop, int64_t begin, int64_t end) const {
+  if (begin >= end) {
+    return;
+  }
+  const int dims = ndim();
+  const int args = ntensors();
+  Dims counter(static_cast<std::size_t>(dims), 0);
+  std::vector<char *> ptrs(data_);
+  int64_t linear = begin;
+  for (int dim = 0; dim < dims; ++dim) {
+    const int64_t size = shape_[static_cast<std::size_t>(dim)];
+    counter[static_cast<std::size_t>(dim)] = linear % size;
+    linear /= size;
+    for (int arg = 0; arg < args; ++arg) {
+      ptrs[static_cast<std::size_t>(arg)] += counter[static_cast<std::size_t>(dim)] * stride(arg, dim);
+    }
+  }
+
+  const int64_t *inner_strides = strides_.data();
+  const int64_t inner_size = shape_[0];
+  while (begin < end) {
+    const int64_t run = std::min(inner_size - counter[0], end - begin);
+    loop(ptrs.data(), inner_strides, run);
+    begin += run;
+    if (begin >= end) {
+      break;
+    }
+
+    counter[0] += run;
+    for (int arg = 0; arg < args; ++arg) {
+      ptrs[static_cast<std::size_t>(arg)] += run * stride(arg, 0);
+    }
+    for (int dim = 0; dim + 1 < dims && counter[static_cast<std::size_t>(dim)] ==
+                                            shape_[static_cast<std::size_t>(dim)];
+         ++dim) {
+      const int64_t size = shape_[static_cast<std::size_t>(dim)];
+      counter[static_cast<std::size_t>(dim)] = 0;
+      ++counter[static_cast<std::size_t>(dim + 1)];
+      for (int arg = 0; arg < args; ++arg) {
+        ptrs[static_cast<std::size_t>(arg)] += stride(arg, dim + 1) - size * stride(arg, dim);
+      }
+    }
+  }
+}
+
+template <typename Loop>
+void TensorIterator::for_each(const Loop &loop, int64_t grain) const {
+  if (numel_ == 0) {
+    return;
+  }
+  parallel_for(0, numel_, grain, [&](int64_t begin, int64_t end) {
+    serial_for_each(loop, begin, end);
+  });
+}
+
+} // namespace Tensor
@@ -0,0 +1,309 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace Tensor::simd {
+
+// Register width of the build target. Builds with TENSOR_ENABLE_NATIVE_ARCH
+// (or any -mavx / -mavx512f flags) widen every Vec automatically; the 16-byte
+// baseline maps onto SSE2 and NEON.
+#if defined(__AVX512F__)
+inline constexpr std::size_t kVectorBytes = 64;
+#elif defined(__AVX__)
+inline constexpr std::size_t kVectorBytes = 32;
+#else
+inline constexpr std::size_t kVectorBytes = 16;
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TENSOR_VECTOR_EXTENSIONS 1
+#else
+#define TENSOR_VECTOR_EXTENSIONS 0
+#endif
+
+template <typename T>
+using MaskBits = std::conditional_t<sizeof(T) == 4, int32_t, int64_t>;
+
+template <typename T> class VecMask;
+
+// Fixed-width SIMD value. Arithmetic, comparisons and selects are lane-wise, so
+// a functor written against `auto` arguments compiles for both T and Vec<T>.
+template <typename T> class Vec {
+  static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Vec supports 32- and 64-bit lanes");
+
+public:
+  static constexpr int64_t size = static_cast<int64_t>(kVectorBytes / sizeof(T));
+#if TENSOR_VECTOR_EXTENSIONS
+  typedef T Native __attribute__((vector_size(kVectorBytes)));
+#else
+  struct Native {
+    T lanes[size];
+    T &operator[](int64_t index) { return lanes[index]; }
+    const T &operator[](int64_t index) const { return lanes[index]; }
+  };
+#endif
+
+  Vec() = default;
+  Vec(T scalar) { // NOLINT: implicit broadcast keeps functors dtype-generic
+#if TENSOR_VECTOR_EXTENSIONS
+    value = Native{} + scalar;
+#else
+    for (int64_t lane = 0; lane < size; ++lane) {
+      value[lane] = scalar;
+    }
+#endif
+  }
+  static Vec wrap(Native native) {
+    Vec result;
+    result.value = native;
+    return result;
+  }
+
+  static Vec load(const T *ptr) {
+    Vec result;
+    std::memcpy(&result.value, ptr, sizeof(Native));
+    return result;
+  }
+
+  // Loads `count` (< size) lanes and zero-fills the rest without touching
+  // memory past ptr + count.
+  static Vec load_partial(const T *ptr, int64_t count) {
+#if defined(__AVX512F__)
+    if constexpr (std::is_same_v<T, float>) {
+      return wrap(_mm512_maskz_loadu_ps(mask16(count), ptr));
+    } else if constexpr (std::is_same_v<T, double>) {
+      return wrap(_mm512_maskz_loadu_pd(mask8(count), ptr));
+    } else if constexpr (sizeof(T) == 4) {
+      return wrap(reinterpret_cast<Native>(_mm512_maskz_loadu_epi32(mask16(count), ptr)));
+    } else {
+      return wrap(reinterpret_cast<Native>(_mm512_maskz_loadu_epi64(mask8(count), ptr)));
+    }
+#elif defined(__AVX2__)
+    if constexpr (std::is_same_v<T, float>) {
+      return wrap(_mm256_maskload_ps(ptr, tail_mask(count)));
+    } else if constexpr (std::is_same_v<T, double>) {
+      return wrap(_mm256_maskload_pd(ptr, tail_mask(count)));
+    } else if constexpr (sizeof(T) == 4) {
+      return wrap(reinterpret_cast<Native>(
+          _mm256_maskload_epi32(reinterpret_cast<const int *>(ptr), tail_mask(count))));
+    } else {
+      return wrap(reinterpret_cast<Native>(
+          _mm256_maskload_epi64(reinterpret_cast<const long long *>(ptr), tail_mask(count))));
+    }
+#else
+    Vec result(T{});
+    std::memcpy(&result.value, ptr, static_cast<std::size_t>(count) * sizeof(T));
+    return result;
+#endif
+  }
+
+  void store(T *ptr) const { std::memcpy(ptr, &value, sizeof(Native)); }
+
+  void store_partial(T *ptr, int64_t count) const {
+#if defined(__AVX512F__)
+    if constexpr (std::is_same_v<T, float>) {
+      _mm512_mask_storeu_ps(ptr, mask16(count), value);
+    } else if constexpr (std::is_same_v<T, double>) {
+      _mm512_mask_storeu_pd(ptr, mask8(count), value);
+    } else if constexpr (sizeof(T) == 4) {
+      _mm512_mask_storeu_epi32(ptr, mask16(count), reinterpret_cast<__m512i>(value));
+    } else {
+      _mm512_mask_storeu_epi64(ptr, mask8(count), reinterpret_cast<__m512i>(value));
+    }
+#elif defined(__AVX2__)
+    if constexpr (std::is_same_v<T, float>) {
+      _mm256_maskstore_ps(ptr, tail_mask(count), value);
+    } else if constexpr (std::is_same_v<T, double>) {
+      _mm256_maskstore_pd(ptr, tail_mask(count), value);
+    } else if constexpr (sizeof(T) == 4) {
+      _mm256_maskstore_epi32(reinterpret_cast<int *>(ptr), tail_mask(count),
+                             reinterpret_cast<__m256i>(value));
+    } else {
+      _mm256_maskstore_epi64(reinterpret_cast<long long *>(ptr), tail_mask(count),
+                             reinterpret_cast<__m256i>(value));
+    }
+#else
+    std::memcpy(ptr, &value, static_cast<std::size_t>(count) * sizeof(T));
+#endif
+  }
+
+  T operator[](int64_t lane) const { return value[lane]; }
+
+  friend Vec operator+(const Vec &a, const Vec &b) { return a.zip(b, Add{}); }
+  friend Vec operator-(const Vec &a, const Vec &b) { return a.zip(b, Sub{}); }
+  friend Vec operator*(const Vec &a, const Vec &b) { return a.zip(b, Mul{}); }
+  friend Vec operator/(const Vec &a, const Vec &b) { return a.zip(b, Div{}); }
+  friend Vec operator-(const Vec &a) { return Vec(T{}) - a; }
+
+  friend VecMask<T> operator<(const Vec &a, const Vec &b) { return compare(a, b, Lt{}); }
+  friend VecMask<T> operator>(const Vec &a, const Vec &b) { return compare(b, a, Lt{}); }
+  friend VecMask<T> operator<=(const Vec &a, const Vec &b) { return compare(a, b, Le{}); }
+  friend VecMask<T> operator>=(const Vec &a, const Vec &b) { return compare(b, a, Le{}); }
+
+  Native value;
+
+private:
+  struct Add { template <typename U> U operator()(U a, U b) const { return a + b; } };
+  struct Sub { template <typename U> U operator()(U a, U b) const { return a - b; } };
+  struct Mul { template <typename U> U operator()(U a, U b) const { return a * b; } };
+  struct Div { template <typename U> U operator()(U a, U b) const { return a / b; } };
+  struct Lt { template <typename U> auto operator()(U a, U b) const { return a < b; } };
+  struct Le { template <typename U> auto operator()(U a, U b) const { return a <= b; } };
+
+#if defined(__AVX512F__)
+  static __mmask16 mask16(int64_t count) { return static_cast<__mmask16>((1u << count) - 1u); }
+  static __mmask8 mask8(int64_t count) { return static_cast<__mmask8>((1u << count) - 1u); }
+#elif defined(__AVX2__)
+  // Lanes below `count` have their sign bit set, as maskload/maskstore expect.
+  static __m256i tail_mask(int64_t count) {
+    if constexpr (sizeof(T) == 4) {
+      const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+      return _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(count)), lanes);
+    } else {
+      const __m256i lanes = _mm256_setr_epi64x(0, 1, 2, 3);
+      return _mm256_cmpgt_epi64(_mm256_set1_epi64x(count), lanes);
+    }
+  }
+#endif
+
+  template <typename Op> Vec zip(const Vec &other, Op op) const {
+#if TENSOR_VECTOR_EXTENSIONS
+    return wrap(op(value, other.value));
+#else
+    Vec result;
+    for (int64_t lane = 0; lane < size; ++lane) {
+      result.value[lane] = op(value[lane], other.value[lane]);
+    }
+    return result;
+#endif
+  }
+
+  template <typename Op> static VecMask<T> compare(const Vec &a, const Vec &b, Op op);
+};
+
+// Lane-wise predicate produced by Vec comparisons: all-ones or all-zeros lanes.
+template <typename T> class VecMask {
+public:
+  using Bits = MaskBits<T>;
+#if TENSOR_VECTOR_EXTENSIONS
+  typedef Bits Native __attribute__((vector_size(kVectorBytes)));
+#else
+  struct Native {
+    Bits lanes[Vec<T>::size];
+    Bits &operator[](int64_t index) { return lanes[index]; }
+    const Bits &operator[](int64_t index) const { return lanes[index]; }
+  };
+#endif
+
+  static VecMask wrap(Native native) {
+    VecMask result;
+    result.value = native;
+    return result;
+  }
+
+  friend VecMask operator&(const VecMask &a, const VecMask &b) {
+    return a.zip(b, [](auto x, auto y) { return x & y; });
+  }
+  friend VecMask operator|(const VecMask &a, const VecMask &b) {
+    return a.zip(b, [](auto x, auto y) { return x | y; });
+  }
+
+  Native value;
+
+private:
+  template <typename Op> VecMask zip(const VecMask &other, Op op) const {
+#if TENSOR_VECTOR_EXTENSIONS
+    return wrap(op(value, other.value));
+#else
+    VecMask result;
+    for (int64_t lane = 0; lane < Vec<T>::size; ++lane) {
+      result.value[lane] = op(value[lane], other.value[lane]);
+    }
+    return result;
+#endif
+  }
+};
+
+template <typename T>
+template <typename Op>
+VecMask<T> Vec<T>::compare(const Vec &a, const Vec &b, Op op) {
+#if TENSOR_VECTOR_EXTENSIONS
+  return VecMask<T>::wrap(reinterpret_cast<typename VecMask<T>::Native>(op(a.value, b.value)));
+#else
+  VecMask<T> result;
+  for (int64_t lane = 0; lane < size; ++lane) {
+    result.value[lane] = op(a.value[lane], b.value[lane]) ? MaskBits<T>{-1} : MaskBits<T>{0};
+  }
+  return result;
+#endif
+}
+
+template <typename T> Vec<T> select(const VecMask<T> &mask, const Vec<T> &a, const Vec<T> &b) {
+#if TENSOR_VECTOR_EXTENSIONS
+  using Bits = typename VecMask<T>::Native;
+  const Bits picked = (mask.value & reinterpret_cast<Bits>(a.value)) |
+                      (~mask.value & reinterpret_cast<Bits>(b.value));
+  return Vec<T>::wrap(reinterpret_cast<typename Vec<T>::Native>(picked));
+#else
+  Vec<T> result;
+  for (int64_t lane = 0; lane < Vec<T>::size; ++lane) {
+    result.value[lane] = mask.value[lane] ? a.value[lane] : b.value[lane];
+  }
+  return result;
+#endif
+}
+
+// Scalar overloads so the same functor body serves vector lanes and tails.
+template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+T select(bool mask, T a, T b) {
+  return mask ? a : b;
+}
+
+// maximum/minimum/clamp mirror std::max/std::min/std::clamp, including which
+// operand wins when a comparison involves NaN.
+template <typename V> V maximum(const V &a, const V &b) {
+  return select(a < b, b, a);
+}
+
+template <typename V> V minimum(const V &a, const V &b) {
+  return select(b < a, b, a);
+}
+
+template <typename V> V clamp(const V &value, const V &lo, const V &hi) {
+  return select(value < lo, lo, select(hi < value, hi, value));
+}
+
+// Lane-wise square root of floating-point lanes, correctly rounded like
+// std::sqrt.
+template <typename T> Vec<T> sqrt(const Vec<T> &a) {
+  static_assert(std::is_floating_point_v<T>, "sqrt needs floating-point lanes");
+#if defined(__AVX512F__)
+  if constexpr (std::is_same_v<T, float>) {
+    return Vec<T>::wrap(_mm512_sqrt_ps(a.value));
+  } else {
+    return Vec<T>::wrap(_mm512_sqrt_pd(a.value));
+  }
+#elif defined(__AVX2__)
+  if constexpr (std::is_same_v<T, float>) {
+    return Vec<T>::wrap(_mm256_sqrt_ps(a.value));
+  } else {
+    return Vec<T>::wrap(_mm256_sqrt_pd(a.value));
+  }
+#else
+  Vec<T> result;
+  for (int64_t lane = 0; lane < Vec<T>::size; ++lane) {
+    result.value[lane] = std::sqrt(a.value[lane]);
+  }
+  return result;
+#endif
+}
+
+} // namespace Tensor::simd
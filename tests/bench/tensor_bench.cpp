@@ -1,8 +1,25 @@
+#include <algorithm>
 #include <benchmark/benchmark.h>
+#include <chrono>
 #include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
 #include "api/Api.hpp"
+#include "tensor/Allocator.hpp"
+#include "tensor/Autograd.hpp"
+#include "tensor/Batching.hpp"
+#include "tensor/DataLoader.hpp"
+#include "tensor/Lazy.hpp"
 #include "tensor/Linear.hpp"
 #include "tensor/Ops.hpp"
+#include "tensor/Optim.hpp"
+#include "tensor/Parallel.hpp"
+#include "tensor/Serialize.hpp"
 
 // Avoid broad using-directives to prevent symbol ambiguity on MSVC
 
@@ -50,24 +67,501 @@ static void BM_Matmul(benchmark::State& state) {
         benchmark::DoNotOptimize(out.data());
     }
     state.SetItemsProcessed(state.iterations() * m * k * n);
+    state.counters["GFLOP"] = benchmark::Counter(
+        2.0 * static_cast<double>(m * k * n) * 1.0e-9,
+        benchmark::Counter::kIsIterationInvariantRate);
 }
-BENCHMARK(BM_Matmul)->Args({128, 256, 64})->Args({1, 768, 256});
+BENCHMARK(BM_Matmul)
+    ->Args({128, 256, 64})
+    ->Args({1, 768, 256})
+    ->Args({256, 256, 256})
+    ->Args({512, 512, 512})
+    ->Args({1024, 1024, 1024});
 
+static void BM_MatmulBackward(benchmark::State& state) {
+    const int64_t m = state.range(0);
+    const int64_t k = state.range(1);
+    const int64_t n = state.range(2);
+    auto lhs = ::Tensor::api::zeros<float>({m, k}, true);
+    auto rhs = ::Tensor::api::zeros<float>({k, n}, true);
+    ::Tensor::ops::fill(lhs.as_dtensor(), 1.0f);
+    ::Tensor::ops::fill(rhs.as_dtensor(), 1.0f);
+
+    for (auto _ : state) {
+        lhs.zero_grad();
+        rhs.zero_grad();
+        auto loss = ::Tensor::ops::sum(::Tensor::ops::matmul(lhs.as_dtensor(), rhs.as_dtensor()));
+        ::Tensor::ops::backward(loss);
+        benchmark::DoNotOptimize(lhs.grad()->data());
+    }
+    // Forward plus the two backward products.
+    state.counters["GFLOP"] = benchmark::Counter(
+        6.0 * static_cast<double>(m * k * n) * 1.0e-9,
+        benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_MatmulBackward)->Args({128, 256, 64})->Args({256, 512, 256});
+
+// Per-call cost of a Linear forward. The last argument picks how much autograd
+// bookkeeping runs: 0 = recording, 1 = NoGradGuard, 2 = InferenceMode.
 static void BM_LinearForward(benchmark::State& state) {
     const int64_t batch = state.range(0);
     const int64_t in_features = state.range(1);
     const int64_t out_features = state.range(2);
+    const int64_t mode = state.range(3);
     ::Tensor::nn::Linear linear(in_features, out_features);
     auto input = ::Tensor::api::zeros<float>({batch, in_features});
     ::Tensor::ops::fill(input.as_dtensor(), 1.0f);
 
+    std::optional<::Tensor::NoGradGuard> no_grad;
+    std::optional<::Tensor::InferenceMode> inference;
+    if (mode == 1) {
+        no_grad.emplace();
+    } else if (mode == 2) {
+        inference.emplace();
+    }
     for (auto _ : state) {
         auto out = linear.forward(input.as_dtensor());
         benchmark::DoNotOptimize(out.data());
     }
     state.SetItemsProcessed(state.iterations() * batch * in_features * out_features);
 }
-BENCHMARK(BM_LinearForward)->Args({1, 768, 256})->Args({1, 256, 32});
+BENCHMARK(BM_LinearForward)->ArgsProduct({{1}, {768}, {256}, {0, 1, 2}})
+    ->ArgsProduct({{1}, {256}, {32}, {0, 1, 2}})
+    ->ArgsProduct({{1}, {16}, {16}, {0, 1, 2}});
+
+// Single-row {1, 768} -> 256 requests from concurrent clients, each waiting for
+// its result before sending the next. Mode 0 runs every request as its own
+// forward; mode 1 sends them through a shared LinearBatcher with the given
+// max_delay in microseconds and max_batch_size. Latency percentiles are per
+// request.
+static std::unique_ptr<::Tensor::nn::LinearBatcher> g_serving_batcher;
+
+static void BM_ServeLinearRows(benchmark::State& state) {
+    static ::Tensor::nn::Linear linear(768, 256);
+    const bool batched = state.range(0) != 0;
+    if (batched && state.thread_index() == 0) {
+        g_serving_batcher = std::make_unique<::Tensor::nn::LinearBatcher>(
+            linear, ::Tensor::nn::BatchingOptions{state.range(2),
+                                                  std::chrono::microseconds(state.range(1))});
+    }
+    ::Tensor::InferenceMode inference;
+    auto row = ::Tensor::api::zeros<float>({1, 768});
+    ::Tensor::ops::fill(row.as_dtensor(), 1.0f);
+    std::vector<double> latencies;
+
+    for (auto _ : state) {
+        const auto start = std::chrono::steady_clock::now();
+        auto out = batched ? g_serving_batcher->submit(row.as_dtensor()).get()
+                           : linear.forward(row.as_dtensor());
+        benchmark::DoNotOptimize(out.data());
+        latencies.push_back(
+            std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+                .count());
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&](double p) {
+        return latencies.empty() ? 0.0
+                                 : latencies[static_cast<std::size_t>(
+                                       p * static_cast<double>(latencies.size() - 1))];
+    };
+    state.counters["p50_us"] =
+        benchmark::Counter(percentile(0.5), benchmark::Counter::kAvgThreads);
+    state.counters["p99_us"] =
+        benchmark::Counter(percentile(0.99), benchmark::Counter::kAvgThreads);
+    state.SetItemsProcessed(state.iterations());
+    if (batched && state.thread_index() == 0) {
+        const auto stats = g_serving_batcher->stats();
+        const auto batches = std::max<uint64_t>(stats.batches, 1);
+        state.counters["rows_per_batch"] =
+            static_cast<double>(stats.rows) / static_cast<double>(batches);
+        g_serving_batcher.reset();
+    }
+}
+BENCHMARK(BM_ServeLinearRows)->Args({0, 0, 1})->Args({1, 50, 64})->Args({1, 500, 64})
+    ->Args({1, 500, 8})->ThreadRange(1, 16)->UseRealTime();
+
+// Cold-start cost of load_tensors for a file holding 16 parameters with the
+// given total size in MiB. Loading maps the file, so it should not grow with
+// the size.
+static void BM_LoadTensors(benchmark::State& state) {
+    const int64_t per_tensor = state.range(0) * (int64_t{1} << 20) / 16 / 4;
+    const auto path = std::filesystem::temp_directory_path() / "tensor_bench_load.tnsr";
+    std::vector<::Tensor::NamedTensor> tensors;
+    for (int index = 0; index < 16; ++index) {
+        tensors.push_back({"p" + std::to_string(index),
+                           ::Tensor::api::zeros({per_tensor}, ::Tensor::DType::f32)});
+    }
+    ::Tensor::save_tensors(path.string(), tensors);
+    for (auto _ : state) {
+        auto loaded = ::Tensor::load_tensors(path.string());
+        benchmark::DoNotOptimize(loaded.data());
+    }
+    std::filesystem::remove(path);
+}
+BENCHMARK(BM_LoadTensors)->Arg(1)->Arg(64)->Arg(512);
+
+// Linear training steps fed from 32 MiB of shards, with batches assembled on
+// the stepping thread (0) or ahead of it by one background worker (1).
+static void BM_DataLoaderStep(benchmark::State& state) {
+    constexpr int64_t kFeatures = 512;
+    constexpr int64_t kBatch = 256;
+    std::vector<std::string> shards;
+    const std::vector<float> row(kFeatures, 0.25f);
+    for (int index = 0; index < 4; ++index) {
+        shards.push_back((std::filesystem::temp_directory_path() /
+                          ("tensor_bench_shard_" + std::to_string(index)))
+                             .string());
+        std::ofstream out(shards.back(), std::ios::binary);
+        for (int64_t written = 0; written < 4096; ++written) {
+            out.write(reinterpret_cast<const char*>(row.data()),
+                      static_cast<std::streamsize>(row.size() * sizeof(float)));
+        }
+    }
+    ::Tensor::DataLoader loader(shards, kFeatures,
+                                {.batch_size = kBatch,
+                                 .num_workers = static_cast<int>(state.range(0))});
+    ::Tensor::nn::Linear linear(kFeatures, 256);
+    ::Tensor::nn::SGD optimizer(0.001f);
+    auto parameters = linear.parameters();
+    auto target = ::Tensor::api::zeros<float>({kBatch, 256});
+
+    int64_t epoch = 0;
+    loader.start_epoch(epoch);
+    for (auto _ : state) {
+        auto batch = loader.next();
+        if (!batch.defined()) {
+            loader.start_epoch(++epoch);
+            batch = loader.next();
+        }
+        optimizer.zero_grad(parameters);
+        ::Tensor::ops::backward(
+            ::Tensor::ops::mse_loss(linear.forward(batch), target.as_dtensor()));
+        optimizer.step(parameters);
+    }
+    state.SetItemsProcessed(state.iterations() * kBatch);
+    for (const auto& shard : shards) {
+        std::filesystem::remove(shard);
+    }
+}
+BENCHMARK(BM_DataLoaderStep)->Arg(0)->Arg(1);
+
+// Linear + ReLU as separate matmul, bias_add and relu passes (0) or through
+// the fused GEMM epilogue (1).
+static void BM_LinearRelu(benchmark::State& state) {
+    const int64_t batch = state.range(0);
+    const bool fused = state.range(1) != 0;
+    ::Tensor::nn::Linear linear(512, 512);
+    auto input = ::Tensor::api::zeros<float>({batch, 512});
+    ::Tensor::ops::fill(input.as_dtensor(), 1.0f);
+
+    for (auto _ : state) {
+        auto out = fused ? linear.forward(input.as_dtensor(), ::Tensor::ops::Activation::relu())
+                         : ::Tensor::ops::relu(::Tensor::ops::bias_add(
+                               ::Tensor::ops::matmul(input.as_dtensor(), linear.weight()),
+                               linear.bias()));
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * batch * 512 * 512);
+}
+BENCHMARK(BM_LinearRelu)->ArgsProduct({{1, 64, 512}, {0, 1}});
+
+// One small MLP training step. The second argument picks the allocation path:
+// 0 = system allocator, 1 = host cache, 2 = host cache inside a StepArena.
+static void BM_TrainingStep(benchmark::State& state) {
+    const int64_t batch = state.range(0);
+    const std::size_t previous_limit = ::Tensor::host_cache_limit();
+    ::Tensor::set_host_cache_limit(state.range(1) != 0 ? previous_limit : 0);
+    ::Tensor::nn::Linear hidden(64, 128);
+    ::Tensor::nn::Linear output(128, 10);
+    ::Tensor::nn::SGD optimizer(0.01f);
+    std::vector<::Tensor::DTensor*> parameters = hidden.parameters();
+    for (auto* parameter : output.parameters()) {
+        parameters.push_back(parameter);
+    }
+    auto input = ::Tensor::api::zeros<float>({batch, 64});
+    auto target = ::Tensor::api::zeros<float>({batch, 10});
+    ::Tensor::ops::fill(input.as_dtensor(), 0.5f);
+
+    ::Tensor::reset_host_allocator_stats();
+    for (auto _ : state) {
+        std::optional<::Tensor::api::StepArena> arena;
+        if (state.range(1) == 2) {
+            arena.emplace();
+        }
+        optimizer.zero_grad(parameters);
+        auto prediction =
+            output.forward(::Tensor::ops::relu(hidden.forward(input.as_dtensor())));
+        auto error = ::Tensor::ops::sub(prediction, target.as_dtensor());
+        ::Tensor::ops::backward(::Tensor::ops::mean(::Tensor::ops::mul(error, error)));
+        optimizer.step(parameters);
+    }
+    const auto stats = ::Tensor::host_allocator_stats();
+    state.counters["hit_rate"] = static_cast<double>(stats.hits) /
+                                 static_cast<double>(std::max<uint64_t>(1, stats.hits + stats.misses));
+    ::Tensor::set_host_cache_limit(previous_limit);
+}
+BENCHMARK(BM_TrainingStep)->ArgsProduct({{32, 256}, {0, 1, 2}});
+
+// One optimizer step over a model-shaped parameter list: a 1M-element matrix,
+// 64 4K-element matrices and 64 64-element biases. The first argument picks
+// SGD (0), Nesterov SGD (1) or AdamW with gradient clipping (2); the second
+// steps the whole list at once (1) or each parameter through its own
+// optimizer (0), one launch per tensor.
+static void BM_OptimizerStep(benchmark::State& state) {
+    std::vector<::Tensor::DTensor> parameters;
+    parameters.push_back(::Tensor::api::zeros({1024, 1024}, ::Tensor::DType::f32, true));
+    for (int index = 0; index < 64; ++index) {
+        parameters.push_back(::Tensor::api::zeros({64, 64}, ::Tensor::DType::f32, true));
+        parameters.push_back(::Tensor::api::zeros({64}, ::Tensor::DType::f32, true));
+    }
+    int64_t elements = 0;
+    std::vector<::Tensor::DTensor*> pointers;
+    for (auto& parameter : parameters) {
+        auto grad = ::Tensor::api::zeros(parameter.shape(), ::Tensor::DType::f32);
+        ::Tensor::ops::fill(grad, 0.01);
+        parameter.set_grad(std::make_shared<::Tensor::DTensor>(grad));
+        pointers.push_back(&parameter);
+        elements += parameter.numel();
+    }
+
+    const auto make = [&]() -> std::function<void(const std::vector<::Tensor::DTensor*>&)> {
+        switch (state.range(0)) {
+        case 0:
+            return [optimizer = std::make_shared<::Tensor::nn::SGD>(0.01f)](const auto& list) {
+                optimizer->step(list);
+            };
+        case 1:
+            return [optimizer = std::make_shared<::Tensor::nn::SGD>(
+                        0.01f, ::Tensor::nn::SGDOptions{.momentum = 0.9f, .nesterov = true})](
+                       const auto& list) { optimizer->step(list); };
+        default:
+            return [optimizer = std::make_shared<::Tensor::nn::AdamW>(
+                        0.001f, 0.01f, ::Tensor::nn::AdamOptions{.max_grad_norm = 1.0f})](
+                       const auto& list) { optimizer->step(list); };
+        }
+    };
+    const bool batched = state.range(1) != 0;
+    std::vector<std::function<void(const std::vector<::Tensor::DTensor*>&)>> optimizers;
+    for (std::size_t index = 0; index < (batched ? 1 : pointers.size()); ++index) {
+        optimizers.push_back(make());
+    }
+
+    for (auto _ : state) {
+        if (batched) {
+            optimizers[0](pointers);
+        } else {
+            for (std::size_t index = 0; index < pointers.size(); ++index) {
+                optimizers[index]({pointers[index]});
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * elements);
+}
+BENCHMARK(BM_OptimizerStep)->ArgsProduct({{0, 1, 2}, {0, 1}});
+
+// Backward through independent Linear + ReLU branches that share one input;
+// the second argument toggles wave-parallel backward.
+static void BM_BackwardBranches(benchmark::State& state) {
+    const int64_t branches = state.range(0);
+    ::Tensor::set_parallel_backward(state.range(1) != 0);
+    std::vector<::Tensor::nn::Linear> layers;
+    for (int64_t branch = 0; branch < branches; ++branch) {
+        layers.emplace_back(256, 256);
+    }
+    auto input = ::Tensor::api::ones<float>({64, 256});
+
+    for (auto _ : state) {
+        ::Tensor::DTensor total;
+        for (auto& layer : layers) {
+            auto loss = ::Tensor::ops::sum(::Tensor::ops::relu(layer.forward(input.as_dtensor())));
+            total = total.defined() ? ::Tensor::ops::add(total, loss) : loss;
+        }
+        ::Tensor::ops::backward(total);
+        for (auto& layer : layers) {
+            layer.weight().zero_grad();
+            layer.bias().zero_grad();
+        }
+    }
+    ::Tensor::set_parallel_backward(true);
+}
+BENCHMARK(BM_BackwardBranches)->ArgsProduct({{4, 16}, {0, 1}})->UseRealTime();
+
+// Elementwise throughput; large sizes should approach memory bandwidth.
+static void BM_Add(benchmark::State& state) {
+    const int64_t n = state.range(0);
+    auto lhs = ::Tensor::api::ones<float>({n});
+    auto rhs = ::Tensor::api::ones<float>({n});
+    for (auto _ : state) {
+        auto out = ::Tensor::ops::add(lhs.as_dtensor(), rhs.as_dtensor());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * n * 3 * static_cast<int64_t>(sizeof(float)));
+}
+BENCHMARK(BM_Add)->RangeMultiplier(16)->Range(1 << 10, 1 << 24)->UseRealTime();
+
+static void BM_AddOut(benchmark::State& state) {
+    const int64_t n = state.range(0);
+    auto lhs = ::Tensor::api::ones<float>({n});
+    auto rhs = ::Tensor::api::ones<float>({n});
+    auto out = ::Tensor::api::empty<float>({n});
+    for (auto _ : state) {
+        ::Tensor::ops::add_out(lhs.as_dtensor(), rhs.as_dtensor(), out.as_dtensor());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * n * 3 * static_cast<int64_t>(sizeof(float)));
+}
+BENCHMARK(BM_AddOut)->RangeMultiplier(16)->Range(1 << 10, 1 << 24)->UseRealTime();
+
+static void BM_Mul(benchmark::State& state) {
+    const int64_t n = state.range(0);
+    auto lhs = ::Tensor::api::ones<float>({n});
+    auto rhs = ::Tensor::api::ones<float>({n});
+    for (auto _ : state) {
+        auto out = ::Tensor::ops::mul(lhs.as_dtensor(), rhs.as_dtensor());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * n * 3 * static_cast<int64_t>(sizeof(float)));
+}
+BENCHMARK(BM_Mul)->RangeMultiplier(16)->Range(1 << 10, 1 << 24)->UseRealTime();
+
+static void BM_Relu(benchmark::State& state) {
+    const int64_t n = state.range(0);
+    auto input = ::Tensor::api::ones<float>({n});
+    for (auto _ : state) {
+        auto out = ::Tensor::ops::relu(input.as_dtensor());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * n * 2 * static_cast<int64_t>(sizeof(float)));
+}
+BENCHMARK(BM_Relu)->RangeMultiplier(16)->Range(1 << 10, 1 << 24)->UseRealTime();
+
+// MSE loss forward and backward: sub/mul/mean op by op (0), the same ops as one
+// lazy region (1), or the dedicated single-pass ops::mse_loss (2).
+static void BM_MseLoss(benchmark::State& state) {
+    const int64_t n = state.range(0);
+    const int64_t mode = state.range(1);
+    auto prediction = ::Tensor::api::ones<float>({n}, true);
+    auto target = ::Tensor::api::zeros<float>({n});
+    for (auto _ : state) {
+        std::optional<::Tensor::LazyGuard> guard;
+        if (mode == 1) {
+            guard.emplace();
+        }
+        ::Tensor::DTensor loss;
+        if (mode == 2) {
+            loss = ::Tensor::ops::mse_loss(prediction.as_dtensor(), target.as_dtensor());
+        } else {
+            auto diff = ::Tensor::ops::sub(prediction.as_dtensor(), target.as_dtensor());
+            loss = ::Tensor::ops::mean(::Tensor::ops::mul(diff, diff));
+        }
+        ::Tensor::ops::backward(loss);
+        benchmark::DoNotOptimize(prediction.grad()->data());
+        prediction.zero_grad();
+    }
+    state.SetBytesProcessed(state.iterations() * n * 3 * static_cast<int64_t>(sizeof(float)));
+}
+BENCHMARK(BM_MseLoss)->ArgsProduct({{1 << 12, 1 << 16, 1 << 20}, {0, 1, 2}})->UseRealTime();
+
+// Sum of a [rows, cols] matrix over dim 0 (column sums, as in a bias gradient)
+// or dim 1 (row sums).
+static void BM_SumDim(benchmark::State& state) {
+    const int64_t rows = state.range(0);
+    const int64_t cols = state.range(1);
+    const int64_t dim = state.range(2);
+    auto input = ::Tensor::api::ones<float>({rows, cols});
+    for (auto _ : state) {
+        auto out = ::Tensor::ops::sum(input.as_dtensor(), {dim});
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * rows * cols * static_cast<int64_t>(sizeof(float)));
+}
+BENCHMARK(BM_SumDim)
+    ->ArgsProduct({{512, 8192}, {512}, {0, 1}})
+    ->Args({1 << 22, 4, 0})
+    ->Args({4, 1 << 22, 1})
+    ->UseRealTime();
+
+// Strided and broadcast operands go through TensorIterator.
+static void BM_AddRowBroadcast(benchmark::State& state) {
+    const int64_t n = state.range(0);
+    auto matrix = ::Tensor::api::ones<float>({n, n});
+    auto row = ::Tensor::api::ones<float>({n});
+    for (auto _ : state) {
+        auto out = ::Tensor::ops::add(matrix.as_dtensor(), row.as_dtensor());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * n * n * 2 * static_cast<int64_t>(sizeof(float)));
+}
+BENCHMARK(BM_AddRowBroadcast)->Arg(64)->Arg(512)->Arg(2048)->UseRealTime();
+
+static void BM_AddTransposed(benchmark::State& state) {
+    const int64_t n = state.range(0);
+    auto lhs = ::Tensor::api::ones<float>({n, n});
+    auto rhs = ::Tensor::api::ones<float>({n, n});
+    auto lhs_t = ::Tensor::api::permute(lhs.as_dtensor(), {1, 0});
+    auto rhs_t = ::Tensor::api::permute(rhs.as_dtensor(), {1, 0});
+    for (auto _ : state) {
+        auto out = ::Tensor::ops::add(lhs_t, rhs_t);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * n * n * 3 * static_cast<int64_t>(sizeof(float)));
+}
+BENCHMARK(BM_AddTransposed)->Arg(64)->Arg(512)->Arg(2048)->UseRealTime();
+
+// Thread-scaling runs: the last argument is the intra-op thread count.
+static void ThreadCounts(benchmark::internal::Benchmark* bench,
+                         const std::vector<int64_t>& shape) {
+    const int64_t max_threads =
+        static_cast<int64_t>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int64_t threads = 1;; threads *= 2) {
+        std::vector<int64_t> args(shape);
+        args.push_back(std::min(threads, max_threads));
+        bench->Args(args);
+        if (threads >= max_threads) {
+            break;
+        }
+    }
+    bench->UseRealTime();
+}
+
+static void BM_MatmulThreads(benchmark::State& state) {
+    const int64_t n = state.range(0);
+    ::Tensor::set_num_threads(static_cast<int>(state.range(1)));
+    auto lhs = ::Tensor::api::zeros<float>({n, n});
+    auto rhs = ::Tensor::api::zeros<float>({n, n});
+    ::Tensor::ops::fill(lhs.as_dtensor(), 1.0f);
+    ::Tensor::ops::fill(rhs.as_dtensor(), 1.0f);
+
+    for (auto _ : state) {
+        auto out = ::Tensor::ops::matmul(lhs.as_dtensor(), rhs.as_dtensor());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.counters["GFLOP"] = benchmark::Counter(
+        2.0 * static_cast<double>(n * n * n) * 1.0e-9,
+        benchmark::Counter::kIsIterationInvariantRate);
+    ::Tensor::set_num_threads(static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+}
+BENCHMARK(BM_MatmulThreads)->Apply([](benchmark::internal::Benchmark* bench) {
+    ThreadCounts(bench, {1024});
+});
+
+static void BM_AddThreads(benchmark::State& state) {
+    const int64_t n = state.range(0);
+    ::Tensor::set_num_threads(static_cast<int>(state.range(1)));
+    auto lhs = ::Tensor::api::zeros<float>({n});
+    auto rhs = ::Tensor::api::zeros<float>({n});
+
+    for (auto _ : state) {
+        auto out = ::Tensor::ops::add(lhs.as_dtensor(), rhs.as_dtensor());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * n * 3 * static_cast<int64_t>(sizeof(float)));
+    ::Tensor::set_num_threads(static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+}
+BENCHMARK(BM_AddThreads)->Apply([](benchmark::internal::Benchmark* bench) {
+    ThreadCounts(bench, {1 << 24});
+});
 
 BENCHMARK_MAIN();
 
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "api/Api.hpp"
+#include "tensor/Dispatch.hpp"
+#include "tensor/Ops.hpp"
+#include "tensor/Parallel.hpp"
+#include "tensor/Tensor.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace tensor_test {
+
+// An f32 tensor of `shape` holding `values` in row-major order.
+inline Tensor::DTensor make_tensor(const std::vector<int64_t> &shape,
+                                   const std::vector<float> &values, bool requires_grad = false) {
+  auto tensor = Tensor::api::empty(shape, Tensor::DType::f32, requires_grad);
+  std::copy(values.begin(), values.end(), static_cast<float *>(tensor.data()));
+  return tensor;
+}
+
+// A tensor's elements in logical order, read through a dense copy when it is
+// strided.
+template <typename T = float> std::vector<T> values_of(const Tensor::DTensor &tensor) {
+  const Tensor::DTensor dense = tensor.is_contiguous() ? tensor : Tensor::ops::clone(tensor);
+  const auto *ptr = static_cast<const T *>(dense.data());
+  return std::vector<T>(ptr, ptr + dense.numel());
+}
+
+// Element i of a sawtooth tensor is ((i * step + shift) % period) / scale - bias,
+// a cheap spread of small positive and negative values.
+struct Sawtooth {
+  int64_t step{1};
+  int64_t shift{0};
+  int64_t period{17};
+  double scale{8.0};
+  double bias{1.0};
+};
+
+// A tensor filled with `pattern`, each value computed in double and cast to
+// the dtype.
+inline Tensor::DTensor sawtooth(const std::vector<int64_t> &shape, const Sawtooth &pattern,
+                                Tensor::DType dtype = Tensor::DType::f32,
+                                bool requires_grad = false) {
+  auto tensor = Tensor::api::empty(shape, dtype, requires_grad);
+  Tensor::dispatch_dtype(dtype, [&](auto tag) {
+    using T = typename decltype(tag)::type;
+    auto *ptr = static_cast<T *>(tensor.data());
+    for (int64_t index = 0; index < tensor.numel(); ++index) {
+      const int64_t tooth = (index * pattern.step + pattern.shift) % pattern.period;
+      ptr[index] = static_cast<T>(static_cast<double>(tooth) / pattern.scale - pattern.bias);
+    }
+  });
+  return tensor;
+}
+
+// Sets the intra-op pool's thread count for the guard's lifetime.
+class ThreadCountGuard {
+public:
+  explicit ThreadCountGuard(int threads) : previous_(Tensor::get_num_threads()) {
+    Tensor::set_num_threads(threads);
+  }
+  ~ThreadCountGuard() { Tensor::set_num_threads(previous_); }
+
+private:
+  int previous_;
+};
+
+} // namespace tensor_test
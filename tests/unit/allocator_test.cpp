@@ -0,0 +1,104 @@
+#include <cstdint>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "api/Api.hpp"
+#include "tensor/Allocator.hpp"
+
+namespace {
+
+class CacheLimitGuard {
+public:
+  explicit CacheLimitGuard(std::size_t bytes) : previous_(Tensor::host_cache_limit()) {
+    Tensor::set_host_cache_limit(bytes);
+  }
+  ~CacheLimitGuard() { Tensor::set_host_cache_limit(previous_); }
+
+private:
+  std::size_t previous_;
+};
+
+} // namespace
+
+TEST(HostAllocator, ReleasedBlocksAreReused) {
+  CacheLimitGuard limit(std::size_t{64} << 20);
+  Tensor::empty_host_cache();
+  void *first = nullptr;
+  {
+    auto block = Tensor::allocate_host_block(1000);
+    first = block.get();
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(first) % 64, 0u);
+  }
+  Tensor::reset_host_allocator_stats();
+  // 1000 and 1010 bytes round up to the same 1024-byte class.
+  auto again = Tensor::allocate_host_block(1010);
+  EXPECT_EQ(again.get(), first);
+  const auto stats = Tensor::host_allocator_stats();
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.misses, 0u);
+}
+
+TEST(HostAllocator, StatsTrackUsageAndCachedBytes) {
+  CacheLimitGuard limit(std::size_t{64} << 20);
+  Tensor::empty_host_cache();
+  Tensor::reset_host_allocator_stats();
+  const auto before = Tensor::host_allocator_stats();
+  {
+    auto tensor = Tensor::api::zeros({256, 256}, Tensor::DType::f32);
+    const auto during = Tensor::host_allocator_stats();
+    EXPECT_GE(during.bytes_in_use - before.bytes_in_use, 256u * 256u * 4u);
+    EXPECT_GE(during.peak_bytes_in_use, during.bytes_in_use);
+  }
+  const auto after = Tensor::host_allocator_stats();
+  EXPECT_EQ(after.bytes_in_use, before.bytes_in_use);
+  EXPECT_GE(after.bytes_cached, 256u * 256u * 4u);
+
+  Tensor::empty_host_cache();
+  EXPECT_EQ(Tensor::host_allocator_stats().bytes_cached, 0u);
+}
+
+TEST(HostAllocator, GlobalCacheStaysUnderLimit) {
+  const std::size_t limit_bytes = std::size_t{3} << 20;
+  CacheLimitGuard limit(limit_bytes);
+  Tensor::empty_host_cache();
+  {
+    // Blocks above the per-thread cache size go straight to the global cache.
+    auto a = Tensor::allocate_host_block(std::size_t{1} << 20);
+    auto b = Tensor::allocate_host_block(std::size_t{2} << 20);
+    auto c = Tensor::allocate_host_block(std::size_t{2} << 20);
+    auto huge = Tensor::allocate_host_block(std::size_t{8} << 20);
+  }
+  const auto stats = Tensor::host_allocator_stats();
+  EXPECT_LE(stats.bytes_cached, limit_bytes);
+  EXPECT_GT(stats.bytes_cached, 0u);
+}
+
+TEST(HostAllocator, ZeroLimitDisablesCaching) {
+  CacheLimitGuard limit(0);
+  { auto block = Tensor::allocate_host_block(4096); }
+  Tensor::reset_host_allocator_stats();
+  { auto block = Tensor::allocate_host_block(4096); }
+  const auto stats = Tensor::host_allocator_stats();
+  EXPECT_EQ(stats.hits, 0u);
+  EXPECT_EQ(stats.bytes_cached, 0u);
+}
+
+TEST(HostAllocator, BlocksMayBeReleasedOnAnotherThread) {
+  CacheLimitGuard limit(std::size_t{64} << 20);
+  Tensor::empty_host_cache();
+  auto block = Tensor::allocate_host_block(4096);
+  const auto in_use = Tensor::host_allocator_stats().bytes_in_use;
+  std::thread worker([moved = std::move(block)]() mutable { moved.reset(); });
+  worker.join();
+  EXPECT_EQ(Tensor::host_allocator_stats().bytes_in_use, in_use - 4096);
+  // The worker's thread cache was flushed to the global pool on exit.
+  Tensor::reset_host_allocator_stats();
+  auto reused = Tensor::allocate_host_block(4096);
+  EXPECT_EQ(Tensor::host_allocator_stats().hits, 1u);
+}
+
+TEST(HostAllocator, LargeAlignmentsBypassTheCache) {
+  auto block = Tensor::allocate_host_block(100, 4096);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(block.get()) % 4096, 0u);
+}
@@ -0,0 +1,99 @@
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "api/Api.hpp"
+#include "tensor/Allocator.hpp"
+#include "tensor/Linear.hpp"
+#include "tensor/Ops.hpp"
+#include "tensor/Optim.hpp"
+
+#include "TestUtil.hpp"
+
+namespace {
+
+using tensor_test::values_of;
+
+Tensor::DTensor filled(const std::vector<int64_t> &shape, float value) {
+  auto tensor = Tensor::api::empty(shape, Tensor::DType::f32);
+  Tensor::ops::fill(tensor, value);
+  return tensor;
+}
+
+} // namespace
+
+TEST(StepArena, GuardsNestAndScopeTheCallingThread) {
+  EXPECT_FALSE(Tensor::step_arena_active());
+  {
+    Tensor::api::StepArena outer;
+    EXPECT_TRUE(Tensor::step_arena_active());
+    {
+      Tensor::api::StepArena inner;
+      Tensor::ArenaSuspendGuard suspend;
+      EXPECT_FALSE(Tensor::step_arena_active());
+    }
+    EXPECT_TRUE(Tensor::step_arena_active());
+    bool worker_active = true;
+    std::thread worker([&] { worker_active = Tensor::step_arena_active(); });
+    worker.join();
+    EXPECT_FALSE(worker_active);
+  }
+  EXPECT_FALSE(Tensor::step_arena_active());
+}
+
+TEST(StepArena, SmallStorageBypassesTheHostAllocator) {
+  Tensor::api::StepArena arena;
+  Tensor::reset_host_allocator_stats();
+  auto tensor = Tensor::api::zeros({64, 64}, Tensor::DType::f32);
+  const auto stats = Tensor::host_allocator_stats();
+  EXPECT_EQ(stats.hits + stats.misses, 0u);
+  EXPECT_GT(Tensor::step_arena_reserved_bytes(), 0u);
+
+  // Large blocks still go to the caching allocator.
+  auto large = Tensor::api::empty({1024, 1024}, Tensor::DType::f32);
+  EXPECT_EQ(Tensor::host_allocator_stats().hits + Tensor::host_allocator_stats().misses, 1u);
+}
+
+TEST(StepArena, EscapedTensorsSurviveLaterSteps) {
+  Tensor::DTensor escaped;
+  {
+    Tensor::api::StepArena arena;
+    escaped = Tensor::ops::add(filled({4, 4}, 1.0f), filled({4, 4}, 2.0f));
+  }
+  for (int step = 0; step < 3; ++step) {
+    Tensor::api::StepArena arena;
+    auto scratch = filled({4, 4}, -7.0f);
+  }
+  EXPECT_EQ(values_of(escaped), std::vector<float>(16, 3.0f));
+}
+
+TEST(StepArena, TrainingStepsMatchHeapAllocation) {
+  auto run = [](bool use_arena) {
+    Tensor::nn::Linear layer(3, 2);
+    Tensor::ops::fill(layer.weight(), 0.25);
+    Tensor::ops::fill(layer.bias(), -0.5);
+    Tensor::nn::SGD optimizer(0.1f);
+    const auto input = filled({4, 3}, 1.5f);
+    const auto target = filled({4, 2}, 1.0f);
+    for (int step = 0; step < 5; ++step) {
+      std::optional<Tensor::api::StepArena> arena;
+      if (use_arena) {
+        arena.emplace();
+      }
+      optimizer.zero_grad(layer.parameters());
+      auto loss = Tensor::ops::mse_loss(
+          Tensor::ops::relu(layer.forward(input)), target);
+      Tensor::ops::backward(loss);
+      optimizer.step(layer.parameters());
+    }
+    return std::make_pair(values_of(layer.weight()), values_of(*layer.bias().grad()));
+  };
+
+  const auto heap = run(false);
+  const auto arena = run(true);
+  EXPECT_EQ(heap.first, arena.first);
+  EXPECT_EQ(heap.second, arena.second);
+}
@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <cmath>
+#include <stdexcept>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -90,3 +91,132 @@ TEST(Autograd, LeafGradientsAccumulateAcrossBackwardCalls) {
   EXPECT_FLOAT_EQ(grad[0], 2.0f);
   EXPECT_FLOAT_EQ(grad[1], 2.0f);
 }
+
+TEST(Autograd, MatmulBackwardMatchesTransposedProducts) {
+  auto lhs = trainable_tensor({2, 3}, {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f});
+  auto rhs = trainable_tensor({3, 2}, {7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f});
+  auto weights = Tensor::api::zeros({2, 2}, Tensor::DType::f32, false);
+  std::copy_n(std::vector<float>{1.0f, -1.0f, 2.0f, 0.5f}.begin(), 4,
+              static_cast<float *>(weights.data()));
+
+  auto product = Tensor::ops::matmul(lhs, rhs);
+  Tensor::ops::backward(Tensor::ops::sum(Tensor::ops::mul(product, weights)));
+
+  // grad_lhs = W * rhs^T, grad_rhs = lhs^T * W.
+  const auto *lhs_grad = static_cast<const float *>(lhs.grad()->data());
+  const std::vector<float> expected_lhs{-1.0f, -1.0f, -1.0f, 18.0f, 23.0f, 28.0f};
+  for (std::size_t index = 0; index < expected_lhs.size(); ++index) {
+    EXPECT_FLOAT_EQ(lhs_grad[index], expected_lhs[index]);
+  }
+  const auto *rhs_grad = static_cast<const float *>(rhs.grad()->data());
+  const std::vector<float> expected_rhs{9.0f, 1.0f, 12.0f, 0.5f, 15.0f, 0.0f};
+  for (std::size_t index = 0; index < expected_rhs.size(); ++index) {
+    EXPECT_FLOAT_EQ(rhs_grad[index], expected_rhs[index]);
+  }
+}
+
+TEST(Autograd, BroadcastGradientsReduceToInputShape) {
+  auto matrix = trainable_tensor({2, 3}, {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f});
+  auto row = trainable_tensor({3}, {1.0f, 2.0f, 3.0f});
+
+  Tensor::ops::backward(Tensor::ops::sum(Tensor::ops::mul(matrix, row)));
+
+  ASSERT_EQ(row.grad()->shape(), (std::vector<int64_t>{3}));
+  const auto *row_grad = static_cast<const float *>(row.grad()->data());
+  EXPECT_FLOAT_EQ(row_grad[0], 5.0f);
+  EXPECT_FLOAT_EQ(row_grad[1], 7.0f);
+  EXPECT_FLOAT_EQ(row_grad[2], 9.0f);
+  const auto *matrix_grad = static_cast<const float *>(matrix.grad()->data());
+  EXPECT_FLOAT_EQ(matrix_grad[0], 1.0f);
+  EXPECT_FLOAT_EQ(matrix_grad[5], 3.0f);
+}
+
+TEST(Autograd, PermutedWeightGradientsKeepTheBaseLayout) {
+  auto weight = trainable_tensor({3, 2}, {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f});
+  auto input = Tensor::api::zeros({1, 2}, Tensor::DType::f32, false);
+  static_cast<float *>(input.data())[0] = 1.0f;
+  static_cast<float *>(input.data())[1] = 2.0f;
+
+  const auto out = Tensor::ops::matmul(input, Tensor::api::permute(weight, {1, 0}));
+  Tensor::ops::backward(Tensor::ops::sum(out));
+
+  ASSERT_TRUE(weight.grad());
+  ASSERT_EQ(weight.grad()->shape(), (std::vector<int64_t>{3, 2}));
+  const auto *grad = static_cast<const float *>(weight.grad()->data());
+  const std::vector<float> expected{1.0f, 2.0f, 1.0f, 2.0f, 1.0f, 2.0f};
+  for (std::size_t index = 0; index < expected.size(); ++index) {
+    EXPECT_FLOAT_EQ(grad[index], expected[index]);
+  }
+}
+
+TEST(Autograd, ReshapedViewGradientsKeepTheBaseShape) {
+  auto weight = trainable_tensor({2, 3}, {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f});
+  auto scale = Tensor::api::zeros({3, 2}, Tensor::DType::f32, false);
+  for (int index = 0; index < 6; ++index) {
+    static_cast<float *>(scale.data())[index] = static_cast<float>(index + 1);
+  }
+
+  auto view = Tensor::api::reshape(weight, {3, 2});
+  Tensor::ops::backward(Tensor::ops::sum(Tensor::ops::mul(view, scale)));
+
+  ASSERT_TRUE(weight.grad());
+  ASSERT_EQ(weight.grad()->shape(), (std::vector<int64_t>{2, 3}));
+  const auto *grad = static_cast<const float *>(weight.grad()->data());
+  for (int index = 0; index < 6; ++index) {
+    EXPECT_FLOAT_EQ(grad[index], static_cast<float>(index + 1));
+  }
+  EXPECT_THROW(Tensor::ops::relu_(view), std::invalid_argument);
+}
+
+TEST(Autograd, ElementwiseGradientsThroughPermutedAndBroadcastOperands) {
+  auto weight = trainable_tensor({3, 2}, {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f});
+  auto row = trainable_tensor({1, 3}, {1.0f, 2.0f, 3.0f});
+  auto column = trainable_tensor({2, 1}, {10.0f, -100.0f});
+
+  // relu(weight^T * row - column) = relu({{-9, -4, 5}, {102, 108, 118}}).
+  const auto view = Tensor::api::permute(weight, {1, 0});
+  const auto hidden = Tensor::ops::sub(Tensor::ops::mul(view, row), column);
+  Tensor::ops::backward(Tensor::ops::sum(Tensor::ops::relu(hidden)));
+
+  const auto expect_grad = [](const Tensor::DTensor &tensor, const std::vector<int64_t> &shape,
+                              const std::vector<float> &expected) {
+    ASSERT_TRUE(tensor.grad());
+    ASSERT_EQ(tensor.grad()->shape(), shape);
+    const auto *grad = static_cast<const float *>(tensor.grad()->data());
+    for (std::size_t index = 0; index < expected.size(); ++index) {
+      EXPECT_FLOAT_EQ(grad[index], expected[index]);
+    }
+  };
+  expect_grad(weight, {3, 2}, {0.0f, 1.0f, 0.0f, 2.0f, 3.0f, 3.0f});
+  expect_grad(row, {1, 3}, {2.0f, 4.0f, 11.0f});
+  expect_grad(column, {2, 1}, {-1.0f, -3.0f});
+}
+
+TEST(Autograd, DiamondGraphsRunEachNodeOnce) {
+  // Forty stacked diamonds: the recursive walk would visit the input 2^40
+  // times, the engine visits each node once.
+  auto input = trainable_tensor({2}, {1.0f, -1.0f});
+  auto value = input;
+  for (int layer = 0; layer < 40; ++layer) {
+    value = Tensor::ops::add(value, value);
+  }
+  Tensor::ops::backward(Tensor::ops::sum(value));
+
+  ASSERT_TRUE(input.grad());
+  const auto *grad = static_cast<const float *>(input.grad()->data());
+  EXPECT_EQ(grad[0], std::ldexp(1.0f, 40));
+  EXPECT_EQ(grad[1], std::ldexp(1.0f, 40));
+}
+
+TEST(Autograd, DeepChainsDoNotRecurse) {
+  auto input = trainable_tensor({1}, {0.5f});
+  const auto zero = Tensor::api::zeros({1}, Tensor::DType::f32);
+  auto value = input;
+  for (int layer = 0; layer < 20000; ++layer) {
+    value = Tensor::ops::relu(Tensor::ops::add(value, zero));
+  }
+  Tensor::ops::backward(Tensor::ops::sum(value));
+
+  ASSERT_TRUE(input.grad());
+  EXPECT_EQ(static_cast<const float *>(input.grad()->data())[0], 1.0f);
+}
@@ -0,0 +1,145 @@
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "api/Api.hpp"
+#include "tensor/Batching.hpp"
+
+#include "TestUtil.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+Tensor::DTensor make_row(const std::vector<int64_t> &shape, int64_t seed) {
+  return tensor_test::sawtooth(
+      shape, {.step = 5, .shift = seed * 3, .period = 13, .scale = 8.0, .bias = 0.75});
+}
+
+void expect_near(const Tensor::DTensor &actual, const Tensor::DTensor &expected) {
+  ASSERT_EQ(actual.numel(), expected.numel());
+  const auto *lhs = static_cast<const float *>(actual.data());
+  const auto *rhs = static_cast<const float *>(expected.data());
+  for (int64_t index = 0; index < actual.numel(); ++index) {
+    EXPECT_NEAR(lhs[index], rhs[index], 1e-5f) << "index " << index;
+  }
+}
+
+struct Item : Tensor::MpscNode {
+  int producer{0};
+  int sequence{0};
+};
+
+} // namespace
+
+TEST(MpscQueue, KeepsEachProducersOrder) {
+  constexpr int kProducers = 4;
+  constexpr int kItems = 20000;
+  Tensor::MpscQueue queue;
+  std::vector<std::vector<Item>> items(kProducers);
+  for (auto &run : items) {
+    run = std::vector<Item>(kItems);
+  }
+  std::vector<std::thread> producers;
+  for (int producer = 0; producer < kProducers; ++producer) {
+    producers.emplace_back([&, producer] {
+      for (int sequence = 0; sequence < kItems; ++sequence) {
+        Item &item = items[producer][sequence];
+        item.producer = producer;
+        item.sequence = sequence;
+        queue.push(&item);
+      }
+    });
+  }
+
+  std::vector<int> next(kProducers, 0);
+  for (int popped = 0; popped < kProducers * kItems;) {
+    auto *item = static_cast<Item *>(queue.pop());
+    if (item == nullptr) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_EQ(item->sequence, next[item->producer]++);
+    ++popped;
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+  EXPECT_EQ(queue.pop(), nullptr);
+}
+
+TEST(LinearBatcher, RowsFromManyThreadsMatchDirectForwards) {
+  Tensor::nn::Linear linear(24, 10);
+  Tensor::nn::LinearBatcher batcher(linear, {8, 500us}, Tensor::ops::Activation::relu());
+  constexpr int kThreads = 4;
+  constexpr int kRows = 25;
+  std::vector<std::thread> clients;
+  for (int client = 0; client < kThreads; ++client) {
+    clients.emplace_back([&, client] {
+      for (int request = 0; request < kRows; ++request) {
+        const auto row = make_row({1, 24}, client * kRows + request);
+        const auto result = batcher.submit(row).get();
+        EXPECT_EQ(result.shape(), (Tensor::Dims{1, 10}));
+        expect_near(result, linear.forward(row, Tensor::ops::Activation::relu()));
+      }
+    });
+  }
+  for (auto &client : clients) {
+    client.join();
+  }
+  const auto stats = batcher.stats();
+  EXPECT_EQ(stats.rows, static_cast<uint64_t>(kThreads * kRows));
+  EXPECT_LE(stats.batches, stats.rows);
+}
+
+TEST(LinearBatcher, CoalescesUpToTheMaxBatchSize) {
+  Tensor::nn::Linear linear(6, 3);
+  Tensor::nn::LinearBatcher batcher(linear, {4, 10s});
+  std::vector<Tensor::DTensor> rows;
+  std::vector<std::future<Tensor::DTensor>> results;
+  for (int request = 0; request < 8; ++request) {
+    rows.push_back(make_row({6}, request));
+    results.push_back(batcher.submit(rows.back()));
+  }
+  for (int request = 0; request < 8; ++request) {
+    const auto result = results[request].get();
+    EXPECT_EQ(result.shape(), (Tensor::Dims{3}));
+    EXPECT_FALSE(result.requires_grad());
+    expect_near(result, linear.forward(Tensor::api::reshape(rows[request], {1, 6})));
+  }
+  EXPECT_EQ(batcher.stats().batches, 2u);
+  EXPECT_EQ(batcher.stats().rows, 8u);
+}
+
+TEST(LinearBatcher, PartialBatchesRunAtTheDeadline) {
+  Tensor::nn::Linear linear(6, 3);
+  Tensor::nn::LinearBatcher batcher(linear, {64, 1ms});
+  auto result = batcher.submit(make_row({6}, 1));
+  ASSERT_EQ(result.wait_for(10s), std::future_status::ready);
+  EXPECT_EQ(batcher.stats().batches, 1u);
+}
+
+TEST(LinearBatcher, ShutdownServesQueuedRows) {
+  Tensor::nn::Linear linear(6, 3);
+  std::future<Tensor::DTensor> result;
+  {
+    Tensor::nn::LinearBatcher batcher(linear, {64, 1h});
+    result = batcher.submit(make_row({1, 6}, 2));
+  }
+  ASSERT_EQ(result.wait_for(0s), std::future_status::ready);
+  EXPECT_EQ(result.get().shape(), (Tensor::Dims{1, 3}));
+}
+
+TEST(LinearBatcher, RejectsRowsTheLayerCannotTake) {
+  Tensor::nn::Linear linear(6, 3);
+  Tensor::nn::LinearBatcher batcher(linear);
+  EXPECT_THROW(batcher.submit(make_row({5}, 0)), std::invalid_argument);
+  EXPECT_THROW(batcher.submit(make_row({2, 6}, 0)), std::invalid_argument);
+  EXPECT_THROW(batcher.submit(Tensor::api::zeros({6}, Tensor::DType::f64)),
+               std::invalid_argument);
+  EXPECT_THROW(Tensor::nn::LinearBatcher(linear, {0, 1ms}), std::invalid_argument);
+}
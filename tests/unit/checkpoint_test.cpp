@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "api/Api.hpp"
+#include "tensor/Allocator.hpp"
+#include "tensor/Autograd.hpp"
+#include "tensor/Linear.hpp"
+#include "tensor/Ops.hpp"
+
+#include "TestUtil.hpp"
+
+namespace {
+
+constexpr int64_t kBatch = 512;
+constexpr int64_t kWidth = 128;
+constexpr int kDepth = 16;
+
+using tensor_test::values_of;
+
+Tensor::DTensor ramp(const std::vector<int64_t> &shape, bool requires_grad = false) {
+  return tensor_test::sawtooth(shape, {}, Tensor::DType::f32, requires_grad);
+}
+
+std::vector<Tensor::nn::Linear> make_layers() {
+  std::vector<Tensor::nn::Linear> layers;
+  for (int layer = 0; layer < kDepth; ++layer) {
+    layers.emplace_back(kWidth, kWidth);
+  }
+  return layers;
+}
+
+// Runs the MLP with every `segment` layers checkpointed (0 runs it plainly) and
+// backpropagates its sum.
+void train_step(std::vector<Tensor::nn::Linear> &layers, const Tensor::DTensor &input,
+                int segment) {
+  Tensor::DTensor hidden = input;
+  for (int first = 0; first < kDepth; first += segment == 0 ? kDepth : segment) {
+    const int last = segment == 0 ? kDepth : std::min(kDepth, first + segment);
+    const auto run = [&layers, first, last](const std::vector<Tensor::DTensor> &in) {
+      Tensor::DTensor value = in[0];
+      for (int layer = first; layer < last; ++layer) {
+        value = Tensor::ops::relu(layers[static_cast<std::size_t>(layer)].forward(value));
+      }
+      return value;
+    };
+    hidden = segment == 0 ? run({hidden}) : Tensor::checkpoint(run, {hidden});
+  }
+  Tensor::ops::backward(Tensor::ops::sum(hidden));
+}
+
+std::vector<std::vector<float>> gradients_of(std::vector<Tensor::nn::Linear> &layers,
+                                             const Tensor::DTensor &input) {
+  std::vector<std::vector<float>> grads{values_of(*input.grad())};
+  for (auto &layer : layers) {
+    grads.push_back(values_of(*layer.weight().grad()));
+    grads.push_back(values_of(*layer.bias().grad()));
+  }
+  return grads;
+}
+
+void clear_gradients(std::vector<Tensor::nn::Linear> &layers, Tensor::DTensor &input) {
+  input.zero_grad();
+  for (auto &layer : layers) {
+    layer.weight().zero_grad();
+    layer.bias().zero_grad();
+  }
+}
+
+} // namespace
+
+TEST(GradMode, NoGradGuardStopsRecording) {
+  auto weight = ramp({2, 2}, true);
+  {
+    Tensor::NoGradGuard no_grad;
+    EXPECT_FALSE(Tensor::grad_mode_enabled());
+    const auto product = Tensor::ops::matmul(weight, weight);
+    EXPECT_FALSE(product.requires_grad());
+    EXPECT_EQ(product.grad_fn(), nullptr);
+    // Leaves may be updated in place while nothing is recording.
+    EXPECT_NO_THROW(Tensor::ops::add_(weight, product));
+    {
+      Tensor::GradModeGuard recording(true);
+      EXPECT_TRUE(Tensor::ops::relu(weight).requires_grad());
+    }
+    EXPECT_FALSE(Tensor::grad_mode_enabled());
+  }
+  EXPECT_TRUE(Tensor::grad_mode_enabled());
+  EXPECT_TRUE(Tensor::ops::relu(weight).requires_grad());
+}
+
+TEST(Checkpoint, GradientsMatchAPlainRunBitForBit) {
+  auto layers = make_layers();
+  auto input = ramp({kBatch, kWidth}, true);
+
+  train_step(layers, input, 0);
+  const auto expected = gradients_of(layers, input);
+  for (const int segment : {1, 2, 3}) {
+    clear_gradients(layers, input);
+    train_step(layers, input, segment);
+    EXPECT_EQ(gradients_of(layers, input), expected) << "segment " << segment;
+  }
+}
+
+TEST(Checkpoint, LowersPeakMemoryOfATrainingStep) {
+  auto layers = make_layers();
+  auto input = ramp({kBatch, kWidth}, true);
+  const auto peak_of = [&](int segment) {
+    clear_gradients(layers, input);
+    Tensor::reset_host_allocator_stats();
+    const auto before = Tensor::host_allocator_stats();
+    train_step(layers, input, segment);
+    return Tensor::host_allocator_stats().peak_bytes_in_use - before.bytes_in_use;
+  };
+
+  const std::size_t plain = peak_of(0);
+  const std::size_t checkpointed = peak_of(4);
+  EXPECT_LT(checkpointed, plain * 3 / 4) << "plain " << plain << ", checkpointed "
+                                         << checkpointed;
+}
+
+TEST(Checkpoint, ModifiedInputsFailBackward) {
+  Tensor::nn::Linear layer(2, 2);
+  auto input = ramp({1, 2});
+  const auto output = Tensor::checkpoint(
+      [&layer](const std::vector<Tensor::DTensor> &in) { return layer.forward(in[0]); },
+      {input});
+  Tensor::ops::fill(input, 3.0);
+  EXPECT_THROW(Tensor::ops::backward(Tensor::ops::sum(output)), std::runtime_error);
+}
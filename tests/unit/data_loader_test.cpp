@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "tensor/DataLoader.hpp"
+
+namespace {
+
+constexpr int64_t kFeatures = 3;
+
+// Shard files under the temp directory, removed when the test ends. Row r of
+// the dataset holds r * kFeatures, r * kFeatures + 1, ...
+class Shards {
+public:
+  explicit Shards(const std::vector<int64_t> &rows) {
+    const auto *test = ::testing::UnitTest::GetInstance()->current_test_info();
+    int64_t first = 0;
+    for (std::size_t shard = 0; shard < rows.size(); ++shard) {
+      const auto path = std::filesystem::temp_directory_path() /
+                        ("shard_" + std::string(test->name()) + "_" + std::to_string(shard));
+      std::ofstream out(path, std::ios::binary);
+      for (int64_t row = first; row < first + rows[shard]; ++row) {
+        for (int64_t feature = 0; feature < kFeatures; ++feature) {
+          const auto value = static_cast<float>(row * kFeatures + feature);
+          out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+        }
+      }
+      first += rows[shard];
+      paths_.push_back(path.string());
+    }
+  }
+  ~Shards() {
+    for (const auto &path : paths_) {
+      std::filesystem::remove(path);
+    }
+  }
+  const std::vector<std::string> &paths() const { return paths_; }
+
+private:
+  std::vector<std::string> paths_;
+};
+
+// The dataset row ids of each batch, checking every row is intact.
+std::vector<int64_t> rows_of(const Tensor::DTensor &batch) {
+  EXPECT_EQ(batch.rank(), 2);
+  EXPECT_EQ(batch.shape()[1], kFeatures);
+  EXPECT_TRUE(batch.is_contiguous());
+  const auto *values = static_cast<const float *>(batch.data());
+  std::vector<int64_t> rows;
+  for (int64_t row = 0; row < batch.shape()[0]; ++row) {
+    const auto id = static_cast<int64_t>(values[row * kFeatures]) / kFeatures;
+    for (int64_t feature = 0; feature < kFeatures; ++feature) {
+      EXPECT_EQ(values[row * kFeatures + feature], static_cast<float>(id * kFeatures + feature));
+    }
+    rows.push_back(id);
+  }
+  return rows;
+}
+
+std::vector<int64_t> epoch_rows(Tensor::DataLoader &loader, int64_t epoch) {
+  loader.start_epoch(epoch);
+  std::vector<int64_t> rows;
+  for (auto batch = loader.next(); batch.defined(); batch = loader.next()) {
+    const auto ids = rows_of(batch);
+    rows.insert(rows.end(), ids.begin(), ids.end());
+  }
+  return rows;
+}
+
+std::vector<int64_t> iota(int64_t count) {
+  std::vector<int64_t> values(static_cast<std::size_t>(count));
+  for (int64_t index = 0; index < count; ++index) {
+    values[static_cast<std::size_t>(index)] = index;
+  }
+  return values;
+}
+
+} // namespace
+
+TEST(DataLoader, ServesShardsInOrderWithoutShuffling) {
+  const Shards shards({5, 0, 7, 3});
+  Tensor::DataLoader loader(shards.paths(), kFeatures,
+                            {.batch_size = 4, .shuffle = Tensor::Shuffle::none});
+  EXPECT_EQ(loader.rows(), 15);
+  EXPECT_EQ(loader.shard_count(), 4);
+  EXPECT_EQ(loader.shard_rows(2), 7);
+  EXPECT_EQ(loader.batches_per_epoch(), 4);
+  EXPECT_EQ(loader.epoch(), -1);
+  EXPECT_THROW(loader.next(), std::runtime_error);
+
+  loader.start_epoch(0);
+  std::vector<int64_t> sizes;
+  std::vector<int64_t> rows;
+  for (auto batch = loader.next(); batch.defined(); batch = loader.next()) {
+    EXPECT_FALSE(batch.requires_grad());
+    sizes.push_back(batch.shape()[0]);
+    const auto ids = rows_of(batch);
+    rows.insert(rows.end(), ids.begin(), ids.end());
+  }
+  EXPECT_EQ(sizes, (std::vector<int64_t>{4, 4, 4, 3}));
+  EXPECT_EQ(rows, iota(15));
+  EXPECT_FALSE(loader.next().defined());
+  EXPECT_EQ(loader.epoch(), 0);
+}
+
+TEST(DataLoader, DropLastSkipsTheShortBatch) {
+  const Shards shards({10});
+  Tensor::DataLoader loader(shards.paths(), kFeatures,
+                            {.batch_size = 4, .shuffle = Tensor::Shuffle::none, .drop_last = true});
+  EXPECT_EQ(loader.batches_per_epoch(), 2);
+  EXPECT_EQ(epoch_rows(loader, 0), iota(8));
+}
+
+TEST(DataLoader, ShufflesEveryRowOncePerEpochReproducibly) {
+  const Shards shards({40, 25, 35});
+  Tensor::DataLoader loader(shards.paths(), kFeatures, {.batch_size = 8, .seed = 7});
+  Tensor::DataLoader rerun(shards.paths(), kFeatures, {.batch_size = 8, .seed = 7});
+
+  const auto first = epoch_rows(loader, 0);
+  const auto second = epoch_rows(loader, 1);
+  EXPECT_NE(first, iota(100));
+  EXPECT_NE(first, second);
+  for (auto rows : {first, second}) {
+    std::sort(rows.begin(), rows.end());
+    EXPECT_EQ(rows, iota(100));
+  }
+  EXPECT_EQ(epoch_rows(rerun, 1), second);
+  EXPECT_EQ(epoch_rows(rerun, 0), first);
+}
+
+TEST(DataLoader, ShufflingWithinShardsKeepsShardsTogether) {
+  const Shards shards({30, 30, 30});
+  Tensor::DataLoader loader(shards.paths(), kFeatures,
+                            {.batch_size = 7, .shuffle = Tensor::Shuffle::within_shards});
+  const auto rows = epoch_rows(loader, 3);
+  ASSERT_EQ(rows.size(), 90u);
+  std::set<int64_t> shards_seen;
+  for (std::size_t begin = 0; begin < rows.size(); begin += 30) {
+    const int64_t shard = rows[begin] / 30;
+    EXPECT_TRUE(shards_seen.insert(shard).second);
+    std::vector<int64_t> block(rows.begin() + static_cast<std::ptrdiff_t>(begin),
+                               rows.begin() + static_cast<std::ptrdiff_t>(begin + 30));
+    for (const int64_t row : block) {
+      EXPECT_EQ(row / 30, shard);
+    }
+    std::sort(block.begin(), block.end());
+    EXPECT_EQ(block.front(), shard * 30);
+    EXPECT_EQ(block.back(), shard * 30 + 29);
+  }
+}
+
+TEST(DataLoader, ReusesARingOfBuffers) {
+  const Shards shards({64});
+  for (const int workers : {0, 1, 2}) {
+    Tensor::DataLoader loader(shards.paths(), kFeatures,
+                              {.batch_size = 2, .num_workers = workers, .prefetch = 2});
+    loader.start_epoch(0);
+    std::set<const void *> buffers;
+    std::vector<int64_t> rows;
+    for (auto batch = loader.next(); batch.defined(); batch = loader.next()) {
+      buffers.insert(batch.data());
+      const auto ids = rows_of(batch);
+      rows.insert(rows.end(), ids.begin(), ids.end());
+    }
+    EXPECT_LE(buffers.size(), 3u) << workers << " workers";
+    std::sort(rows.begin(), rows.end());
+    EXPECT_EQ(rows, iota(64)) << workers << " workers";
+  }
+}
+
+TEST(DataLoader, HoldingBatchesFallsBackToFreshMemory) {
+  const Shards shards({50});
+  Tensor::DataLoader loader(shards.paths(), kFeatures,
+                            {.batch_size = 5, .shuffle = Tensor::Shuffle::none, .prefetch = 1});
+  loader.start_epoch(0);
+  std::vector<Tensor::DTensor> held;
+  for (auto batch = loader.next(); batch.defined(); batch = loader.next()) {
+    held.push_back(std::move(batch));
+  }
+  ASSERT_EQ(held.size(), 10u);
+  std::vector<int64_t> rows;
+  for (const auto &batch : held) {
+    const auto ids = rows_of(batch);
+    rows.insert(rows.end(), ids.begin(), ids.end());
+  }
+  EXPECT_EQ(rows, iota(50));
+}
+
+TEST(DataLoader, RestartingAnEpochDropsQueuedBatches) {
+  const Shards shards({40});
+  Tensor::DataLoader loader(shards.paths(), kFeatures,
+                            {.batch_size = 4, .shuffle = Tensor::Shuffle::none, .num_workers = 2});
+  loader.start_epoch(0);
+  const auto first = loader.next();
+  EXPECT_EQ(rows_of(first), (std::vector<int64_t>{0, 1, 2, 3}));
+  loader.start_epoch(5);
+  EXPECT_EQ(loader.epoch(), 5);
+  EXPECT_EQ(rows_of(loader.next()), (std::vector<int64_t>{0, 1, 2, 3}));
+}
+
+TEST(DataLoader, BatchesOutliveTheLoader) {
+  const Shards shards({12});
+  Tensor::DTensor batch;
+  {
+    Tensor::DataLoader loader(shards.paths(), kFeatures,
+                              {.batch_size = 6, .shuffle = Tensor::Shuffle::none});
+    loader.start_epoch(0);
+    batch = loader.next();
+  }
+  EXPECT_EQ(rows_of(batch), (std::vector<int64_t>{0, 1, 2, 3, 4, 5}));
+}
+
+TEST(DataLoader, RejectsBadArguments) {
+  const Shards shards({4});
+  EXPECT_THROW(Tensor::DataLoader(shards.paths(), 0), std::invalid_argument);
+  EXPECT_THROW(Tensor::DataLoader(shards.paths(), kFeatures, {.batch_size = 0}),
+               std::invalid_argument);
+  EXPECT_THROW(Tensor::DataLoader({}, kFeatures), std::invalid_argument);
+  // 4 rows of 3 floats are not a whole number of 5-float rows.
+  EXPECT_THROW(Tensor::DataLoader(shards.paths(), 5), std::invalid_argument);
+  EXPECT_THROW(Tensor::DataLoader({shards.paths()[0] + ".missing"}, kFeatures),
+               std::runtime_error);
+
+  Tensor::DataLoader loader(shards.paths(), kFeatures);
+  EXPECT_THROW(loader.start_epoch(-1), std::invalid_argument);
+  EXPECT_THROW(loader.shard_rows(1), std::out_of_range);
+}
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "api/Api.hpp"
+#include "tensor/Linear.hpp"
+#include "tensor/Ops.hpp"
+#include "tensor/Optim.hpp"
+
+#include "TestUtil.hpp"
+
+namespace {
+
+template <typename T>
+Tensor::DTensor typed_tensor(const std::vector<int64_t> &shape, const std::vector<T> &values,
+                             bool requires_grad = false) {
+  auto tensor = Tensor::api::empty(shape, Tensor::dtype_of<T>(), requires_grad);
+  std::copy(values.begin(), values.end(), static_cast<T *>(tensor.data()));
+  return tensor;
+}
+
+using tensor_test::values_of;
+
+template <typename T> class DTypeOps : public ::testing::Test {};
+
+using AllDTypes = ::testing::Types<float, double, int32_t, int64_t>;
+TYPED_TEST_SUITE(DTypeOps, AllDTypes);
+
+} // namespace
+
+TYPED_TEST(DTypeOps, ElementwiseOpsKeepTheirDtype) {
+  using T = TypeParam;
+  // 37 elements exercise full vectors and a masked tail at every width.
+  std::vector<T> lhs_values;
+  std::vector<T> rhs_values;
+  for (int index = 0; index < 37; ++index) {
+    lhs_values.push_back(static_cast<T>(index - 18));
+    rhs_values.push_back(static_cast<T>(index % 5 + 1));
+  }
+  const auto lhs = typed_tensor<T>({37}, lhs_values);
+  const auto rhs = typed_tensor<T>({37}, rhs_values);
+
+  const auto sum = Tensor::ops::add(lhs, rhs);
+  const auto product = Tensor::ops::mul(lhs, rhs);
+  const auto relu = Tensor::ops::relu(Tensor::ops::sub(lhs, rhs));
+  const auto clamped = Tensor::ops::clamp(lhs, -3.0, 4.0);
+  EXPECT_EQ(sum.dtype(), Tensor::dtype_of<T>());
+
+  const auto sums = values_of<T>(sum);
+  const auto products = values_of<T>(product);
+  const auto relus = values_of<T>(relu);
+  const auto clamps = values_of<T>(clamped);
+  for (std::size_t index = 0; index < lhs_values.size(); ++index) {
+    const T a = lhs_values[index];
+    const T b = rhs_values[index];
+    EXPECT_EQ(sums[index], static_cast<T>(a + b));
+    EXPECT_EQ(products[index], static_cast<T>(a * b));
+    EXPECT_EQ(relus[index], a - b > T{0} ? static_cast<T>(a - b) : T{0});
+    EXPECT_EQ(clamps[index], std::clamp(a, T{-3}, T{4}));
+  }
+  EXPECT_EQ(values_of<T>(Tensor::ops::sum(lhs))[0], T{0});
+}
+
+TYPED_TEST(DTypeOps, MatmulAndFillMatchReference) {
+  using T = TypeParam;
+  const auto lhs = typed_tensor<T>({2, 3}, {1, 2, 3, 4, 5, 6});
+  const auto stored = typed_tensor<T>({2, 3}, {7, 9, 11, 8, 10, 12});
+  const auto rhs = Tensor::api::permute(stored, {1, 0});
+
+  const auto product = values_of<T>(Tensor::ops::matmul(lhs, rhs));
+  EXPECT_EQ(product, (std::vector<T>{58, 64, 139, 154}));
+
+  auto filled = Tensor::api::empty({5}, Tensor::dtype_of<T>());
+  Tensor::ops::fill(filled, 3.0);
+  EXPECT_EQ(values_of<T>(filled), std::vector<T>(5, T{3}));
+}
+
+TEST(DTypeAutograd, DoubleGradientsFlowThroughEveryNode) {
+  auto weight = typed_tensor<double>({2, 2}, {0.5, -1.0, 2.0, 0.25}, true);
+  auto bias = typed_tensor<double>({2}, {0.1, -0.2}, true);
+  const auto input = typed_tensor<double>({3, 2}, {1.0, 2.0, -1.0, 0.5, 3.0, -2.0});
+
+  auto hidden =
+      Tensor::ops::relu(Tensor::ops::bias_add(Tensor::ops::matmul(input, weight), bias));
+  Tensor::ops::backward(Tensor::ops::mean(Tensor::ops::mul(hidden, hidden)));
+
+  ASSERT_TRUE(weight.grad());
+  ASSERT_TRUE(bias.grad());
+  EXPECT_EQ(weight.grad()->dtype(), Tensor::DType::f64);
+  // Pre-activations are {4.6, -0.7}, {0.6, 0.925} and {-2.4, -3.7}; the mean of
+  // six squares gives d/dh = h / 3 on the active units.
+  const auto bias_grad = values_of<double>(*bias.grad());
+  EXPECT_NEAR(bias_grad[0], (4.6 + 0.6) / 3.0, 1e-12);
+  EXPECT_NEAR(bias_grad[1], 0.925 / 3.0, 1e-12);
+}
+
+TEST(DTypeAutograd, LinearAndSgdTrainInDouble) {
+  Tensor::nn::Linear layer(3, 2, Tensor::DType::f64);
+  Tensor::nn::SGD optimizer(0.1f);
+  const auto input = typed_tensor<double>({1, 3}, {1.0, -1.0, 0.5});
+  EXPECT_THROW(layer.forward(Tensor::api::zeros({1, 3}, Tensor::DType::f32)),
+               std::invalid_argument);
+
+  const auto before = values_of<double>(layer.bias());
+  Tensor::ops::backward(Tensor::ops::sum(layer.forward(input)));
+  optimizer.step(layer.parameters());
+  const auto after = values_of<double>(layer.bias());
+  EXPECT_NEAR(after[0], before[0] - 0.1, 1e-7);
+  EXPECT_NEAR(after[1], before[1] - 0.1, 1e-7);
+}
+
+TEST(DTypeErrors, MixedDtypesAreRejected) {
+  const auto lhs = Tensor::api::zeros({2}, Tensor::DType::f32);
+  const auto rhs = Tensor::api::zeros({2}, Tensor::DType::i64);
+  EXPECT_THROW(Tensor::ops::add(lhs, rhs), std::invalid_argument);
+}
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "api/Api.hpp"
+#include "tensor/Elementwise.hpp"
+#include "tensor/Ops.hpp"
+
+#include "TestUtil.hpp"
+
+namespace {
+
+std::vector<float> patterned_values(int64_t count, float offset) {
+  std::vector<float> values(static_cast<std::size_t>(count));
+  for (int64_t index = 0; index < count; ++index) {
+    values[static_cast<std::size_t>(index)] =
+        static_cast<float>((index * 29) % 41) / 8.0f - 2.5f + offset;
+  }
+  return values;
+}
+
+using tensor_test::make_tensor;
+using tensor_test::values_of;
+
+} // namespace
+
+TEST(Elementwise, MapHandlesEveryTailLengthWithoutOverrun) {
+  constexpr float kGuard = 12345.0f;
+  for (int64_t count = 0; count <= 100; ++count) {
+    const auto lhs = patterned_values(count, 0.0f);
+    const auto rhs = patterned_values(count, 0.75f);
+    std::vector<float> out(static_cast<std::size_t>(count) + 8, kGuard);
+
+    Tensor::kernels::map_contiguous_serial(
+        count, out.data(), [](auto a, auto b) { return a * b - b; }, lhs.data(), rhs.data());
+
+    for (int64_t index = 0; index < count; ++index) {
+      const auto at = static_cast<std::size_t>(index);
+      ASSERT_FLOAT_EQ(out[at], lhs[at] * rhs[at] - rhs[at]) << "count " << count;
+    }
+    for (std::size_t index = static_cast<std::size_t>(count); index < out.size(); ++index) {
+      ASSERT_EQ(out[index], kGuard) << "count " << count;
+    }
+  }
+}
+
+TEST(Elementwise, MapSupportsInPlaceAliasing) {
+  auto values = patterned_values(1 << 17, 0.0f);
+  const auto expected = values;
+  Tensor::kernels::map_contiguous(
+      static_cast<int64_t>(values.size()), values.data(),
+      [](auto x) { return x + x; }, values.data());
+  for (std::size_t index = 0; index < values.size(); ++index) {
+    ASSERT_EQ(values[index], expected[index] * 2.0f);
+  }
+}
+
+TEST(Elementwise, FillWritesExactRange) {
+  std::vector<float> out(37, -1.0f);
+  Tensor::kernels::fill_contiguous<float>(35, out.data() + 1, 4.5f);
+  EXPECT_EQ(out.front(), -1.0f);
+  EXPECT_EQ(out.back(), -1.0f);
+  for (std::size_t index = 1; index < 36; ++index) {
+    EXPECT_EQ(out[index], 4.5f);
+  }
+}
+
+TEST(Elementwise, OpsMatchScalarReferenceAcrossSizes) {
+  for (const int64_t count : {1, 7, 16, 33, 1000, 70001}) {
+    const auto lhs_values = patterned_values(count, 0.0f);
+    const auto rhs_values = patterned_values(count, 1.25f);
+    const auto lhs = make_tensor({count}, lhs_values);
+    const auto rhs = make_tensor({count}, rhs_values);
+
+    const auto sum = values_of(Tensor::ops::add(lhs, rhs));
+    const auto diff = values_of(Tensor::ops::sub(lhs, rhs));
+    const auto product = values_of(Tensor::ops::mul(lhs, rhs));
+    const auto relu = values_of(Tensor::ops::relu(lhs));
+    const auto clamped = values_of(Tensor::ops::clamp(lhs, -1.0f, 0.5f));
+
+    for (int64_t index = 0; index < count; ++index) {
+      const auto at = static_cast<std::size_t>(index);
+      ASSERT_EQ(sum[at], lhs_values[at] + rhs_values[at]);
+      ASSERT_EQ(diff[at], lhs_values[at] - rhs_values[at]);
+      ASSERT_EQ(product[at], lhs_values[at] * rhs_values[at]);
+      ASSERT_EQ(relu[at], std::max(lhs_values[at], 0.0f));
+      ASSERT_EQ(clamped[at], std::clamp(lhs_values[at], -1.0f, 0.5f));
+    }
+  }
+}
+
+TEST(Elementwise, ReluAndClampPropagateNaNLikeStd) {
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const auto input = make_tensor({3}, {nan, -1.0f, 2.0f});
+  const auto relu = values_of(Tensor::ops::relu(input));
+  const auto clamped = values_of(Tensor::ops::clamp(input, 0.0f, 1.0f));
+  EXPECT_TRUE(std::isnan(relu[0]));
+  EXPECT_TRUE(std::isnan(clamped[0]));
+  EXPECT_EQ(relu[1], 0.0f);
+  EXPECT_EQ(clamped[2], 1.0f);
+}
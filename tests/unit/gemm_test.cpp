@@ -0,0 +1,119 @@
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "tensor/Gemm.hpp"
+
+namespace {
+
+std::vector<float> patterned(int64_t count, int64_t seed) {
+  std::vector<float> values(static_cast<std::size_t>(count));
+  for (int64_t index = 0; index < count; ++index) {
+    values[static_cast<std::size_t>(index)] =
+        static_cast<float>(((index * 7 + seed * 13) % 17) - 8) / 8.0f;
+  }
+  return values;
+}
+
+using Tensor::kernels::Transpose;
+
+// op(A) and op(B) are read through their stored layouts, so `a` holds m x k
+// (or k x m when transposed) and `b` holds k x n (or n x k).
+std::vector<float> reference_gemm(Transpose ta, Transpose tb, int64_t m, int64_t n,
+                                  int64_t k, float alpha, const std::vector<float> &a,
+                                  const std::vector<float> &b, float beta,
+                                  const std::vector<float> &c) {
+  std::vector<float> out(c);
+  for (int64_t row = 0; row < m; ++row) {
+    for (int64_t col = 0; col < n; ++col) {
+      double acc = 0.0;
+      for (int64_t inner = 0; inner < k; ++inner) {
+        const int64_t a_index = ta == Transpose::none ? row * k + inner : inner * m + row;
+        const int64_t b_index = tb == Transpose::none ? inner * n + col : col * k + inner;
+        acc += static_cast<double>(a[static_cast<std::size_t>(a_index)]) *
+               b[static_cast<std::size_t>(b_index)];
+      }
+      const auto index = static_cast<std::size_t>(row * n + col);
+      out[index] = static_cast<float>(alpha * acc + beta * c[index]);
+    }
+  }
+  return out;
+}
+
+void expect_matches_reference(int64_t m, int64_t n, int64_t k, float alpha, float beta,
+                              Transpose ta = Transpose::none,
+                              Transpose tb = Transpose::none) {
+  const auto a = patterned(m * k, 1);
+  const auto b = patterned(k * n, 2);
+  auto c = patterned(m * n, 3);
+  const auto expected = reference_gemm(ta, tb, m, n, k, alpha, a, b, beta, c);
+
+  const int64_t lda = ta == Transpose::none ? k : m;
+  const int64_t ldb = tb == Transpose::none ? n : k;
+  Tensor::kernels::sgemm(ta, tb, m, n, k, alpha, a.data(), lda, b.data(), ldb, beta,
+                         c.data(), n);
+
+  for (std::size_t index = 0; index < c.size(); ++index) {
+    ASSERT_NEAR(c[index], expected[index], 1.0e-3f * (1.0f + std::fabs(expected[index])))
+        << "m=" << m << " n=" << n << " k=" << k << " index=" << index;
+  }
+}
+
+} // namespace
+
+TEST(Gemm, MatchesReferenceAcrossTileEdges) {
+  const int64_t sizes[] = {1, 2, 5, 6, 7, 13, 16, 17, 33, 64, 100};
+  for (const int64_t m : sizes) {
+    for (const int64_t n : sizes) {
+      for (const int64_t k : {1, 3, 31}) {
+        expect_matches_reference(m, n, k, 1.0f, 0.0f);
+      }
+    }
+  }
+}
+
+TEST(Gemm, AccumulatesAcrossDeepInnerDimension) {
+  expect_matches_reference(37, 45, 1500, 1.0f, 0.0f);
+  expect_matches_reference(1, 300, 1500, 1.0f, 0.0f);
+  expect_matches_reference(300, 1, 1500, 1.0f, 0.0f);
+}
+
+TEST(Gemm, AppliesAlphaAndBeta) {
+  expect_matches_reference(19, 23, 29, 0.5f, 2.0f);
+  expect_matches_reference(1, 23, 29, -1.0f, 1.0f);
+  expect_matches_reference(19, 1, 29, 2.0f, -0.5f);
+}
+
+TEST(Gemm, TransposedOperandsMatchReference) {
+  for (const auto ta : {Transpose::none, Transpose::trans}) {
+    for (const auto tb : {Transpose::none, Transpose::trans}) {
+      for (const int64_t m : {1, 7, 40}) {
+        for (const int64_t n : {1, 9, 35}) {
+          expect_matches_reference(m, n, 300, 1.0f, 0.0f, ta, tb);
+          expect_matches_reference(m, n, 5, 0.5f, 1.0f, ta, tb);
+        }
+      }
+    }
+  }
+}
+
+TEST(Gemm, BetaZeroIgnoresGarbageInOutput) {
+  const auto a = patterned(8 * 4, 1);
+  const auto b = patterned(4 * 9, 2);
+  std::vector<float> c(8 * 9, std::nanf(""));
+
+  Tensor::kernels::sgemm(Transpose::none, Transpose::none, 8, 9, 4, 1.0f, a.data(), 4,
+                         b.data(), 9, 0.0f, c.data(), 9);
+
+  for (const float value : c) {
+    EXPECT_FALSE(std::isnan(value));
+  }
+}
+
+TEST(Gemm, ReportsSelectedKernel) {
+  const std::string name = Tensor::kernels::sgemm_kernel_name();
+  EXPECT_TRUE(name == "avx512" || name == "avx2" || name == "scalar");
+}
@@ -0,0 +1,104 @@
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "api/Api.hpp"
+#include "tensor/Autograd.hpp"
+#include "tensor/Linear.hpp"
+#include "tensor/Ops.hpp"
+
+#include "TestUtil.hpp"
+
+namespace {
+
+using tensor_test::values_of;
+
+Tensor::DTensor ramp(const std::vector<int64_t> &shape, bool requires_grad = false) {
+  return tensor_test::sawtooth(shape, {.period = 11, .scale = 4.0}, Tensor::DType::f32,
+                               requires_grad);
+}
+
+} // namespace
+
+TEST(InferenceMode, GuardIsScopedAndThreadLocal) {
+  EXPECT_FALSE(Tensor::inference_mode_enabled());
+  {
+    Tensor::InferenceMode inference;
+    EXPECT_TRUE(Tensor::inference_mode_enabled());
+    EXPECT_FALSE(Tensor::grad_mode_enabled());
+    {
+      Tensor::InferenceMode inner;
+    }
+    EXPECT_TRUE(Tensor::inference_mode_enabled());
+    bool other_thread = true;
+    std::thread([&] { other_thread = Tensor::inference_mode_enabled(); }).join();
+    EXPECT_FALSE(other_thread);
+  }
+  EXPECT_FALSE(Tensor::inference_mode_enabled());
+  EXPECT_TRUE(Tensor::grad_mode_enabled());
+}
+
+TEST(InferenceMode, ResultsCarryNoAutogradState) {
+  Tensor::nn::Linear linear(6, 4);
+  const auto input = ramp({3, 6});
+  const auto expected = linear.forward(input, Tensor::ops::Activation::relu());
+  ASSERT_NE(expected.autograd_state(), nullptr);
+
+  Tensor::InferenceMode inference;
+  const auto output = linear.forward(input, Tensor::ops::Activation::relu());
+  EXPECT_TRUE(output.is_inference());
+  EXPECT_EQ(output.autograd_state(), nullptr);
+  EXPECT_FALSE(output.requires_grad());
+  EXPECT_TRUE(output.is_leaf());
+  EXPECT_EQ(values_of(output), values_of(expected));
+
+  const auto view = Tensor::api::permute(output, {1, 0});
+  EXPECT_TRUE(view.is_inference());
+  EXPECT_EQ(view.autograd_state(), nullptr);
+  EXPECT_FALSE(input.is_inference());
+  EXPECT_FALSE(linear.weight().is_inference());
+}
+
+TEST(InferenceMode, TensorsAskedToRequireGradKeepTheirState) {
+  Tensor::DTensor weight;
+  {
+    Tensor::InferenceMode inference;
+    weight = ramp({2, 2}, true);
+  }
+  EXPECT_TRUE(weight.is_inference());
+  ASSERT_NE(weight.autograd_state(), nullptr);
+  Tensor::ops::backward(Tensor::ops::sum(Tensor::ops::mul(weight, weight)));
+  EXPECT_EQ(values_of(*weight.grad()), values_of(Tensor::ops::add(weight, weight)));
+}
+
+TEST(InferenceMode, InferenceTensorsFeedRecordedOps) {
+  auto weight = ramp({4, 3}, true);
+  Tensor::DTensor features;
+  {
+    Tensor::InferenceMode inference;
+    features = Tensor::ops::relu(ramp({2, 4}));
+  }
+  const auto loss = Tensor::ops::sum(Tensor::ops::matmul(features, weight));
+  Tensor::ops::backward(loss);
+  ASSERT_TRUE(weight.grad());
+  EXPECT_FALSE(features.grad());
+}
+
+TEST(InferenceMode, RecordingInPlaceOnAnInferenceTensorThrows) {
+  auto weight = ramp({3}, true);
+  Tensor::DTensor buffer;
+  {
+    Tensor::InferenceMode inference;
+    buffer = ramp({3});
+    // Nothing records inside the scope, so in-place updates are allowed.
+    EXPECT_NO_THROW(Tensor::ops::add_(buffer, weight));
+  }
+  EXPECT_THROW(Tensor::ops::add_(buffer, weight), std::runtime_error);
+  EXPECT_NO_THROW(Tensor::ops::relu_(buffer));
+  {
+    Tensor::NoGradGuard no_grad;
+    EXPECT_NO_THROW(Tensor::ops::add_(buffer, weight));
+  }
+}
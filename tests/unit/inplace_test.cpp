@@ -0,0 +1,189 @@
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "api/Api.hpp"
+#include "tensor/Linear.hpp"
+#include "tensor/Ops.hpp"
+#include "tensor/Optim.hpp"
+
+#include "TestUtil.hpp"
+
+namespace {
+
+using tensor_test::make_tensor;
+using tensor_test::values_of;
+
+} // namespace
+
+TEST(InPlace, OpsOverwriteSelfAndBumpTheVersion) {
+  auto tensor = make_tensor({2, 3}, {-1, 2, -3, 4, -5, 6});
+  const auto row = make_tensor({3}, {1, 1, 2});
+  const void *data = tensor.data();
+  const auto version = tensor.version();
+
+  Tensor::ops::add_(tensor, row);
+  EXPECT_EQ(values_of(tensor), (std::vector<float>{0, 3, -1, 5, -4, 8}));
+  Tensor::ops::mul_(tensor, row);
+  EXPECT_EQ(values_of(tensor), (std::vector<float>{0, 3, -2, 5, -4, 16}));
+  Tensor::ops::relu_(tensor);
+  EXPECT_EQ(values_of(tensor), (std::vector<float>{0, 3, 0, 5, 0, 16}));
+  Tensor::ops::clamp_(tensor, 1.0, 4.0);
+  EXPECT_EQ(values_of(tensor), (std::vector<float>{1, 3, 1, 4, 1, 4}));
+
+  EXPECT_EQ(tensor.data(), data);
+  EXPECT_EQ(tensor.version(), version + 4);
+  auto small = make_tensor({3}, {1, 2, 3});
+  EXPECT_THROW(Tensor::ops::add_(small, tensor), std::invalid_argument);
+}
+
+TEST(InPlace, OutVariantsReusePreallocatedBuffers) {
+  const auto lhs = make_tensor({2, 2}, {1, 2, 3, 4});
+  const auto rhs = make_tensor({2, 2}, {5, 6, 7, 8});
+  auto out = Tensor::api::empty({2, 2}, Tensor::DType::f32);
+  const void *data = out.data();
+
+  Tensor::ops::matmul_out(lhs, rhs, out);
+  EXPECT_EQ(values_of(out), (std::vector<float>{19, 22, 43, 50}));
+  Tensor::ops::add_out(lhs, make_tensor({2}, {10, 20}), out);
+  EXPECT_EQ(values_of(out), (std::vector<float>{11, 22, 13, 24}));
+  Tensor::ops::relu_out(make_tensor({2, 2}, {-1, 2, -3, 4}), out);
+  EXPECT_EQ(values_of(out), (std::vector<float>{0, 2, 0, 4}));
+  EXPECT_EQ(out.data(), data);
+
+  auto wrong_shape = Tensor::api::empty({2, 3}, Tensor::DType::f32);
+  EXPECT_THROW(Tensor::ops::matmul_out(lhs, rhs, wrong_shape), std::invalid_argument);
+  auto aliased = lhs;
+  EXPECT_THROW(Tensor::ops::matmul_out(lhs, rhs, aliased), std::invalid_argument);
+  const auto tracked = make_tensor({2, 2}, {1, 1, 1, 1}, true);
+  EXPECT_THROW(Tensor::ops::add_out(tracked, rhs, out), std::invalid_argument);
+  EXPECT_THROW(Tensor::ops::relu_out(tracked, out), std::invalid_argument);
+
+  // `out` itself may carry neither a trainable leaf nor recorded history.
+  auto trainable = make_tensor({2, 2}, {1, 1, 1, 1}, true);
+  EXPECT_THROW(Tensor::ops::relu_out(lhs, trainable), std::invalid_argument);
+  EXPECT_THROW(Tensor::ops::add_out(lhs, rhs, trainable), std::invalid_argument);
+  auto recorded = Tensor::ops::mul(trainable, trainable);
+  EXPECT_THROW(Tensor::ops::add_out(lhs, rhs, recorded), std::invalid_argument);
+  EXPECT_THROW(Tensor::ops::matmul_out(lhs, rhs, recorded), std::invalid_argument);
+  EXPECT_FALSE(trainable.grad());
+}
+
+TEST(InPlace, GradientsFlowThroughInPlaceOps) {
+  auto input = make_tensor({4}, {-1, 2, -3, 4}, true);
+  auto weight = make_tensor({4}, {3, 3, 3, 3}, true);
+  const auto offset = make_tensor({4}, {0.5f, 0.5f, 0.5f, 0.5f});
+
+  // hidden = relu((input + 0.5) * weight), built with in-place steps.
+  auto hidden = Tensor::ops::add(input, offset);
+  Tensor::ops::mul_(hidden, weight);
+  Tensor::ops::relu_(hidden);
+  Tensor::ops::backward(Tensor::ops::sum(hidden));
+
+  ASSERT_TRUE(input.grad());
+  ASSERT_TRUE(weight.grad());
+  EXPECT_EQ(values_of(*input.grad()), (std::vector<float>{0, 3, 0, 3}));
+  EXPECT_EQ(values_of(*weight.grad()), (std::vector<float>{0, 2.5f, 0, 4.5f}));
+}
+
+TEST(InPlace, EarlierConsumersKeepTheirHistory) {
+  const auto input = make_tensor({3}, {-1, 2, 3}, true);
+  const auto other = make_tensor({3}, {4, 5, 6}, true);
+  auto hidden = Tensor::ops::mul(input, make_tensor({3}, {2, 2, 2}));
+  const auto consumer = Tensor::ops::relu(hidden);
+  Tensor::ops::add_(hidden, other);
+  Tensor::ops::backward(Tensor::ops::sum(consumer));
+
+  // relu read `hidden` before add_, so nothing reaches `other`.
+  ASSERT_TRUE(input.grad());
+  EXPECT_EQ(values_of(*input.grad()), (std::vector<float>{0, 2, 2}));
+  EXPECT_FALSE(other.grad());
+}
+
+TEST(InPlace, OtherHandlesToTheTargetCannotRecord) {
+  const auto input = make_tensor({3}, {-1, 2, 3}, true);
+  auto hidden = Tensor::ops::mul(input, make_tensor({3}, {1, 1, 1}));
+  const auto alias = hidden;
+  const auto view = Tensor::api::reshape(hidden, {1, 3});
+  Tensor::ops::relu_(hidden);
+
+  // Both read the rectified values but still hold the history from before relu_.
+  EXPECT_EQ(values_of(alias), (std::vector<float>{0, 2, 3}));
+  EXPECT_THROW(Tensor::ops::sum(alias), std::runtime_error);
+  EXPECT_THROW(Tensor::ops::mul(view, view), std::runtime_error);
+
+  auto total = Tensor::ops::sum(hidden);
+  const auto total_alias = total;
+  Tensor::ops::mul_(total, make_tensor({1}, {2}));
+  EXPECT_THROW(Tensor::ops::backward(total_alias), std::runtime_error);
+  Tensor::ops::backward(total);
+  ASSERT_TRUE(input.grad());
+  EXPECT_EQ(values_of(*input.grad()), (std::vector<float>{0, 2, 2}));
+}
+
+TEST(InPlace, PlainTargetsJoinTheHistoryOfTheirOperand) {
+  auto target = make_tensor({3}, {1, 2, 3});
+  const auto other = make_tensor({3}, {4, 5, 6}, true);
+  Tensor::ops::add_(target, other);
+  Tensor::ops::backward(Tensor::ops::sum(target));
+
+  ASSERT_TRUE(other.grad());
+  EXPECT_EQ(values_of(*other.grad()), (std::vector<float>{1, 1, 1}));
+}
+
+TEST(InPlace, MaskedOpsSurviveWritesToTheirInput) {
+  const auto input = make_tensor({3}, {-1, 2, 3}, true);
+  const auto other = make_tensor({3}, {4, 5, 6}, true);
+  auto hidden = Tensor::ops::mul(input, make_tensor({3}, {2, 2, 2}));
+  const auto rectified = Tensor::ops::relu(hidden);
+  const auto clamped = Tensor::ops::clamp(hidden, 0.0, 5.0);
+  const auto largest = Tensor::ops::max(hidden, {0}, false);
+  Tensor::ops::add_(hidden, other);
+
+  // The masks were taken from the outputs, so the write to `hidden` does not
+  // change what reaches `input`.
+  Tensor::ops::backward(Tensor::ops::sum(rectified));
+  EXPECT_EQ(values_of(*input.grad()), (std::vector<float>{0, 2, 2}));
+  Tensor::ops::backward(Tensor::ops::sum(clamped));
+  EXPECT_EQ(values_of(*input.grad()), (std::vector<float>{0, 4, 2}));
+  Tensor::ops::backward(largest);
+  EXPECT_EQ(values_of(*input.grad()), (std::vector<float>{0, 4, 4}));
+  EXPECT_FALSE(other.grad());
+
+  const auto leaf = make_tensor({1, 2}, {1, 2}, true);
+  const auto weight = make_tensor({2, 2}, {1, -1, 1, -1});
+  auto features = Tensor::ops::mul(leaf, make_tensor({1, 2}, {1, 1}));
+  const auto activated = Tensor::ops::linear(features, weight, {}, Tensor::ops::Activation::relu());
+  Tensor::ops::relu_(features);
+  Tensor::ops::backward(Tensor::ops::sum(activated));
+  ASSERT_TRUE(leaf.grad());
+  EXPECT_EQ(values_of(*leaf.grad()), (std::vector<float>{1, 1}));
+}
+
+TEST(InPlace, LeavesThatRequireGradAreProtected) {
+  auto leaf = make_tensor({2}, {1, 2}, true);
+  EXPECT_THROW(Tensor::ops::relu_(leaf), std::invalid_argument);
+  EXPECT_THROW(Tensor::ops::add_(leaf, make_tensor({2}, {1, 1})), std::invalid_argument);
+}
+
+TEST(InPlace, ModifyingASavedTensorFailsBackward) {
+  auto input = make_tensor({3}, {-1, 2, 3}, true);
+  auto hidden = Tensor::ops::add(input, make_tensor({3}, {0, 0, 0}));
+  const auto scaled = Tensor::ops::mul(hidden, make_tensor({3}, {1, 2, 3}, true));
+  Tensor::ops::add_(hidden, make_tensor({3}, {5, 5, 5}));
+  EXPECT_THROW(Tensor::ops::backward(Tensor::ops::sum(scaled)), std::runtime_error);
+}
+
+TEST(InPlace, OptimizerStepInvalidatesTheOldGraph) {
+  Tensor::nn::Linear layer(2, 2);
+  Tensor::nn::SGD optimizer(0.1f);
+  const auto input = make_tensor({1, 2}, {1, 2}, true);
+  const auto first = Tensor::ops::sum(layer.forward(input));
+  const auto second = Tensor::ops::sum(layer.forward(input));
+  Tensor::ops::backward(first);
+  optimizer.step(layer.parameters());
+  // `second` saved the weight before the update, and its input gradient would
+  // be computed from the new values.
+  EXPECT_THROW(Tensor::ops::backward(second), std::runtime_error);
+}
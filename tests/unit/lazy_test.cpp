@@ -0,0 +1,220 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "api/Api.hpp"
+#include "tensor/Autograd.hpp"
+#include "tensor/Lazy.hpp"
+#include "tensor/Ops.hpp"
+
+#include "TestUtil.hpp"
+
+namespace {
+
+Tensor::DTensor ramp(const std::vector<int64_t> &shape, Tensor::DType dtype, int shift,
+                     bool requires_grad = false) {
+  return tensor_test::sawtooth(
+      shape, {.step = 7, .shift = shift, .period = 23, .scale = 8.0, .bias = 1.25}, dtype,
+      requires_grad);
+}
+
+bool same_bits(const Tensor::DTensor &lhs, const Tensor::DTensor &rhs) {
+  const auto bytes = static_cast<std::size_t>(lhs.numel()) * Tensor::dtype_size(lhs.dtype());
+  return lhs.numel() == rhs.numel() && std::memcmp(lhs.data(), rhs.data(), bytes) == 0;
+}
+
+// mse as separate ops, which lazy mode fuses into one region.
+Tensor::DTensor mse_of(const Tensor::DTensor &prediction, const Tensor::DTensor &target) {
+  const auto diff = Tensor::ops::sub(prediction, target);
+  return Tensor::ops::mean(Tensor::ops::mul(diff, diff));
+}
+
+// Adds a relu/clamp branch so every fused op shows up in backward. The target
+// is reached along three paths whose gradients the fused pass sums in its own
+// order, so its gradient matches eager only up to rounding.
+Tensor::DTensor branchy_of(const Tensor::DTensor &prediction, const Tensor::DTensor &target) {
+  using namespace Tensor::ops;
+  const auto branch = sum(mul(relu(add(prediction, target)), clamp(target, -0.5, 0.75)));
+  return add(mse_of(prediction, target), branch);
+}
+
+struct Run {
+  Tensor::DTensor loss;
+  Tensor::DTensor prediction;
+  Tensor::DTensor target;
+};
+
+template <typename T, typename Loss>
+Run run(const Loss &loss_fn, Tensor::DType dtype, int64_t rows, bool lazy_mode) {
+  const std::vector<int64_t> shape{rows, 33};
+  Run result{{}, ramp(shape, dtype, 0, true), ramp(shape, dtype, 5, true)};
+  {
+    std::optional<Tensor::LazyGuard> lazy;
+    if (lazy_mode) {
+      lazy.emplace();
+    }
+    result.loss = loss_fn(result.prediction, result.target);
+  }
+  Tensor::ops::backward(result.loss);
+  return result;
+}
+
+template <typename T> void expect_near(const Tensor::DTensor &lhs, const Tensor::DTensor &rhs) {
+  const auto *a = static_cast<const T *>(lhs.data());
+  const auto *b = static_cast<const T *>(rhs.data());
+  for (int64_t index = 0; index < lhs.numel(); ++index) {
+    EXPECT_NEAR(a[index], b[index], 1e-5 * (1.0 + std::abs(a[index])));
+  }
+}
+
+template <typename T> void expect_matches_eager(Tensor::DType dtype, int64_t rows) {
+  const Run eager = run<T>(mse_of, dtype, rows, false);
+  const Run fused = run<T>(mse_of, dtype, rows, true);
+  EXPECT_TRUE(same_bits(eager.loss, fused.loss));
+  EXPECT_TRUE(same_bits(*eager.prediction.grad(), *fused.prediction.grad()));
+  EXPECT_TRUE(same_bits(*eager.target.grad(), *fused.target.grad()));
+
+  const Run eager_branchy = run<T>(branchy_of, dtype, rows, false);
+  const Run fused_branchy = run<T>(branchy_of, dtype, rows, true);
+  EXPECT_TRUE(same_bits(eager_branchy.loss, fused_branchy.loss));
+  EXPECT_TRUE(same_bits(*eager_branchy.prediction.grad(), *fused_branchy.prediction.grad()));
+  expect_near<T>(*eager_branchy.target.grad(), *fused_branchy.target.grad());
+}
+
+TEST(Lazy, FusedLossAndGradsMatchEager) {
+  // One block, a partial block, and several reduction chunks.
+  for (const int64_t rows : {1, 9, 4000}) {
+    expect_matches_eager<float>(Tensor::DType::f32, rows);
+    expect_matches_eager<double>(Tensor::DType::f64, rows);
+  }
+}
+
+TEST(Lazy, ResultsArePendingUntilRead) {
+  const auto lhs = ramp({64}, Tensor::DType::f32, 0);
+  const auto rhs = ramp({64}, Tensor::DType::f32, 3);
+  Tensor::LazyGuard lazy;
+  const auto total = Tensor::ops::add(lhs, rhs);
+  const auto squared = Tensor::ops::relu(Tensor::ops::mul(total, total));
+  EXPECT_TRUE(Tensor::is_pending(total));
+  EXPECT_TRUE(Tensor::is_pending(squared));
+
+  const auto *values = static_cast<const float *>(squared.data());
+  EXPECT_FALSE(Tensor::is_pending(squared));
+  // `total` was inlined into `squared`, so reading it computed nothing else.
+  EXPECT_TRUE(Tensor::is_pending(total));
+  const auto *a = static_cast<const float *>(lhs.data());
+  const auto *b = static_cast<const float *>(rhs.data());
+  for (int64_t index = 0; index < 64; ++index) {
+    const float sum = a[index] + b[index];
+    EXPECT_EQ(values[index], sum * sum);
+  }
+}
+
+TEST(Lazy, LeavesAfterComputedOperandsCompile) {
+  const auto a = ramp({40}, Tensor::DType::f32, 0);
+  const auto b = ramp({40}, Tensor::DType::f32, 3);
+  const auto c = ramp({40}, Tensor::DType::f32, 6);
+  Tensor::LazyGuard lazy;
+  const auto result = Tensor::ops::mul(Tensor::ops::add(a, b), c);
+  const auto *values = static_cast<const float *>(result.data());
+  const auto *pa = static_cast<const float *>(a.data());
+  const auto *pb = static_cast<const float *>(b.data());
+  const auto *pc = static_cast<const float *>(c.data());
+  for (int64_t index = 0; index < 40; ++index) {
+    EXPECT_EQ(values[index], (pa[index] + pb[index]) * pc[index]);
+  }
+}
+
+TEST(Lazy, NoGradAliasesKeepTheirOwnEdge) {
+  auto input = ramp({24}, Tensor::DType::f32, 0, true);
+  Tensor::DTensor alias;
+  {
+    Tensor::NoGradGuard no_grad;
+    alias = Tensor::ops::reshape(input, input.shape());
+  }
+  {
+    Tensor::LazyGuard lazy;
+    Tensor::ops::backward(Tensor::ops::sum(Tensor::ops::mul(input, alias)));
+  }
+  ASSERT_TRUE(input.grad());
+  const auto *grad = static_cast<const float *>(input.grad()->data());
+  const auto *values = static_cast<const float *>(input.data());
+  for (int64_t index = 0; index < 24; ++index) {
+    EXPECT_EQ(grad[index], values[index]);
+  }
+}
+
+TEST(Lazy, NoGradResultsAreNotInlined) {
+  const auto input = tensor_test::make_tensor({3}, {1, 2, 3}, true);
+  const auto weight = tensor_test::make_tensor({3}, {4, 5, 6}, true);
+  const auto other = tensor_test::make_tensor({3}, {1, 1, 1}, true);
+  Tensor::LazyGuard lazy;
+  Tensor::DTensor product;
+  {
+    Tensor::NoGradGuard no_grad;
+    product = Tensor::ops::mul(input, weight);
+  }
+  Tensor::ops::backward(Tensor::ops::sum(Tensor::ops::mul(product, other)));
+
+  // `product` was computed without history, so it is a constant here.
+  EXPECT_FALSE(input.grad());
+  EXPECT_FALSE(weight.grad());
+  ASSERT_TRUE(other.grad());
+  EXPECT_EQ(tensor_test::values_of(*other.grad()), (std::vector<float>{4, 10, 18}));
+}
+
+TEST(Lazy, FusedRegionIsOneAutogradNode) {
+  auto prediction = ramp({16, 8}, Tensor::DType::f32, 0, true);
+  const auto target = ramp({16, 8}, Tensor::DType::f32, 2);
+  Tensor::LazyGuard lazy;
+  const auto loss = mse_of(prediction, target);
+  const auto node = loss.autograd_state()->grad_fn;
+  ASSERT_NE(node, nullptr);
+  ASSERT_EQ(node->num_inputs(), 2U);
+  EXPECT_EQ(node->input(0), prediction.autograd_state());
+  EXPECT_FALSE(Tensor::edge_requires_grad(node->input(1)));
+}
+
+TEST(Lazy, IneligibleOperandsRunEagerly) {
+  const auto matrix = ramp({4, 8}, Tensor::DType::f32, 0);
+  const auto row = ramp({1, 8}, Tensor::DType::f32, 1);
+  const auto wide = ramp({4, 8}, Tensor::DType::f64, 1);
+  Tensor::LazyGuard lazy;
+  EXPECT_FALSE(Tensor::is_pending(Tensor::ops::add(matrix, row)));
+  EXPECT_THROW(Tensor::ops::add(matrix, wide), std::invalid_argument);
+  // A reduction of a materialized tensor is a single read already.
+  EXPECT_FALSE(Tensor::is_pending(Tensor::ops::sum(matrix)));
+  EXPECT_TRUE(Tensor::is_pending(Tensor::ops::sum(Tensor::ops::relu(matrix))));
+}
+
+TEST(Lazy, ModifyingAnInputBeforeTheReadThrows) {
+  auto input = ramp({32}, Tensor::DType::f32, 0);
+  const auto other = ramp({32}, Tensor::DType::f32, 1);
+  Tensor::DTensor result;
+  {
+    Tensor::LazyGuard lazy;
+    result = Tensor::ops::mul(input, other);
+  }
+  Tensor::ops::add_(input, other);
+  EXPECT_THROW(result.data(), std::runtime_error);
+}
+
+TEST(Lazy, GuardIsScopedAndThreadLocal) {
+  EXPECT_FALSE(Tensor::lazy_mode_enabled());
+  {
+    Tensor::LazyGuard outer;
+    EXPECT_TRUE(Tensor::lazy_mode_enabled());
+    {
+      Tensor::LazyGuard inner;
+    }
+    EXPECT_TRUE(Tensor::lazy_mode_enabled());
+  }
+  EXPECT_FALSE(Tensor::lazy_mode_enabled());
+}
+
+} // namespace
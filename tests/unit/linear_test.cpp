@@ -1,10 +1,14 @@
 #include <algorithm>
+#include <stdexcept>
 #include <vector>
 
 #include <gtest/gtest.h>
 
 #include "api/Api.hpp"
 #include "tensor/Linear.hpp"
+#include "tensor/Optim.hpp"
+
+#include "TestUtil.hpp"
 
 namespace {
 
@@ -15,6 +19,31 @@ Tensor::DTensor dataset_tensor(const std::vector<int64_t> &shape,
   return tensor;
 }
 
+Tensor::DTensor patterned(const std::vector<int64_t> &shape, Tensor::DType dtype,
+                          int64_t seed, bool requires_grad = false) {
+  return tensor_test::sawtooth(shape, {.step = 7, .shift = seed * 13, .scale = 16.0, .bias = 0.5},
+                               dtype, requires_grad);
+}
+
+std::vector<unsigned char> bytes_of(const Tensor::DTensor &tensor) {
+  const auto *ptr = static_cast<const unsigned char *>(tensor.data());
+  return std::vector<unsigned char>(
+      ptr, ptr + tensor.numel() * static_cast<int64_t>(Tensor::dtype_size(tensor.dtype())));
+}
+
+Tensor::DTensor unfused(const Tensor::DTensor &input, const Tensor::DTensor &weight,
+                        const Tensor::DTensor &bias, Tensor::ops::Activation activation) {
+  auto value = Tensor::ops::bias_add(Tensor::ops::matmul(input, weight), bias);
+  switch (activation.kind) {
+  case Tensor::ops::ActivationKind::relu:
+    return Tensor::ops::relu(value);
+  case Tensor::ops::ActivationKind::clamp:
+    return Tensor::ops::clamp(value, activation.min_value, activation.max_value);
+  default:
+    return value;
+  }
+}
+
 float scalar_value(const Tensor::DTensor &tensor) {
   return static_cast<const float *>(tensor.data())[0];
 }
@@ -76,3 +105,52 @@ TEST(Linear, LearnsSimpleAffineMapping) {
   EXPECT_NEAR(pred_ptr[0], -5.0f, 0.25f);
   EXPECT_NEAR(pred_ptr[3], 3.0f, 0.25f);
 }
+
+TEST(Linear, FusedEpilogueMatchesUnfusedOpsBitForBit) {
+  const std::vector<Tensor::ops::Activation> activations{
+      Tensor::ops::Activation::identity(), Tensor::ops::Activation::relu(),
+      Tensor::ops::Activation::clamp(-0.25, 0.5)};
+  // Batch 1 takes the GEMV path, odd sizes leave partial tiles, and the deep
+  // case spans several packed K blocks.
+  const std::vector<std::vector<int64_t>> shapes{{1, 96, 40}, {37, 65, 70}, {30, 1100, 50}};
+  for (const auto dtype : {Tensor::DType::f32, Tensor::DType::f64}) {
+    for (const auto &shape : shapes) {
+      for (const auto activation : activations) {
+        const auto input = patterned({shape[0], shape[1]}, dtype, 1, true);
+        const auto weight = patterned({shape[1], shape[2]}, dtype, 2, true);
+        const auto bias = patterned({shape[2]}, dtype, 3, true);
+        const auto scale = patterned({shape[0], shape[2]}, dtype, 4);
+
+        const auto expected = unfused(input, weight, bias, activation);
+        Tensor::ops::backward(Tensor::ops::sum(Tensor::ops::mul(expected, scale)));
+        const auto input_grad = bytes_of(*input.grad());
+        const auto weight_grad = bytes_of(*weight.grad());
+        const auto bias_grad = bytes_of(*bias.grad());
+        for (auto tensor : {input, weight, bias}) {
+          tensor.zero_grad();
+        }
+
+        const auto fused = Tensor::ops::linear(input, weight, bias, activation);
+        EXPECT_EQ(bytes_of(fused), bytes_of(expected));
+        Tensor::ops::backward(Tensor::ops::sum(Tensor::ops::mul(fused, scale)));
+        EXPECT_EQ(bytes_of(*input.grad()), input_grad);
+        EXPECT_EQ(bytes_of(*weight.grad()), weight_grad);
+        EXPECT_EQ(bytes_of(*bias.grad()), bias_grad);
+      }
+    }
+  }
+}
+
+TEST(Linear, FusedForwardRecordsOneNodeAndAcceptsNoBias) {
+  const auto input = patterned({4, 3}, Tensor::DType::f32, 1);
+  const auto weight = patterned({3, 5}, Tensor::DType::f32, 2, true);
+  const auto output = Tensor::ops::linear(input, weight, {}, Tensor::ops::Activation::relu());
+  EXPECT_EQ(output.shape(), (std::vector<int64_t>{4, 5}));
+  ASSERT_NE(output.grad_fn(), nullptr);
+  EXPECT_EQ(output.grad_fn()->num_inputs(), 3u);
+
+  const auto expected = Tensor::ops::relu(Tensor::ops::matmul(input, weight));
+  EXPECT_EQ(bytes_of(output), bytes_of(expected));
+  EXPECT_THROW(Tensor::ops::linear(input, weight, patterned({4}, Tensor::DType::f32, 3)),
+               std::invalid_argument);
+}
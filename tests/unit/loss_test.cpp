@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "api/Api.hpp"
+#include "tensor/Ops.hpp"
+
+#include "TestUtil.hpp"
+
+namespace {
+
+using LossFn = std::function<Tensor::DTensor(const Tensor::DTensor &, const Tensor::DTensor &)>;
+
+// Reference loss and derivative in d = prediction - target.
+struct Reference {
+  std::function<double(double)> value;
+  std::function<double(double)> slope;
+};
+
+constexpr double kDelta = 0.6;
+
+const Reference kMse{[](double d) { return d * d; }, [](double d) { return 2.0 * d; }};
+const Reference kL1{[](double d) { return std::abs(d); },
+                    [](double d) { return d > 0.0 ? 1.0 : (d < 0.0 ? -1.0 : 0.0); }};
+const Reference kHuber{
+    [](double d) {
+      return std::abs(d) <= kDelta ? 0.5 * d * d : kDelta * (std::abs(d) - 0.5 * kDelta);
+    },
+    [](double d) { return std::clamp(d, -kDelta, kDelta); }};
+
+Tensor::DTensor ramp(const std::vector<int64_t> &shape, Tensor::DType dtype, int shift,
+                     bool requires_grad = false) {
+  return tensor_test::sawtooth(
+      shape, {.step = 5, .shift = shift, .period = 19, .scale = 4.0, .bias = 2.0}, dtype,
+      requires_grad);
+}
+
+template <typename T>
+void expect_matches_reference(const LossFn &loss_fn, const Reference &reference,
+                              Tensor::DType dtype, int64_t count, double tolerance) {
+  auto prediction = ramp({count}, dtype, 0, true);
+  auto target = ramp({count}, dtype, 7, true);
+  const auto loss = loss_fn(prediction, target);
+  Tensor::ops::backward(loss);
+
+  const auto *p = static_cast<const T *>(prediction.data());
+  const auto *t = static_cast<const T *>(target.data());
+  const auto *p_grad = static_cast<const T *>(prediction.grad()->data());
+  const auto *t_grad = static_cast<const T *>(target.grad()->data());
+  double expected = 0.0;
+  for (int64_t index = 0; index < count; ++index) {
+    const double d = static_cast<double>(p[index]) - static_cast<double>(t[index]);
+    expected += reference.value(d);
+    const double slope = reference.slope(d) / static_cast<double>(count);
+    EXPECT_NEAR(p_grad[index], slope, tolerance * (1.0 + std::abs(slope)));
+    EXPECT_NEAR(t_grad[index], -slope, tolerance * (1.0 + std::abs(slope)));
+  }
+  expected /= static_cast<double>(count);
+  EXPECT_NEAR(static_cast<const T *>(loss.data())[0], expected,
+              tolerance * (1.0 + std::abs(expected)));
+}
+
+template <typename T> void expect_all_losses(Tensor::DType dtype, double tolerance) {
+  const LossFn huber = [](const Tensor::DTensor &p, const Tensor::DTensor &t) {
+    return Tensor::ops::huber_loss(p, t, kDelta);
+  };
+  // A partial vector, and several reduction chunks with a tail.
+  for (const int64_t count : {int64_t{5}, int64_t{100003}}) {
+    expect_matches_reference<T>(Tensor::ops::mse_loss, kMse, dtype, count, tolerance);
+    expect_matches_reference<T>(Tensor::ops::l1_loss, kL1, dtype, count, tolerance);
+    expect_matches_reference<T>(huber, kHuber, dtype, count, tolerance);
+  }
+}
+
+} // namespace
+
+TEST(Loss, ValuesAndGradientsMatchReference) {
+  expect_all_losses<float>(Tensor::DType::f32, 1e-4);
+  expect_all_losses<double>(Tensor::DType::f64, 1e-12);
+}
+
+TEST(Loss, MseMatchesTheComposedOps) {
+  auto prediction = ramp({64, 33}, Tensor::DType::f32, 0, true);
+  const auto target = ramp({64, 33}, Tensor::DType::f32, 3);
+  const auto fused = Tensor::ops::mse_loss(prediction, target);
+  const auto diff = Tensor::ops::sub(prediction, target);
+  const auto composed = Tensor::ops::mean(Tensor::ops::mul(diff, diff));
+  EXPECT_NEAR(static_cast<const float *>(fused.data())[0],
+              static_cast<const float *>(composed.data())[0], 1e-5);
+}
+
+TEST(Loss, RecordsOneNodeOverBothInputs) {
+  auto prediction = ramp({8, 4}, Tensor::DType::f32, 0, true);
+  const auto target = ramp({8, 4}, Tensor::DType::f32, 1);
+  const auto loss = Tensor::ops::l1_loss(prediction, target);
+  const auto node = loss.autograd_state()->grad_fn;
+  ASSERT_NE(node, nullptr);
+  ASSERT_EQ(node->num_inputs(), 2U);
+  EXPECT_EQ(node->input(0), prediction.autograd_state());
+  EXPECT_FALSE(Tensor::edge_requires_grad(node->input(1)));
+
+  Tensor::ops::backward(loss);
+  EXPECT_FALSE(target.grad());
+}
+
+TEST(Loss, ReadsStridedOperands) {
+  auto base = ramp({6, 9}, Tensor::DType::f32, 0, true);
+  const auto prediction = Tensor::api::permute(base, {1, 0});
+  const auto target = ramp({9, 6}, Tensor::DType::f32, 4);
+  const auto dense_prediction = Tensor::ops::clone(prediction);
+  const auto strided = Tensor::ops::huber_loss(prediction, target);
+  const auto dense = Tensor::ops::huber_loss(dense_prediction, target);
+  EXPECT_EQ(static_cast<const float *>(strided.data())[0],
+            static_cast<const float *>(dense.data())[0]);
+}
+
+TEST(Loss, RejectsMismatchedOperands) {
+  const auto matrix = ramp({4, 8}, Tensor::DType::f32, 0);
+  const auto row = ramp({1, 8}, Tensor::DType::f32, 0);
+  const auto wide = ramp({4, 8}, Tensor::DType::f64, 0);
+  const auto ints = Tensor::api::zeros({4, 8}, Tensor::DType::i32);
+  EXPECT_THROW(Tensor::ops::mse_loss(matrix, row), std::invalid_argument);
+  EXPECT_THROW(Tensor::ops::l1_loss(matrix, wide), std::invalid_argument);
+  EXPECT_THROW(Tensor::ops::huber_loss(matrix, matrix, 0.0), std::invalid_argument);
+  EXPECT_THROW(Tensor::ops::huber_loss(ints, ints), std::invalid_argument);
+  // Integer means would truncate the 1/N gradient scale to zero.
+  EXPECT_THROW(Tensor::ops::mse_loss(ints, ints), std::invalid_argument);
+  EXPECT_THROW(Tensor::ops::l1_loss(ints, ints), std::invalid_argument);
+}
+
+TEST(Loss, ModifyingASavedOperandFailsBackward) {
+  auto prediction = ramp({32}, Tensor::DType::f32, 0, true);
+  auto target = ramp({32}, Tensor::DType::f32, 2);
+  const auto loss = Tensor::ops::mse_loss(prediction, target);
+  Tensor::ops::add_(target, target);
+  EXPECT_THROW(Tensor::ops::backward(loss), std::runtime_error);
+}
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <stdexcept>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -91,3 +92,46 @@ TEST(OpsForward, BiasAddBroadcastsAcrossRows) {
   EXPECT_FLOAT_EQ(ptr[4], 4.0f);
   EXPECT_FLOAT_EQ(ptr[5], 8.0f);
 }
+
+TEST(OpsForward, MatmulConsumesPermutedView) {
+  auto stored = tensor_from_values({3, 2}, {1.0f, 4.0f, 2.0f, 5.0f, 3.0f, 6.0f});
+  auto lhs = Tensor::api::permute(stored, {1, 0});
+  auto rhs = tensor_from_values({3, 2}, {7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f});
+  ASSERT_FALSE(lhs.is_contiguous());
+
+  auto out = Tensor::ops::matmul(lhs, rhs);
+  const auto *ptr = static_cast<const float *>(out.data());
+
+  EXPECT_FLOAT_EQ(ptr[0], 58.0f);
+  EXPECT_FLOAT_EQ(ptr[1], 64.0f);
+  EXPECT_FLOAT_EQ(ptr[2], 139.0f);
+  EXPECT_FLOAT_EQ(ptr[3], 154.0f);
+}
+
+TEST(OpsForward, ElementwiseOpsBroadcastAndReadViews) {
+  auto matrix = tensor_from_values({2, 3}, {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f});
+  auto column = tensor_from_values({2, 1}, {10.0f, 20.0f});
+  auto transposed = Tensor::api::permute(matrix, {1, 0});
+
+  auto shifted = Tensor::ops::add(matrix, column);
+  ASSERT_EQ(shifted.shape(), (std::vector<int64_t>{2, 3}));
+  const auto *shifted_ptr = static_cast<const float *>(shifted.data());
+  const std::vector<float> expected_shifted{11.0f, 12.0f, 13.0f, 24.0f, 25.0f, 26.0f};
+  for (std::size_t index = 0; index < expected_shifted.size(); ++index) {
+    EXPECT_FLOAT_EQ(shifted_ptr[index], expected_shifted[index]);
+  }
+
+  auto scaled = Tensor::ops::mul(transposed, transposed);
+  ASSERT_EQ(scaled.shape(), (std::vector<int64_t>{3, 2}));
+  const auto *scaled_ptr = static_cast<const float *>(scaled.data());
+  const std::vector<float> expected_scaled{1.0f, 16.0f, 4.0f, 25.0f, 9.0f, 36.0f};
+  for (std::size_t index = 0; index < expected_scaled.size(); ++index) {
+    EXPECT_FLOAT_EQ(scaled_ptr[index], expected_scaled[index]);
+  }
+
+  auto copied = Tensor::ops::clone(transposed);
+  EXPECT_TRUE(copied.is_contiguous());
+  EXPECT_FLOAT_EQ(static_cast<const float *>(copied.data())[1], 4.0f);
+  EXPECT_FLOAT_EQ(static_cast<const float *>(Tensor::ops::sum(transposed).data())[0], 21.0f);
+  EXPECT_THROW(Tensor::ops::add(matrix, transposed), std::invalid_argument);
+}
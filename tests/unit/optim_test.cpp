@@ -0,0 +1,341 @@
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "api/Api.hpp"
+#include "tensor/Linear.hpp"
+#include "tensor/Ops.hpp"
+#include "tensor/Optim.hpp"
+
+#include "TestUtil.hpp"
+
+namespace {
+
+using tensor_test::ThreadCountGuard;
+using Values = std::vector<double>;
+
+Values pattern(int64_t count, int64_t seed) {
+  Values values(static_cast<std::size_t>(count));
+  for (int64_t index = 0; index < count; ++index) {
+    values[static_cast<std::size_t>(index)] =
+        static_cast<double>(((index * 7 + seed * 13) % 17) - 8) / 16.0;
+  }
+  return values;
+}
+
+Tensor::DTensor tensor_of(const Values &values, Tensor::DType dtype, bool requires_grad = false) {
+  auto tensor =
+      Tensor::api::empty({static_cast<int64_t>(values.size())}, dtype, requires_grad);
+  for (std::size_t index = 0; index < values.size(); ++index) {
+    if (dtype == Tensor::DType::f32) {
+      static_cast<float *>(tensor.data())[index] = static_cast<float>(values[index]);
+    } else {
+      static_cast<double *>(tensor.data())[index] = values[index];
+    }
+  }
+  return tensor;
+}
+
+Values values_of(const Tensor::DTensor &tensor) {
+  const auto dense = Tensor::ops::clone(tensor);
+  Values values(static_cast<std::size_t>(dense.numel()));
+  for (std::size_t index = 0; index < values.size(); ++index) {
+    values[index] = dense.dtype() == Tensor::DType::f32
+                        ? static_cast<const float *>(dense.data())[index]
+                        : static_cast<const double *>(dense.data())[index];
+  }
+  return values;
+}
+
+void set_grad(Tensor::DTensor &parameter, const Values &grad) {
+  auto dense = tensor_of(grad, parameter.dtype());
+  parameter.set_grad(std::make_shared<Tensor::DTensor>(
+      Tensor::api::reshape(dense, parameter.shape())));
+}
+
+void expect_near(const Values &actual, const Values &expected, double tolerance) {
+  ASSERT_EQ(actual.size(), expected.size());
+  for (std::size_t index = 0; index < actual.size(); ++index) {
+    EXPECT_NEAR(actual[index], expected[index], tolerance) << "index " << index;
+  }
+}
+
+// Scalar SGD and Adam on doubles, one parameter at a time, as the textbook
+// update rules state them.
+struct SgdReference {
+  double learning_rate;
+  Tensor::nn::SGDOptions options;
+  std::vector<Values> buffers;
+
+  void step(std::vector<Values> &parameters, const std::vector<Values> &grads, double scale) {
+    const bool first = buffers.empty();
+    buffers.resize(parameters.size());
+    for (std::size_t p = 0; p < parameters.size(); ++p) {
+      buffers[p].resize(parameters[p].size());
+      for (std::size_t i = 0; i < parameters[p].size(); ++i) {
+        double g = grads[p][i] * scale + options.weight_decay * parameters[p][i];
+        if (options.momentum != 0.0f) {
+          double &m = buffers[p][i];
+          m = first ? g : options.momentum * m + (1.0 - options.dampening) * g;
+          g = options.nesterov ? g + options.momentum * m : m;
+        }
+        parameters[p][i] -= learning_rate * g;
+      }
+    }
+  }
+};
+
+struct AdamReference {
+  double learning_rate;
+  Tensor::nn::AdamOptions options;
+  std::vector<Values> m;
+  std::vector<Values> v;
+  int step_count{0};
+
+  void step(std::vector<Values> &parameters, const std::vector<Values> &grads) {
+    ++step_count;
+    m.resize(parameters.size());
+    v.resize(parameters.size());
+    const double correction1 = 1.0 - std::pow(options.beta1, step_count);
+    const double correction2 = 1.0 - std::pow(options.beta2, step_count);
+    for (std::size_t p = 0; p < parameters.size(); ++p) {
+      m[p].resize(parameters[p].size());
+      v[p].resize(parameters[p].size());
+      for (std::size_t i = 0; i < parameters[p].size(); ++i) {
+        double &value = parameters[p][i];
+        double g = grads[p][i];
+        if (options.decoupled_weight_decay) {
+          value *= 1.0 - learning_rate * options.weight_decay;
+        } else {
+          g += options.weight_decay * value;
+        }
+        m[p][i] = options.beta1 * m[p][i] + (1.0 - options.beta1) * g;
+        v[p][i] = options.beta2 * v[p][i] + (1.0 - options.beta2) * g * g;
+        const double m_hat = m[p][i] / correction1;
+        const double v_hat = v[p][i] / correction2;
+        value -= learning_rate * m_hat / (std::sqrt(v_hat) + options.eps);
+      }
+    }
+  }
+};
+
+} // namespace
+
+TEST(Optim, SgdVariantsMatchTheReference) {
+  const std::vector<Tensor::nn::SGDOptions> variants{
+      {},
+      {.momentum = 0.875f, .dampening = 0.125f},
+      {.momentum = 0.75f, .nesterov = true, .weight_decay = 0.0625f},
+  };
+  for (const auto dtype : {Tensor::DType::f32, Tensor::DType::f64}) {
+    for (const auto &options : variants) {
+      // 37 and 3 elements leave partial registers; 1 is all tail.
+      std::vector<Values> expected{pattern(37, 1), pattern(3, 2), pattern(1, 3)};
+      std::vector<Tensor::DTensor> parameters;
+      for (const auto &values : expected) {
+        parameters.push_back(tensor_of(values, dtype, true));
+      }
+      std::vector<Tensor::DTensor *> pointers;
+      for (auto &parameter : parameters) {
+        pointers.push_back(&parameter);
+      }
+      Tensor::nn::SGD optimizer(0.125f, options);
+      SgdReference reference{0.125, options, {}};
+      for (int step = 0; step < 4; ++step) {
+        std::vector<Values> grads;
+        for (std::size_t p = 0; p < parameters.size(); ++p) {
+          grads.push_back(pattern(static_cast<int64_t>(expected[p].size()), step * 5 + 7));
+          set_grad(parameters[p], grads.back());
+        }
+        optimizer.step(pointers);
+        reference.step(expected, grads, 1.0);
+      }
+      const double tolerance = dtype == Tensor::DType::f32 ? 1e-5 : 1e-12;
+      for (std::size_t p = 0; p < parameters.size(); ++p) {
+        expect_near(values_of(parameters[p]), expected[p], tolerance);
+      }
+    }
+  }
+}
+
+TEST(Optim, AdamAndAdamWMatchTheReference) {
+  for (const bool decoupled : {false, true}) {
+    for (const auto dtype : {Tensor::DType::f32, Tensor::DType::f64}) {
+      std::vector<Values> expected{pattern(70, 4), pattern(5, 9)};
+      std::vector<Tensor::DTensor> parameters;
+      for (const auto &values : expected) {
+        parameters.push_back(tensor_of(values, dtype, true));
+      }
+      std::vector<Tensor::DTensor *> pointers{&parameters[0], &parameters[1]};
+      Tensor::nn::AdamOptions options;
+      options.weight_decay = 0.0625f;
+      Tensor::nn::Adam adam(0.015625f, options);
+      Tensor::nn::AdamW adamw(0.015625f, 0.0625f);
+      Tensor::nn::Adam &optimizer = decoupled ? adamw : adam;
+      options.decoupled_weight_decay = decoupled;
+      AdamReference reference{0.015625, options, {}, {}};
+      for (int step = 0; step < 5; ++step) {
+        std::vector<Values> grads;
+        for (std::size_t p = 0; p < parameters.size(); ++p) {
+          grads.push_back(pattern(static_cast<int64_t>(expected[p].size()), step + 2));
+          set_grad(parameters[p], grads.back());
+        }
+        optimizer.step(pointers);
+        reference.step(expected, grads);
+      }
+      const double tolerance = dtype == Tensor::DType::f32 ? 1e-5 : 1e-12;
+      for (std::size_t p = 0; p < parameters.size(); ++p) {
+        expect_near(values_of(parameters[p]), expected[p], tolerance);
+      }
+    }
+  }
+}
+
+TEST(Optim, ClipsByTheGlobalGradientNorm) {
+  auto first = tensor_of({1.0, 1.0}, Tensor::DType::f32, true);
+  auto second = tensor_of({0.0}, Tensor::DType::f64, true);
+  const std::vector<Tensor::DTensor *> parameters{&first, &second};
+  Tensor::nn::SGD optimizer(1.0f, {.max_grad_norm = 1.0f});
+
+  // Gradients {3, 0} and {4} have norm 5 across both dtypes.
+  set_grad(first, {3.0, 0.0});
+  set_grad(second, {4.0});
+  optimizer.step(parameters);
+  EXPECT_NEAR(optimizer.last_grad_norm(), 5.0, 1e-9);
+  expect_near(values_of(first), {1.0 - 0.6, 1.0}, 1e-6);
+  expect_near(values_of(second), {-0.8}, 1e-6);
+  // The gradients themselves are left as they were.
+  expect_near(values_of(*first.grad()), {3.0, 0.0}, 0.0);
+
+  // Below the limit nothing is scaled.
+  set_grad(first, {0.5, 0.0});
+  set_grad(second, {0.0});
+  optimizer.step(parameters);
+  EXPECT_NEAR(optimizer.last_grad_norm(), 0.5, 1e-9);
+  expect_near(values_of(first), {0.4 - 0.5, 1.0}, 1e-6);
+}
+
+TEST(Optim, BatchesManySmallTensorsIntoOneLaunch) {
+  ThreadCountGuard threads(4);
+  // Small tensors end to end, then one spanning several blocks, so blocks both
+  // straddle tensors and split them.
+  std::vector<Values> expected;
+  for (int64_t index = 0; index < 300; ++index) {
+    expected.push_back(pattern(1 + index % 250, index));
+  }
+  expected.push_back(pattern(3 * Tensor::kDefaultGrainSize + 11, 5));
+  std::vector<Tensor::DTensor> parameters;
+  std::vector<Values> grads;
+  for (std::size_t p = 0; p < expected.size(); ++p) {
+    parameters.push_back(tensor_of(expected[p], Tensor::DType::f64, true));
+    grads.push_back(pattern(static_cast<int64_t>(expected[p].size()), static_cast<int64_t>(p) + 1));
+    set_grad(parameters.back(), grads.back());
+  }
+  std::vector<Tensor::DTensor *> pointers;
+  for (auto &parameter : parameters) {
+    pointers.push_back(&parameter);
+  }
+
+  double squares = 0.0;
+  for (const auto &grad : grads) {
+    for (const double value : grad) {
+      squares += value * value;
+    }
+  }
+  const double norm = std::sqrt(squares);
+  Tensor::nn::SGDOptions options{.momentum = 0.9f, .max_grad_norm = 10.0f};
+  Tensor::nn::SGD optimizer(0.5f, options);
+  optimizer.step(pointers);
+  SgdReference reference{0.5, options, {}};
+  reference.step(expected, grads, std::min(1.0, 10.0 / (norm + 1e-6)));
+
+  EXPECT_NEAR(optimizer.last_grad_norm(), norm, 1e-9 * norm);
+  for (std::size_t p = 0; p < parameters.size(); ++p) {
+    expect_near(values_of(parameters[p]), expected[p], 1e-12);
+  }
+}
+
+TEST(Optim, UpdatesNonContiguousParameters) {
+  auto base = tensor_of(pattern(6, 1), Tensor::DType::f32);
+  // The transpose of a {2, 3} row-major matrix.
+  Tensor::DTensor parameter(base.storage(), {3, 2}, {1, 3}, 0, Tensor::DType::f32, false, true);
+  ASSERT_FALSE(parameter.is_contiguous());
+  const auto before = values_of(parameter);
+  set_grad(parameter, {1, 2, 3, 4, 5, 6});
+
+  Tensor::nn::Adam optimizer(0.1f);
+  optimizer.step({&parameter});
+  // Adam's first step moves every element by about the learning rate, against
+  // the sign of its gradient.
+  const auto after = values_of(parameter);
+  for (std::size_t index = 0; index < after.size(); ++index) {
+    EXPECT_NEAR(after[index], before[index] - 0.1, 1e-5) << index;
+  }
+  EXPECT_EQ(values_of(base)[1], after[2]);
+}
+
+TEST(Optim, AdamTrainsALinearLayer) {
+  Tensor::nn::Linear linear(2, 1);
+  Tensor::nn::AdamW optimizer(0.05f, 0.0f);
+  auto input = Tensor::api::reshape(
+      tensor_of({1, 0, 0, 1, 1, 1, -1, 2}, Tensor::DType::f32), {4, 2});
+  auto target = Tensor::api::reshape(tensor_of({2, -1, 1, -4}, Tensor::DType::f32), {4, 1});
+  double first_loss = 0.0;
+  double last_loss = 0.0;
+  for (int step = 0; step < 300; ++step) {
+    optimizer.zero_grad(linear.parameters());
+    auto loss = Tensor::ops::mse_loss(linear.forward(input), target);
+    Tensor::ops::backward(loss);
+    optimizer.step(linear.parameters());
+    last_loss = values_of(loss)[0];
+    if (step == 0) {
+      first_loss = last_loss;
+    }
+  }
+  EXPECT_LT(last_loss, 1e-3 * first_loss);
+}
+
+TEST(Optim, RejectsBadSettingsAndParameters) {
+  EXPECT_THROW(Tensor::nn::SGD(0.1f, {.nesterov = true}), std::invalid_argument);
+  EXPECT_THROW(Tensor::nn::Adam(0.1f, {.beta1 = 1.0f}), std::invalid_argument);
+
+  auto first = tensor_of({1.0, 2.0}, Tensor::DType::f32, true);
+  auto second = tensor_of({3.0}, Tensor::DType::f32, true);
+  set_grad(first, {1.0, 1.0});
+  set_grad(second, {1.0});
+  Tensor::nn::SGD optimizer(0.1f, {.momentum = 0.9f});
+  optimizer.step({&first, &second});
+  EXPECT_THROW(optimizer.step({&first}), std::invalid_argument);
+  EXPECT_THROW(optimizer.step({&second, &first}), std::invalid_argument);
+
+  // The first step fixes the parameter count even when nothing has a grad.
+  auto idle = tensor_of({4.0}, Tensor::DType::f32, true);
+  Tensor::nn::Adam adam(0.1f);
+  adam.step({&idle});
+  EXPECT_THROW(adam.step({&idle, &first, &second}), std::invalid_argument);
+  adam.step({&first});
+  expect_near(values_of(first), {0.9 - 0.1, 1.9 - 0.1}, 1e-6);
+
+}
+
+TEST(Optim, OnlyPlainSGDStepsIntegerParameters) {
+  auto counts = Tensor::api::zeros({2}, Tensor::DType::i32, true);
+  auto grad = Tensor::api::zeros({2}, Tensor::DType::i32);
+  Tensor::ops::fill(grad, 3);
+  counts.set_grad(std::make_shared<Tensor::DTensor>(grad));
+
+  Tensor::nn::SGD plain(2.0f);
+  plain.step({&counts});
+  const auto *stepped = static_cast<const int32_t *>(counts.data());
+  EXPECT_EQ(stepped[0], -6);
+  EXPECT_EQ(stepped[1], -6);
+
+  Tensor::nn::SGD momentum(2.0f, {.momentum = 0.9f});
+  EXPECT_THROW(momentum.step({&counts}), std::invalid_argument);
+  Tensor::nn::Adam adam(2.0f);
+  EXPECT_THROW(adam.step({&counts}), std::invalid_argument);
+}
@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "api/Api.hpp"
+#include "tensor/Autograd.hpp"
+#include "tensor/Linear.hpp"
+#include "tensor/Ops.hpp"
+
+#include "TestUtil.hpp"
+
+namespace {
+
+class ParallelBackwardGuard {
+public:
+  explicit ParallelBackwardGuard(bool enabled) : previous_(Tensor::parallel_backward_enabled()) {
+    Tensor::set_parallel_backward(enabled);
+  }
+  ~ParallelBackwardGuard() { Tensor::set_parallel_backward(previous_); }
+
+private:
+  bool previous_;
+};
+
+using tensor_test::ThreadCountGuard;
+using tensor_test::values_of;
+
+Tensor::DTensor patterned(const std::vector<int64_t> &shape, int seed, bool requires_grad) {
+  return tensor_test::sawtooth(shape, {.step = 7, .shift = seed * 13}, Tensor::DType::f32,
+                               requires_grad);
+}
+
+// Gradients of a graph with four independent Linear branches feeding one loss.
+std::vector<std::vector<float>> branch_gradients(bool parallel) {
+  ParallelBackwardGuard guard(parallel);
+  auto input = patterned({8, 16}, 0, true);
+  std::vector<Tensor::nn::Linear> branches;
+  for (int branch = 0; branch < 4; ++branch) {
+    branches.emplace_back(16, 16);
+  }
+  Tensor::DTensor total;
+  for (auto &branch : branches) {
+    auto loss = Tensor::ops::sum(Tensor::ops::relu(branch.forward(input)));
+    total = total.defined() ? Tensor::ops::add(total, loss) : loss;
+  }
+  Tensor::ops::backward(total);
+
+  std::vector<std::vector<float>> grads{values_of(*input.grad())};
+  for (auto &branch : branches) {
+    grads.push_back(values_of(*branch.weight().grad()));
+    grads.push_back(values_of(*branch.bias().grad()));
+  }
+  return grads;
+}
+
+} // namespace
+
+TEST(ParallelBackward, MatchesSerialEngine) {
+  ThreadCountGuard threads(4);
+  const auto serial = branch_gradients(false);
+  const auto parallel = branch_gradients(true);
+  ASSERT_EQ(serial.size(), parallel.size());
+  for (std::size_t tensor = 0; tensor < serial.size(); ++tensor) {
+    ASSERT_EQ(serial[tensor].size(), parallel[tensor].size());
+    for (std::size_t index = 0; index < serial[tensor].size(); ++index) {
+      EXPECT_NEAR(serial[tensor][index], parallel[tensor][index], 1e-5f);
+    }
+  }
+  // Routing order is fixed, so repeated parallel runs agree bit for bit.
+  EXPECT_EQ(parallel, branch_gradients(true));
+}
+
+TEST(ParallelBackward, LeafAccumulationIsThreadSafe) {
+  auto weight = Tensor::api::zeros({4, 4}, Tensor::DType::f32, true);
+  Tensor::ops::fill(weight, 1.0);
+  constexpr int kThreads = 4;
+  constexpr int kSteps = 50;
+
+  std::vector<std::thread> workers;
+  for (int worker = 0; worker < kThreads; ++worker) {
+    workers.emplace_back([&weight] {
+      const auto input = Tensor::api::ones<float>({2, 4});
+      for (int step = 0; step < kSteps; ++step) {
+        Tensor::ops::backward(Tensor::ops::sum(Tensor::ops::matmul(input.as_dtensor(), weight)));
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  // Every backward adds the column sums of the input, 2, to each entry.
+  ASSERT_TRUE(weight.grad());
+  EXPECT_EQ(values_of(*weight.grad()), std::vector<float>(16, 2.0f * kThreads * kSteps));
+}
@@ -0,0 +1,93 @@
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "api/Api.hpp"
+#include "tensor/Ops.hpp"
+#include "tensor/Parallel.hpp"
+
+#include "TestUtil.hpp"
+
+namespace {
+
+using tensor_test::ThreadCountGuard;
+
+Tensor::DTensor patterned_tensor(const std::vector<int64_t> &shape) {
+  return tensor_test::sawtooth(shape, {.step = 37, .period = 101, .scale = 50.0});
+}
+
+} // namespace
+
+TEST(Parallel, CoversEveryIndexExactlyOnce) {
+  for (const int threads : {1, 2, 4, 7}) {
+    ThreadCountGuard guard(threads);
+    std::vector<std::atomic<int>> hits(100003);
+    Tensor::parallel_for(0, static_cast<int64_t>(hits.size()), 1000,
+                         [&](int64_t begin, int64_t end) {
+                           for (int64_t index = begin; index < end; ++index) {
+                             hits[static_cast<std::size_t>(index)].fetch_add(1);
+                           }
+                         });
+    for (const auto &hit : hits) {
+      ASSERT_EQ(hit.load(), 1);
+    }
+  }
+}
+
+TEST(Parallel, SmallRangesAndNestedCallsRunInline) {
+  ThreadCountGuard guard(4);
+  bool small_inline = false;
+  Tensor::parallel_for(0, 10, 100, [&](int64_t begin, int64_t end) {
+    small_inline = begin == 0 && end == 10 && !Tensor::in_parallel_region();
+  });
+  EXPECT_TRUE(small_inline);
+
+  std::atomic<int> nested_calls{0};
+  Tensor::parallel_for(0, 64, 1, [&](int64_t, int64_t) {
+    EXPECT_TRUE(Tensor::in_parallel_region());
+    Tensor::parallel_for(0, 1000, 1, [&](int64_t begin, int64_t end) {
+      EXPECT_EQ(begin, 0);
+      EXPECT_EQ(end, 1000);
+      nested_calls.fetch_add(1);
+    });
+  });
+  EXPECT_EQ(nested_calls.load(), 64);
+}
+
+TEST(Parallel, PropagatesExceptionsToCaller) {
+  ThreadCountGuard guard(3);
+  EXPECT_THROW(Tensor::parallel_for(0, 1000, 10,
+                                    [](int64_t begin, int64_t) {
+                                      if (begin >= 500) {
+                                        throw std::runtime_error("boom");
+                                      }
+                                    }),
+               std::runtime_error);
+  EXPECT_THROW(Tensor::set_num_threads(0), std::invalid_argument);
+}
+
+TEST(Parallel, KernelResultsDoNotDependOnThreadCount) {
+  auto lhs = patterned_tensor({150, 300});
+  auto rhs = patterned_tensor({300, 170});
+  auto flat = patterned_tensor({1 << 20});
+
+  Tensor::DTensor product_serial;
+  Tensor::DTensor sum_serial;
+  {
+    ThreadCountGuard guard(1);
+    product_serial = Tensor::ops::matmul(lhs, rhs);
+    sum_serial = Tensor::ops::sum(flat);
+  }
+  ThreadCountGuard guard(4);
+  auto product_parallel = Tensor::ops::matmul(lhs, rhs);
+  auto sum_parallel = Tensor::ops::sum(flat);
+
+  EXPECT_EQ(std::memcmp(product_serial.data(), product_parallel.data(),
+                        static_cast<std::size_t>(product_serial.numel()) * sizeof(float)),
+            0);
+  EXPECT_EQ(static_cast<const float *>(sum_serial.data())[0],
+            static_cast<const float *>(sum_parallel.data())[0]);
+}
@@ -0,0 +1,307 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "api/Api.hpp"
+#include "tensor/Allocator.hpp"
+#include "tensor/Ops.hpp"
+
+#include "TestUtil.hpp"
+
+namespace {
+
+Tensor::DTensor ramp(const std::vector<int64_t> &shape, Tensor::DType dtype,
+                     bool requires_grad = false) {
+  return tensor_test::sawtooth(shape, {.step = 13, .period = 29, .scale = 1.0, .bias = 14.0},
+                               dtype, requires_grad);
+}
+
+using tensor_test::ThreadCountGuard;
+using tensor_test::values_of;
+
+// Reference reduction of a contiguous 3-d tensor over the dims in `reduced`,
+// with the reduced dims kept.
+enum class Kind { sum, max, min };
+
+template <typename T>
+std::vector<double> reference(const Tensor::DTensor &tensor, const std::vector<bool> &reduced,
+                              Kind kind) {
+  const auto &shape = tensor.shape();
+  const int64_t out0 = reduced[0] ? 1 : shape[0];
+  const int64_t out1 = reduced[1] ? 1 : shape[1];
+  const int64_t out2 = reduced[2] ? 1 : shape[2];
+  std::vector<double> out(static_cast<std::size_t>(out0 * out1 * out2));
+  std::vector<bool> seen(out.size(), false);
+  const auto *values = static_cast<const T *>(tensor.data());
+  for (int64_t i = 0; i < shape[0]; ++i) {
+    for (int64_t j = 0; j < shape[1]; ++j) {
+      for (int64_t k = 0; k < shape[2]; ++k) {
+        const auto slot = static_cast<std::size_t>(
+            ((reduced[0] ? 0 : i) * out1 + (reduced[1] ? 0 : j)) * out2 + (reduced[2] ? 0 : k));
+        const double value = static_cast<double>(values[(i * shape[1] + j) * shape[2] + k]);
+        if (!seen[slot]) {
+          out[slot] = value;
+          seen[slot] = true;
+        } else if (kind == Kind::sum) {
+          out[slot] += value;
+        } else if (kind == Kind::max) {
+          out[slot] = std::max(out[slot], value);
+        } else {
+          out[slot] = std::min(out[slot], value);
+        }
+      }
+    }
+  }
+  return out;
+}
+
+template <typename T>
+void expect_reductions_match(const std::vector<int64_t> &shape, Tensor::DType dtype) {
+  const auto tensor = ramp(shape, dtype);
+  const std::vector<std::vector<int64_t>> dim_sets{{0}, {1}, {2}, {0, 2}, {-1, 0}, {0, 1, 2}};
+  for (const auto &dims : dim_sets) {
+    std::vector<bool> reduced(3, false);
+    for (const int64_t dim : dims) {
+      reduced[static_cast<std::size_t>(dim < 0 ? dim + 3 : dim)] = true;
+    }
+    const auto sum = Tensor::ops::sum(tensor, dims, true);
+    const auto max = Tensor::ops::max(tensor, dims, true);
+    const auto min = Tensor::ops::min(tensor, dims, true);
+    const auto expected_sum = reference<T>(tensor, reduced, Kind::sum);
+    const auto expected_max = reference<T>(tensor, reduced, Kind::max);
+    const auto expected_min = reference<T>(tensor, reduced, Kind::min);
+    ASSERT_EQ(static_cast<std::size_t>(sum.numel()), expected_sum.size());
+    const auto sums = values_of<T>(sum);
+    const auto maxes = values_of<T>(max);
+    const auto mins = values_of<T>(min);
+    for (std::size_t index = 0; index < expected_sum.size(); ++index) {
+      EXPECT_NEAR(static_cast<double>(sums[index]), expected_sum[index],
+                  1e-6 * (1.0 + std::abs(expected_sum[index])));
+      EXPECT_EQ(static_cast<double>(maxes[index]), expected_max[index]);
+      EXPECT_EQ(static_cast<double>(mins[index]), expected_min[index]);
+    }
+  }
+}
+
+} // namespace
+
+TEST(Reduce, DimsMatchReference) {
+  // Short rows, a plane split into bands and chunks, and long rows.
+  expect_reductions_match<float>({3, 5, 7}, Tensor::DType::f32);
+  expect_reductions_match<double>({2, 4100, 300}, Tensor::DType::f64);
+  expect_reductions_match<int32_t>({2, 3, 70000}, Tensor::DType::i32);
+  expect_reductions_match<int64_t>({70000, 2, 3}, Tensor::DType::i64);
+}
+
+TEST(Reduce, SumsRowsAndColumnsOfAMatrix) {
+  ThreadCountGuard guard(4);
+  auto input = Tensor::api::empty({300, 200}, Tensor::DType::f32);
+  auto *values = static_cast<float *>(input.data());
+  for (int64_t index = 0; index < input.numel(); ++index) {
+    values[index] = static_cast<float>(index);
+  }
+  const auto columns = values_of<float>(Tensor::ops::sum(input, {0}));
+  const auto rows = values_of<float>(Tensor::ops::sum(input, {1}, true));
+  for (int64_t col = 0; col < 200; ++col) {
+    // sum over r of (200 r + col) = 200 * 299 * 300 / 2 + 300 col
+    ASSERT_FLOAT_EQ(columns[static_cast<std::size_t>(col)],
+                    8970000.0f + 300.0f * static_cast<float>(col));
+  }
+  for (int64_t row = 0; row < 300; ++row) {
+    ASSERT_FLOAT_EQ(rows[static_cast<std::size_t>(row)],
+                    40000.0f * static_cast<float>(row) + 19900.0f);
+  }
+}
+
+TEST(Reduce, ShapesFollowKeepdim) {
+  const auto tensor = ramp({2, 3, 4}, Tensor::DType::f32);
+  EXPECT_EQ(Tensor::ops::sum(tensor, {1}).shape(), (std::vector<int64_t>{2, 4}));
+  EXPECT_EQ(Tensor::ops::sum(tensor, {1}, true).shape(), (std::vector<int64_t>{2, 1, 4}));
+  EXPECT_EQ(Tensor::ops::mean(tensor, {}).shape(), (std::vector<int64_t>{1}));
+  EXPECT_EQ(Tensor::ops::max(tensor, {}, true).shape(), (std::vector<int64_t>{1, 1, 1}));
+  EXPECT_EQ(Tensor::ops::argmax(tensor, -1).shape(), (std::vector<int64_t>{2, 3}));
+  EXPECT_EQ(Tensor::ops::argmax(tensor, 0, true).dtype(), Tensor::DType::i64);
+}
+
+TEST(Reduce, ReadsStridedViews) {
+  const auto base = ramp({6, 9}, Tensor::DType::f32);
+  const auto view = Tensor::api::permute(base, {1, 0});
+  const auto dense = Tensor::ops::clone(view);
+  EXPECT_EQ(values_of<float>(Tensor::ops::sum(view, {1})),
+            values_of<float>(Tensor::ops::sum(dense, {1})));
+  EXPECT_EQ(values_of<int64_t>(Tensor::ops::argmax(view, 0)),
+            values_of<int64_t>(Tensor::ops::argmax(dense, 0)));
+
+  const auto cube = Tensor::api::permute(ramp({4, 5, 6}, Tensor::DType::f32), {2, 0, 1});
+  const auto dense_cube = Tensor::ops::clone(cube);
+  for (const auto &dims : {std::vector<int64_t>{0}, std::vector<int64_t>{1},
+                           std::vector<int64_t>{2}, std::vector<int64_t>{0, 2},
+                           std::vector<int64_t>{1, 2}}) {
+    EXPECT_EQ(values_of<float>(Tensor::ops::sum(cube, dims)),
+              values_of<float>(Tensor::ops::sum(dense_cube, dims)));
+    EXPECT_EQ(values_of<float>(Tensor::ops::max(cube, dims, true)),
+              values_of<float>(Tensor::ops::max(dense_cube, dims, true)));
+  }
+  for (const int64_t dim : {0, 1, 2}) {
+    EXPECT_EQ(values_of<int64_t>(Tensor::ops::argmax(cube, dim)),
+              values_of<int64_t>(Tensor::ops::argmax(dense_cube, dim)));
+  }
+}
+
+TEST(Reduce, ViewsAreNotCopied) {
+  const auto base = ramp({512, 256}, Tensor::DType::f32);
+  const auto view = Tensor::api::permute(base, {1, 0});
+  const std::size_t input_bytes = 512 * 256 * sizeof(float);
+  Tensor::reset_host_allocator_stats();
+  const std::size_t before = Tensor::host_allocator_stats().bytes_in_use;
+  const auto sums = Tensor::ops::sum(view, {1});
+  const auto largest = Tensor::ops::max(view, {0});
+  const auto picks = Tensor::ops::argmax(view, 0);
+  EXPECT_LT(Tensor::host_allocator_stats().peak_bytes_in_use - before, input_bytes / 16);
+  EXPECT_EQ(sums.shape(), (std::vector<int64_t>{256}));
+  EXPECT_EQ(picks.shape(), (std::vector<int64_t>{512}));
+}
+
+TEST(Reduce, ArgmaxPicksTheFirstMaximum) {
+  auto tensor = Tensor::api::zeros({2, 4}, Tensor::DType::f32);
+  auto *values = static_cast<float *>(tensor.data());
+  const float data[] = {1.0f, 5.0f, 5.0f, 2.0f, 7.0f, 3.0f, 7.0f, 7.0f};
+  std::memcpy(values, data, sizeof(data));
+  EXPECT_EQ(values_of<int64_t>(Tensor::ops::argmax(tensor, 1)), (std::vector<int64_t>{1, 0}));
+  EXPECT_EQ(values_of<int64_t>(Tensor::ops::argmax(tensor, 0)),
+            (std::vector<int64_t>{1, 0, 1, 1}));
+
+  const int64_t count = 100000;
+  auto row = Tensor::api::zeros({count}, Tensor::DType::f64);
+  static_cast<double *>(row.data())[40000] = 3.0;
+  static_cast<double *>(row.data())[90000] = 3.0;
+  EXPECT_EQ(values_of<int64_t>(Tensor::ops::argmax(row, 0)), (std::vector<int64_t>{40000}));
+}
+
+TEST(Reduce, MaxAndMinKeepInfinitiesAndPropagateNan) {
+  constexpr float kInf = std::numeric_limits<float>::infinity();
+  constexpr float kNan = std::numeric_limits<float>::quiet_NaN();
+  const auto expect_same = [](const std::vector<float> &actual,
+                              const std::vector<float> &expected) {
+    ASSERT_EQ(actual.size(), expected.size());
+    for (std::size_t index = 0; index < actual.size(); ++index) {
+      if (std::isnan(expected[index])) {
+        EXPECT_TRUE(std::isnan(actual[index])) << index;
+      } else {
+        EXPECT_EQ(actual[index], expected[index]) << index;
+      }
+    }
+  };
+
+  // Reducing rows, columns and everything takes three different kernel paths.
+  const auto lows = tensor_test::make_tensor({2, 3}, std::vector<float>(6, -kInf), true);
+  const auto highs = tensor_test::make_tensor({2, 3}, std::vector<float>(6, kInf));
+  for (const auto &dims :
+       {std::vector<int64_t>{0}, std::vector<int64_t>{1}, std::vector<int64_t>{}}) {
+    for (const float value : values_of<float>(Tensor::ops::max(lows, dims))) {
+      EXPECT_EQ(value, -kInf);
+    }
+    for (const float value : values_of<float>(Tensor::ops::min(highs, dims))) {
+      EXPECT_EQ(value, kInf);
+    }
+  }
+  Tensor::ops::backward(Tensor::ops::sum(Tensor::ops::max(lows, {1})));
+  EXPECT_EQ(values_of<float>(*lows.grad()), std::vector<float>(6, 1.0f / 3.0f));
+
+  const auto mixed = tensor_test::make_tensor({2, 3}, {1, kNan, 2, 3, 4, 5}, true);
+  expect_same(values_of<float>(Tensor::ops::max(mixed, {1})), {kNan, 5});
+  expect_same(values_of<float>(Tensor::ops::max(mixed, {0})), {3, kNan, 5});
+  expect_same(values_of<float>(Tensor::ops::max(mixed, {})), {kNan});
+  expect_same(values_of<float>(Tensor::ops::min(mixed, {1})), {kNan, 3});
+  expect_same(values_of<float>(Tensor::ops::min(mixed, {0})), {1, kNan, 2});
+  EXPECT_EQ(values_of<int64_t>(Tensor::ops::argmax(mixed, 1)), (std::vector<int64_t>{1, 2}));
+  EXPECT_EQ(values_of<int64_t>(Tensor::ops::argmax(mixed, 0)), (std::vector<int64_t>{1, 0, 1}));
+  Tensor::ops::backward(Tensor::ops::sum(Tensor::ops::max(mixed, {1})));
+  EXPECT_EQ(values_of<float>(*mixed.grad()), (std::vector<float>{0, 1, 0, 0, 0, 1}));
+
+  auto tall = ramp({300, 40}, Tensor::DType::f32);
+  static_cast<float *>(tall.data())[123 * 40 + 7] = kNan;
+  const auto columns = values_of<float>(Tensor::ops::max(tall, {0}));
+  const auto rows = values_of<float>(Tensor::ops::min(tall, {1}));
+  for (std::size_t index = 0; index < columns.size(); ++index) {
+    EXPECT_EQ(std::isnan(columns[index]), index == 7) << index;
+  }
+  for (std::size_t index = 0; index < rows.size(); ++index) {
+    EXPECT_EQ(std::isnan(rows[index]), index == 123) << index;
+  }
+}
+
+TEST(Reduce, LongSumsStayAccurate) {
+  // Ten million additions of 0.1f: one running float accumulator drifts by
+  // percent, a pairwise sum stays within a few ulps.
+  const int64_t count = 10'000'000;
+  auto tensor = Tensor::api::empty({count}, Tensor::DType::f32);
+  Tensor::ops::fill(tensor, 0.1f);
+  const double exact = static_cast<double>(0.1f) * static_cast<double>(count);
+  const float total = values_of<float>(Tensor::ops::sum(tensor))[0];
+  EXPECT_NEAR(total, exact, exact * 1e-6);
+}
+
+TEST(Reduce, ResultsDoNotDependOnThreadCount) {
+  const auto tensor = ramp({3, 50000, 5}, Tensor::DType::f32);
+  std::vector<std::vector<float>> runs;
+  for (const int threads : {1, 4}) {
+    ThreadCountGuard guard(threads);
+    runs.push_back(values_of<float>(Tensor::ops::sum(tensor, {1})));
+    const auto flat = values_of<float>(Tensor::ops::sum(tensor));
+    runs.back().insert(runs.back().end(), flat.begin(), flat.end());
+  }
+  EXPECT_EQ(runs[0], runs[1]);
+}
+
+TEST(Reduce, SumAndMeanGradientsBroadcastBack) {
+  auto input = ramp({2, 3, 4}, Tensor::DType::f32, true);
+  const auto loss = Tensor::ops::sum(Tensor::ops::mul(
+      Tensor::ops::mean(input, {0, 2}), ramp({3}, Tensor::DType::f32)));
+  Tensor::ops::backward(loss);
+  const auto weights = values_of<float>(ramp({3}, Tensor::DType::f32));
+  const auto grad = values_of<float>(*input.grad());
+  for (int64_t index = 0; index < 24; ++index) {
+    EXPECT_FLOAT_EQ(grad[static_cast<std::size_t>(index)],
+                    weights[static_cast<std::size_t>(index / 4 % 3)] / 8.0f);
+  }
+}
+
+TEST(Reduce, MaxGradientIsSplitBetweenTies) {
+  auto input = Tensor::api::zeros({2, 3}, Tensor::DType::f32, true);
+  const float data[] = {4.0f, 1.0f, 4.0f, -2.0f, 6.0f, 0.0f};
+  std::memcpy(input.data(), data, sizeof(data));
+  Tensor::ops::backward(Tensor::ops::sum(Tensor::ops::max(input, {1})));
+  EXPECT_EQ(values_of<float>(*input.grad()),
+            (std::vector<float>{0.5f, 0.0f, 0.5f, 0.0f, 1.0f, 0.0f}));
+
+  input.zero_grad();
+  Tensor::ops::backward(Tensor::ops::sum(Tensor::ops::min(input, {0})));
+  EXPECT_EQ(values_of<float>(*input.grad()),
+            (std::vector<float>{0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f}));
+}
+
+TEST(Reduce, IntegerMaxGradientCoversPartialVectors) {
+  auto input = Tensor::api::zeros({2, 5}, Tensor::DType::i32, true);
+  const int32_t data[] = {3, 9, 1, 7, 2, -4, -1, -8, -2, -6};
+  std::memcpy(input.data(), data, sizeof(data));
+  Tensor::ops::backward(Tensor::ops::sum(Tensor::ops::max(input, {1})));
+  EXPECT_EQ(values_of<int32_t>(*input.grad()),
+            (std::vector<int32_t>{0, 1, 0, 0, 0, 0, 1, 0, 0, 0}));
+}
+
+TEST(Reduce, RejectsBadDims) {
+  const auto tensor = ramp({2, 3}, Tensor::DType::f32);
+  EXPECT_THROW(Tensor::ops::sum(tensor, {2}), std::invalid_argument);
+  EXPECT_THROW(Tensor::ops::mean(tensor, {-3}), std::invalid_argument);
+  EXPECT_THROW(Tensor::ops::max(tensor, {1, -1}), std::invalid_argument);
+  const auto empty = Tensor::api::zeros({2, 0}, Tensor::DType::f32);
+  EXPECT_THROW(Tensor::ops::min(empty, {1}), std::invalid_argument);
+  EXPECT_THROW(Tensor::ops::argmax(empty, 1), std::invalid_argument);
+  EXPECT_EQ(values_of<float>(Tensor::ops::sum(empty, {1})), (std::vector<float>{0.0f, 0.0f}));
+}
@@ -0,0 +1,113 @@
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "api/Api.hpp"
+#include "tensor/Allocator.hpp"
+#include "tensor/Autograd.hpp"
+#include "tensor/Linear.hpp"
+#include "tensor/Ops.hpp"
+
+#include "TestUtil.hpp"
+
+namespace {
+
+using tensor_test::make_tensor;
+using tensor_test::values_of;
+
+} // namespace
+
+TEST(SavedTensors, MasksCoverPartialWords) {
+  std::vector<float> values(150);
+  for (std::size_t index = 0; index < values.size(); ++index) {
+    values[index] = static_cast<float>(index % 7) - 3.0f;
+  }
+  const auto input = make_tensor({10, 15}, values, true);
+  const auto activated = Tensor::ops::relu(input);
+  const auto clamped = Tensor::ops::clamp(input, -1.5, 2.0);
+  Tensor::ops::backward(Tensor::ops::add(Tensor::ops::sum(activated),
+                                         Tensor::ops::sum(clamped)));
+
+  std::vector<float> expected(values.size());
+  for (std::size_t index = 0; index < values.size(); ++index) {
+    const float x = values[index];
+    expected[index] = (x > 0 ? 1.0f : 0.0f) + (x > -1.5f && x < 2.0f ? 1.0f : 0.0f);
+  }
+  EXPECT_EQ(values_of(*input.grad()), expected);
+}
+
+TEST(SavedTensors, MaskedOpsDoNotDependOnTheirInputValues) {
+  auto input = make_tensor({3}, {-1, 2, 3}, true);
+  auto hidden = Tensor::ops::add(input, make_tensor({3}, {0, 0, 0}));
+  const auto activated = Tensor::ops::relu(hidden);
+  Tensor::ops::add_(hidden, make_tensor({3}, {5, 5, 5}));
+  Tensor::ops::backward(Tensor::ops::sum(activated));
+  EXPECT_EQ(values_of(*input.grad()), (std::vector<float>{0, 1, 1}));
+}
+
+TEST(SavedTensors, SquaringATensorSavesItOnce) {
+  auto input = make_tensor({4}, {1, -2, 3, 0.5f}, true);
+  const auto square = Tensor::ops::mul(input, input);
+  Tensor::ops::backward(Tensor::ops::sum(square));
+  EXPECT_EQ(values_of(*input.grad()), (std::vector<float>{2, -4, 6, 1}));
+
+  auto hidden = Tensor::ops::add(input, make_tensor({4}, {0, 0, 0, 0}));
+  input.zero_grad();
+  Tensor::ops::mul_(hidden, hidden);
+  Tensor::ops::backward(Tensor::ops::sum(hidden));
+  EXPECT_EQ(values_of(*input.grad()), (std::vector<float>{2, -4, 6, 1}));
+}
+
+TEST(SavedTensors, NoGradAliasesAreNotTheSameOperand) {
+  auto input = make_tensor({4}, {1, 2, 3, 4}, true);
+  Tensor::DTensor alias;
+  {
+    Tensor::NoGradGuard no_grad;
+    alias = Tensor::ops::reshape(input, input.shape());
+  }
+  Tensor::ops::backward(Tensor::ops::sum(Tensor::ops::mul(input, alias)));
+  EXPECT_EQ(values_of(*input.grad()), (std::vector<float>{1, 2, 3, 4}));
+
+  auto hidden = Tensor::ops::add(input, make_tensor({4}, {0, 0, 0, 0}));
+  Tensor::DTensor hidden_alias;
+  {
+    Tensor::NoGradGuard no_grad;
+    hidden_alias = Tensor::ops::reshape(hidden, hidden.shape());
+  }
+  // mul_ saves the alias for self's gradient, and its own write invalidates it.
+  Tensor::ops::mul_(hidden, hidden_alias);
+  EXPECT_THROW(Tensor::ops::backward(Tensor::ops::sum(hidden)), std::runtime_error);
+}
+
+TEST(SavedTensors, DeepReluMlpKeepsOneActivationPerLayer) {
+  constexpr int64_t kBatch = 64;
+  constexpr int64_t kWidth = 256;
+  constexpr int kDepth = 8;
+  std::vector<Tensor::nn::Linear> layers;
+  for (int layer = 0; layer < kDepth; ++layer) {
+    layers.emplace_back(kWidth, kWidth);
+  }
+  auto input = Tensor::api::empty({kBatch, kWidth}, Tensor::DType::f32);
+  Tensor::ops::fill(input, 0.5);
+
+  const std::size_t before = Tensor::host_allocator_stats().bytes_in_use;
+  Tensor::DTensor hidden = input;
+  for (const auto &layer : layers) {
+    hidden = Tensor::ops::relu(layer.forward(hidden));
+  }
+  const auto loss = Tensor::ops::sum(hidden);
+  hidden = Tensor::DTensor{};
+  const std::size_t held = Tensor::host_allocator_stats().bytes_in_use - before;
+
+  // Each matmul keeps the activation it reads; the pre-activations behind the
+  // relu masks are gone.
+  const std::size_t activation_bytes = kBatch * kWidth * sizeof(float);
+  EXPECT_LT(held, kDepth * activation_bytes * 5 / 4);
+
+  Tensor::ops::backward(loss);
+  for (const auto &layer : layers) {
+    ASSERT_TRUE(layer.weight().grad());
+  }
+}
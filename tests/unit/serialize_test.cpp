@@ -0,0 +1,224 @@
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "api/Api.hpp"
+#include "tensor/Allocator.hpp"
+#include "tensor/Linear.hpp"
+#include "tensor/Serialize.hpp"
+
+#include "TestUtil.hpp"
+
+namespace {
+
+// A path under the temp directory that is removed when the test ends.
+class TempFile {
+public:
+  explicit TempFile(const std::string &name)
+      : path_(std::filesystem::temp_directory_path() /
+              (name + "_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) +
+               "_" + ::testing::UnitTest::GetInstance()->current_test_info()->name())) {}
+  ~TempFile() { std::filesystem::remove(path_); }
+  std::string str() const { return path_.string(); }
+
+private:
+  std::filesystem::path path_;
+};
+
+using tensor_test::values_of;
+
+Tensor::DTensor iota(const std::vector<int64_t> &shape, Tensor::DType dtype) {
+  auto tensor = Tensor::api::empty(shape, dtype);
+  for (int64_t index = 0; index < tensor.numel(); ++index) {
+    switch (dtype) {
+    case Tensor::DType::f32:
+      static_cast<float *>(tensor.data())[index] = static_cast<float>(index) / 4.0f;
+      break;
+    case Tensor::DType::f64:
+      static_cast<double *>(tensor.data())[index] = static_cast<double>(index) / 8.0;
+      break;
+    case Tensor::DType::i32:
+      static_cast<int32_t *>(tensor.data())[index] = static_cast<int32_t>(index) - 3;
+      break;
+    case Tensor::DType::i64:
+      static_cast<int64_t *>(tensor.data())[index] = index * 1000000007LL;
+      break;
+    }
+  }
+  return tensor;
+}
+
+void write_bytes(const std::string &path, const std::vector<unsigned char> &bytes) {
+  std::ofstream out(path, std::ios::binary);
+  out.write(reinterpret_cast<const char *>(bytes.data()),
+            static_cast<std::streamsize>(bytes.size()));
+}
+
+template <typename T> void append(std::vector<unsigned char> &bytes, T value) {
+  const auto *raw = reinterpret_cast<const unsigned char *>(&value);
+  bytes.insert(bytes.end(), raw, raw + sizeof(T));
+}
+
+} // namespace
+
+TEST(Serialize, RoundTripsEveryDtypeAndLayout) {
+  TempFile file("tensors");
+  const auto matrix = iota({3, 5}, Tensor::DType::f32);
+  const auto transposed = Tensor::api::permute(iota({4, 6}, Tensor::DType::f64), {1, 0});
+  const auto indices = iota({7}, Tensor::DType::i32);
+  const auto wide = iota({2, 2, 2}, Tensor::DType::i64);
+  const auto empty = Tensor::api::empty({0, 3}, Tensor::DType::f32);
+  Tensor::save_tensors(file.str(), {{"matrix", matrix},
+                                    {"transposed", transposed},
+                                    {"indices", indices},
+                                    {"wide", wide},
+                                    {"empty", empty}});
+
+  const auto loaded = Tensor::load_tensors(file.str());
+  ASSERT_EQ(loaded.size(), 5u);
+  EXPECT_EQ(loaded[0].name, "matrix");
+  EXPECT_EQ(loaded[0].tensor.shape(), matrix.shape());
+  EXPECT_EQ(values_of<float>(loaded[0].tensor), values_of<float>(matrix));
+  EXPECT_EQ(loaded[1].tensor.shape(), (Tensor::Dims{6, 4}));
+  EXPECT_EQ(loaded[1].tensor.stride(), transposed.stride());
+  EXPECT_FALSE(loaded[1].tensor.is_contiguous());
+  EXPECT_EQ(values_of<double>(loaded[1].tensor), values_of<double>(transposed));
+  EXPECT_EQ(values_of<int32_t>(loaded[2].tensor), values_of<int32_t>(indices));
+  EXPECT_EQ(values_of<int64_t>(loaded[3].tensor), values_of<int64_t>(wide));
+  EXPECT_EQ(loaded[4].tensor.shape(), (Tensor::Dims{0, 3}));
+  for (const auto &entry : loaded) {
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(entry.tensor.data()) % 64, 0u) << entry.name;
+    EXPECT_FALSE(entry.tensor.requires_grad());
+  }
+}
+
+TEST(Serialize, ViewsSaveOnlyTheSpanTheyCover) {
+  TempFile whole_file("whole");
+  TempFile view_file("view");
+  const auto base = iota({64, 64}, Tensor::DType::f32);
+  const auto row = Tensor::DTensor(base.storage(), {64}, {1}, 10 * 64, Tensor::DType::f32);
+  Tensor::save_tensors(whole_file.str(), {{"base", base}});
+  Tensor::save_tensors(view_file.str(), {{"row", row}});
+  EXPECT_LT(std::filesystem::file_size(view_file.str()) + 64 * 60 * 4,
+            std::filesystem::file_size(whole_file.str()));
+
+  const auto loaded = Tensor::load_tensors(view_file.str());
+  EXPECT_EQ(loaded[0].tensor.offset(), 0);
+  EXPECT_EQ(values_of<float>(loaded[0].tensor), values_of<float>(row));
+}
+
+TEST(Serialize, LoadingMapsInsteadOfAllocating) {
+  TempFile file("mapped");
+  Tensor::save_tensors(file.str(), {{"big", iota({256, 1024}, Tensor::DType::f32)}});
+  const auto before = Tensor::host_allocator_stats();
+  auto loaded = Tensor::load_tensors(file.str());
+  const auto after = Tensor::host_allocator_stats();
+  EXPECT_EQ(after.bytes_in_use, before.bytes_in_use);
+
+  // The mapping is private: writes stay in memory and the file is unchanged.
+  Tensor::ops::fill(loaded[0].tensor, -1.0);
+  const auto reloaded = Tensor::load_tensors(file.str());
+  EXPECT_EQ(values_of<float>(reloaded[0].tensor)[5], 1.25f);
+  EXPECT_EQ(values_of<float>(loaded[0].tensor)[5], -1.0f);
+}
+
+TEST(Serialize, LinearParametersRoundTrip) {
+  TempFile file("linear");
+  Tensor::nn::Linear trained(5, 3);
+  Tensor::ops::fill(trained.bias(), 0.5);
+  Tensor::save_parameters(file.str(), trained.parameters());
+
+  Tensor::nn::Linear fresh(5, 3);
+  Tensor::load_parameters(file.str(), fresh.parameters());
+  EXPECT_TRUE(fresh.weight().requires_grad());
+  EXPECT_EQ(values_of<float>(fresh.weight()), values_of<float>(trained.weight()));
+  EXPECT_EQ(values_of<float>(fresh.bias()), values_of<float>(trained.bias()));
+  const auto input = iota({2, 5}, Tensor::DType::f32);
+  EXPECT_EQ(values_of<float>(fresh.forward(input)), values_of<float>(trained.forward(input)));
+
+  Tensor::nn::Linear other(4, 3);
+  EXPECT_THROW(Tensor::load_parameters(file.str(), other.parameters()), std::invalid_argument);
+}
+
+TEST(Serialize, ResavingOverTheLoadedFileKeepsBothCopies) {
+  TempFile file("resume");
+  Tensor::nn::Linear trained(40, 24);
+  Tensor::save_parameters(file.str(), trained.parameters());
+
+  Tensor::nn::Linear resumed(40, 24);
+  Tensor::load_parameters(file.str(), resumed.parameters());
+  Tensor::ops::fill(resumed.bias(), 0.25);
+  Tensor::save_parameters(file.str(), resumed.parameters());
+  EXPECT_FALSE(std::filesystem::exists(file.str() + ".tmp"));
+  EXPECT_EQ(values_of<float>(resumed.weight()), values_of<float>(trained.weight()));
+
+  Tensor::nn::Linear reloaded(40, 24);
+  Tensor::load_parameters(file.str(), reloaded.parameters());
+  EXPECT_EQ(values_of<float>(reloaded.weight()), values_of<float>(trained.weight()));
+  EXPECT_EQ(values_of<float>(reloaded.bias()), std::vector<float>(24, 0.25f));
+}
+
+TEST(Serialize, ReadsSafetensors) {
+  TempFile file("model.safetensors");
+  // The header is padded to 8 bytes, so the i64 tensor, 20 bytes into the
+  // data, is misaligned and gets copied.
+  std::string header =
+      R"({"__metadata__":{"format":"pt"},"a":{"dtype":"F32","shape":[2,2],"data_offsets":[0,16]},)"
+      R"("b\u00e9":{"dtype":"I64","shape":[1],"data_offsets":[20,28]}})";
+  header.resize((header.size() + 7) / 8 * 8, ' ');
+  std::vector<unsigned char> bytes;
+  append<uint64_t>(bytes, header.size());
+  bytes.insert(bytes.end(), header.begin(), header.end());
+  const std::size_t data_start = bytes.size();
+  for (const float value : {1.0f, 2.0f, 3.0f, 4.0f, 0.0f}) {
+    append(bytes, value);
+  }
+  append<int64_t>(bytes, -42);
+  ASSERT_EQ(bytes.size(), data_start + 28);
+  write_bytes(file.str(), bytes);
+
+  const auto loaded = Tensor::load_tensors(file.str());
+  ASSERT_EQ(loaded.size(), 2u);
+  EXPECT_EQ(loaded[0].name, "a");
+  EXPECT_EQ(loaded[0].tensor.shape(), (Tensor::Dims{2, 2}));
+  EXPECT_EQ(values_of<float>(loaded[0].tensor), (std::vector<float>{1, 2, 3, 4}));
+  EXPECT_EQ(loaded[1].name, "b\xc3\xa9");
+  EXPECT_EQ(loaded[1].tensor.dtype(), Tensor::DType::i64);
+  EXPECT_EQ(values_of<int64_t>(loaded[1].tensor), (std::vector<int64_t>{-42}));
+}
+
+TEST(Serialize, RejectsMalformedFiles) {
+  TempFile file("broken");
+  EXPECT_THROW(Tensor::load_tensors(file.str()), std::runtime_error);
+
+  Tensor::save_tensors(file.str(), {{"x", iota({16}, Tensor::DType::f32)}});
+  auto bytes = std::vector<unsigned char>(std::filesystem::file_size(file.str()));
+  std::ifstream(file.str(), std::ios::binary)
+      .read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+  // Claim a much larger shape than the payload holds.
+  const int64_t huge = int64_t{1} << 40;
+  std::memcpy(bytes.data() + 24 + 4 + 1 + 4, &huge, sizeof(huge));
+  write_bytes(file.str(), bytes);
+  EXPECT_THROW(Tensor::load_tensors(file.str()), std::runtime_error);
+
+  // Cut the file off inside the payload.
+  bytes.resize(bytes.size() - 8);
+  const int64_t sixteen = 16;
+  std::memcpy(bytes.data() + 24 + 4 + 1 + 4, &sixteen, sizeof(sixteen));
+  write_bytes(file.str(), bytes);
+  EXPECT_THROW(Tensor::load_tensors(file.str()), std::runtime_error);
+
+  const std::string header = R"({"x":{"dtype":"F16","shape":[1],"data_offsets":[0,2]}})";
+  std::vector<unsigned char> safetensors;
+  append<uint64_t>(safetensors, header.size());
+  safetensors.insert(safetensors.end(), header.begin(), header.end());
+  append<uint16_t>(safetensors, 0);
+  write_bytes(file.str(), safetensors);
+  EXPECT_THROW(Tensor::load_tensors(file.str()), std::runtime_error);
+}
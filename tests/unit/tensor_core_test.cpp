@@ -48,3 +48,32 @@ TEST(Core, RequiresGradStateIsSharedAcrossCopies) {
     EXPECT_TRUE(alias.is_leaf());
 }
 
+TEST(Core, DimsSpillPastTheInlineCapacity) {
+    Tensor::Dims dims{1, 2, 3};
+    Tensor::Dims copy = dims;
+    for (int64_t dim = 4; dim <= 9; ++dim) {
+        dims.push_back(dim);
+    }
+    EXPECT_EQ(dims, (std::vector<int64_t>{1, 2, 3, 4, 5, 6, 7, 8, 9}));
+    EXPECT_EQ(copy, (std::vector<int64_t>{1, 2, 3}));
+    dims.erase(dims.begin());
+    dims.insert(dims.begin() + 1, 0);
+    Tensor::Dims moved = std::move(dims);
+    EXPECT_EQ(moved, (std::vector<int64_t>{2, 0, 3, 4, 5, 6, 7, 8, 9}));
+    copy = moved;
+    EXPECT_EQ(copy, moved);
+}
+
+TEST(Core, LayoutFlagsAreDerivedOnce) {
+    auto high_rank = Tensor::api::zeros({2, 1, 3, 1, 2, 1, 2, 1}, Tensor::DType::f32);
+    EXPECT_EQ(high_rank.numel(), 24);
+    EXPECT_TRUE(high_rank.is_contiguous());
+
+    auto base = Tensor::api::zeros({2, 3, 4}, Tensor::DType::f32);
+    EXPECT_FALSE(Tensor::api::permute(base, {0, 2, 1}).is_contiguous());
+    // A permutation that keeps the default strides is still contiguous.
+    EXPECT_TRUE(Tensor::api::permute(base, {0, 1, 2}).is_contiguous());
+    const auto reshaped = Tensor::api::reshape(base, {6, 4});
+    EXPECT_EQ(reshaped.numel(), 24);
+    EXPECT_EQ(reshaped.stride(), (std::vector<int64_t>{4, 1}));
+}
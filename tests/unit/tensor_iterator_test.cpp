@@ -0,0 +1,89 @@
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "api/Api.hpp"
+#include "tensor/Elementwise.hpp"
+#include "tensor/TensorIterator.hpp"
+
+namespace {
+
+Tensor::DTensor iota_tensor(const std::vector<int64_t> &shape) {
+  auto tensor = Tensor::api::empty(shape, Tensor::DType::f32);
+  auto *ptr = static_cast<float *>(tensor.data());
+  std::iota(ptr, ptr + tensor.numel(), 0.0f);
+  return tensor;
+}
+
+} // namespace
+
+TEST(TensorIterator, BroadcastShapesFollowNumpyRules) {
+  EXPECT_EQ(Tensor::broadcast_shapes({4, 1, 3}, {5, 1}), (std::vector<int64_t>{4, 5, 3}));
+  EXPECT_EQ(Tensor::broadcast_shapes({}, {2, 2}), (std::vector<int64_t>{2, 2}));
+  EXPECT_THROW(Tensor::broadcast_shapes({2, 3}, {3, 2}), std::invalid_argument);
+}
+
+TEST(TensorIterator, ContiguousOperandsCoalesceToOneDimension) {
+  auto lhs = iota_tensor({4, 5, 6});
+  auto rhs = iota_tensor({4, 5, 6});
+  auto out = Tensor::api::empty({4, 5, 6}, Tensor::DType::f32);
+  Tensor::TensorIterator iter(out, {lhs, rhs});
+  EXPECT_EQ(iter.ndim(), 1);
+  EXPECT_EQ(iter.numel(), 120);
+  EXPECT_TRUE(iter.is_contiguous());
+}
+
+TEST(TensorIterator, TransposedOperandsIterateInMemoryOrder) {
+  auto stored = iota_tensor({8, 16});
+  auto transposed = Tensor::api::permute(stored, {1, 0});
+  auto scratch = Tensor::api::empty({8, 16}, Tensor::DType::f32);
+  auto permuted_out = Tensor::api::permute(scratch, {1, 0});
+
+  // Both operands walk storage in the same order, so the plan is one dense run.
+  Tensor::TensorIterator iter(permuted_out, {transposed});
+  EXPECT_TRUE(iter.is_contiguous());
+
+  auto out = Tensor::api::empty({16, 8}, Tensor::DType::f32);
+
+  // Mixed layouts keep two dims with the input's unit stride innermost.
+  Tensor::TensorIterator mixed(out, {transposed});
+  ASSERT_EQ(mixed.ndim(), 2);
+  EXPECT_EQ(mixed.stride(0, 0), static_cast<int64_t>(sizeof(float)));
+
+  Tensor::kernels::map<float>(mixed, [](auto x) { return x; });
+  const auto *out_ptr = static_cast<const float *>(out.data());
+  for (int64_t row = 0; row < 16; ++row) {
+    for (int64_t col = 0; col < 8; ++col) {
+      ASSERT_EQ(out_ptr[row * 8 + col], static_cast<float>(col * 16 + row));
+    }
+  }
+}
+
+TEST(TensorIterator, BroadcastInputsGetZeroStride) {
+  auto matrix = iota_tensor({3, 4});
+  auto row = iota_tensor({4});
+  auto out = Tensor::api::empty({3, 4}, Tensor::DType::f32);
+  Tensor::TensorIterator iter(out, {matrix, row});
+  ASSERT_EQ(iter.ndim(), 2);
+  EXPECT_EQ(iter.stride(2, 1), 0);
+
+  Tensor::kernels::map<float>(iter, [](auto a, auto b) { return a - b; });
+  const auto *ptr = static_cast<const float *>(out.data());
+  for (int64_t index = 0; index < 12; ++index) {
+    EXPECT_EQ(ptr[index], static_cast<float>(index - index % 4));
+  }
+}
+
+TEST(TensorIterator, InputsMayNotExpandTheOutput) {
+  const auto matrix = iota_tensor({3, 4});
+  auto column = Tensor::api::empty({3, 1}, Tensor::DType::f32);
+  EXPECT_THROW(Tensor::TensorIterator(column, {matrix}), std::invalid_argument);
+
+  // Leading dims of size 1 add no elements.
+  const auto batched = iota_tensor({1, 3, 4});
+  auto out = Tensor::api::empty({3, 4}, Tensor::DType::f32);
+  Tensor::TensorIterator iter(out, {batched});
+  EXPECT_EQ(iter.numel(), 12);
+}
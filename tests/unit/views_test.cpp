@@ -1,3 +1,6 @@
+#include <stdexcept>
+#include <vector>
+
 #include <gtest/gtest.h>
 #include "api/Api.hpp"
 
@@ -21,13 +24,40 @@ TEST(Views, PermuteBasic) {
     EXPECT_EQ(p.shape()[2], 2);
 }
 
-TEST(Views, ReshapePreservesAutogradState) {
+TEST(Views, ViewsOfTrainableTensorsRecordANode) {
     auto t = Tensor::api::zeros<float>({2, 3}, true);
     auto reshaped = Tensor::api::reshape(t.as_dtensor(), {3, 2});
 
     EXPECT_TRUE(reshaped.requires_grad());
-    EXPECT_TRUE(reshaped.is_leaf());
+    EXPECT_FALSE(reshaped.is_leaf());
+    EXPECT_TRUE(reshaped.grad_fn());
     EXPECT_EQ(reshaped.numel(), t.numel());
 }
 
+TEST(Views, PermuteRejectsRepeatedAxes) {
+    auto t = Tensor::api::zeros<float>({2, 3});
+    EXPECT_THROW(Tensor::api::permute(t.as_dtensor(), {0, 0}), std::invalid_argument);
+}
+
+TEST(Views, ViewsOfPlainTensorsSkipAutogradState) {
+    auto t = Tensor::api::zeros<float>({2, 3});
+    auto p = Tensor::api::permute(t.as_dtensor(), {1, 0});
+    EXPECT_FALSE(p.autograd_state());
+    EXPECT_FALSE(Tensor::api::reshape(t.as_dtensor(), {6}).autograd_state());
 
+    // The state is created on demand once the view joins autograd.
+    p.set_requires_grad(true);
+    EXPECT_TRUE(p.requires_grad());
+    EXPECT_FALSE(t.requires_grad());
+}
+
+TEST(Views, VectorLayoutsStillCompile) {
+    auto t = Tensor::api::zeros<float>({2, 3, 4});
+    const std::vector<int> perm{2, 0, 1};
+    const auto p = Tensor::api::permute(t.as_dtensor(), perm);
+    const std::vector<int64_t> shape = p.shape();
+    const std::vector<int64_t> stride = p.stride();
+    EXPECT_EQ(shape, (std::vector<int64_t>{4, 2, 3}));
+    EXPECT_EQ(stride, (std::vector<int64_t>{1, 12, 4}));
+    EXPECT_EQ(Tensor::api::reshape(t.as_dtensor(), std::vector<int64_t>{4, 6}).numel(), 24);
+}